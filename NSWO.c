@@ -20,6 +20,8 @@
    IN THE SOFTWARE.
 */
 #include "nswo.h"
+#include "export.h"
+#include "dpptrack.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -35,29 +37,31 @@ int check_nswo(ImageHandle *fh, int skip, int mode)
 	/* search: *** Find NSWO1/NSWO2 Values by searching for correct function code byte sequence */
 	if(skip == 0) return found;		
 
-	printf("\n-[ NSWO1/NSWO2 engine-speed threshold 1 & 2 for switching calculation  ]---------------------\n\n");
-	printf(">>> Scanning for NSWO1/NSWO2 Lookup code sequence... \n");
+	con_printf("\n-[ NSWO1/NSWO2 engine-speed threshold 1 & 2 for switching calculation  ]---------------------\n\n");
+	con_printf(">>> Scanning for NSWO1/NSWO2 Lookup code sequence... \n");
 	byte_offset    = search_offset( rom_load_addr, fh->len, (unsigned char *)&needle_PROKON, (unsigned char *)&mask_PROKON, needle_PROKON_len);
 	if(byte_offset != 0) 
 	{
 		addr = rom_load_addr + byte_offset;
-		printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
+		con_printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(byte_offset, rom_load_addr + byte_offset, needle_PROKON_len+16); }
 
 		if(mode == 1) {
-			translate_seg(&_nswo1, "NSWO1", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+10) /*val*/);
+			translate_seg(&_nswo1, "NSWO1", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+10) /*seg*/, get16((unsigned char *)addr+10) /*val*/);
 			show_seg(&_nswo1);
 			nswo1_val = *(_nswo1.ram);
-			printf("NSWO1: (0x%-2.2x) %-5.1f Upm : Speed threshold 1 switching speed for calculating time savings\n", nswo1_val, (double)nswo1_val*40.0 );
+			con_printf("NSWO1: (0x%-2.2x) %-5.1f Upm : Speed threshold 1 switching speed for calculating time savings\n", nswo1_val, (double)nswo1_val*40.0 );
+			export_scalar("NSWO1", "Speed threshold 1 switching speed for calculating time savings", (unsigned long)_nswo1.rom, nswo1_val, (double)nswo1_val*40.0, "Upm");
 		} else if(mode == 2) {
-			translate_seg(&_nswo2, "NSWO2", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+30) /*val*/);
+			translate_seg(&_nswo2, "NSWO2", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+30) /*seg*/, get16((unsigned char *)addr+30) /*val*/);
 			show_seg(&_nswo2);
 			nswo2_val = *(_nswo2.ram);
-			printf("NSWO2: (0x%-2.2x) %-5.1f Upm : Speed threshold 2 switching speed for calculating time savings\n", nswo2_val, (double)nswo2_val*40.0 );
+			con_printf("NSWO2: (0x%-2.2x) %-5.1f Upm : Speed threshold 2 switching speed for calculating time savings\n", nswo2_val, (double)nswo2_val*40.0 );
+			export_scalar("NSWO2", "Speed threshold 2 switching speed for calculating time savings", (unsigned long)_nswo2.rom, nswo2_val, (double)nswo2_val*40.0, "Upm");
 		}
 	} else {
-		printf("Not found\n");
+		con_printf("Not found\n");
 	}
 
 	return found;
@@ -0,0 +1,198 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+/*
+ * Checksum / crc32 throughput benchmark.
+ *
+ * Measures CalcChecksumBlk() and crc32()
+ * in GB/s over the romfiles given on the command line and over synthetic
+ * buffers from 16KB to 8MB, then times fix_checksums() end-to-end on each
+ * romfile with its console output sent to the null device.
+ *
+ * Usage: cksum_bench [romfile ...]     (make bench runs it on ../Release/ *.bin)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#define NULL_DEVICE "NUL"
+#else
+#include <unistd.h>
+#define NULL_DEVICE "/dev/null"
+#endif
+
+#include "utils.h"
+#include "crc32.h"
+#include "fixsums.h"
+
+#define MIN_BENCH_TIME    0.25			// seconds spent per measurement
+#define SYNTH_MIN_SIZE    (16*1024)
+#define SYNTH_MAX_SIZE    (8*1024*1024)
+
+// globals normally owned by main.c
+char *save_name=NULL;
+int correct_checksums=OPTION_SET;
+int force_write=1;
+int show_diss=0;
+
+static volatile uint32_t sink;			// keeps results alive so kernels aren't optimised away
+
+typedef uint32_t (*bench_kernel)(ImageHandle *ih);
+
+typedef struct BENCH_KERNEL {
+	char         *group;
+	char         *name;
+	bench_kernel  fn;
+} BENCH_KERNEL;
+
+static uint32_t sum_scalar(ImageHandle *ih)
+{
+	return CalcChecksumBlk(ih, 0, ih->len-2);
+}
+
+static uint32_t crc_bytewise(ImageHandle *ih)
+{
+	return crc32(0, ih->d.p, ih->len);
+}
+
+// every kernel variant in the tree, add new ones (e.g. simd/slicing variants) here
+static BENCH_KERNEL kernels[] = {
+	{ "checksum", "scalar",   sum_scalar   },
+	{ "crc32",    "bytewise", crc_bytewise },
+};
+
+static double now_sec(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER f, c;
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return (double)c.QuadPart / (double)f.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* repeat kernel until MIN_BENCH_TIME has elapsed, returns GB/s */
+static double run_kernel(BENCH_KERNEL *k, ImageHandle *ih)
+{
+	double start, elapsed;
+	unsigned long iters = 0;
+
+	start = now_sec();
+	do {
+		sink ^= k->fn(ih);
+		iters++;
+		elapsed = now_sec() - start;
+	} while(elapsed < MIN_BENCH_TIME);
+
+	return ((double)ih->len * (double)iters) / elapsed / 1e9;
+}
+
+static void bench_buffer(char *label, ImageHandle *ih)
+{
+	int i;
+	for(i=0; i < sizeof(kernels)/sizeof(BENCH_KERNEL); i++) {
+		printf("%-9s %-9s %-44s %9lu %8.3f GB/s\n", kernels[i].group, kernels[i].name, label,
+			(unsigned long)ih->len, run_kernel(&kernels[i], ih));
+	}
+}
+
+/* time fix_checksums() on a fresh copy of the image each round, console output discarded */
+static void bench_fix_checksums(char *filename, ImageHandle *rom)
+{
+	ImageHandle work;
+	double start, elapsed;
+	unsigned long iters = 0;
+	int saved_stdout, null_fd;
+
+	work.len = rom->len;
+	work.d.p = malloc(rom->len);
+	if(work.d.p == 0) return;
+
+	save_name = NULL_DEVICE;				// corrected roms are "saved" to the null device
+	fflush(stdout);
+	saved_stdout = dup(fileno(stdout));
+	null_fd      = open(NULL_DEVICE, O_WRONLY);
+	dup2(null_fd, fileno(stdout));
+
+	start = now_sec();
+	do {
+		memcpy(work.d.p, rom->d.p, rom->len);
+		fix_checksums(&work, 0, filename, work.len, work.d.u8);
+		iters++;
+		elapsed = now_sec() - start;
+	} while(elapsed < MIN_BENCH_TIME);
+
+	fflush(stdout);
+	dup2(saved_stdout, fileno(stdout));
+	close(saved_stdout);
+	close(null_fd);
+
+	printf("%-9s %-9s %-44s %9lu %8.3f ms/rom (%.3f GB/s)\n", "fixsums", "e2e", filename, (unsigned long)rom->len,
+		elapsed*1000.0/iters, ((double)rom->len * (double)iters) / elapsed / 1e9);
+	free(work.d.p);
+}
+
+int main(int argc, char *argv[])
+{
+	ImageHandle ih;
+	char label[64];
+	uint32_t seed = 0x360;
+	size_t size, i;
+	int arg;
+
+	printf("%-9s %-9s %-44s %9s %13s\n", "group", "kernel", "input", "bytes", "throughput");
+
+	// bundled/given romfiles
+	for(arg=1; arg < argc; arg++) {
+		ih.d.p = load_file_ex(argv[arg], &ih.len, 0);
+		if(ih.d.p == 0) {
+			printf("Failed to load '%s'\n", argv[arg]);
+			continue;
+		}
+		bench_buffer(argv[arg], &ih);
+		bench_fix_checksums(argv[arg], &ih);
+		ifree_file(&ih);
+	}
+
+	// synthetic buffers 16KB..8MB filled from a fixed lcg so runs are repeatable
+	ih.len = SYNTH_MAX_SIZE;
+	ih.d.p = malloc(SYNTH_MAX_SIZE);
+	if(ih.d.p == 0) { printf("Failed to allocate synthetic buffer\n"); return 1; }
+	for(i=0; i < SYNTH_MAX_SIZE; i++) {
+		seed = seed * 1103515245 + 12345;
+		ih.d.u8[i] = (uint8_t)(seed >> 16);
+	}
+	for(size = SYNTH_MIN_SIZE; size <= SYNTH_MAX_SIZE; size *= 2) {
+		ih.len = size;
+		snprintf(label, sizeof(label), "synthetic %luKB", (unsigned long)(size/1024));
+		bench_buffer(label, &ih);
+	}
+	free(ih.d.p);
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "checkjobs.h"
+
+static void run_job(CHECK_JOB *job)
+{
+	if(job->fn != 0) {
+		job->result = job->fn(job->fh, job->skip);
+	} else {
+		job->result = job->fn_mode(job->fh, job->skip, job->mode);
+	}
+}
+
+// run a job with its console output captured and thrown away
+static void run_job_quiet(CHECK_JOB *job)
+{
+	OUTBUF *ob = ob_get();
+	size_t len = ob->len;
+	int capture = ob->capture;
+
+	ob->capture = 1;
+	run_job(job);
+	ob->capture = capture;
+	ob->len = len;
+}
+
+#ifndef NO_THREADS
+static void *job_thread(void *arg)
+{
+	CHECK_JOB *job = (CHECK_JOB *)arg;
+	OUTBUF *ob = ob_get();
+
+	ob->capture = 1;
+	run_job(job);
+	ob->capture = 0;
+
+	// hand the thread's buffer over to the job, it is printed (and freed) by run_check_jobs()
+	job->out  = *ob;
+	ob->data  = 0;
+	ob->len   = 0;
+	ob->size  = 0;
+	return 0;
+}
+#endif
+
+/*
+ * Run a list of checks, output appears exactly as if they had been called in list order.
+ * With 'parallel' 0 (or built with NO_THREADS) they are simply called in turn.
+ *
+ * returns the number of checks that were run
+ */
+static int run_jobs(ImageHandle *fh, CHECK_JOB *jobs, int num, int parallel, int quiet)
+{
+	int i, ran = 0;
+
+	for(i=0;i<num;i++) {
+		jobs[i].fh      = fh;
+		jobs[i].result  = 0;
+		jobs[i].started = 0;
+		memset(&jobs[i].out, 0, sizeof(OUTBUF));
+#ifndef NO_THREADS
+		if(parallel && jobs[i].skip != 0) {
+			jobs[i].started = (pthread_create(&jobs[i].thread, NULL, job_thread, &jobs[i]) == 0);
+		}
+#endif
+	}
+
+	for(i=0;i<num;i++) {
+		if(jobs[i].skip == 0) continue;
+#ifndef NO_THREADS
+		if(jobs[i].started) {
+			pthread_join(jobs[i].thread, NULL);
+			jobs[i].out.fp = stdout;
+			if(quiet) jobs[i].out.len = 0;
+			ob_free(&jobs[i].out);
+			ran++;
+			continue;
+		}
+#endif
+		// not threaded (or the thread couldn't be created), everything before it is printed already
+		if(quiet) run_job_quiet(&jobs[i]);
+		else run_job(&jobs[i]);
+		ran++;
+	}
+	return ran;
+}
+
+int run_check_jobs(ImageHandle *fh, CHECK_JOB *jobs, int num, int parallel)
+{
+	return run_jobs(fh, jobs, num, parallel, 0);
+}
+
+/*
+ * As run_check_jobs() but nothing is printed, for checks only run for what they find (see catalog_note_map)
+ */
+int run_check_jobs_quiet(ImageHandle *fh, CHECK_JOB *jobs, int num, int parallel)
+{
+	return run_jobs(fh, jobs, num, parallel, 1);
+}
@@ -0,0 +1,57 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _CHECKJOBS_SUPPORT_H
+#define _CHECKJOBS_SUPPORT_H
+#include "utils.h"
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
+// The table/value checks only read the image, so a group of them can run at once.
+// Each check runs on its own thread with its console output (con_printf, show_map,
+// hexdumps) captured, the output is then printed in the order the jobs are listed.
+// Build with -DNO_THREADS to always run them one after the other.
+
+typedef int (*check_fn)(ImageHandle *fh, int skip);
+typedef int (*check_mode_fn)(ImageHandle *fh, int skip, int mode);
+
+typedef struct CHECK_JOB {
+	check_fn		fn;				// one of fn or fn_mode is set
+	check_mode_fn	fn_mode;
+	int				skip;			// the check's option flag, 0 means it isn't run
+	int				mode;
+	int				result;
+	int				started;		// running on its own thread
+	ImageHandle		*fh;
+	OUTBUF			out;			// captured console output
+#ifndef NO_THREADS
+	pthread_t		thread;
+#endif
+} CHECK_JOB;
+
+#define CHECK_JOB(f, skip)				{ f, 0, skip, 0 }
+#define CHECK_JOB_MODE(f, skip, mode)	{ 0, f, skip, mode }
+
+int run_check_jobs(ImageHandle *fh, CHECK_JOB *jobs, int num, int parallel);
+int run_check_jobs_quiet(ImageHandle *fh, CHECK_JOB *jobs, int num, int parallel);
+
+#endif
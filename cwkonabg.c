@@ -22,6 +22,9 @@
 #include "cwkonabg.h"
 #include "needles.h"
 #include "utils.h"
+#include "export.h"
+#include "dpptrack.h"
+#include "labels.h"
 
 extern unsigned dpp1_value;
 extern int show_diss;
@@ -53,28 +56,30 @@ int check_cwkonabg(ImageHandle *fh, int skip)
 	 */
 	if(skip == 0) return found;		
 
-	printf("\n>>> Scanning for CWKONABG [Codeword for configuration of Exhaust emission treatment]\n");
+	con_printf("\n>>> Scanning for CWKONABG [Codeword for configuration of Exhaust emission treatment]\n");
 	addr = search( fh, (unsigned char *)&needle_CWKONABG, (unsigned char *)&mask_CWKONABG, needle_CWKONABG_len, 0 );
 	if(addr != NULL) {
 		found = 1;
-		printf("\nfound at offset=0x%x ",(int)(addr-(int)rom_load_addr) );
+		con_printf("\nfound at offset=0x%x ",(int)(addr-(int)rom_load_addr) );
 		val = get16((unsigned char *)addr+10);
-		cwkonabg_adr  = ((dpp1_value-1)*SEGMENT_SIZE);
-		cwkonabg_adr += val;
+		cwkonabg_adr  = (unsigned char *)dpp_near(addr+10-(unsigned long)fh->d.u8, val);	// through the DPPs at the needle
 		val_adr       = (unsigned long)cwkonabg_adr;		// derive phyiscal address from offset and segment
 		val_adr      &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
+		label_symbol(val_adr, SYM_DATA, "CWKONABG");
+		label_symbol(addr-(unsigned long)rom_load_addr, SYM_CODE, "CWKONABG lookup");
 					
-		printf("CWKONABG @ ADR:%#x\n\n", cwkonabg_adr );
+		con_printf("CWKONABG @ ADR:%#x\n\n", cwkonabg_adr );
 		if(show_diss) { 
-			printf("Dumping ...\n");
+			con_printf("Dumping ...\n");
 			c167x_diss(addr-(int)rom_load_addr, addr, needle_CWKONFZ1_len+4); 
 		}
 		cwkonabg = (unsigned char)*(rom_load_addr+val_adr);
 		dump_bin(s_bin, cwkonabg, 8 );							// create formatted binary string from byte of cwkonabg
 		dump_bitfmt_table(&cwkonabg_fmt, cwkonabg, s_bin);		// show it correctly formatted using template
+		export_codeword(&cwkonabg_fmt, (unsigned long)cwkonabg_adr, cwkonabg);
 	}
 
-	if(found == 0) { printf("Sequence not found\n"); }
+	if(found == 0) { con_printf("Sequence not found\n"); }
 	return found;
 }
 
@@ -20,6 +20,9 @@
    IN THE SOFTWARE.
 */
 #include "cwkonfz1.h"
+#include "export.h"
+#include "dpptrack.h"
+#include "labels.h"
 
 extern unsigned dpp1_value;
 extern int show_diss;
@@ -51,36 +54,38 @@ int check_cwkonfz(ImageHandle *fh, int skip)
 	 */
 	if(skip == 0) return found;		
 
-	printf("\n>>> Scanning for CWKONFZ1 [Codeword for configuration of vehicle]\n");
+	con_printf("\n>>> Scanning for CWKONFZ1 [Codeword for configuration of vehicle]\n");
 	addr = search( fh, (unsigned char *)&needle_CWKONFZ1, (unsigned char *)&mask_CWKONFZ1, needle_CWKONFZ1_len, 0 );
 	if(addr != NULL) {
 		found = 1;
-		printf("\nfound at offset=0x%x ",(int)(addr-(int)rom_load_addr) );
+		con_printf("\nfound at offset=0x%x ",(int)(addr-(int)rom_load_addr) );
 		val = get16((unsigned char *)addr+2);
-		cwkonfz1_adr  = ((dpp1_value-1)*SEGMENT_SIZE);
-		cwkonfz1_adr += val;
+		cwkonfz1_adr  = (unsigned char *)dpp_near(addr+2-(unsigned long)fh->d.u8, val);	// through the DPPs at the needle
 		val_adr       = (unsigned long)cwkonfz1_adr;		// derive phyiscal address from offset and segment
 		val_adr      &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
+		label_symbol(val_adr, SYM_DATA, "CWKONFZ1");
+		label_symbol(addr-(unsigned long)rom_load_addr, SYM_CODE, "CWKONFZ1 lookup");
 					
-		printf("CWKONFZ1 @ ADR:%#x\n\n", cwkonfz1_adr );
+		con_printf("CWKONFZ1 @ ADR:%#x\n\n", cwkonfz1_adr );
 		if(show_diss) { 
-			printf("Dumping ...\n");
+			con_printf("Dumping ...\n");
 			c167x_diss(addr-(int)rom_load_addr, addr, needle_CWKONFZ1_len+4+32); 
 		}
 					
 		cwkonfz1 = (unsigned char)*(rom_load_addr+val_adr);
 		dump_bin(s_bin, cwkonfz1, 8 );							// create formatted binary string from byte of cwkonfz1
 		dump_bitfmt_table(&cwkonfz1_fmt, cwkonfz1, s_bin);		// show it correctly formatted using template
+		export_codeword(&cwkonfz1_fmt, (unsigned long)cwkonfz1_adr, cwkonfz1);
 
-		printf("This ROM is configured for : ");
+		con_printf("This ROM is configured for : ");
 		if(s_bin[8] == '1') { 
-			printf("F1-AMT Gearbox with a Transmission Control Unit.\n"); 
+			con_printf("F1-AMT Gearbox with a Transmission Control Unit.\n"); 
 		} else {
-			printf("H-Gate Manual gearbox.\n"); 
+			con_printf("H-Gate Manual gearbox.\n"); 
 		}
 	}
 
-	if(found == 0) { printf("Sequence not found\n"); }
+	if(found == 0) { con_printf("Sequence not found\n"); }
 	return found;
 }
 
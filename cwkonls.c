@@ -23,6 +23,9 @@
 #include "cwkonfz1.h"
 #include "needles.h"
 #include "utils.h"
+#include "export.h"
+#include "dpptrack.h"
+#include "labels.h"
 
 extern unsigned dpp1_value;
 extern int show_diss;
@@ -54,28 +57,30 @@ int check_cwkonls(ImageHandle *fh, int skip)
 	 */
 	if(skip == 0) return found;		
 
-	printf("\n>>> Scanning for CWKONLS [Codeword for configuration of Lambda sensors]\n");
+	con_printf("\n>>> Scanning for CWKONLS [Codeword for configuration of Lambda sensors]\n");
 	addr = search( fh, (unsigned char *)&needle_CWKONFZ1, (unsigned char *)&mask_CWKONFZ1, needle_CWKONFZ1_len, 0 );
 	if(addr != NULL) {
 		found = 1;
-		printf("\nfound at offset=0x%x ",(int)(addr-(int)rom_load_addr) );
+		con_printf("\nfound at offset=0x%x ",(int)(addr-(int)rom_load_addr) );
 		val = get16((unsigned char *)addr+92);
-		cwkonls_adr  = ((dpp1_value-1)*SEGMENT_SIZE);
-		cwkonls_adr += val;
+		cwkonls_adr  = (unsigned char *)dpp_near(addr+92-(unsigned long)fh->d.u8, val);	// through the DPPs at the needle
 		val_adr       = (unsigned long)cwkonls_adr;		// derive phyiscal address from offset and segment
 		val_adr      &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
+		label_symbol(val_adr, SYM_DATA, "CWKONLS");
+		label_symbol(addr-(unsigned long)rom_load_addr, SYM_CODE, "CWKONLS lookup");
 					
-		printf("CWKONLS @ ADR:%#x\n\n", cwkonls_adr );
+		con_printf("CWKONLS @ ADR:%#x\n\n", cwkonls_adr );
 		if(show_diss) { 
-			printf("Dumping ...\n");
+			con_printf("Dumping ...\n");
 			c167x_diss(addr-(int)rom_load_addr, addr, needle_CWKONFZ1_len+4); 
 		}
 		cwkonls = (unsigned char)*(rom_load_addr+val_adr);
 		dump_bin(s_bin, cwkonls, 8 );							// create formatted binary string from byte of cwkonls
 		dump_bitfmt_table(&cwkonls_fmt, cwkonls, s_bin);		// show it correctly formatted using template
+		export_codeword(&cwkonls_fmt, (unsigned long)cwkonls_adr, cwkonls);
 	}
 
-	if(found == 0) { printf("Sequence not found\n"); }
+	if(found == 0) { con_printf("Sequence not found\n"); }
 	return found;
 }
 
@@ -0,0 +1,243 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include "datalog.h"
+
+static const double pow10_exact[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+// move the unparsed tail to the front of the buffer and read more behind it, returns 0 if nothing was added
+static int fill(DATALOG *dl)
+{
+	size_t n;
+	char *p;
+
+	if(dl->eof) return 0;
+	if(dl->pos != 0) {
+		memmove(dl->buf, dl->buf + dl->pos, dl->len - dl->pos);
+		dl->len -= dl->pos;
+		dl->pos  = 0;
+	}
+	// a single line longer than the buffer, make it bigger
+	if(dl->len == dl->size) {
+		p = realloc(dl->buf, dl->size*2 + 1);
+		if(p == 0) return 0;
+		dl->buf   = p;
+		dl->size *= 2;
+	}
+	n = fread(dl->buf + dl->len, 1, dl->size - dl->len, dl->fp);
+	if(n == 0) {
+		dl->eof = 1;
+		return 0;
+	}
+	dl->len += n;
+	return 1;
+}
+
+// next line, nul terminated and without its line ending, 0 at the end of the file
+static char *next_line(DATALOG *dl)
+{
+	char *s, *e;
+
+	for(;;) {
+		s = dl->buf + dl->pos;
+		e = memchr(s, '\n', dl->len - dl->pos);
+		if(e != 0) {
+			dl->pos = (e - dl->buf) + 1;
+			break;
+		}
+		if(fill(dl) == 0) {
+			// last line has no line ending (the buffer always has room for the nul)
+			if(dl->pos == dl->len) return 0;
+			s = dl->buf + dl->pos;
+			e = dl->buf + dl->len;
+			dl->pos = dl->len;
+			break;
+		}
+	}
+	if(e > s && e[-1] == '\r') e--;
+	*e = 0;
+	return s;
+}
+
+// copy of a header field without surrounding blanks or quotes
+static char *column_name(const char *s, const char *e)
+{
+	char *name;
+
+	while(s < e && (isspace((unsigned char)*s) || *s == '"')) s++;
+	while(e > s && (isspace((unsigned char)e[-1]) || e[-1] == '"')) e--;
+	name = malloc(e - s + 1);
+	if(name != 0) {
+		memcpy(name, s, e - s);
+		name[e - s] = 0;
+	}
+	return name;
+}
+
+/*
+ * Plain decimals ("-12.345") are converted directly. With at most 15 digits both the digits and
+ * the power of ten are exact doubles, so the one division rounds exactly like strtod() does.
+ * Anything else (exponents, hex, inf/nan, long numbers) is left to strtod().
+ */
+static double parse_number(char *p, char **end)
+{
+	char *s = p;
+	uint64_t digits = 0;
+	int num = 0, frac = 0, neg = 0;
+	double v;
+
+	if(*s == '-' || *s == '+') neg = (*s++ == '-');
+	for(; *s >= '0' && *s <= '9'; s++, num++) digits = digits*10 + (*s - '0');
+	if(*s == '.') {
+		for(s++; *s >= '0' && *s <= '9'; s++, num++, frac++) digits = digits*10 + (*s - '0');
+	}
+	if(num == 0 || num > 15 || ((*s | 0x20) >= 'a' && (*s | 0x20) <= 'z')) return strtod(p, end);
+
+	*end = s;
+	v = (double)digits / pow10_exact[frac];
+	return neg ? -v : v;
+}
+
+/*
+ * Open a csv datalog and read its header line, the separator is whichever of ',' ';' or tab
+ * the header uses most.
+ *
+ * returns 0 if the file couldn't be opened or has no header
+ */
+DATALOG *datalog_open(const char *filename)
+{
+	DATALOG *dl;
+	char *line, *s, *e;
+	int commas = 0, semis = 0, tabs = 0;
+
+	dl = calloc(1, sizeof(DATALOG));
+	if(dl == 0) return 0;
+	dl->fp = fopen(filename, "rb");
+	if(dl->fp == 0) {
+		printf("Failed to open datalog '%s'\n", filename);
+		free(dl);
+		return 0;
+	}
+	dl->size = DATALOG_READ_SIZE;
+	dl->buf  = malloc(dl->size + 1);
+	if(dl->buf == 0 || (line = next_line(dl)) == 0) {
+		printf("Datalog '%s' is empty\n", filename);
+		datalog_close(dl);
+		return 0;
+	}
+
+	// skip a utf-8 byte order mark
+	if((unsigned char)line[0] == 0xef && (unsigned char)line[1] == 0xbb && (unsigned char)line[2] == 0xbf) line += 3;
+
+	for(s=line; *s; s++) {
+		if(*s == ',')  commas++;
+		if(*s == ';')  semis++;
+		if(*s == '\t') tabs++;
+	}
+	dl->sep = ',';
+	if(semis > commas && semis >= tabs) dl->sep = ';';
+	if(tabs > commas && tabs > semis)   dl->sep = '\t';
+
+	for(s=line; dl->num_cols < DATALOG_MAX_COLUMNS; s=e+1) {
+		for(e=s; *e && *e != dl->sep; e++);
+		dl->col_names[dl->num_cols++] = column_name(s, e);
+		if(*e == 0) break;
+	}
+	return dl;
+}
+
+void datalog_close(DATALOG *dl)
+{
+	int i;
+
+	if(dl == 0) return;
+	for(i=0;i<dl->num_cols;i++) free(dl->col_names[i]);
+	if(dl->fp != 0) fclose(dl->fp);
+	free(dl->buf);
+	free(dl);
+}
+
+/*
+ * returns the index of the named column (case is ignored) or -1 if the log doesn't have it
+ */
+int datalog_column(DATALOG *dl, const char *name)
+{
+	int i;
+	const char *a, *b;
+
+	for(i=0;i<dl->num_cols;i++) {
+		if(dl->col_names[i] == 0) continue;
+		for(a=dl->col_names[i], b=name; *a && tolower((unsigned char)*a) == tolower((unsigned char)*b); a++, b++);
+		if(*a == 0 && *b == 0) return i;
+	}
+	return -1;
+}
+
+/*
+ * Read up to max_rows rows, out[k][row] receives the value of column cols[k] (a column
+ * index of -1 gives NAN). Blank lines are skipped.
+ *
+ * returns the number of rows read, 0 at the end of the log
+ */
+int datalog_read(DATALOG *dl, const int *cols, int num, double **out, int max_rows)
+{
+	int i, k, f, last = -1, rows = 0;
+	char *line, *p, *e;
+	double v;
+
+	for(i=0;i<dl->num_cols;i++) dl->slot[i] = -1;
+	for(k=0;k<num;k++) {
+		if(cols[k] < 0 || cols[k] >= dl->num_cols) continue;
+		dl->slot[cols[k]] = k;
+		if(cols[k] > last) last = cols[k];
+	}
+
+	while(rows < max_rows && (line = next_line(dl)) != 0) {
+		for(p=line; *p == ' ' || *p == '\t'; p++);
+		if(*p == 0) continue;
+
+		for(k=0;k<num;k++) out[k][rows] = NAN;
+
+		// walk the fields up to the last one we want
+		for(p=line, f=0; f <= last; f++) {
+			if(dl->slot[f] >= 0) {
+				while(*p == ' ' || *p == '"') p++;
+				// strtod() skips leading white space, which would run into the next tab separated field
+				if(*p != dl->sep && *p != 0) {
+					v = parse_number(p, &e);
+					if(e != p) out[dl->slot[f]][rows] = v;
+					p = e;
+				}
+			}
+			while(*p && *p != dl->sep) p++;
+			if(*p == 0) break;
+			p++;
+		}
+		rows++;
+	}
+	dl->rows += rows;
+	return rows;
+}
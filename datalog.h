@@ -0,0 +1,52 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _DATALOG_SUPPORT_H
+#define _DATALOG_SUPPORT_H
+#include <stdio.h>
+
+// Streaming reader for csv datalogs (',' ';' or tab separated, first line holds
+// the column names). Rows are handed out in blocks, one array per requested
+// column, so a log of any length is read with a fixed amount of memory.
+// Empty or non-numeric fields are returned as NAN.
+
+#define DATALOG_MAX_COLUMNS		256
+#define DATALOG_BLOCK_ROWS		4096
+#define DATALOG_READ_SIZE		(256*1024)
+
+typedef struct DATALOG {
+	FILE   *fp;
+	char   *buf;					// read buffer, [pos,len) is not parsed yet
+	size_t  pos, len, size;
+	int     eof;
+	char    sep;
+	int     num_cols;
+	char   *col_names[DATALOG_MAX_COLUMNS];
+	int     slot[DATALOG_MAX_COLUMNS];	// column -> output array of the current read, -1 if unused
+	unsigned long rows;				// data rows read so far
+} DATALOG;
+
+DATALOG *datalog_open(const char *filename);
+void datalog_close(DATALOG *dl);
+int  datalog_column(DATALOG *dl, const char *name);
+int  datalog_read(DATALOG *dl, const int *cols, int num, double **out, int max_rows);
+
+#endif
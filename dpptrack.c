@@ -0,0 +1,311 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "dpptrack.h"
+#include "funcindex.h"
+#include "mapcatalog.h"
+#include "inst_c16x.h"
+
+extern unsigned long dpp0_value, dpp1_value, dpp2_value, dpp3_value;
+
+#define DPP_MAP_PAGE	((CAT_ROM_BASE + MAP_AREA_START) / SEGMENT_SIZE)	// page 0 near pointers land here
+#define DPP_SFR_BASE	0xFE00												// DPP0..DPP3 in the SFR area
+#define DPP_PAGE_MASK	0x3FF
+
+#define OP_MOV_RI		0xE6		// mov reg,#data16
+#define OP_SCXT_RI		0xC6		// scxt reg,#data16
+#define OP_MOV_RM		0xF2		// mov reg,mem
+#define OP_MOV_MR		0xF6		// mov mem,reg
+#define OP_POP			0xFC		// pop reg
+#define OP_EXT			0xD7		// extp/exts/extpr/extsr #value,#n
+#define OP_EXT_R		0xDC		// extp/exts/extpr/extsr Rw,#n
+
+// a DPP holds 'page' from rom file offset 'code' on (until its next change)
+typedef struct DPP_CHANGE {
+	uint32_t       code;
+	unsigned short page;
+	unsigned char  known;
+} DPP_CHANGE;
+
+// the instructions in [start,end) are prefixed by an extp/exts
+typedef struct DPP_EXT {
+	uint32_t       start;
+	uint32_t       end;
+	unsigned short val;
+	unsigned char  kind;
+	unsigned char  known;
+} DPP_EXT;
+
+typedef struct DPP_LIST {
+	void *p;
+	int   num, max;
+} DPP_LIST;
+
+static DPP_LIST       changes[4];
+static DPP_LIST       exts;
+static unsigned long  entry_page[4];
+static unsigned long  track_len;
+
+static void *list_add(DPP_LIST *l, size_t size)
+{
+	void *p;
+
+	if(l->num == l->max) {
+		int max = l->max ? l->max*2 : 256;
+		if((p = realloc(l->p, max * size)) == 0) return 0;
+		l->p   = p;
+		l->max = max;
+	}
+	return (char *)l->p + (l->num++)*size;
+}
+
+static int inst_len(const unsigned char *rom, unsigned long a)
+{
+	return inst_set[rom[a]].len ? inst_set[rom[a]].len : 2;
+}
+
+// DPPn changes from code on, nothing is recorded if it already holds that
+static int set_dpp(int n, unsigned long code, unsigned long page, int known)
+{
+	DPP_CHANGE *c = changes[n].num ? &((DPP_CHANGE *)changes[n].p)[changes[n].num-1] : 0;
+
+	if(c ? (c->known == known && c->page == page) : (known && page == entry_page[n])) return 0;
+	if(c && c->code == code) {
+		c->page  = page;
+		c->known = known;
+		return 0;
+	}
+	if((c = list_add(&changes[n], sizeof(DPP_CHANGE))) == 0) return -1;
+	c->code  = code;
+	c->page  = page;
+	c->known = known;
+	return 0;
+}
+
+// DPP number written by the register operand of a 'reg' addressing mode, -1 if it isn't one
+static int dpp_reg(unsigned char reg)
+{
+	return (reg < 4) ? reg : -1;
+}
+
+// one function, from start to the next function start
+static int walk(const unsigned char *rom, unsigned long start, unsigned long end)
+{
+	unsigned long a, e, next;
+	unsigned char op;
+	DPP_EXT *x;
+	int n, k, l;
+
+	for(n=0;n<4;n++) {
+		if(set_dpp(n, start, entry_page[n], 1) != 0) return -1;
+	}
+
+	for(a=start;a+2<=end;a=next) {
+		op   = rom[a];
+		l    = inst_len(rom, a);
+		next = a + l;
+		if(next > end) break;
+
+		switch(op) {
+			case OP_MOV_RI:
+			case OP_SCXT_RI:
+				if((n = dpp_reg(rom[a+1])) >= 0 && set_dpp(n, next, get16((unsigned char *)rom+a+2) & DPP_PAGE_MASK, 1) != 0) return -1;
+				break;
+			case OP_POP:
+				// pushed on entry, restored on the way out
+				if((n = dpp_reg(rom[a+1])) >= 0 && set_dpp(n, next, entry_page[n], 1) != 0) return -1;
+				break;
+			case OP_MOV_MR:
+				k = get16((unsigned char *)rom+a+2);
+				if(k >= DPP_SFR_BASE && k < DPP_SFR_BASE+8 && set_dpp((k - DPP_SFR_BASE) >> 1, next, 0, 0) != 0) return -1;
+				break;
+			case OP_EXT:
+			case OP_EXT_R:
+				if((x = list_add(&exts, sizeof(DPP_EXT))) == 0) return -1;
+				x->kind  = (rom[a+1] & 0x40) ? DPP_EXT_P : DPP_EXT_S;
+				x->known = (op == OP_EXT);
+				x->val   = (x->kind == DPP_EXT_P) ? (rom[a+2] | ((rom[a+3] & 3) << 8)) : rom[a+2];
+				// covers the next 1..4 instructions
+				for(e=next,k=((rom[a+1] >> 4) & 3)+1;k>0 && e+2<=track_len;k--) e += inst_len(rom, e);
+				x->start = next;
+				x->end   = e;
+				break;
+			default:
+				// mov reg,mem and the alu ops with a reg destination (cmp only reads it)
+				if(op == OP_MOV_RM || ((op & 0x0B) == 0x02 && (op >> 4) <= 7 && (op >> 4) != 4)) {
+					if((n = dpp_reg(rom[a+1])) >= 0 && set_dpp(n, next, 0, 0) != 0) return -1;
+				}
+				break;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Walk every function of the image once and record where the DPPs change, func_index_build()
+ * and check_dppx() must have run
+ */
+int dpp_track_build(ImageHandle *fh)
+{
+	const unsigned char *rom = fh->d.u8;
+	unsigned long a, end, len = fh->len & ~1UL;
+
+	dpp_track_free();
+	entry_page[0] = dpp0_value & DPP_PAGE_MASK;
+	entry_page[1] = dpp1_value & DPP_PAGE_MASK;
+	entry_page[2] = dpp2_value & DPP_PAGE_MASK;
+	entry_page[3] = dpp3_value & DPP_PAGE_MASK;
+	track_len = len;
+
+	for(a=0;a<len;a=end) {
+		// the map area holds no code
+		if(a >= MAP_AREA_START && a < ROM_MAIN_START) a = ROM_MAIN_START;
+		if(a >= len) break;
+		end = func_end(a);
+		if(end == FUNC_NONE || end > len) end = len;
+		if(a < MAP_AREA_START && end > MAP_AREA_START) end = MAP_AREA_START;
+		if(walk(rom, a, end) != 0) {
+			dpp_track_free();
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void dpp_track_free(void)
+{
+	int n;
+
+	for(n=0;n<4;n++) {
+		free(changes[n].p);
+		memset(&changes[n], 0, sizeof(DPP_LIST));
+	}
+	free(exts.p);
+	memset(&exts, 0, sizeof(DPP_LIST));
+	track_len = 0;
+}
+
+//-[ Queries ]--------------------------------------------------------------------------------------------------------------
+
+// page in DPPn at code, returns 0 if the page written there isn't known
+static int page_at(unsigned long code, int n, unsigned long *page)
+{
+	const DPP_CHANGE *c = changes[n].p;
+	int lo = 0, hi = changes[n].num - 1, mid, res = -1;
+
+	while(lo <= hi) {
+		mid = (lo + hi) / 2;
+		if(c[mid].code <= code) {
+			res = mid;
+			lo  = mid + 1;
+		} else {
+			hi  = mid - 1;
+		}
+	}
+	if(res < 0 || code >= track_len) {
+		*page = entry_page[n];
+		return 1;
+	}
+	*page = c[res].page;
+	return c[res].known;
+}
+
+/*
+ * Page held by DPPn at code, DPP_UNKNOWN if it was loaded from memory
+ */
+unsigned long dpp_page(unsigned long code, int n)
+{
+	unsigned long page;
+
+	return page_at(code, n & 3, &page) ? page : DPP_UNKNOWN;
+}
+
+/*
+ * extp/exts prefix covering code (DPP_EXT_xxx), *val is its page or segment (DPP_UNKNOWN for a register form)
+ */
+int dpp_ext(unsigned long code, unsigned long *val)
+{
+	const DPP_EXT *x = exts.p;
+	int lo = 0, hi = exts.num - 1, mid, res = -1;
+
+	while(lo <= hi) {
+		mid = (lo + hi) / 2;
+		if(x[mid].start <= code) {
+			res = mid;
+			lo  = mid + 1;
+		} else {
+			hi  = mid - 1;
+		}
+	}
+	// prefixes are never nested, only the latest can still be active
+	if(res < 0 || code >= x[res].end) return DPP_EXT_NONE;
+	if(val) *val = x[res].known ? x[res].val : DPP_UNKNOWN;
+	return x[res].kind;
+}
+
+/*
+ * Physical address of the mem operand of the instruction at code, DPP_UNKNOWN if its
+ * page isn't known. *ext (if given) is set to the prefix used, DPP_EXT_NONE for a DPP.
+ */
+unsigned long dpp_mem(unsigned long code, unsigned short mem, int *ext)
+{
+	unsigned long page, val = 0;
+	int kind = dpp_ext(code, &val);
+
+	if(ext) *ext = kind;
+	if(kind != DPP_EXT_NONE) {
+		if(val == DPP_UNKNOWN) return DPP_UNKNOWN;
+		if(kind == DPP_EXT_P) return val*SEGMENT_SIZE + (mem & (SEGMENT_SIZE-1));
+		return (val << 16) | mem;
+	}
+	if(!page_at(code, mem >> 14, &page)) return DPP_UNKNOWN;
+	return page*SEGMENT_SIZE + (mem & (SEGMENT_SIZE-1));
+}
+
+/*
+ * Physical address of a near pointer loaded at code. A DPP that isn't known is taken to
+ * hold its startup page, page 0 is the map area.
+ */
+unsigned long dpp_near(unsigned long code, unsigned short ptr)
+{
+	unsigned long page;
+
+	if(!page_at(code, ptr >> 14, &page)) page = entry_page[ptr >> 14];
+	if(page == 0) page = DPP_MAP_PAGE;
+	return page*SEGMENT_SIZE + (ptr & (SEGMENT_SIZE-1));
+}
+
+/*
+ * Segment for translate_seg()/dump_table(), seg*SEGMENT_SIZE + val is where the near
+ * pointer val loaded at code points
+ */
+int dpp_seg(unsigned long code, unsigned short val)
+{
+	return (int)(((long)dpp_near(code, val) - (long)val) / SEGMENT_SIZE);
+}
+
+/*
+ * dpp_seg() of the #data16 at p in the image, eg. the operand of a 'mov r12,#data16' in a needle
+ */
+int dpp_seg_at(const ImageHandle *fh, const unsigned char *p)
+{
+	return dpp_seg(p - fh->d.u8, get16((unsigned char *)p));
+}
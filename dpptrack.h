@@ -0,0 +1,57 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _DPPTRACK_SUPPORT_H
+#define _DPPTRACK_SUPPORT_H
+#include "utils.h"
+
+// Data page tracking: which page each DPP holds, and which extp/exts prefix is active, at
+// any code offset of the rom, so a 16 bit data address found by a needle resolves to the
+// physical address the cpu really uses instead of assuming the map page is dpp1-1.
+//
+// One linear pass over the instruction stream of every function (see funcindex.h) built
+// by search_rom() after check_dppx(). Each function is entered with the DPPs set up by the
+// startup code, a write to a DPP changes it from that instruction on (mov/scxt #data16 give a
+// known page, anything else an unknown one) and a 'pop DPPn' restores the entry value. The
+// state is kept per function rather than per basic block, a join of two paths is taken in
+// address order. extp/exts/extpr/extsr cover the next 1..4 instructions.
+//
+// Near pointers passed in registers (not mem operands) whose DPP holds page 0 point into
+// the 64KByte map area, the convention every lookup in the ME7 rom follows.
+
+#define DPP_UNKNOWN		0xFFFFFFFFUL
+
+#define DPP_EXT_NONE	0
+#define DPP_EXT_P		1			// extp/extpr, page in 'val'
+#define DPP_EXT_S		2			// exts/extsr, segment in 'val'
+
+int  dpp_track_build(ImageHandle *fh);
+void dpp_track_free(void);
+
+// all take 'code' as a rom file offset anywhere inside the instruction using the address
+unsigned long dpp_page(unsigned long code, int n);
+int  dpp_ext(unsigned long code, unsigned long *val);
+unsigned long dpp_mem(unsigned long code, unsigned short mem, int *ext);
+unsigned long dpp_near(unsigned long code, unsigned short ptr);
+int  dpp_seg(unsigned long code, unsigned short val);
+int  dpp_seg_at(const ImageHandle *fh, const unsigned char *p);
+
+#endif
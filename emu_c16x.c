@@ -0,0 +1,1131 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "emu_c16x.h"
+#include <time.h>
+
+extern unsigned long dpp0_value, dpp1_value, dpp2_value, dpp3_value;
+
+#define EMU_MAP_PAGE	((EMU_ROM_BASE + MAP_AREA_START) / SEGMENT_SIZE)	// DPP0 while the ecu runs, see emu_reset()
+#define EMU_SFR_START	0xFE00
+
+// PSW flags
+#define PSW_N			0x01
+#define PSW_C			0x02
+#define PSW_V			0x04
+#define PSW_Z			0x08
+#define PSW_E			0x10
+#define PSW_FLAGS		0x1F
+
+// ext_mode
+#define EXT_PAGE		0x01		// extp/extpr: addresses are page:offset
+#define EXT_SEG			0x02		// exts/extsr: addresses are segment:offset
+#define EXT_REG			0x04		// extr/extpr/extsr: reg and bitoff name the extended SFRs
+
+// instruction classes, one handler each
+enum {
+	C_INVALID = 0,
+	C_ALU_RR, C_ALUB_RR, C_ALU_RM, C_ALUB_RM, C_ALU_MR, C_ALUB_MR, C_ALU_RI, C_ALUB_RI, C_ALU_RX, C_ALUB_RX,
+	C_BFLD, C_BITOP, C_MUL, C_PRIOR, C_DIV, C_SHIFT,
+	C_JMPR, C_BCLR, C_BSET, C_JBIT, C_JMPI, C_JMP, C_CALL, C_CALLI, C_CALLR, C_RET,
+	C_CMPID, C_NEG, C_MOV_IM, C_MOV_IND, C_MOV_DISP, C_MOVBX, C_MOV_RR, C_MOV_RI, C_MOV_RM, C_MOV_MR,
+	C_SCXT, C_PUSH, C_POP, C_EXT, C_NOP, C_SYS,
+	C_NUM
+};
+
+static const char *result_names[] = { "returned", "instruction limit reached", "undefined opcode", "left the rom image", "halted" };
+
+/*
+ * Memory. Writes into the rom image are dropped (it is flash), SFR writes keep the
+ * cached copies of DPP0-3 and CP up to date.
+ */
+static inline unsigned rd16(EMU *e, unsigned long a)
+{
+	a &= EMU_MEM_SIZE-2;
+	return e->mem[a] | (e->mem[a+1] << 8);
+}
+
+static inline unsigned rd8(EMU *e, unsigned long a)
+{
+	return e->mem[a & (EMU_MEM_SIZE-1)];
+}
+
+static inline void poke16(EMU *e, unsigned long a, unsigned v)
+{
+	a &= EMU_MEM_SIZE-2;
+	e->mem[a]   = v;
+	e->mem[a+1] = v >> 8;
+}
+
+static void sfr_sync(EMU *e, unsigned long a)
+{
+	switch(a) {
+		case EMU_DPP0: case EMU_DPP0+2: case EMU_DPP0+4: case EMU_DPP0+6:
+			e->dpp[(a - EMU_DPP0) >> 1] = rd16(e, a) & 0x3FF;
+			break;
+		case EMU_CPR:
+			e->cp = rd16(e, a) & 0xFFFE;
+			break;
+		case EMU_ZEROS:
+			poke16(e, a, 0);
+			break;
+		case EMU_ONES:
+			poke16(e, a, 0xFFFF);
+			break;
+	}
+}
+
+static inline void wr16(EMU *e, unsigned long a, unsigned v)
+{
+	a &= EMU_MEM_SIZE-2;
+	if(a - EMU_ROM_BASE < e->rom_len || a < EMU_LOW_ROM) return;
+	poke16(e, a, v);
+	if(a >= EMU_SFR_START && a < 0x10000) sfr_sync(e, a);
+}
+
+static inline void wr8(EMU *e, unsigned long a, unsigned v)
+{
+	a &= EMU_MEM_SIZE-1;
+	if(a - EMU_ROM_BASE < e->rom_len || a < EMU_LOW_ROM) return;
+	e->mem[a] = v;
+	if(a >= EMU_SFR_START && a < 0x10000) sfr_sync(e, a & ~1UL);
+}
+
+// physical address of a 16 bit data address (mem, [Rw]) through the DPPs or an ext prefix
+static inline unsigned long dadr(EMU *e, unsigned a)
+{
+	a &= 0xFFFF;
+	if(e->ext_mode & EXT_PAGE) return ((unsigned long)e->ext_val << 14) | (a & 0x3FFF);
+	if(e->ext_mode & EXT_SEG)  return ((unsigned long)e->ext_val << 16) | a;
+	return ((unsigned long)e->dpp[a >> 14] << 14) | (a & 0x3FFF);
+}
+
+// registers: 4 bit GPR numbers, 8 bit 'reg' short addresses and bitoff
+#define GPR(n)			rd16(e, e->cp + 2*(n))
+#define SET_GPR(n,v)	poke16(e, e->cp + 2*(n), (v))
+#define GPRB(n)			e->mem[e->cp + (n)]
+#define SET_GPRB(n,v)	(e->mem[e->cp + (n)] = (v))
+
+static inline unsigned long reg_adr(EMU *e, unsigned q)
+{
+	if(q >= 0xF0) return e->cp + 2*(q & 0xF);
+	return ((e->ext_mode & EXT_REG) ? 0xF000 : EMU_SFR_START) + 2*q;
+}
+
+static inline unsigned long regb_adr(EMU *e, unsigned q)
+{
+	if(q >= 0xF0) return e->cp + (q & 0xF);
+	return ((e->ext_mode & EXT_REG) ? 0xF000 : EMU_SFR_START) + 2*q;
+}
+
+static inline unsigned long bit_adr(EMU *e, unsigned q)
+{
+	if(q < 0x80) return 0xFD00 + 2*q;
+	if(q < 0xF0) return ((e->ext_mode & EXT_REG) ? 0xF100 : 0xFF00) + 2*(q - 0x80);
+	return e->cp + 2*(q & 0xF);
+}
+
+static inline unsigned bit_get(EMU *e, unsigned q, unsigned b)
+{
+	return (rd16(e, bit_adr(e, q)) >> b) & 1;
+}
+
+static inline void bit_put(EMU *e, unsigned q, unsigned b, unsigned v)
+{
+	unsigned long a = bit_adr(e, q);
+	wr16(e, a, (rd16(e, a) & ~(1U << b)) | (v << b));
+}
+
+// system stack, always in segment 0
+static inline void push(EMU *e, unsigned v)
+{
+	unsigned sp = (rd16(e, EMU_SPR) - 2) & 0xFFFF;
+
+	poke16(e, EMU_SPR, sp);
+	wr16(e, sp, v);
+}
+
+static inline unsigned pop(EMU *e)
+{
+	unsigned sp = rd16(e, EMU_SPR);
+
+	poke16(e, EMU_SPR, (sp + 2) & 0xFFFF);
+	return rd16(e, sp);
+}
+
+/*
+ * Flags
+ */
+static inline void set_flags(EMU *e, unsigned mask, unsigned f)
+{
+	poke16(e, EMU_PSW, (rd16(e, EMU_PSW) & ~mask) | f);
+}
+
+// N, Z and E of a moved value (msb is 0x8000 or 0x80)
+static inline unsigned nze(unsigned v, unsigned msb)
+{
+	return ((v & msb) ? PSW_N : 0) | (v ? 0 : PSW_Z) | (v == msb ? PSW_E : 0);
+}
+
+// add, addc, sub, subc, cmp, xor, and, or (the high nibble of the opcode)
+static unsigned alu(EMU *e, int op, unsigned a, unsigned b, unsigned msb)
+{
+	unsigned mask = 2*msb - 1, psw = rd16(e, EMU_PSW), c = (psw & PSW_C) ? 1 : 0, r, f = 0;
+
+	a &= mask;
+	b &= mask;
+	switch(op) {
+		case 0:
+		case 1:
+			r = a + b + (op == 1 ? c : 0);
+			if(r > mask) f |= PSW_C;
+			if(~(a ^ b) & (a ^ r) & msb) f |= PSW_V;
+			break;
+		case 2:
+		case 3:
+		case 4:
+			c = (op == 3) ? c : 0;
+			r = a - b - c;
+			if(a < b + c) f |= PSW_C;
+			if((a ^ b) & (a ^ r) & msb) f |= PSW_V;
+			break;
+		case 5:  r = a ^ b; break;
+		case 6:  r = a & b; break;
+		default: r = a | b; break;
+	}
+	r &= mask;
+	if(r & msb) f |= PSW_N;
+	// addc/subc only keep Z set, so a multi word result tests zero as a whole
+	if(r == 0 && ((op != 1 && op != 3) || (psw & PSW_Z))) f |= PSW_Z;
+	if(b == msb) f |= PSW_E;
+	poke16(e, EMU_PSW, (psw & ~PSW_FLAGS) | f);
+	return r;
+}
+
+// bit f of cc[c] is set if condition code c holds for the flag combination f
+static void build_cc(EMU *e)
+{
+	int f, c, t[16];
+
+	memset(e->cc, 0, sizeof(e->cc));
+	for(f=0;f<32;f++) {
+		int n = f & PSW_N ? 1 : 0, cy = f & PSW_C ? 1 : 0, v = f & PSW_V ? 1 : 0, z = f & PSW_Z ? 1 : 0, x = f & PSW_E ? 1 : 0;
+
+		t[CC_UC]  = 1;
+		t[CC_NET] = !z && !x;
+		t[CC_Z]   = z;
+		t[CC_NZ]  = !z;
+		t[CC_V]   = v;
+		t[CC_NV]  = !v;
+		t[CC_N]   = n;
+		t[CC_NN]  = !n;
+		t[CC_C]   = cy;
+		t[CC_NC]  = !cy;
+		t[CC_SGT] = !z && n == v;
+		t[CC_SLE] = z || n != v;
+		t[CC_SLT] = n != v;
+		t[CC_SGE] = n == v;
+		t[CC_UGT] = !z && !cy;
+		t[CC_ULE] = z || cy;
+		for(c=0;c<16;c++) if(t[c]) e->cc[c] |= 1UL << f;
+	}
+}
+
+#define COND(c)		((e->cc[(c) & 0xF] >> (rd16(e, EMU_PSW) & PSW_FLAGS)) & 1)
+
+static int op_class(int op)
+{
+	int lo = op & 0xF, hi = op >> 4;
+
+	if(inst_set[op].len == 0) return C_INVALID;
+	switch(lo) {
+		case 0xD: return C_JMPR;
+		case 0xE: return C_BCLR;
+		case 0xF: return C_BSET;
+	}
+	if(op < 0x80) {
+		switch(lo) {
+			case 0x0: return C_ALU_RR;
+			case 0x1: return C_ALUB_RR;
+			case 0x2: return C_ALU_RM;
+			case 0x3: return C_ALUB_RM;
+			case 0x4: return C_ALU_MR;
+			case 0x5: return C_ALUB_MR;
+			case 0x6: return C_ALU_RI;
+			case 0x7: return C_ALUB_RI;
+			case 0x8: return C_ALU_RX;
+			case 0x9: return C_ALUB_RX;
+			case 0xA: return (hi < 2) ? C_BFLD : C_BITOP;
+			case 0xB: return (hi < 2) ? C_MUL : (hi == 2) ? C_PRIOR : C_DIV;
+			case 0xC: return C_SHIFT;
+		}
+		return C_INVALID;
+	}
+	switch(op) {
+		case 0x80: case 0x82: case 0x86: case 0x90: case 0x92: case 0x96:
+		case 0xA0: case 0xA2: case 0xA6: case 0xB0: case 0xB2: case 0xB6:
+			return C_CMPID;
+		case 0x81: case 0x91: case 0xA1: case 0xB1:
+			return C_NEG;
+		case 0x84: case 0x94: case 0xA4: case 0xB4:
+			return C_MOV_IM;
+		case 0x88: case 0x89: case 0x98: case 0x99: case 0xA8: case 0xA9: case 0xB8: case 0xB9:
+		case 0xC8: case 0xC9: case 0xD8: case 0xD9: case 0xE8: case 0xE9:
+			return C_MOV_IND;
+		case 0x8A: case 0x9A: case 0xAA: case 0xBA:
+			return C_JBIT;
+		case 0x9C: return C_JMPI;
+		case 0xAB: return C_CALLI;
+		case 0xBB: return C_CALLR;
+		case 0xAC: case 0xBC:
+			return C_SHIFT;
+		case 0xC0: case 0xC2: case 0xC5: case 0xD0: case 0xD2: case 0xD5:
+			return C_MOVBX;
+		case 0xC4: case 0xD4: case 0xE4: case 0xF4:
+			return C_MOV_DISP;
+		case 0xC6: case 0xD6:
+			return C_SCXT;
+		case 0xCA: case 0xDA: case 0xE2:
+			return C_CALL;
+		case 0xEA: case 0xFA:
+			return C_JMP;
+		case 0xCB: case 0xDB: case 0xEB: case 0xFB:
+			return C_RET;
+		case 0xD1: case 0xD7: case 0xDC:
+			return C_EXT;
+		case 0xF0: case 0xF1: return C_MOV_RR;
+		case 0xE0: case 0xE1: case 0xE6: case 0xE7: return C_MOV_RI;
+		case 0xF2: case 0xF3: return C_MOV_RM;
+		case 0xF6: case 0xF7: return C_MOV_MR;
+		case 0xEC: return C_PUSH;
+		case 0xFC: return C_POP;
+		case 0xCC: case 0xA5: case 0xB5:
+			return C_NOP;
+		case 0x87: case 0x97: case 0x9B: case 0xB7:
+			return C_SYS;
+	}
+	return C_INVALID;
+}
+
+// first execution of a rom word, is it a defined instruction (including its sub table entry)
+static int check_code(EMU *e, unsigned long pc)
+{
+	DIS_INST di;
+
+	c167x_decode(e->mem + EMU_ROM_BASE + pc, e->rom_len - pc, pc, &di);
+	if(e->rom_len - pc < di.len) di.flags |= DIS_INVALID;
+	e->code[pc >> 1] = (di.flags & DIS_INVALID) ? 2 : 1;
+	return e->code[pc >> 1] == 1;
+}
+
+/*
+ * Create an emulator with the image copied in at EMU_ROM_BASE
+ */
+EMU *emu_create(ImageHandle *fh)
+{
+	EMU *e;
+	int op;
+
+	if(fh->len > EMU_MEM_SIZE - EMU_ROM_BASE) return 0;
+	e = calloc(1, sizeof(EMU));
+	if(e == 0) return 0;
+	e->mem  = calloc(1, EMU_MEM_SIZE);
+	e->code = calloc(1, fh->len/2 + 1);
+	if(e->mem == 0 || e->code == 0) {
+		emu_free(e);
+		return 0;
+	}
+	memcpy(e->mem + EMU_ROM_BASE, fh->d.u8, fh->len);
+	memcpy(e->mem, fh->d.u8, (fh->len < EMU_LOW_ROM) ? fh->len : EMU_LOW_ROM);
+	e->rom_len   = fh->len & ~1UL;
+	e->max_insts = EMU_MAX_INSTS;
+	for(op=0;op<256;op++) {
+		e->len[op] = inst_set[op].len;
+		e->cls[op] = op_class(op);
+	}
+	build_cc(e);
+	emu_reset(e);
+	return e;
+}
+
+void emu_free(EMU *e)
+{
+	if(e == 0) return;
+	free(e->mem);
+	free(e->code);
+	free(e);
+}
+
+/*
+ * Registers as the rom's startup code leaves them, ram keeps its contents. DPP1-3 are the
+ * values check_dppx found, DPP0 is switched to the map area once the ecu runs (dpptrack
+ * finds these writes) and map lookups pass near pointers relying on that.
+ */
+void emu_reset(EMU *e)
+{
+	int i;
+
+	poke16(e, EMU_DPP0+0, dpp0_value ? dpp0_value : EMU_MAP_PAGE);
+	poke16(e, EMU_DPP0+2, dpp1_value ? dpp1_value : 0x205);
+	poke16(e, EMU_DPP0+4, dpp2_value ? dpp2_value : 0xE0);
+	poke16(e, EMU_DPP0+6, 3);
+	for(i=0;i<4;i++) sfr_sync(e, EMU_DPP0 + 2*i);
+	poke16(e, EMU_CSP, 0);
+	poke16(e, EMU_MDH, 0);
+	poke16(e, EMU_MDL, 0);
+	poke16(e, EMU_PSW, 0);
+	poke16(e, EMU_SPR, EMU_SP);
+	wr16(e, EMU_CPR, EMU_CP);
+	wr16(e, EMU_ZEROS, 0);
+	wr16(e, EMU_ONES, 0);
+	for(i=0;i<16;i++) SET_GPR(i, 0);
+	SET_GPR(0, EMU_USP);
+	e->ip = e->csp = 0;
+	e->ext_left = e->ext_mode = 0;
+}
+
+unsigned short emu_reg(EMU *e, int n)                    { return GPR(n & 0xF); }
+void emu_set_reg(EMU *e, int n, unsigned short val)      { SET_GPR(n & 0xF, val); }
+unsigned short emu_read16(EMU *e, unsigned long adr)      { return rd16(e, adr); }
+void emu_write16(EMU *e, unsigned long adr, unsigned short val) { poke16(e, adr, val); sfr_sync(e, adr & ~1UL); }
+
+const char *emu_result_name(int res)
+{
+	if(res < 0 || res > EMU_HALT) return "?";
+	return result_names[res];
+}
+
+/*
+ * Threaded dispatch, each handler ends in NEXT which fetches the following instruction
+ * and jumps to its handler. Without gcc's computed goto NEXT goes through a switch.
+ */
+#if defined(__GNUC__)
+#define OP(c)			h_##c:
+#define DISPATCH(c)		goto *handler[c]
+#else
+#define OP(c)			case c:
+#define DISPATCH(c)		do { cls = (c); goto dispatch; } while(0)
+#endif
+
+#define NEXT	do { \
+	if(e->ext_left && --e->ext_left == 0) e->ext_mode = 0; \
+	at = ((unsigned long)csp << 16) | ip; \
+	pc = (at < EMU_LOW_ROM) ? at : at - EMU_ROM_BASE; \
+	if(pc >= e->rom_len) { res = EMU_FAULT; goto done; } \
+	if(e->code[pc >> 1] != 1 && !check_code(e, pc)) { res = EMU_INVALID; goto done; } \
+	if(++n > max) { res = EMU_LIMIT; goto done; } \
+	p  = e->mem + EMU_ROM_BASE + pc; \
+	ip = (ip + e->len[p[0]]) & 0xFFFF; \
+	DISPATCH(e->cls[p[0]]); \
+} while(0)
+
+// a return to the frame pushed by emu_call() ends the run
+#define RETURNED	do { if(ip == EMU_EXIT_IP && rd16(e, EMU_SPR) >= sp0 - 2) { res = EMU_OK; goto done; } } while(0)
+
+#define JREL(b)		((ip + 2*(signed char)(b)) & 0xFFFF)
+#define IMM16		((unsigned)(p[2] | (p[3] << 8)))
+
+/*
+ * Call the routine at physical address adr with args in r12.. and run until it returns
+ */
+int emu_call(EMU *e, unsigned long adr, const unsigned short *args, int nargs)
+{
+#if defined(__GNUC__)
+	static void *const handler[C_NUM] = {
+		[C_INVALID] = &&h_C_INVALID,
+		[C_ALU_RR] = &&h_C_ALU_RR, [C_ALUB_RR] = &&h_C_ALUB_RR, [C_ALU_RM] = &&h_C_ALU_RM, [C_ALUB_RM] = &&h_C_ALUB_RM,
+		[C_ALU_MR] = &&h_C_ALU_MR, [C_ALUB_MR] = &&h_C_ALUB_MR, [C_ALU_RI] = &&h_C_ALU_RI, [C_ALUB_RI] = &&h_C_ALUB_RI,
+		[C_ALU_RX] = &&h_C_ALU_RX, [C_ALUB_RX] = &&h_C_ALUB_RX,
+		[C_BFLD] = &&h_C_BFLD, [C_BITOP] = &&h_C_BITOP, [C_MUL] = &&h_C_MUL, [C_PRIOR] = &&h_C_PRIOR,
+		[C_DIV] = &&h_C_DIV, [C_SHIFT] = &&h_C_SHIFT,
+		[C_JMPR] = &&h_C_JMPR, [C_BCLR] = &&h_C_BCLR, [C_BSET] = &&h_C_BSET, [C_JBIT] = &&h_C_JBIT,
+		[C_JMPI] = &&h_C_JMPI, [C_JMP] = &&h_C_JMP, [C_CALL] = &&h_C_CALL, [C_CALLI] = &&h_C_CALLI,
+		[C_CALLR] = &&h_C_CALLR, [C_RET] = &&h_C_RET,
+		[C_CMPID] = &&h_C_CMPID, [C_NEG] = &&h_C_NEG, [C_MOV_IM] = &&h_C_MOV_IM, [C_MOV_IND] = &&h_C_MOV_IND,
+		[C_MOV_DISP] = &&h_C_MOV_DISP, [C_MOVBX] = &&h_C_MOVBX, [C_MOV_RR] = &&h_C_MOV_RR, [C_MOV_RI] = &&h_C_MOV_RI,
+		[C_MOV_RM] = &&h_C_MOV_RM, [C_MOV_MR] = &&h_C_MOV_MR,
+		[C_SCXT] = &&h_C_SCXT, [C_PUSH] = &&h_C_PUSH, [C_POP] = &&h_C_POP, [C_EXT] = &&h_C_EXT,
+		[C_NOP] = &&h_C_NOP, [C_SYS] = &&h_C_SYS,
+	};
+#else
+	int cls;
+#endif
+	const uint8_t *p = 0;
+	unsigned long at = 0, pc, n = 0, max = e->max_insts;
+	unsigned ip, csp, sp0, a, b, r, op;
+	unsigned long m;
+	int res = EMU_OK, i;
+	clock_t start = clock();
+
+	for(i=0;i<nargs && i<EMU_MAX_ARGS;i++) SET_GPR(EMU_ARG_FIRST+i, args[i]);
+	sp0 = rd16(e, EMU_SPR);
+	push(e, rd16(e, EMU_CSP));
+	push(e, EMU_EXIT_IP);
+	csp = (adr >> 16) & 0xFF;
+	ip  = adr & 0xFFFE;
+	poke16(e, EMU_CSP, csp);
+	e->ext_left = e->ext_mode = 0;
+
+	NEXT;
+
+#if !defined(__GNUC__)
+dispatch:
+	switch(cls) {
+#endif
+
+	OP(C_INVALID)
+		res = EMU_INVALID;
+		goto done;
+
+	// op Rwn,Rwm
+	OP(C_ALU_RR)
+		op = p[0] >> 4;
+		r  = alu(e, op, GPR(p[1] >> 4), GPR(p[1] & 0xF), 0x8000);
+		if(op != 4) SET_GPR(p[1] >> 4, r);
+		NEXT;
+
+	OP(C_ALUB_RR)
+		op = p[0] >> 4;
+		r  = alu(e, op, GPRB(p[1] >> 4), GPRB(p[1] & 0xF), 0x80);
+		if(op != 4) SET_GPRB(p[1] >> 4, r);
+		NEXT;
+
+	// op reg,mem
+	OP(C_ALU_RM)
+		op = p[0] >> 4;
+		m  = reg_adr(e, p[1]);
+		r  = alu(e, op, rd16(e, m), rd16(e, dadr(e, IMM16)), 0x8000);
+		if(op != 4) wr16(e, m, r);
+		NEXT;
+
+	OP(C_ALUB_RM)
+		op = p[0] >> 4;
+		m  = regb_adr(e, p[1]);
+		r  = alu(e, op, rd8(e, m), rd8(e, dadr(e, IMM16)), 0x80);
+		if(op != 4) wr8(e, m, r);
+		NEXT;
+
+	// op mem,reg
+	OP(C_ALU_MR)
+		op = p[0] >> 4;
+		m  = dadr(e, IMM16);
+		r  = alu(e, op, rd16(e, m), rd16(e, reg_adr(e, p[1])), 0x8000);
+		if(op != 4) wr16(e, m, r);
+		NEXT;
+
+	OP(C_ALUB_MR)
+		op = p[0] >> 4;
+		m  = dadr(e, IMM16);
+		r  = alu(e, op, rd8(e, m), rd8(e, regb_adr(e, p[1])), 0x80);
+		if(op != 4) wr8(e, m, r);
+		NEXT;
+
+	// op reg,#data16 / op reg,#data8
+	OP(C_ALU_RI)
+		op = p[0] >> 4;
+		m  = reg_adr(e, p[1]);
+		r  = alu(e, op, rd16(e, m), IMM16, 0x8000);
+		if(op != 4) wr16(e, m, r);
+		NEXT;
+
+	OP(C_ALUB_RI)
+		op = p[0] >> 4;
+		m  = regb_adr(e, p[1]);
+		r  = alu(e, op, rd8(e, m), p[2], 0x80);
+		if(op != 4) wr8(e, m, r);
+		NEXT;
+
+	// op Rwn,#data3 / [Rwi] / [Rwi+]
+	OP(C_ALU_RX)
+		op = p[0] >> 4;
+		a  = p[1] & 0xF;
+		if(a < 8) {
+			b = a & 7;
+		} else {
+			r = GPR(a & 3);
+			b = rd16(e, dadr(e, r));
+			if(a & 4) SET_GPR(a & 3, r + 2);
+		}
+		r = alu(e, op, GPR(p[1] >> 4), b, 0x8000);
+		if(op != 4) SET_GPR(p[1] >> 4, r);
+		NEXT;
+
+	OP(C_ALUB_RX)
+		op = p[0] >> 4;
+		a  = p[1] & 0xF;
+		if(a < 8) {
+			b = a & 7;
+		} else {
+			r = GPR(a & 3);
+			b = rd8(e, dadr(e, r));
+			if(a & 4) SET_GPR(a & 3, r + 1);
+		}
+		r = alu(e, op, GPRB(p[1] >> 4), b, 0x80);
+		if(op != 4) SET_GPRB(p[1] >> 4, r);
+		NEXT;
+
+	// bfldl bitoff,#mask8,#data8 is 0A QQ @@ ##, bfldh is 1A QQ ## @@
+	OP(C_BFLD)
+		m = bit_adr(e, p[1]);
+		a = rd16(e, m);
+		set_flags(e, PSW_FLAGS, nze(a, 0x8000) & ~PSW_E);
+		if(p[0] == 0x0A) r = (a & ~p[2]) | p[3];
+		else             r = (a & ~(p[3] << 8)) | (p[2] << 8);
+		wr16(e, m, r & 0xFFFF);
+		NEXT;
+
+	// bcmp, bmovn, bmov, bor, band, bxor QQ ZZ qz (source QQ.q, destination ZZ.z)
+	OP(C_BITOP)
+		a = bit_get(e, p[2], p[3] & 0xF);
+		b = bit_get(e, p[1], p[3] >> 4);
+		switch(p[0]) {
+			case 0x3A:
+				b ^= 1;
+				// fall through
+			case 0x4A:
+				set_flags(e, PSW_FLAGS, b ? PSW_N : PSW_Z);
+				bit_put(e, p[2], p[3] & 0xF, b);
+				break;
+			default:
+				set_flags(e, PSW_FLAGS, ((a | b) ? PSW_V : PSW_Z) | ((a & b) ? PSW_C : 0) | ((a ^ b) ? PSW_N : 0));
+				if(p[0] == 0x5A) bit_put(e, p[2], p[3] & 0xF, a | b);
+				if(p[0] == 0x6A) bit_put(e, p[2], p[3] & 0xF, a & b);
+				if(p[0] == 0x7A) bit_put(e, p[2], p[3] & 0xF, a ^ b);
+				break;
+		}
+		NEXT;
+
+	// mul/mulu Rwn,Rwm into MDH:MDL
+	OP(C_MUL)
+		a = GPR(p[1] >> 4);
+		b = GPR(p[1] & 0xF);
+		if(p[0] == 0x0B) {
+			long s = (long)(short)a * (short)b;
+			m = (unsigned long)s & 0xFFFFFFFFUL;
+			r = (s != (short)s) ? PSW_V : 0;
+		} else {
+			m = (unsigned long)a * b;
+			r = (m > 0xFFFF) ? PSW_V : 0;
+		}
+		poke16(e, EMU_MDH, m >> 16);
+		poke16(e, EMU_MDL, m & 0xFFFF);
+		set_flags(e, PSW_FLAGS, r | ((m & 0x80000000UL) ? PSW_N : 0) | (m ? 0 : PSW_Z));
+		NEXT;
+
+	// prior Rwn,Rwm: shifts needed to normalise Rwm
+	OP(C_PRIOR)
+		a = GPR(p[1] & 0xF);
+		r = 0;
+		if(a) for(b=a;!(b & 0x8000);b<<=1) r++;
+		SET_GPR(p[1] >> 4, r);
+		set_flags(e, PSW_FLAGS, a ? 0 : PSW_Z);
+		NEXT;
+
+	// div, divu, divl, divlu Rwn: MDL is the quotient, MDH the remainder (truncating toward zero)
+	OP(C_DIV)
+		b = GPR(p[1] >> 4);
+		m = ((unsigned long)rd16(e, EMU_MDH) << 16) | rd16(e, EMU_MDL);
+		r = 0;
+		if(b == 0) {
+			r = PSW_V;
+		} else if(p[0] == 0x4B || p[0] == 0x6B) {
+			long x = (p[0] == 0x4B) ? (long)(short)(m & 0xFFFF) : (long)(int32_t)(uint32_t)m;
+			long q = x / (short)b;
+			if(q != (short)q) r = PSW_V;
+			poke16(e, EMU_MDL, q & 0xFFFF);
+			poke16(e, EMU_MDH, (x % (short)b) & 0xFFFF);
+		} else {
+			unsigned long x = (p[0] == 0x5B) ? (m & 0xFFFF) : m;
+			unsigned long q = x / b;
+			if(q > 0xFFFF) r = PSW_V;
+			poke16(e, EMU_MDL, q & 0xFFFF);
+			poke16(e, EMU_MDH, (x % b) & 0xFFFF);
+		}
+		a = rd16(e, EMU_MDL);
+		set_flags(e, PSW_FLAGS, r | ((a & 0x8000) ? PSW_N : 0) | (a ? 0 : PSW_Z));
+		NEXT;
+
+	// rol, ror, shl, shr, ashr: even rows shift by Rwm, odd rows by #data4 (byte is #n:Rwn)
+	OP(C_SHIFT)
+		if(p[0] & 0x10) {
+			i = p[1] & 0xF;
+			b = p[1] >> 4;
+		} else {
+			i = p[1] >> 4;
+			b = GPR(p[1] & 0xF) & 0xF;
+		}
+		a = GPR(i);
+		r = a;
+		op = 0;
+		switch(p[0] >> 5) {
+			case 0:		// rol
+				if(b) {
+					r = ((a << b) | (a >> (16 - b))) & 0xFFFF;
+					if((a >> (16 - b)) & 1) op |= PSW_C;
+				}
+				break;
+			case 1:		// ror
+				if(b) {
+					r = ((a >> b) | (a << (16 - b))) & 0xFFFF;
+					if((a >> (b - 1)) & 1) op |= PSW_C;
+					if(b > 1 && (a & ((1U << (b - 1)) - 1))) op |= PSW_V;
+				}
+				break;
+			case 2:		// shl
+				if(b) {
+					r = (a << b) & 0xFFFF;
+					if((a >> (16 - b)) & 1) op |= PSW_C;
+				}
+				break;
+			case 3:		// shr
+				if(b) {
+					r = a >> b;
+					if((a >> (b - 1)) & 1) op |= PSW_C;
+					if(b > 1 && (a & ((1U << (b - 1)) - 1))) op |= PSW_V;
+				}
+				break;
+			default:	// ashr
+				if(b) {
+					r = ((short)a >> b) & 0xFFFF;
+					if((a >> (b - 1)) & 1) op |= PSW_C;
+					if(b > 1 && (a & ((1U << (b - 1)) - 1))) op |= PSW_V;
+				}
+				break;
+		}
+		set_flags(e, PSW_FLAGS, op | (nze(r, 0x8000) & ~PSW_E));
+		SET_GPR(i, r);
+		NEXT;
+
+	OP(C_JMPR)
+		if(COND(p[0] >> 4)) ip = JREL(p[1]);
+		NEXT;
+
+	OP(C_BCLR)
+		a = bit_get(e, p[1], p[0] >> 4);
+		set_flags(e, PSW_FLAGS, a ? PSW_N : PSW_Z);
+		bit_put(e, p[1], p[0] >> 4, 0);
+		NEXT;
+
+	OP(C_BSET)
+		a = bit_get(e, p[1], p[0] >> 4);
+		set_flags(e, PSW_FLAGS, a ? PSW_N : PSW_Z);
+		bit_put(e, p[1], p[0] >> 4, 1);
+		NEXT;
+
+	// jb, jnb, jbc, jnbs bitoff.q,rel is 8A QQ rr q0
+	OP(C_JBIT)
+		a = bit_get(e, p[1], p[3] >> 4);
+		switch(p[0]) {
+			case 0x8A: if(a) ip = JREL(p[2]); break;
+			case 0x9A: if(!a) ip = JREL(p[2]); break;
+			case 0xAA:
+				if(a) {
+					bit_put(e, p[1], p[3] >> 4, 0);
+					ip = JREL(p[2]);
+				}
+				break;
+			default:
+				if(!a) {
+					bit_put(e, p[1], p[3] >> 4, 1);
+					ip = JREL(p[2]);
+				}
+				break;
+		}
+		NEXT;
+
+	OP(C_JMPI)
+		if(COND(p[1] >> 4)) {
+			ip = GPR(p[1] & 0xF) & 0xFFFE;
+			RETURNED;
+		}
+		NEXT;
+
+	OP(C_JMP)
+		if(p[0] == 0xFA) {
+			csp = p[1];
+			poke16(e, EMU_CSP, csp);
+			ip = IMM16 & 0xFFFE;
+		} else if(COND(p[1] >> 4)) {
+			ip = IMM16 & 0xFFFE;
+		}
+		NEXT;
+
+	// calla cc,caddr, calls seg,caddr, pcall reg,caddr
+	OP(C_CALL)
+		if(p[0] == 0xCA) {
+			if(!COND(p[1] >> 4)) NEXT;
+		} else if(p[0] == 0xDA) {
+			push(e, csp);
+			csp = p[1];
+			poke16(e, EMU_CSP, csp);
+		} else {
+			a = rd16(e, reg_adr(e, p[1]));
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+			push(e, a);
+		}
+		push(e, ip);
+		ip = IMM16 & 0xFFFE;
+		NEXT;
+
+	OP(C_CALLI)
+		if(COND(p[1] >> 4)) {
+			push(e, ip);
+			ip = GPR(p[1] & 0xF) & 0xFFFE;
+		}
+		NEXT;
+
+	OP(C_CALLR)
+		push(e, ip);
+		ip = JREL(p[1]);
+		NEXT;
+
+	// ret, rets, retp reg, reti
+	OP(C_RET)
+		ip = pop(e) & 0xFFFE;
+		if(p[0] == 0xDB || p[0] == 0xFB) {
+			csp = pop(e) & 0xFF;
+			poke16(e, EMU_CSP, csp);
+			if(p[0] == 0xFB) poke16(e, EMU_PSW, pop(e));
+		} else if(p[0] == 0xEB) {
+			a = pop(e);
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+			wr16(e, reg_adr(e, p[1]), a);
+		}
+		RETURNED;
+		NEXT;
+
+	// cmpi1/2, cmpd1/2 Rwn with #data4, mem or #data16, then Rwn +/- 1/2
+	OP(C_CMPID)
+		if((p[0] & 0xF) == 0) {
+			i = p[1] & 0xF;
+			b = p[1] >> 4;
+		} else {
+			i = p[1] & 0xF;
+			b = ((p[0] & 0xF) == 2) ? rd16(e, dadr(e, IMM16)) : IMM16;
+		}
+		a = GPR(i);
+		alu(e, 4, a, b, 0x8000);
+		switch(p[0] >> 4) {
+			case 0x8: a += 1; break;
+			case 0x9: a += 2; break;
+			case 0xA: a -= 1; break;
+			default:  a -= 2; break;
+		}
+		SET_GPR(i, a);
+		NEXT;
+
+	// neg, cpl, negb, cplb
+	OP(C_NEG)
+		i = p[1] >> 4;
+		if(p[0] == 0x81) {
+			SET_GPR(i, alu(e, 2, 0, GPR(i), 0x8000));
+		} else if(p[0] == 0xA1) {
+			SET_GPRB(i, alu(e, 2, 0, GPRB(i), 0x80));
+		} else if(p[0] == 0x91) {
+			r = ~GPR(i) & 0xFFFF;
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(r, 0x8000));
+			SET_GPR(i, r);
+		} else {
+			r = ~GPRB(i) & 0xFF;
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(r, 0x80));
+			SET_GPRB(i, r);
+		}
+		NEXT;
+
+	// mov [Rwn],mem / mov mem,[Rwn] (and movb)
+	OP(C_MOV_IM)
+		m = dadr(e, GPR(p[1] & 0xF));
+		if(p[0] == 0x84 || p[0] == 0xA4) {
+			b = dadr(e, IMM16);
+		} else {
+			b = m;
+			m = dadr(e, IMM16);
+		}
+		if(p[0] & 0x20) {
+			a = rd8(e, b);
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+			wr8(e, m, a);
+		} else {
+			a = rd16(e, b);
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+			wr16(e, m, a);
+		}
+		NEXT;
+
+	// the indirect moves, byte is nm
+	OP(C_MOV_IND)
+		{
+			unsigned rn = p[1] >> 4, rm = p[1] & 0xF, msb = (p[0] & 1) ? 0x80 : 0x8000, step = (p[0] & 1) ? 1 : 2;
+			unsigned long src, dst;
+
+			switch(p[0] & 0xFE) {
+				case 0x88:		// mov [-Rwm],Rn
+					SET_GPR(rm, GPR(rm) - step);
+					a = (step == 1) ? GPRB(rn) : GPR(rn);
+					set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, msb));
+					if(step == 1) wr8(e, dadr(e, GPR(rm)), a); else wr16(e, dadr(e, GPR(rm)), a);
+					NEXT;
+				case 0xB8:		// mov [Rwm],Rn
+					a = (step == 1) ? GPRB(rn) : GPR(rn);
+					set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, msb));
+					if(step == 1) wr8(e, dadr(e, GPR(rm)), a); else wr16(e, dadr(e, GPR(rm)), a);
+					NEXT;
+				case 0xA8:		// mov Rn,[Rwm]
+				case 0x98:		// mov Rn,[Rwm+]
+					b = GPR(rm);
+					a = (step == 1) ? rd8(e, dadr(e, b)) : rd16(e, dadr(e, b));
+					if(p[0] & 0x10) SET_GPR(rm, b + step);
+					set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, msb));
+					if(step == 1) SET_GPRB(rn, a); else SET_GPR(rn, a);
+					NEXT;
+			}
+			// mov [Rwn],[Rwm], [Rwn+],[Rwm], [Rwn],[Rwm+]
+			src = dadr(e, GPR(rm));
+			dst = dadr(e, GPR(rn));
+			a = (step == 1) ? rd8(e, src) : rd16(e, src);
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, msb));
+			if(step == 1) wr8(e, dst, a); else wr16(e, dst, a);
+			if((p[0] & 0xFE) == 0xD8) SET_GPR(rn, GPR(rn) + step);
+			if((p[0] & 0xFE) == 0xE8) SET_GPR(rm, GPR(rm) + step);
+		}
+		NEXT;
+
+	// mov [Rwm+#data16],Rn (C4, E4 movb) / mov Rn,[Rwm+#data16] (D4, F4 movb)
+	OP(C_MOV_DISP)
+		m = dadr(e, GPR(p[1] & 0xF) + IMM16);
+		i = p[1] >> 4;
+		switch(p[0]) {
+			case 0xC4:
+				a = GPR(i);
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+				wr16(e, m, a);
+				break;
+			case 0xE4:
+				a = GPRB(i);
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+				wr8(e, m, a);
+				break;
+			case 0xD4:
+				a = rd16(e, m);
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+				SET_GPR(i, a);
+				break;
+			default:
+				a = rd8(e, m);
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+				SET_GPRB(i, a);
+				break;
+		}
+		NEXT;
+
+	// movbz/movbs: Rwn,Rbm (byte is m:n), reg,mem and mem,reg
+	OP(C_MOVBX)
+		switch(p[0] & 0xF) {
+			case 0x0: a = GPRB(p[1] >> 4); break;
+			case 0x2: a = rd8(e, dadr(e, IMM16)); break;
+			default:  a = rd8(e, regb_adr(e, p[1])); break;
+		}
+		r = (p[0] & 0x10 && (a & 0x80)) ? (a | 0xFF00) : a;
+		set_flags(e, PSW_N | PSW_Z | PSW_E, ((p[0] & 0x10 && (a & 0x80)) ? PSW_N : 0) | (a ? 0 : PSW_Z) | (a == 0x80 ? PSW_E : 0));
+		switch(p[0] & 0xF) {
+			case 0x0: SET_GPR(p[1] & 0xF, r); break;
+			case 0x2: wr16(e, reg_adr(e, p[1]), r); break;
+			default:  wr16(e, dadr(e, IMM16), r); break;
+		}
+		NEXT;
+
+	OP(C_MOV_RR)
+		if(p[0] == 0xF0) {
+			a = GPR(p[1] & 0xF);
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+			SET_GPR(p[1] >> 4, a);
+		} else {
+			a = GPRB(p[1] & 0xF);
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+			SET_GPRB(p[1] >> 4, a);
+		}
+		NEXT;
+
+	// mov Rwn,#data4 (byte is #:n), movb Rbn,#data4, mov reg,#data16, movb reg,#data8
+	OP(C_MOV_RI)
+		switch(p[0]) {
+			case 0xE0:
+				a = p[1] >> 4;
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+				SET_GPR(p[1] & 0xF, a);
+				break;
+			case 0xE1:
+				a = p[1] >> 4;
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+				SET_GPRB(p[1] & 0xF, a);
+				break;
+			case 0xE6:
+				a = IMM16;
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+				wr16(e, reg_adr(e, p[1]), a);
+				break;
+			default:
+				a = p[2];
+				set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+				wr8(e, regb_adr(e, p[1]), a);
+				break;
+		}
+		NEXT;
+
+	OP(C_MOV_RM)
+		if(p[0] == 0xF2) {
+			a = rd16(e, dadr(e, IMM16));
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+			wr16(e, reg_adr(e, p[1]), a);
+		} else {
+			a = rd8(e, dadr(e, IMM16));
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+			wr8(e, regb_adr(e, p[1]), a);
+		}
+		NEXT;
+
+	OP(C_MOV_MR)
+		if(p[0] == 0xF6) {
+			a = rd16(e, reg_adr(e, p[1]));
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+			wr16(e, dadr(e, IMM16), a);
+		} else {
+			a = rd8(e, regb_adr(e, p[1]));
+			set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x80));
+			wr8(e, dadr(e, IMM16), a);
+		}
+		NEXT;
+
+	// scxt reg,#data16 / reg,mem: push reg, then load it (scxt CP switches the register bank)
+	OP(C_SCXT)
+		m = reg_adr(e, p[1]);
+		a = (p[0] == 0xC6) ? IMM16 : rd16(e, dadr(e, IMM16));
+		push(e, rd16(e, m));
+		wr16(e, m, a);
+		NEXT;
+
+	OP(C_PUSH)
+		a = rd16(e, reg_adr(e, p[1]));
+		set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+		push(e, a);
+		NEXT;
+
+	OP(C_POP)
+		a = pop(e);
+		set_flags(e, PSW_N | PSW_Z | PSW_E, nze(a, 0x8000));
+		wr16(e, reg_adr(e, p[1]), a);
+		NEXT;
+
+	// atomic/extr #n (D1), exts/extp/extsr/extpr #seg/#page or Rwm (D7/DC), bits 5-4 are n-1
+	OP(C_EXT)
+		a = ((p[1] >> 4) & 3) + 2;
+		if(p[0] == 0xD1) {
+			if((p[1] >> 6) == 2) {
+				e->ext_mode = EXT_REG;
+				e->ext_left = a;
+			}
+			NEXT;
+		}
+		op = p[1] >> 6;
+		if(p[0] == 0xD7) b = (op & 1) ? (p[2] | ((p[3] & 3) << 8)) : p[2];
+		else             b = GPR(p[1] & 0xF) & ((op & 1) ? 0x3FF : 0xFF);
+		e->ext_mode = ((op & 1) ? EXT_PAGE : EXT_SEG) | ((op & 2) ? EXT_REG : 0);
+		e->ext_val  = b;
+		e->ext_left = a;
+		NEXT;
+
+	OP(C_NOP)
+		NEXT;
+
+	// srvwdt (the B7 sub table's second entry) is harmless, trap, idle, pwrdn and srst stop the run
+	OP(C_SYS)
+		if(p[0] == 0xB7 && p[1] != 0x48) NEXT;
+		res = EMU_HALT;
+		goto done;
+
+#if !defined(__GNUC__)
+	}
+#endif
+
+done:
+	e->ms    = 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC;
+	e->insts = (res == EMU_LIMIT) ? max : n;
+	e->stop  = at;
+	e->ip    = ip;
+	e->csp   = csp;
+	e->ext_left = e->ext_mode = 0;
+	poke16(e, EMU_SPR, sp0);
+	return res;
+}
+
+/*
+ * -run <address>[,r12[,r13..]]: call a rom routine and show what it returned
+ */
+int check_run(ImageHandle *fh, char *spec)
+{
+	unsigned short args[EMU_MAX_ARGS];
+	unsigned long adr;
+	char *s, *end;
+	int nargs = 0, res, i;
+	EMU *e;
+
+	printf("\n-[ Run ROM Routine ]---------------------------------------------------------------------\n\n");
+
+	adr = strtoul(spec, &end, 0);
+	if(end == spec) {
+		printf("-run expects <address>[,r12,r13,..], not '%s'\n", spec);
+		return -1;
+	}
+	for(s=end; *s == ',' && nargs < EMU_MAX_ARGS; s=end) {
+		args[nargs] = strtoul(s+1, &end, 0);
+		if(end == s+1) break;
+		nargs++;
+	}
+	if(adr < EMU_ROM_BASE) adr += EMU_ROM_BASE;		// a file offset
+
+	e = emu_create(fh);
+	if(e == 0) {
+		printf("Failed to set up the emulator (out of memory)\n");
+		return -1;
+	}
+	if(adr - EMU_ROM_BASE >= e->rom_len) {
+		printf("0x%lx is outside the rom image\n", adr);
+		emu_free(e);
+		return -1;
+	}
+
+	printf(">>> Calling 0x%lx (file offset 0x%lx)", adr, adr - EMU_ROM_BASE);
+	for(i=0;i<nargs;i++) printf(" r%d=0x%04x", EMU_ARG_FIRST+i, args[i]);
+	printf("\n\n");
+
+	res = emu_call(e, adr, args, nargs);
+
+	printf("%s at 0x%lx after %lu instructions, %.3f ms", emu_result_name(res), e->stop, e->insts, e->ms);
+	if(e->ms > 0) printf(" (%.1f MIPS)", (double)e->insts/(e->ms*1000.0));
+	printf("\n\n");
+	printf("r4 = 0x%04x (%u)  r5:r4 = 0x%08lx\n\n", emu_reg(e, 4), emu_reg(e, 4), ((unsigned long)emu_reg(e, 5) << 16) | emu_reg(e, 4));
+	for(i=0;i<16;i++) printf("r%-2d = %04x%s", i, emu_reg(e, i), (i % 8 == 7) ? "\n" : "  ");
+	printf("MDH = %04x  MDL = %04x  PSW = %04x  DPP0-3 = %03x %03x %03x %03x\n",
+		emu_read16(e, EMU_MDH), emu_read16(e, EMU_MDL), emu_read16(e, EMU_PSW), e->dpp[0], e->dpp[1], e->dpp[2], e->dpp[3]);
+
+	emu_free(e);
+	return (res == EMU_OK) ? 0 : -1;
+}
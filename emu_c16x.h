@@ -0,0 +1,101 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _EMU_C16X_SUPPORT_H
+#define _EMU_C16X_SUPPORT_H
+#include "utils.h"
+#include "inst_c16x.h"
+
+// C167 interpreter, runs a rom routine on the host so a value can be taken from the ECU's
+// own code (a map lookup, a checksum) rather than from our reimplementation of it.
+//
+// The 24 bit address space is one flat 16MByte block with the image copied in at
+// EMU_ROM_BASE, its first 32KBytes also at 0. The GPRs live in internal ram at CP, the SFRs at 0xFE00-0xFFFF as on the
+// chip, data addresses are paged by DPP0-DPP3 (or extp/exts) and the system stack is at SP.
+// Peripherals, interrupts and the watchdog are not modelled: an SFR reads back what was
+// last written to it, so a routine polling hardware runs into the instruction limit.
+//
+// Instruction lengths and undefined opcodes come from inst_set[] (each rom word is checked
+// with c167x_decode() the first time it is executed), execution is threaded: every handler
+// fetches the next instruction and jumps straight to its handler (switch without gcc).
+
+#define EMU_MEM_SIZE		0x1000000		// 24 bit physical address space
+#define EMU_ROM_BASE		0x800000		// where the image is seen, as CAT_ROM_BASE
+#define EMU_LOW_ROM			0x8000			// the boot area is also seen at segment 0 ('calls 0,..')
+#define EMU_CP				0xFC00			// r0-r15
+#define EMU_SP				0xFC00			// system stack grows down from here
+#define EMU_USP				0xB000			// r0, the compiler's user stack (a near address)
+#define EMU_EXIT_IP			0xFFFE			// return address pushed by emu_call()
+#define EMU_MAX_INSTS		50000000UL
+#define EMU_ARG_FIRST		12				// r12-r15 carry the arguments, r4(/r5) the result
+#define EMU_MAX_ARGS		4
+
+// SFRs
+#define EMU_DPP0			0xFE00
+#define EMU_CSP				0xFE08
+#define EMU_MDH				0xFE0C
+#define EMU_MDL				0xFE0E
+#define EMU_CPR				0xFE10
+#define EMU_SPR				0xFE12
+#define EMU_PSW				0xFF10
+#define EMU_ZEROS			0xFF1C
+#define EMU_ONES			0xFF1E
+
+// emu_call() results
+#define EMU_OK				0				// returned to the caller
+#define EMU_LIMIT			1				// instruction limit reached
+#define EMU_INVALID			2				// undefined opcode
+#define EMU_FAULT			3				// jumped outside the rom image
+#define EMU_HALT			4				// trap, idle, pwrdn or srst
+
+typedef struct EMU {
+	uint8_t       *mem;
+	uint8_t       *code;				// per rom word: 0 not seen yet, 1 valid instruction, 2 undefined
+	unsigned long  rom_len;
+	unsigned long  max_insts;
+	unsigned long  insts;				// executed by the last emu_call()
+	unsigned long  stop;				// physical address the last emu_call() stopped at
+	double         ms;
+	unsigned short dpp[4];				// DPP0-DPP3 page numbers (copies of the SFRs)
+	unsigned short cp;					// copy of CP
+	unsigned short ip, csp;
+	unsigned char  ext_left;			// instructions still covered by an ext prefix
+	unsigned char  ext_mode;
+	unsigned short ext_val;
+	unsigned char  len[256];			// instruction length by opcode, from inst_set[]
+	unsigned char  cls[256];			// handler by opcode
+	uint32_t       cc[16];				// bit (psw & 0x1f) is set if condition code cc is true
+} EMU;
+
+EMU  *emu_create(ImageHandle *fh);
+void  emu_free(EMU *e);
+void  emu_reset(EMU *e);
+int   emu_call(EMU *e, unsigned long adr, const unsigned short *args, int nargs);
+
+unsigned short emu_reg(EMU *e, int n);
+void  emu_set_reg(EMU *e, int n, unsigned short val);
+unsigned short emu_read16(EMU *e, unsigned long adr);
+void  emu_write16(EMU *e, unsigned long adr, unsigned short val);
+const char *emu_result_name(int res);
+
+int   check_run(ImageHandle *fh, char *spec);
+
+#endif
@@ -20,6 +20,9 @@
    IN THE SOFTWARE.
 */
 #include "eskonf.h"
+#include "export.h"
+#include "dpptrack.h"
+#include "labels.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -137,15 +140,15 @@ void print_eskonf_byte( ESKCONF_TABLE *p, int idx, unsigned char ch)
 	dump_bits(s_bin, ch, 8, 5);
 	
 	
-	printf("          | %-6.6s %-6.6s %-6.6s %-6.6s\n", p->s1, p->s2, p->s3, p->s4);
-	printf("[%d] 0x%2.2x  | %s\n", idx, ch, s_bin);
-	printf("          | %-6.6s %-6.6s %-6.6s %-6.6s\n", p->s1_pin, p->s2_pin, p->s3_pin, p->s4_pin);
-	printf("          +----------------------------------------------------------------------\n");
-	printf("          | %s   %s\n", p->s1_pin, p->s1_desc);
-	printf("          | %s   %s\n", p->s2_pin, p->s2_desc);
-	printf("          | %s   %s\n", p->s3_pin, p->s3_desc);
-	printf("          | %s   %s\n", p->s4_pin, p->s4_desc);
-	printf("----------+----------------------------------------------------------------------\n");
+	con_printf("          | %-6.6s %-6.6s %-6.6s %-6.6s\n", p->s1, p->s2, p->s3, p->s4);
+	con_printf("[%d] 0x%2.2x  | %s\n", idx, ch, s_bin);
+	con_printf("          | %-6.6s %-6.6s %-6.6s %-6.6s\n", p->s1_pin, p->s2_pin, p->s3_pin, p->s4_pin);
+	con_printf("          +----------------------------------------------------------------------\n");
+	con_printf("          | %s   %s\n", p->s1_pin, p->s1_desc);
+	con_printf("          | %s   %s\n", p->s2_pin, p->s2_desc);
+	con_printf("          | %s   %s\n", p->s3_pin, p->s3_desc);
+	con_printf("          | %s   %s\n", p->s4_pin, p->s4_desc);
+	con_printf("----------+----------------------------------------------------------------------\n");
 }
 
 int check_eskonf(ImageHandle *fh, int skip)
@@ -166,73 +169,79 @@ int check_eskonf(ImageHandle *fh, int skip)
 	 */
 	if(skip == 0) return found;		
 
-	printf("\n-[ ESKONF Configuration of power stage (actuators) ]-------------------------------------------\n\n");
-	printf(">>> Scanning for ESKONF Lookup code sequence... \n");
+	con_printf("\n-[ ESKONF Configuration of power stage (actuators) ]-------------------------------------------\n\n");
+	con_printf(">>> Scanning for ESKONF Lookup code sequence... \n");
 	byte_offset    = search_offset( rom_load_addr, fh->len, (unsigned char *)&needle_ESKONF, (unsigned char *)&mask_ESKONF, needle_ESKONF_len);
 	if(byte_offset != NULL) 
 	{
 		addr = rom_load_addr + byte_offset;
 		
-		printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
-		// try to determine information from rom scan
-		seg           = dpp1_value-1;	// get16((unsigned char *)addr+6);
+		con_printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
 
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(byte_offset, rom_load_addr + byte_offset, needle_ESKONF_len+16); }
 
 		val            = get16((unsigned char *)addr+10+0);		// ESKONF_R
+		seg            = dpp_seg_at(fh, (unsigned char *)addr+10);	// page the code really uses for it
 		eskonf_r_adr   = seg*SEGMENT_SIZE;
 		eskonf_r_adr  += val;
 		val_r_adr      = (unsigned long)eskonf_r_adr;			// derive phyiscal address from offset and segment
 		val_r_adr     &= ~(ROM_1MB_MASK);						// convert physical address to a rom file offset we can easily work with.
 
 		val            = get16((unsigned char *)addr+28+0);		// ESKONF_L
+		seg            = dpp_seg_at(fh, (unsigned char *)addr+28);
 		eskonf_l_adr   = seg*SEGMENT_SIZE;
 		eskonf_l_adr  += val;
 		val_l_adr      = (unsigned long)eskonf_l_adr;			// derive phyiscal address from offset and segment
 		val_l_adr     &= ~(ROM_1MB_MASK);						// convert physical address to a rom file offset we can easily work with.
+		label_symbol(byte_offset, SYM_CODE, "ESKONF lookup");
+		label_symbol(val_r_adr, SYM_DATA, "ESKONF_R");
+		label_symbol(val_l_adr, SYM_DATA, "ESKONF_L");
 
-		printf("\n");
+		con_printf("\n");
 
-		printf(" 1. Configuration of output stages\n");
-		printf(" =================================\n");
-		printf(" The configuration is made with the Label ESKONF_R (right bank) & ESKONF_L (left bank), each by 7 bytes.\n\n");
+		con_printf(" 1. Configuration of output stages\n");
+		con_printf(" =================================\n");
+		con_printf(" The configuration is made with the Label ESKONF_R (right bank) & ESKONF_L (left bank), each by 7 bytes.\n\n");
 		
-		printf(" Every byte is standing for 4 output stages. Therefore every output stage has got 2 consecutive\n");
-		printf(" configuration Bits.\n\n");
+		con_printf(" Every byte is standing for 4 output stages. Therefore every output stage has got 2 consecutive\n");
+		con_printf(" configuration Bits.\n\n");
 
-		printf(" Enable of the output stages diagnosis\n");
-		printf(" -------------------------------------\n");
-		printf(" With the configurations-Bytes in ESKONF the functions have to be set active / inactive depending\n");
-		printf(" on the available components in the car. At the same time with the 2 Bits the function of the \n");
-		printf(" diagnosis is set.\n\n");
+		con_printf(" Enable of the output stages diagnosis\n");
+		con_printf(" -------------------------------------\n");
+		con_printf(" With the configurations-Bytes in ESKONF the functions have to be set active / inactive depending\n");
+		con_printf(" on the available components in the car. At the same time with the 2 Bits the function of the \n");
+		con_printf(" diagnosis is set.\n\n");
 		
-		printf(" Assignment of the Bit pattern:\n");
-		printf(" ------------------------------\n");
-		printf(" 00  Diagnosis active with OBDII-malfunction storage with test of healing\n");
-		printf(" 01  Diagnosis active without OBDII-malfunction storage with test of healing\n");
-		printf(" 10  Diagnosis active without OBDII-fault memory without test of healing (EKP)\n");
-		printf(" 11  Diagnosis not active\n\n");
+		con_printf(" Assignment of the Bit pattern:\n");
+		con_printf(" ------------------------------\n");
+		con_printf(" 00  Diagnosis active with OBDII-malfunction storage with test of healing\n");
+		con_printf(" 01  Diagnosis active without OBDII-malfunction storage with test of healing\n");
+		con_printf(" 10  Diagnosis active without OBDII-fault memory without test of healing (EKP)\n");
+		con_printf(" 11  Diagnosis not active\n\n");
 
-		printf("\nESKONF_L @ ADR:%#x (offset %#x) - Left Bank Configuration\n", eskonf_l_adr, val_l_adr);
-		printf("----------+----------------------------------------------------------------------\n");
-		printf("[i] Hex   |           Bit\n");
-		printf("          | 76     54     32     10\n");
-		printf("----------+----------------------------------------------------------------------\n");
+		con_printf("\nESKONF_L @ ADR:%#x (offset %#x) - Left Bank Configuration\n", eskonf_l_adr, val_l_adr);
+		con_printf("----------+----------------------------------------------------------------------\n");
+		con_printf("[i] Hex   |           Bit\n");
+		con_printf("          | 76     54     32     10\n");
+		con_printf("----------+----------------------------------------------------------------------\n");
 		for(i=0;i<7;i++) { 
 			print_eskonf_byte( &left[i], i, *(unsigned char *)(rom_load_addr + val_l_adr + i));
 		}
 
 
-		printf("\n\nESKONF_R @ ADR:%#x (offset %#x) - Right Bank Configuration\n", eskonf_r_adr, val_r_adr);
-		printf("----------+----------------------------------------------------------------------\n");
-		printf("[i] Hex   |           Bit\n");
-		printf("          | 76     54     32     10\n");
-		printf("----------+----------------------------------------------------------------------\n");
+		con_printf("\n\nESKONF_R @ ADR:%#x (offset %#x) - Right Bank Configuration\n", eskonf_r_adr, val_r_adr);
+		con_printf("----------+----------------------------------------------------------------------\n");
+		con_printf("[i] Hex   |           Bit\n");
+		con_printf("          | 76     54     32     10\n");
+		con_printf("----------+----------------------------------------------------------------------\n");
 		for(i=0;i<7;i++) { 
 			print_eskonf_byte( &right[i], i, *(unsigned char *)(rom_load_addr + val_r_adr + i));
 		}
 
+		export_array("ESKONF_L", "Output stage configuration, left bank",  (unsigned long)eskonf_l_adr, (const unsigned char *)rom_load_addr + val_l_adr, 7, 1);
+		export_array("ESKONF_R", "Output stage configuration, right bank", (unsigned long)eskonf_r_adr, (const unsigned char *)rom_load_addr + val_r_adr, 7, 1);
+
 		// If Air Injection is enabled its going to be a non European car (e.g. Federal spec US car)
 		{
 			char s_bin[8*8];
@@ -244,19 +253,19 @@ int check_eskonf(ImageHandle *fh, int skip)
 			if(s_bin[45] == '1') { air |=0x10; } // check if bit 45 is set - ESKONF_R array [5x8=40 + 5)
 
 			if(air == 0x11) { 
-				printf("Air Injection Diagnostics are off: This is probably a European spec car\n"); 			
+				con_printf("Air Injection Diagnostics are off: This is probably a European spec car\n"); 			
 			} else { 
-				printf("Air Injection Diagnostics are on:  This is probably a US spec (Federal) car.\n"); 
+				con_printf("Air Injection Diagnostics are on:  This is probably a US spec (Federal) car.\n"); 
 			}
 		}
 
 
 
 		
-		printf("\n");
+		con_printf("\n");
 
 	} else {
-		printf("Not found\n");
+		con_printf("Not found\n");
 	}
 
 	return found;
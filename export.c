@@ -0,0 +1,407 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include <math.h>
+#include "export.h"
+#include "outbuf.h"
+
+static OUTBUF export_ob;
+static int    export_format  = EXPORT_NONE;
+static int    export_objects = 0;
+
+static const char *layout_names[] = { "header", "interleaved", "split" };
+
+int export_parse_format(const char *name)
+{
+	if(name == 0) return EXPORT_NONE;
+	if(strcmp(name, "json") == 0) return EXPORT_JSON;
+	if(strcmp(name, "csv")  == 0) return EXPORT_CSV;
+	return EXPORT_NONE;
+}
+
+/*
+ * Open the export file ("-" for stdout) and write the document header.
+ *
+ * returns 0 on success, -1 if the file couldn't be created
+ */
+int export_open(const char *filename, int format, const char *romfile)
+{
+	FILE *fp = stdout;
+
+	if(format != EXPORT_JSON && format != EXPORT_CSV) return -1;
+	if(strcmp(filename, "-") != 0) {
+		fp = fopen(filename, "wb");
+		if(fp == 0) {
+			printf("Failed to create export file '%s'\n", filename);
+			return -1;
+		}
+	}
+	memset(&export_ob, 0, sizeof(export_ob));
+	export_ob.fp   = fp;
+	export_format  = format;
+	export_objects = 0;
+
+	if(format == EXPORT_JSON) {
+		ob_puts(&export_ob, "{\"romfile\":\"");
+		for(; *romfile; romfile++) {
+			if(*romfile == '"' || *romfile == '\\') ob_putc(&export_ob, '\\');
+			ob_putc(&export_ob, *romfile);
+		}
+		ob_puts(&export_ob, "\",\"objects\":[");
+	} else {
+		ob_puts(&export_ob, EXPORT_CSV_HEADER);
+	}
+	ob_flush(&export_ob);
+	return 0;
+}
+
+void export_close(void)
+{
+	if(export_format == EXPORT_NONE) return;
+	if(export_format == EXPORT_JSON) {
+		ob_puts(&export_ob, "\n]}\n");
+	}
+	ob_free(&export_ob);
+	if(export_ob.fp != stdout) {
+		fclose(export_ob.fp);
+	} else {
+		fflush(stdout);
+	}
+	export_format = EXPORT_NONE;
+}
+
+int export_active(void)
+{
+	return export_format != EXPORT_NONE;
+}
+
+// quoted string, escaped for the current format
+static void put_str(const char *s)
+{
+	ob_putc(&export_ob, '"');
+	for(; s && *s; s++) {
+		if(export_format == EXPORT_JSON) {
+			if(*s == '"' || *s == '\\') {
+				ob_putc(&export_ob, '\\');
+			} else if((unsigned char)*s < 0x20) {
+				ob_printf(&export_ob, "\\u%04x", (unsigned char)*s);
+				continue;
+			}
+		} else if(*s == '"') {
+			ob_putc(&export_ob, '"');
+		}
+		ob_putc(&export_ob, *s);
+	}
+	ob_putc(&export_ob, '"');
+}
+
+static void put_num(double v)
+{
+	if(isfinite(v)) {
+		ob_printf(&export_ob, "%.10g", v);
+	} else if(export_format == EXPORT_JSON) {
+		ob_puts(&export_ob, "null");
+	}
+}
+
+static void put_adr(unsigned long adr)
+{
+	if(export_format == EXPORT_JSON) {
+		ob_printf(&export_ob, "\"0x%lx\"", adr);
+	} else {
+		ob_printf(&export_ob, "0x%lx", adr);
+	}
+}
+
+// json: start a new object with its kind/name/desc members
+static void json_begin(const char *kind, const char *name, const char *desc)
+{
+	ob_puts(&export_ob, export_objects++ ? ",\n{\"kind\":\"" : "\n{\"kind\":\"");
+	ob_puts(&export_ob, kind);
+	ob_puts(&export_ob, "\",\"name\":");
+	put_str(name);
+	if(desc != 0) {
+		ob_puts(&export_ob, ",\"desc\":");
+		put_str(desc);
+	}
+}
+
+static void json_end(void)
+{
+	ob_puts(&export_ob, "}");
+	ob_flush(&export_ob);
+}
+
+// csv: kind,name,desc,field,x,y,address,raw,value,unit,conv_name
+static void csv_row(const char *kind, const char *name, const char *desc, const char *field, int x, int y,
+					unsigned long adr, int has_raw, unsigned long raw, int has_value, double value, const char *svalue,
+					const char *unit, const char *conv_name)
+{
+	ob_puts(&export_ob, kind);
+	ob_putc(&export_ob, ',');
+	put_str(name);
+	ob_putc(&export_ob, ',');
+	put_str(desc);
+	ob_putc(&export_ob, ',');
+	put_str(field);
+	ob_putc(&export_ob, ',');
+	if(x >= 0) ob_fmt_int(&export_ob, "%d", x);
+	ob_putc(&export_ob, ',');
+	if(y >= 0) ob_fmt_int(&export_ob, "%d", y);
+	ob_putc(&export_ob, ',');
+	put_adr(adr);
+	ob_putc(&export_ob, ',');
+	if(has_raw) ob_printf(&export_ob, "%lu", raw);
+	ob_putc(&export_ob, ',');
+	if(svalue != 0) put_str(svalue);
+	else if(has_value) put_num(value);
+	ob_putc(&export_ob, ',');
+	put_str(unit);
+	ob_putc(&export_ob, ',');
+	put_str(conv_name);
+	ob_putc(&export_ob, '\n');
+}
+
+// json: "key":{"field":..,"unit":..,"conv_name":..,"address":..,"raw":[..],"value":[..]}
+static void json_axis(const char *key, ENTRY_DEF *e, unsigned long adr, uint16_t *raw, double *phy, int num, int cols)
+{
+	int i;
+
+	ob_printf(&export_ob, ",\"%s\":{\"field\":", key);
+	put_str(e->field_name);
+	ob_puts(&export_ob, ",\"unit\":");
+	put_str(e->desc);
+	ob_puts(&export_ob, ",\"conv_name\":");
+	put_str(e->conv_name);
+	ob_puts(&export_ob, ",\"address\":");
+	put_adr(adr);
+
+	// cols > 0 splits the values into rows of that many columns
+	ob_puts(&export_ob, ",\"raw\":[");
+	for(i=0;i<num;i++) {
+		if(cols > 0 && i % cols == 0) ob_puts(&export_ob, i ? "],[" : "[");
+		else if(i) ob_putc(&export_ob, ',');
+		ob_fmt_int(&export_ob, "%u", raw[i]);
+	}
+	ob_puts(&export_ob, (cols > 0 && num > 0) ? "]],\"value\":[" : "],\"value\":[");
+	for(i=0;i<num;i++) {
+		if(cols > 0 && i % cols == 0) ob_puts(&export_ob, i ? "],[" : "[");
+		else if(i) ob_putc(&export_ob, ',');
+		put_num(phy[i]);
+	}
+	ob_puts(&export_ob, (cols > 0 && num > 0) ? "]]}" : "]}");
+}
+
+/*
+ * Export a decoded map (axes and cells, raw and converted)
+ */
+void export_map(MAP_DATA *m)
+{
+	TABLE_DEF *td = m->td;
+	unsigned long seg_start = 0x800000;
+	int i, x, y;
+
+	if(export_format == EXPORT_NONE) return;
+
+	if(export_format == EXPORT_JSON) {
+		json_begin("map", td->table_name, td->table_desc);
+		ob_puts(&export_ob, ",\"address\":");
+		put_adr(m->x_num_adr + seg_start);
+		ob_printf(&export_ob, ",\"layout\":\"%s\",\"x_num\":%d,\"y_num\":%d", layout_names[m->layout], m->x_num, m->y_num);
+		json_axis("x_axis", &td->x_axis, m->x_axis_adr + seg_start, m->x_raw, m->x_phy, m->x_num, 0);
+		if(m->y_num > 0) {
+			json_axis("y_axis", &td->y_axis, m->y_axis_adr + seg_start, m->y_raw, m->y_phy, m->y_num, 0);
+		}
+		json_axis("cells", &td->cell, map_cell_adr(m, 0, 0) + seg_start, m->cell_raw, m->cell_phy, m->cell_num, m->y_num > 0 ? m->x_num : 0);
+		json_end();
+		return;
+	}
+
+	for(i=0;i<m->x_num;i++) {
+		csv_row("map", td->table_name, td->table_desc, "x_axis", i, -1, m->x_axis_adr + i*td->x_axis_nwidth + seg_start,
+				1, m->x_raw[i], 1, m->x_phy[i], 0, td->x_axis.desc, td->x_axis.conv_name);
+	}
+	for(i=0;i<m->y_num;i++) {
+		csv_row("map", td->table_name, td->table_desc, "y_axis", -1, i, m->y_axis_adr + i*td->y_axis_nwidth + seg_start,
+				1, m->y_raw[i], 1, m->y_phy[i], 0, td->y_axis.desc, td->y_axis.conv_name);
+	}
+	if(m->y_num == 0) {
+		for(x=0;x<m->cell_num;x++) {
+			csv_row("map", td->table_name, td->table_desc, "cell", x, -1, map_cell_adr(m, x, 0) + seg_start,
+					1, m->cell_raw[x], 1, m->cell_phy[x], 0, td->cell.desc, td->cell.conv_name);
+		}
+	} else {
+		for(y=0;y<m->y_num;y++) {
+			for(x=0;x<m->x_num;x++) {
+				csv_row("map", td->table_name, td->table_desc, "cell", x, y, map_cell_adr(m, x, y) + seg_start,
+						1, MAP_CELL_RAW(m, x, y), 1, MAP_CELL_PHY(m, x, y), 0, td->cell.desc, td->cell.conv_name);
+			}
+		}
+	}
+	ob_flush(&export_ob);
+}
+
+/*
+ * Export a single converted value (eg. NMAX, KRKTE)
+ */
+void export_scalar(const char *name, const char *desc, unsigned long adr, unsigned long raw, double value, const char *unit)
+{
+	if(export_format == EXPORT_NONE) return;
+
+	if(export_format == EXPORT_JSON) {
+		json_begin("scalar", name, desc);
+		ob_puts(&export_ob, ",\"address\":");
+		put_adr(adr);
+		ob_printf(&export_ob, ",\"raw\":%lu,\"value\":", raw);
+		put_num(value);
+		ob_puts(&export_ob, ",\"unit\":");
+		put_str(unit);
+		json_end();
+		return;
+	}
+	csv_row("scalar", name, desc, "", -1, -1, adr, 1, raw, 1, value, 0, unit, "");
+	ob_flush(&export_ob);
+}
+
+/*
+ * Export an unconverted little endian array of 1, 2 or 4 byte values (eg. MLHFM, ESKONF)
+ */
+void export_array(const char *name, const char *desc, unsigned long adr, const unsigned char *data, int num, int nwidth)
+{
+	unsigned long val;
+	int i;
+
+	if(export_format == EXPORT_NONE) return;
+
+	if(export_format == EXPORT_JSON) {
+		json_begin("array", name, desc);
+		ob_puts(&export_ob, ",\"address\":");
+		put_adr(adr);
+		ob_printf(&export_ob, ",\"width\":%d,\"raw\":[", nwidth);
+	}
+	for(i=0;i<num;i++) {
+		val = get_nwidth((unsigned char *)data + i*nwidth, nwidth);
+		if(export_format == EXPORT_JSON) {
+			if(i) ob_putc(&export_ob, ',');
+			ob_printf(&export_ob, "%lu", val);
+		} else {
+			csv_row("array", name, desc, "", i, -1, adr + i*nwidth, 1, val, 0, 0, 0, "", "");
+		}
+	}
+	if(export_format == EXPORT_JSON) {
+		ob_puts(&export_ob, "]");
+		json_end();
+	} else {
+		ob_flush(&export_ob);
+	}
+}
+
+/*
+ * Export a codeword byte and its named bits
+ */
+void export_codeword(BITFMT_TABLE *p, unsigned long adr, unsigned char value)
+{
+	// the display template labels bit 0 with b7 (see dump_bitfmt_table), so index by bit number here
+	const char *bits[8] = { p->b7, p->b6, p->b5, p->b4, p->b3, p->b2, p->b1, p->b0 };
+	char name[32];
+	int i, n = 0;
+
+	if(export_format == EXPORT_NONE) return;
+
+	// template names carry a trailing ':' for display
+	snprintf(name, sizeof(name), "%s", p->name);
+	if(strlen(name) && name[strlen(name)-1] == ':') name[strlen(name)-1] = 0;
+
+	if(export_format == EXPORT_JSON) {
+		json_begin("codeword", name, 0);
+		ob_puts(&export_ob, ",\"address\":");
+		put_adr(adr);
+		ob_printf(&export_ob, ",\"raw\":%u,\"bits\":{", value);
+		for(i=0;i<8;i++) {
+			if(bits[i] == 0 || bits[i][0] == ' ' || bits[i][0] == 0) continue;
+			if(n++) ob_putc(&export_ob, ',');
+			put_str(bits[i]);
+			ob_printf(&export_ob, ":%d", (value >> i) & 1);
+		}
+		ob_puts(&export_ob, "}");
+		json_end();
+		return;
+	}
+	csv_row("codeword", name, "", "", -1, -1, adr, 1, value, 0, 0, 0, "", "");
+	for(i=0;i<8;i++) {
+		if(bits[i] == 0 || bits[i][0] == ' ' || bits[i][0] == 0) continue;
+		csv_row("codeword", name, "", bits[i], i, -1, adr, 0, 0, 1, (value >> i) & 1, 0, "", "");
+	}
+	ob_flush(&export_ob);
+}
+
+/*
+ * Export a string (rom information table, EPK)
+ */
+void export_string(const char *name, const char *desc, unsigned long adr, const char *value)
+{
+	if(export_format == EXPORT_NONE) return;
+
+	if(export_format == EXPORT_JSON) {
+		json_begin("string", name, desc);
+		ob_puts(&export_ob, ",\"address\":");
+		put_adr(adr);
+		ob_puts(&export_ob, ",\"value\":");
+		put_str(value);
+		json_end();
+		return;
+	}
+	csv_row("string", name, desc, "", -1, -1, adr, 0, 0, 0, 0, value, "", "");
+	ob_flush(&export_ob);
+}
+
+/*
+ * Export main and multipoint checksum status
+ */
+void export_checksums(CHECKSUM_REPORT *r)
+{
+	const char *main_status = r->main_found ? (r->main_ok ? "OK" : "BAD") : "NOTFOUND";
+	const char *mp_status   = r->mp_found ? (r->mp_fail ? "BAD" : "OK") : "NOTFOUND";
+
+	if(export_format == EXPORT_NONE) return;
+
+	if(export_format == EXPORT_JSON) {
+		json_begin("checksum", "main", 0);
+		ob_printf(&export_ob, ",\"status\":\"%s\",\"regions\":%d,\"calc\":\"0x%-8.8x\",\"stored\":\"0x%-8.8x\",\"stored_comp\":\"0x%-8.8x\"",
+			main_status, r->main_regions, r->main_calc, r->main_stored, r->main_stored_comp);
+		json_end();
+		json_begin("checksum", "multipoint", 0);
+		ob_printf(&export_ob, ",\"status\":\"%s\",\"entries\":%d,\"pass\":%d,\"fail\":%d",
+			mp_status, r->mp_entries, r->mp_pass, r->mp_fail);
+		json_end();
+		return;
+	}
+	csv_row("checksum", "main",       "", "status",      -1, -1, 0, 0, 0,                   0, 0, main_status, "", "");
+	csv_row("checksum", "main",       "", "regions",     -1, -1, 0, 1, r->main_regions,     0, 0, 0,           "", "");
+	csv_row("checksum", "main",       "", "calc",        -1, -1, 0, 1, r->main_calc,        0, 0, 0,           "", "");
+	csv_row("checksum", "main",       "", "stored",      -1, -1, 0, 1, r->main_stored,      0, 0, 0,           "", "");
+	csv_row("checksum", "main",       "", "stored_comp", -1, -1, 0, 1, r->main_stored_comp, 0, 0, 0,           "", "");
+	csv_row("checksum", "multipoint", "", "status",      -1, -1, 0, 0, 0,                   0, 0, mp_status,   "", "");
+	csv_row("checksum", "multipoint", "", "entries",     -1, -1, 0, 1, r->mp_entries,       0, 0, 0,           "", "");
+	csv_row("checksum", "multipoint", "", "pass",        -1, -1, 0, 1, r->mp_pass,          0, 0, 0,           "", "");
+	csv_row("checksum", "multipoint", "", "fail",        -1, -1, 0, 1, r->mp_fail,          0, 0, 0,           "", "");
+	ob_flush(&export_ob);
+}
@@ -0,0 +1,52 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _EXPORT_SUPPORT_H
+#define _EXPORT_SUPPORT_H
+#include "utils.h"
+#include "show_tables.h"
+#include "fixsums.h"
+
+#define EXPORT_NONE		0
+#define EXPORT_JSON		1
+#define EXPORT_CSV		2
+
+// Machine readable export (-export json|csv). Every decoded object is written
+// and flushed as soon as it is found so the document never sits in memory.
+//
+// json: {"romfile":"...","format":1,"objects":[ {..one object per line..} ]}
+// csv:  one row per value, see EXPORT_CSV_HEADER
+
+#define EXPORT_CSV_HEADER	"kind,name,desc,field,x,y,address,raw,value,unit,conv_name\n"
+
+int  export_parse_format(const char *name);
+int  export_open(const char *filename, int format, const char *romfile);
+void export_close(void);
+int  export_active(void);
+
+void export_map(MAP_DATA *m);
+void export_scalar(const char *name, const char *desc, unsigned long adr, unsigned long raw, double value, const char *unit);
+void export_array(const char *name, const char *desc, unsigned long adr, const unsigned char *data, int num, int nwidth);
+void export_codeword(BITFMT_TABLE *p, unsigned long adr, unsigned char value);
+void export_string(const char *name, const char *desc, unsigned long adr, const char *value);
+void export_checksums(CHECKSUM_REPORT *r);
+
+#endif
@@ -21,6 +21,7 @@
 */
 #include "find_dppx.h"
 #include "needles.h"
+#include "labels.h"
 
 extern unsigned dpp0_value;
 extern unsigned dpp1_value;
@@ -48,6 +49,7 @@ int check_dppx(ImageHandle *fh, int skip)
 
 	} else {
 		printf("\nmain rom dppX byte sequence #1 found at offset=0x%x.\n",(int)(addr-rom_load_addr) );
+		label_symbol(addr-rom_load_addr, SYM_CODE, "dpp setup");
 		// do the work of dppx extraction...
 		dpp0_value = extract_dppx(addr,0);
 		dpp1_value = extract_dppx(addr,1);
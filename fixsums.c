@@ -22,6 +22,7 @@
 #include "fixsums.h"
 #include "needles.h"
 #include "utils.h"
+#include "labels.h"
 
 extern int correct_checksums;	// 0 or 1
 extern int force_write;			// 0 or 1
@@ -509,3 +510,260 @@ int fix_checksums(ImageHandle *fh, unsigned char *addr, char *filename_rom, unsi
 		return 0;
 }
 
+
+/*
+ * translate a seg:val pair taken from rom machine code (plus a table index) into a rom file offset.
+ * returns -1 if the resulting 'size' bytes would fall outside the image
+ */
+static long rom_offset(ImageHandle *fh, unsigned char *val_addr, unsigned char *seg_addr, long table_index, int size)
+{
+	unsigned long offset;
+
+	offset  = ((unsigned long)get16(seg_addr)*SEGMENT_SIZE + get16(val_addr)) & ~(ROM_1MB_MASK);
+	offset += table_index;
+	if(offset + size > fh->len) return -1;
+	return (long)offset;
+}
+
+/* range check a start/end block pair as used by CalcChecksumBlk() */
+static int block_in_image(ImageHandle *fh, unsigned long start, unsigned long end)
+{
+	return (start <= end && end/2 < fh->len/2);
+}
+
+/*
+ * Silent version of the fix_checksums() analysis, nothing is printed and the image isn't modified.
+ * Each block is added to the address labels (see labels.h).
+ *
+ * returns 0
+ */
+int verify_checksums(ImageHandle *fh, CHECKSUM_REPORT *rep)
+{
+	unsigned char *rom = fh->d.u8;
+	unsigned char *addr;
+	unsigned char *seg_addr = 0, *lo_addr = 0, *hi_addr;
+	uint32_t sum, stored;
+	unsigned long start_addr, end_addr;
+	long off_lo, off_hi, off;
+	int num_entries = 0;
+	int i, skip_factor = 0, lo_32bit = 0;
+
+	memset(rep, 0, sizeof(*rep));
+
+	//-[ Main rom : number of regions ]-------------------------------------------------------------
+	addr = search( fh, (unsigned char *)&needle_2b, (unsigned char *)&mask_2b, needle_2b_len, 0 );
+	if(addr != NULL) {
+		label_symbol(addr-rom, SYM_CODE, "main rom region count");
+		switch(*(addr+27)) {
+			case 0xA2:	num_entries = 1;	break;
+			case 0xA4:	num_entries = 2;	break;
+			case 0xA6:	num_entries = 3;	break;
+			default:	num_entries = 0;	break;
+		}
+	}
+
+	//-[ Main rom : start/end regions ]-------------------------------------------------------------
+	addr = search( fh, (unsigned char *)&needle_2, (unsigned char *)&mask_2, needle_2_len, 0 );
+	if(addr != NULL && num_entries > 0) {
+		rep->main_found = 1;
+		label_symbol(addr-rom, SYM_CODE, "main rom regions");
+		for(i=0; i < num_entries; i++)
+		{
+			off_lo = rom_offset(fh, addr+18, addr+14, i*8, 2);
+			off_hi = rom_offset(fh, addr+22, addr+14, i*8, 2);
+			if(off_lo < 0 || off_hi < 0) { rep->main_found = 0; break; }
+			if(i == 0) label_symbol(off_lo, SYM_DATA, "main rom region table");
+			start_addr  = (unsigned long)(get16(rom+off_hi) << 16 | get16(rom+off_lo));
+			start_addr &= ~(ROM_1MB_MASK);
+
+			off_lo = rom_offset(fh, addr+18+26, addr+14, i*8, 2);
+			off_hi = rom_offset(fh, addr+22+26, addr+14, i*8, 2);
+			if(off_lo < 0 || off_hi < 0) { rep->main_found = 0; break; }
+			end_addr    = (unsigned long)(get16(rom+off_hi) << 16 | get16(rom+off_lo));
+			end_addr   &= ~(ROM_1MB_MASK);
+
+			if(!block_in_image(fh, start_addr, end_addr)) { rep->main_found = 0; break; }
+			rep->main_calc += CalcChecksumBlk(fh, start_addr, end_addr);
+			label_add(start_addr, (end_addr|1)+1, LBL_BLOCK, "main rom region", i+1, 0, 0);
+			rep->main_regions++;
+		}
+	}
+
+	//-[ Main rom : stored checksums ]--------------------------------------------------------------
+	if(rep->main_found == 1) {
+		rep->main_found = 0;
+		addr = search( fh, (unsigned char *)&needle_3, (unsigned char *)&mask_3, needle_3_len, 0 );
+		if(addr != NULL) {
+			off = rom_offset(fh, addr+14, addr+10, 0, 8);
+			label_symbol(addr-rom, SYM_CODE, "main rom checksum");
+			if(off >= 0) {
+				label_symbol(off, SYM_DATA, "main rom stored checksum");
+				rep->main_stored      = get32(rom+off);
+				rep->main_stored_comp = get32(rom+off+4);
+				rep->main_found       = 1;
+			}
+		} else {
+			addr = search( fh, (unsigned char *)&needle_3b, (unsigned char *)&mask_3b, needle_3b_len, 0 );
+			if(addr != NULL) {
+				off_lo = rom_offset(fh, addr+40, addr+36, 0, 8);
+				off_hi = rom_offset(fh, addr+44, addr+36, 0, 8);
+				label_symbol(addr-rom, SYM_CODE, "main rom checksum");
+				if(off_lo >= 0 && off_hi >= 0) {
+					label_symbol(off_lo, SYM_DATA, "main rom stored checksum");
+					rep->main_stored      = (uint32_t)(get16(rom+off_hi)   << 16 | get16(rom+off_lo));
+					rep->main_stored_comp = (uint32_t)(get16(rom+off_hi+4) << 16 | get16(rom+off_lo+4));
+					rep->main_found       = 1;
+				}
+			}
+		}
+		if(rep->main_found == 1) {
+			rep->main_ok = (rep->main_calc == rep->main_stored && ~rep->main_calc == rep->main_stored_comp);
+		}
+	}
+
+	//-[ Multipoint : number of entries ]-----------------------------------------------------------
+	addr = search( fh, (unsigned char *)&needle_4b, (unsigned char *)&mask_4b, needle_4b_len, 0 );
+	if(addr != NULL) {
+		rep->mp_entries = get16(addr+42);
+	} else {
+		addr = search( fh, (unsigned char *)&needle_4c, (unsigned char *)&mask_4c, needle_4c_len, 0 );
+		if(addr != NULL) {
+			rep->mp_entries = get16(addr+44);
+		}
+	}
+	if(addr != NULL) label_symbol(addr-rom, SYM_CODE, "multipoint entries");
+
+	//-[ Multipoint : stored checksum list ]--------------------------------------------------------
+	hi_addr = 0;
+	addr = search( fh, (unsigned char *)&needle_4, (unsigned char *)&mask_4, needle_4_len, 0 );
+	if(addr != NULL) {
+		lo_32bit    = 1;
+		seg_addr    = addr+58;
+		lo_addr     = addr+54;
+		skip_factor = 0;
+		rep->mp_found = 1;
+	} else {
+		addr = search( fh, (unsigned char *)&needle_4aa, (unsigned char *)&mask_4aa, needle_4aa_len, 0 );
+		if(addr != NULL) {
+			lo_32bit    = 0;
+			seg_addr    = addr+24;
+			lo_addr     = addr+28;
+			hi_addr     = addr+32;
+			skip_factor = 32;		// skip past 1st 2 entries which are actually CRC32's in table
+			rep->mp_entries  = (rep->mp_entries > 2) ? rep->mp_entries-2 : 0;
+			rep->mp_found = 1;
+		}
+	}
+
+	if(rep->mp_found == 1) label_symbol(addr-rom, SYM_CODE, "multipoint checksum");
+	if(rep->mp_found == 1 && rep->mp_entries > 0)
+	{
+		for(i=0; i < rep->mp_entries; i++)
+		{
+			long idx = (long)i*16 + skip_factor;
+
+			off_lo = rom_offset(fh, lo_addr, seg_addr, idx, 16);
+			if(off_lo < 0) { rep->mp_fail += 2; continue; }
+			if(i == 0) label_symbol(off_lo, SYM_DATA, "multipoint table");
+			if(lo_32bit) {
+				start_addr = get32(rom+off_lo);
+				end_addr   = get32(rom+off_lo+4);
+			} else {
+				off_hi = rom_offset(fh, hi_addr, seg_addr, idx, 8);
+				if(off_hi < 0) { rep->mp_fail += 2; continue; }
+				start_addr = (unsigned long)(get16(rom+off_hi)   << 16 | get16(rom+off_lo));
+				end_addr   = (unsigned long)(get16(rom+off_hi+4) << 16 | get16(rom+off_lo+4));
+			}
+			start_addr &= ~(ROM_1MB_MASK);
+			end_addr   &= ~(ROM_1MB_MASK);
+
+			if(start_addr < end_addr && block_in_image(fh, start_addr, end_addr)) {
+				sum = CalcChecksumBlk(fh, start_addr, end_addr);
+				label_add(start_addr, (end_addr|1)+1, LBL_BLOCK, "multipoint block", i+1, 0, 0);
+			} else {
+				sum = 0;
+			}
+
+			// stored sum and ~sum always sit at +8/+12 relative to the low word table
+			stored = get32(rom+off_lo+8);
+			if(stored == sum)  { rep->mp_pass++; } else { rep->mp_fail++; }
+			stored = get32(rom+off_lo+12);
+			if(stored == ~sum) { rep->mp_pass++; } else { rep->mp_fail++; }
+		}
+	}
+
+	return 0;
+}
+
+/* print filename as a quoted json/csv string */
+static void print_quoted(const char *s, int format)
+{
+	putchar('"');
+	for(; *s; s++) {
+		if(format == VERIFY_JSON && (*s == '"' || *s == '\\')) { putchar('\\'); }
+		if(format == VERIFY_CSV  &&  *s == '"')                { putchar('"');  }
+		putchar(*s);
+	}
+	putchar('"');
+}
+
+/*
+ * Checksum-only triage of a single rom, prints exactly one csv or json line.
+ *
+ * returns 0 if main and multipoint checksums are all good, 1 otherwise
+ */
+int verify_rom(char *filename_rom, int format, int show_header)
+{
+	ImageHandle f;
+	ImageHandle *fh = &f;
+	CHECKSUM_REPORT r;
+	const char *status = "OK";
+	const char *main_status;
+	const char *error = 0;
+
+	memset(&r, 0, sizeof(r));
+	memset(fh, 0, sizeof(*fh));
+
+	if(show_header && format == VERIFY_CSV) {
+		printf("file,size,status,main,main_regions,main_calc,main_stored,main_stored_comp,multipoint_entries,multipoint_pass,multipoint_fail\n");
+	}
+
+	fh->d.p = load_file_ex(filename_rom, &fh->len, 0);
+	if(fh->d.p == 0) {
+		error = "load failed";
+	} else if(fh->len != ROM_FILESIZE*1 && fh->len != ROM_FILESIZE*2) {
+		error = "unsupported size";
+	} else {
+		verify_checksums(fh, &r);
+	}
+
+	if(error != 0) {
+		status      = "ERROR";
+		main_status = "ERROR";
+	} else {
+		main_status = r.main_found ? (r.main_ok ? "OK" : "BAD") : "NOTFOUND";
+		// a rom without a multipoint table can't be shown to be intact
+		if(r.main_ok == 0 || r.mp_found == 0 || r.mp_fail > 0) { status = "BAD"; }
+	}
+
+	if(format == VERIFY_JSON) {
+		printf("{\"file\":");
+		print_quoted(filename_rom, format);
+		printf(",\"size\":%lu,\"status\":\"%s\"", (unsigned long)fh->len, status);
+		if(error != 0) {
+			printf(",\"error\":\"%s\"", error);
+		}
+		printf(",\"main\":\"%s\",\"main_regions\":%d,\"main_calc\":\"0x%-8.8x\",\"main_stored\":\"0x%-8.8x\",\"main_stored_comp\":\"0x%-8.8x\"",
+			main_status, r.main_regions, r.main_calc, r.main_stored, r.main_stored_comp);
+		printf(",\"multipoint\":\"%s\",\"multipoint_entries\":%d,\"multipoint_pass\":%d,\"multipoint_fail\":%d}\n",
+			r.mp_found ? "FOUND" : "NOTFOUND", r.mp_entries, r.mp_pass, r.mp_fail);
+	} else {
+		print_quoted(filename_rom, format);
+		printf(",%lu,%s,%s,%d,0x%-8.8x,0x%-8.8x,0x%-8.8x,%d,%d,%d\n", (unsigned long)fh->len, status, main_status,
+			r.main_regions, r.main_calc, r.main_stored, r.main_stored_comp, r.mp_entries, r.mp_pass, r.mp_fail);
+	}
+
+	if(fh->d.p != 0) free(fh->d.p);
+	label_clear();
+	return (strcmp(status, "OK") == 0) ? 0 : 1;
+}
@@ -23,4 +23,26 @@
 #define _FIXSUMS_SUPPORT_H
 #include "utils.h"
 
+#define VERIFY_CSV   1
+#define VERIFY_JSON  2
+
+// result of a silent checksum verification pass (see verify_checksums)
+typedef struct CHECKSUM_REPORT {
+	int       main_found;			// 1 if all main rom checksum needles were located
+	int       main_regions;			// number of main rom regions summed
+	uint32_t  main_calc;			// calculated main rom checksum
+	uint32_t  main_stored;			// stored main rom checksum
+	uint32_t  main_stored_comp;		// stored main rom ~checksum
+	int       main_ok;				// 1 if both stored values match the calculated sum
+	int       mp_found;				// 1 if the multipoint table was located
+	int       mp_entries;			// number of multipoint blocks
+	int       mp_pass;				// multipoint checksums (sum and ~sum counted separately) passed
+	int       mp_fail;				// multipoint checksums failed
+} CHECKSUM_REPORT;
+
+uint32_t CalcChecksumBlk(struct ImageHandle *ih, uint32_t start, uint32_t end);
+int fix_checksums(ImageHandle *fh, unsigned char *addr, char *filename_rom, unsigned long dynamic_ROM_FILESIZE, unsigned char *offset_addr);
+int verify_checksums(ImageHandle *fh, CHECKSUM_REPORT *rep);
+int verify_rom(char *filename_rom, int format, int show_header);
+
 #endif
\ No newline at end of file
@@ -40,13 +40,13 @@ int check_fkkvs(ImageHandle *fh, int skip)
 	 */
 	if(skip == 0) return found;		
 
-	printf("\n-[ FKKVS Correction factor fueling system ]-------------------------------------------\n");
+	con_printf("\n-[ FKKVS Correction factor fueling system ]-------------------------------------------\n");
 
-	printf("\n>>> Scanning for RTKI() for required fields... \n");
+	con_printf("\n>>> Scanning for RTKI() for required fields... \n");
 	addr = search( fh, (unsigned char *)&needle_RKTI, (unsigned char *)&mask_RKTI, needle_RKTI_len, 0 );
 	if(addr != NULL) 
 	{
-		printf("found at offset=0x%x. \n",(int)(addr-rom_load_addr) );
+		con_printf("found at offset=0x%x. \n",(int)(addr-rom_load_addr) );
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(addr-rom_load_addr, addr, needle_RKTI_len); }
 
@@ -57,12 +57,11 @@ int check_fkkvs(ImageHandle *fh, int skip)
 		dump_table(addr, rom_load_addr, get16((unsigned char *)addr+50) /*val*/, get16((unsigned char *)addr+46)  /*seg*/, &FKKVS_table, 0);
 		
 
-//		set_table_overrides( _snm16zuub.ram, _srl12zuub.ram, _kfzw.ram, &KFZW_table);
-//		dump_table2(rom_load_addr, FULL_OVERRIDE);
+//		dump_split_table(rom_load_addr, _snm16zuub.ram, _srl12zuub.ram, _kfzw.ram, &KFZW_table);
 					
 	} else {
-		printf("Not found\n");
+		con_printf("Not found\n");
 	}
-	printf("\n");
+	con_printf("\n");
 	return 0;
 }
@@ -0,0 +1,602 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "flowgraph.h"
+#include <time.h>
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
+#define FLOW_TOP_CALLED		10
+
+static FLOW_GRAPH graph;
+static int        built;
+
+// blocks and call sites of one segment, filled by whichever thread owns the segment
+typedef struct SEG_OUT {
+	FLOW_BLOCK *blocks;
+	int         num_blocks, max_blocks;
+	FLOW_CALL  *calls;
+	int         num_calls, max_calls;
+	int         failed;
+} SEG_OUT;
+
+typedef struct SEG_WORK {
+	FLOW_GRAPH    *g;
+	const uint8_t *rom;
+	SEG_OUT       *out;
+	int            first, step, segs, pass;
+} SEG_WORK;
+
+// functions in discovery order, they are also the queue of the recursive descent
+static uint32_t *entries;
+static unsigned char *entry_flags;
+static int num_entries, max_entries, next_entry;
+static uint32_t *stack;
+static int num_stack, max_stack;
+
+static int valid_target(const FLOW_GRAPH *g, unsigned long t)
+{
+	if(t == DIS_NO_TARGET || t >= g->len || (t & 1)) return 0;
+	if(t >= MAP_AREA_START && t < MAP_AREA_START+MAP_AREA_SIZE) return 0;	// map data, never code
+	return 1;
+}
+
+static int grow(void **p, int *max, int size, int initial)
+{
+	int n = *max ? *max*2 : initial;
+	void *q = realloc(*p, (size_t)n * size);
+
+	if(q == 0) return -1;
+	*p   = q;
+	*max = n;
+	return 0;
+}
+
+//-[ Segment Passes ]-------------------------------------------------------------------------------------------------------
+
+static void decode_segment(FLOW_GRAPH *g, const uint8_t *rom, int seg)
+{
+	unsigned long i = (unsigned long)seg * SEGMENT_SIZE;
+	unsigned long end = i + SEGMENT_SIZE;
+	DIS_INST *di;
+
+	if(end > g->len) end = g->len;
+	for(;i<end;i+=2) {
+		di = &g->insts[i/2];
+		if(c167x_decode(rom+i, g->len-i, i, di) == 0) {
+			// last word of the image, nothing to decode
+			memset(di, 0, sizeof(DIS_INST));
+			di->adr    = i;
+			di->target = DIS_NO_TARGET;
+			di->len    = 2;
+			di->flags  = DIS_INVALID;
+		}
+	}
+}
+
+static int add_block(SEG_OUT *so, FLOW_BLOCK *b)
+{
+	if(so->num_blocks == so->max_blocks && grow((void **)&so->blocks, &so->max_blocks, sizeof(FLOW_BLOCK), 256) != 0) return -1;
+	so->blocks[so->num_blocks++] = *b;
+	return 0;
+}
+
+static int add_call(SEG_OUT *so, unsigned long site, unsigned long target, int caller)
+{
+	FLOW_CALL *c;
+
+	if(so->num_calls == so->max_calls && grow((void **)&so->calls, &so->max_calls, sizeof(FLOW_CALL), 256) != 0) return -1;
+	c = &so->calls[so->num_calls++];
+	c->site   = site;
+	c->target = target;
+	c->caller = caller;
+	c->callee = -1;
+	return 0;
+}
+
+// every block starts at a leader, it runs on until a jump, return, undefined opcode or the next leader
+static void collect_segment(FLOW_GRAPH *g, SEG_OUT *so, int seg)
+{
+	unsigned long a = (unsigned long)seg * SEGMENT_SIZE;
+	unsigned long end = a + SEGMENT_SIZE;
+	unsigned long b, nb;
+	const DIS_INST *di;
+	FLOW_BLOCK blk;
+
+	if(end > g->len) end = g->len;
+	for(;a<end;a+=2) {
+		if((g->state[a/2] & (FL_INST|FL_LEADER)) != (FL_INST|FL_LEADER)) continue;
+
+		memset(&blk, 0, sizeof(blk));
+		blk.start   = a;
+		blk.succ[0] = FLOW_NONE;
+		blk.succ[1] = FLOW_NONE;
+		blk.func    = g->owner[a/2];
+		for(b=a;;b=nb) {
+			di = &g->insts[b/2];
+			nb = b + di->len;
+			blk.insts++;
+			if(di->flags & DIS_CALL) {
+				if(add_call(so, b, valid_target(g, di->target) ? di->target : FLOW_NONE, blk.func) != 0) so->failed = 1;
+				blk.flags |= FLB_CALLS;
+			}
+			if(di->flags & DIS_INVALID) {
+				blk.flags |= FLB_INVALID;
+				break;
+			}
+			if(di->flags & DIS_JUMP) {
+				if(valid_target(g, di->target)) blk.succ[0] = di->target;
+				if(di->flags & DIS_INDIRECT) blk.flags |= FLB_INDIRECT;
+				if((di->flags & DIS_COND) && nb < g->len && (g->state[nb/2] & FL_INST)) blk.succ[1] = nb;
+				break;
+			}
+			if(di->flags & DIS_RET) {
+				blk.flags |= FLB_RET;
+				break;
+			}
+			if(nb >= g->len || !(g->state[nb/2] & FL_INST)) break;
+			if(g->state[nb/2] & FL_LEADER) {
+				blk.succ[1] = nb;
+				break;
+			}
+		}
+		blk.end = nb;
+		if(add_block(so, &blk) != 0) so->failed = 1;
+	}
+}
+
+static void run_work(SEG_WORK *w)
+{
+	int s;
+
+	for(s=w->first;s<w->segs;s+=w->step) {
+		if(w->pass == 0) decode_segment(w->g, w->rom, s);
+		else collect_segment(w->g, &w->out[s], s);
+	}
+}
+
+#ifndef NO_THREADS
+static void *work_thread(void *arg)
+{
+	run_work((SEG_WORK *)arg);
+	return 0;
+}
+#endif
+
+// run a pass over every segment, segments are dealt out to the threads round robin
+static int run_segments(FLOW_GRAPH *g, const uint8_t *rom, SEG_OUT *out, int segs, int pass)
+{
+	SEG_WORK work[FLOW_THREADS];
+	int i, threads = (segs < FLOW_THREADS) ? segs : FLOW_THREADS;
+#ifndef NO_THREADS
+	pthread_t tid[FLOW_THREADS];
+	int started[FLOW_THREADS];
+#endif
+
+	for(i=0;i<threads;i++) {
+		work[i].g     = g;
+		work[i].rom   = rom;
+		work[i].out   = out;
+		work[i].first = i;
+		work[i].step  = threads;
+		work[i].segs  = segs;
+		work[i].pass  = pass;
+#ifndef NO_THREADS
+		started[i] = (pthread_create(&tid[i], NULL, work_thread, &work[i]) == 0);
+		if(!started[i]) run_work(&work[i]);
+#else
+		run_work(&work[i]);
+#endif
+	}
+#ifndef NO_THREADS
+	for(i=0;i<threads;i++) {
+		if(started[i]) pthread_join(tid[i], NULL);
+	}
+#endif
+	return threads;
+}
+
+//-[ Recursive Descent ]----------------------------------------------------------------------------------------------------
+
+static int add_func(FLOW_GRAPH *g, unsigned long t, int flags)
+{
+	if(g->state[t/2] & FL_FUNC) return 0;
+	if(num_entries == max_entries) {
+		int max = max_entries;
+		if(grow((void **)&entries, &max_entries, sizeof(uint32_t), 1024) != 0) return -1;
+		if(grow((void **)&entry_flags, &max, 1, 1024) != 0) return -1;
+	}
+	g->state[t/2] |= FL_FUNC | FL_LEADER;
+	entries[num_entries]     = t;
+	entry_flags[num_entries] = flags;
+	num_entries++;
+	return 0;
+}
+
+static int push(unsigned long a)
+{
+	if(num_stack == max_stack && grow((void **)&stack, &max_stack, sizeof(uint32_t), 1024) != 0) return -1;
+	stack[num_stack++] = a;
+	return 0;
+}
+
+// follow one function's jumps (calls only queue their target as a new function)
+static int descend(FLOW_GRAPH *g, int f)
+{
+	unsigned long a;
+	const DIS_INST *di;
+
+	num_stack = 0;
+	if(push(entries[f]) != 0) return -1;
+	while(num_stack) {
+		a = stack[--num_stack];
+		while(valid_target(g, a)) {
+			if(g->state[a/2] & FL_INST) {
+				// ran into code reached before, it starts a block
+				g->state[a/2] |= FL_LEADER;
+				break;
+			}
+			g->state[a/2] |= FL_INST;
+			g->owner[a/2]  = f;
+			di = &g->insts[a/2];
+			if(di->flags & DIS_INVALID) {
+				g->state[a/2] |= FL_INVALID;
+				break;
+			}
+			if((di->flags & DIS_CALL) && valid_target(g, di->target)) {
+				if(add_func(g, di->target, 0) != 0) return -1;
+			}
+			if(di->flags & DIS_JUMP) {
+				if(valid_target(g, di->target)) {
+					g->state[di->target/2] |= FL_LEADER;
+					if(push(di->target) != 0) return -1;
+				}
+				if(!(di->flags & DIS_COND)) break;
+				a += di->len;
+				if(a < g->len) g->state[a/2] |= FL_LEADER;
+				continue;
+			}
+			if(di->flags & DIS_RET) break;
+			a += di->len;
+		}
+	}
+	return 0;
+}
+
+static int run_queue(FLOW_GRAPH *g)
+{
+	for(;next_entry<num_entries;next_entry++) {
+		if(descend(g, next_entry) != 0) return -1;
+	}
+	return 0;
+}
+
+// a function starts straight after reached code that can't fall through, if nothing reached it yet
+static int sweep(FLOW_GRAPH *g, const uint8_t *rom)
+{
+	unsigned long a, next = FLOW_NONE;
+	const DIS_INST *di;
+	unsigned short w;
+
+	for(a=ROM_MAIN_START;a+2<=g->len;a+=2) {
+		if(g->state[a/2] & FL_INST) {
+			di = &g->insts[a/2];
+			if((di->flags & DIS_RET) || ((di->flags & DIS_JUMP) && !(di->flags & DIS_COND))) next = a + di->len;
+			else next = FLOW_NONE;
+			a += di->len - 2;
+			continue;
+		}
+		if(a != next) continue;
+		w = get16((unsigned char *)rom+a);
+		if(w == 0x0000 || w == 0xFFFF || (g->insts[a/2].flags & DIS_INVALID)) continue;	// padding
+
+		if(add_func(g, a, FL_SWEEP) != 0 || run_queue(g) != 0) return -1;
+		if(g->state[a/2] & FL_INST) a -= 2;		// look at what was just reached
+	}
+	return 0;
+}
+
+//-[ Graph ]----------------------------------------------------------------------------------------------------------------
+
+static int cmp_entry(const void *a, const void *b)
+{
+	uint32_t x = entries[*(const int *)a], y = entries[*(const int *)b];
+	return (x > y) - (x < y);
+}
+
+static int cmp_callee(const void *a, const void *b)
+{
+	const FLOW_CALL *x = &graph.calls[*(const int *)a], *y = &graph.calls[*(const int *)b];
+
+	if(x->target != y->target) return (x->target > y->target) - (x->target < y->target);
+	return (x->site > y->site) - (x->site < y->site);
+}
+
+static void free_discovery(void)
+{
+	free(entries);
+	free(entry_flags);
+	free(stack);
+	entries     = 0;
+	entry_flags = 0;
+	stack       = 0;
+	num_entries = max_entries = next_entry = 0;
+	num_stack   = max_stack = 0;
+}
+
+// join the per segment results and number the functions by entry
+static int merge(FLOW_GRAPH *g, SEG_OUT *out, int segs)
+{
+	int i, j, nb = 0, nc = 0, *order;
+	FLOW_FUNC *f;
+
+	for(i=0;i<segs;i++) {
+		if(out[i].failed) return -1;
+		nb += out[i].num_blocks;
+		nc += out[i].num_calls;
+	}
+	g->blocks    = malloc((nb+1) * sizeof(FLOW_BLOCK));
+	g->calls     = malloc((nc+1) * sizeof(FLOW_CALL));
+	g->by_callee = malloc((nc+1) * sizeof(int));
+	g->funcs     = calloc(num_entries+1, sizeof(FLOW_FUNC));
+	g->func_map  = malloc((num_entries+1) * sizeof(int));
+	order        = malloc((num_entries+1) * sizeof(int));
+	if(!g->blocks || !g->calls || !g->by_callee || !g->funcs || !g->func_map || !order) {
+		free(order);
+		return -1;
+	}
+	for(i=0;i<segs;i++) {
+		if(out[i].num_blocks) memcpy(g->blocks + g->num_blocks, out[i].blocks, out[i].num_blocks * sizeof(FLOW_BLOCK));
+		if(out[i].num_calls)  memcpy(g->calls  + g->num_calls,  out[i].calls,  out[i].num_calls  * sizeof(FLOW_CALL));
+		g->num_blocks += out[i].num_blocks;
+		g->num_calls  += out[i].num_calls;
+	}
+
+	for(i=0;i<num_entries;i++) order[i] = i;
+	qsort(order, num_entries, sizeof(int), cmp_entry);
+	for(i=0;i<num_entries;i++) {
+		g->func_map[order[i]] = i;
+		g->funcs[i].entry     = entries[order[i]];
+		g->funcs[i].flags     = entry_flags[order[i]];
+	}
+	g->num_funcs = num_entries;
+	free(order);
+
+	for(i=0;i<g->num_blocks;i++) {
+		FLOW_BLOCK *b = &g->blocks[i];
+		b->func = g->func_map[b->func];
+		f = &g->funcs[b->func];
+		f->blocks++;
+		f->insts += b->insts;
+		f->bytes += b->end - b->start;
+		g->num_insts  += b->insts;
+		g->code_bytes += b->end - b->start;
+		if(b->flags & FLB_INVALID) g->num_invalid++;
+		for(j=0;j<2;j++) {
+			if(b->succ[j] != FLOW_NONE) g->num_edges++;
+		}
+	}
+	for(i=0;i<g->num_calls;i++) {
+		FLOW_CALL *c = &g->calls[i];
+		c->caller = g->func_map[c->caller];
+		g->funcs[c->caller].calls++;
+		if(c->target != FLOW_NONE && (c->callee = flow_func_find(c->target)) >= 0) g->funcs[c->callee].callers++;
+		g->by_callee[i] = i;
+	}
+	qsort(g->by_callee, g->num_calls, sizeof(int), cmp_callee);
+	return 0;
+}
+
+/*
+ * Find the code of the image and build its blocks and call graph, replaces any previous graph
+ */
+int flow_build(ImageHandle *fh)
+{
+	FLOW_GRAPH *g = &graph;
+	const uint8_t *rom = fh->d.u8;
+	SEG_OUT *out = 0;
+	clock_t start = clock();
+	unsigned long v, words;
+	int i, segs, res = -1;
+
+	flow_free();
+	g->len   = fh->len & ~1UL;
+	words    = g->len / 2;
+	segs     = (g->len + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+	g->insts = malloc((words+1) * sizeof(DIS_INST));
+	g->state = calloc(words+1, 1);
+	g->owner = malloc((words+1) * sizeof(int));
+	out      = calloc(segs, sizeof(SEG_OUT));
+	if(!g->insts || !g->state || !g->owner || !out) goto done;
+	for(v=0;v<words;v++) g->owner[v] = -1;
+
+	run_segments(g, rom, out, segs, 0);
+
+	// reset and trap vectors, each a 'jmps seg,caddr' to its handler
+	for(v=0;v<FLOW_VECTORS && v+4<=g->len;v+=4) {
+		const DIS_INST *di = &g->insts[v/2];
+		if(di->raw[0] == 0xfa && valid_target(g, di->target)) {
+			if(add_func(g, di->target, FL_VECTOR) != 0) goto done;
+		}
+	}
+	if(run_queue(g) != 0 || sweep(g, rom) != 0) goto done;
+
+	run_segments(g, rom, out, segs, 1);
+	if(merge(g, out, segs) != 0) goto done;
+	g->ms = 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC;
+	built = 1;
+	res   = 0;
+
+done:
+	if(out) {
+		for(i=0;i<segs;i++) {
+			free(out[i].blocks);
+			free(out[i].calls);
+		}
+		free(out);
+	}
+	free_discovery();
+	if(res != 0) flow_free();
+	return res;
+}
+
+void flow_free(void)
+{
+	free(graph.insts);
+	free(graph.state);
+	free(graph.owner);
+	free(graph.func_map);
+	free(graph.funcs);
+	free(graph.blocks);
+	free(graph.calls);
+	free(graph.by_callee);
+	memset(&graph, 0, sizeof(graph));
+	built = 0;
+}
+
+const FLOW_GRAPH *flow_graph(void)
+{
+	return built ? &graph : 0;
+}
+
+/*
+ * The decoded instruction at offset if it is reached code, 0 otherwise
+ */
+const DIS_INST *flow_inst(unsigned long offset)
+{
+	if(!built || offset >= graph.len || (offset & 1) || !(graph.state[offset/2] & FL_INST)) return 0;
+	return &graph.insts[offset/2];
+}
+
+/*
+ * Index of the block containing offset, -1 if it isn't code
+ */
+int flow_block_at(unsigned long offset)
+{
+	int lo = 0, hi = graph.num_blocks - 1, mid, res = -1;
+
+	if(!built) return -1;
+	while(lo <= hi) {
+		mid = (lo + hi) / 2;
+		if(graph.blocks[mid].start <= offset) {
+			res = mid;
+			lo  = mid + 1;
+		} else {
+			hi  = mid - 1;
+		}
+	}
+	return (res >= 0 && offset < graph.blocks[res].end) ? res : -1;
+}
+
+/*
+ * Index of the function whose code contains offset, -1 if it isn't code
+ */
+int flow_func_at(unsigned long offset)
+{
+	int b = flow_block_at(offset);
+	return b < 0 ? -1 : graph.blocks[b].func;
+}
+
+/*
+ * Index of the function starting at entry, -1 if there is none
+ */
+int flow_func_find(unsigned long entry)
+{
+	int lo = 0, hi = graph.num_funcs - 1, mid;
+
+	while(lo <= hi) {
+		mid = (lo + hi) / 2;
+		if(graph.funcs[mid].entry == entry) return mid;
+		if(graph.funcs[mid].entry < entry) lo = mid + 1;
+		else hi = mid - 1;
+	}
+	return -1;
+}
+
+/*
+ * Call sites calling entry (up to max of them into calls), returns how many there are
+ */
+int flow_callers(unsigned long entry, const FLOW_CALL **calls, int max)
+{
+	int lo = 0, hi = graph.num_calls, mid, n = 0;
+
+	if(!built) return 0;
+	while(lo < hi) {
+		mid = (lo + hi) / 2;
+		if(graph.calls[graph.by_callee[mid]].target < entry) lo = mid + 1;
+		else hi = mid;
+	}
+	for(;lo<graph.num_calls && graph.calls[graph.by_callee[lo]].target == entry;lo++,n++) {
+		if(n < max) calls[n] = &graph.calls[graph.by_callee[lo]];
+	}
+	return n;
+}
+
+//-[ Report ]---------------------------------------------------------------------------------------------------------------
+
+int check_flow(ImageHandle *fh, int skip)
+{
+	const FLOW_GRAPH *g;
+	int top[FLOW_TOP_CALLED];
+	int i, j, k, ntop = 0, vectors = 0, swept = 0, indirect = 0;
+
+	if(skip == 0) return 0;
+
+	con_printf("\n-[ Control Flow Analysis ]----------------------------------------------------------------------------------\n\n");
+	con_printf(">>> Recursive descent from the trap vectors at 0x0-0x%x, linear sweep from 0x%x \n", FLOW_VECTORS-1, ROM_MAIN_START);
+
+	if((g = flow_graph()) == 0 && (flow_build(fh) != 0 || (g = flow_graph()) == 0)) {
+		con_printf("\nfailed to build the control flow graph\n");
+		return 0;
+	}
+	for(i=0;i<g->num_funcs;i++) {
+		if(g->funcs[i].flags & FL_VECTOR) vectors++;
+		if(g->funcs[i].flags & FL_SWEEP)  swept++;
+	}
+	for(i=0;i<g->num_calls;i++) {
+		if(g->calls[i].target == FLOW_NONE) indirect++;
+	}
+	if(g->insts[0].raw[0] == 0xfa) con_printf("\nreset vector : jmps to 0x%x\n", (int)g->insts[0].target);
+
+	con_printf("\n%d functions (%d trap/reset handlers, %d only called, %d found by the sweep)\n",
+		g->num_funcs, vectors, g->num_funcs - vectors - swept, swept);
+	con_printf("%d basic blocks, %d edges, %d call sites (%d indirect)\n", g->num_blocks, g->num_edges, g->num_calls, indirect);
+	con_printf("%d instructions in %lu bytes of code (%.1f%% of the image), %d blocks end in an undefined opcode\n",
+		g->num_insts, g->code_bytes, 100.0*(double)g->code_bytes/(double)g->len, g->num_invalid);
+	con_printf("(%.2f ms, %d segments over up to %d threads)\n", g->ms, (int)((g->len + SEGMENT_SIZE - 1) / SEGMENT_SIZE), FLOW_THREADS);
+
+	// most called first, lowest entry first on a tie
+	for(i=0;i<g->num_funcs;i++) {
+		if(g->funcs[i].callers == 0) continue;
+		for(j=ntop;j>0 && g->funcs[top[j-1]].callers < g->funcs[i].callers;j--);
+		if(j >= FLOW_TOP_CALLED) continue;
+		if(ntop < FLOW_TOP_CALLED) ntop++;
+		for(k=ntop-1;k>j;k--) top[k] = top[k-1];
+		top[j] = i;
+	}
+	if(ntop) con_printf("\nMost called functions:\n");
+	for(i=0;i<ntop;i++) {
+		const FLOW_FUNC *f = &g->funcs[top[i]];
+		con_printf("  sub_%-6X %5d call sites %5d blocks %6d bytes %5d calls out\n", (int)f->entry, f->callers, f->blocks, f->bytes, f->calls);
+	}
+	return 0;
+}
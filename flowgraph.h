@@ -0,0 +1,111 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _FLOWGRAPH_SUPPORT_H
+#define _FLOWGRAPH_SUPPORT_H
+#include "utils.h"
+#include "inst_c16x.h"
+
+// Whole rom control flow: basic blocks, their successors and the call graph.
+//
+// Every word of the image is decoded up front, one thread per 16KByte segment. Code is then
+// found by recursive descent from the trap vector table at offset 0 (reset is vector 0, each
+// slot holds a 'jmps seg,caddr') following jumps and calls, plus a linear sweep from
+// ROM_MAIN_START that starts a new function straight after any reached code ending in a
+// return or unconditional jump. Blocks and call sites are then collected per segment in
+// parallel, each segment into its own arrays, and joined in segment order (already sorted).
+//
+// Jump and call targets are code addresses, i.e. relative to CSP (calla/jmpa/callr/jmpr
+// stay in the caller's segment, calls/jmps name theirs), the DPPs only page data accesses.
+
+#define FLOW_THREADS		8
+#define FLOW_VECTORS		0x200			// 128 trap vectors of 4 bytes
+#define FLOW_NONE			0xFFFFFFFFUL
+
+// per word state
+#define FL_INST				0x01			// an instruction starts here and was reached
+#define FL_LEADER			0x02			// first instruction of a basic block
+#define FL_FUNC				0x04			// function entry
+#define FL_VECTOR			0x08			// entry is the target of a trap vector
+#define FL_SWEEP			0x10			// entry was found by the linear sweep
+#define FL_INVALID			0x20			// reached an undefined opcode
+
+// block flags
+#define FLB_RET				0x01			// ends in a return
+#define FLB_INDIRECT		0x02			// ends in jmpi, successors unknown
+#define FLB_INVALID			0x04			// ends in an undefined opcode
+#define FLB_CALLS			0x08			// contains call sites
+
+typedef struct FLOW_BLOCK {
+	uint32_t       start;		// rom file offsets, end is exclusive
+	uint32_t       end;
+	uint32_t       succ[2];		// taken jump target, fall through (FLOW_NONE if none)
+	int            func;		// index into functions
+	int            insts;
+	unsigned char  flags;		// FLB_xxx
+} FLOW_BLOCK;
+
+typedef struct FLOW_CALL {
+	uint32_t       site;		// offset of the call instruction
+	uint32_t       target;		// FLOW_NONE for calli
+	int            caller;		// index into functions
+	int            callee;		// index into functions, -1 if indirect
+} FLOW_CALL;
+
+typedef struct FLOW_FUNC {
+	uint32_t       entry;
+	int            blocks;
+	int            insts;
+	int            bytes;
+	int            calls;		// call sites in its blocks
+	int            callers;		// call sites calling it
+	unsigned char  flags;		// FL_VECTOR, FL_SWEEP
+} FLOW_FUNC;
+
+typedef struct FLOW_GRAPH {
+	unsigned long  len;			// image length
+	DIS_INST      *insts;		// decoded instruction at every word, insts[offset/2]
+	unsigned char *state;		// FL_xxx per word
+	int           *owner;		// function (in discovery order) that reached each word, -1 if none
+	int           *func_map;	// discovery order -> index into funcs
+	FLOW_FUNC     *funcs;		// sorted by entry
+	FLOW_BLOCK    *blocks;		// sorted by start
+	FLOW_CALL     *calls;		// sorted by site
+	int           *by_callee;	// call indexes sorted by target
+	int            num_funcs, num_blocks, num_calls, num_edges;
+	int            num_insts, num_invalid;
+	unsigned long  code_bytes;
+	double         ms;
+} FLOW_GRAPH;
+
+int  flow_build(ImageHandle *fh);
+void flow_free(void);
+const FLOW_GRAPH *flow_graph(void);
+
+const DIS_INST *flow_inst(unsigned long offset);
+int  flow_block_at(unsigned long offset);
+int  flow_func_at(unsigned long offset);
+int  flow_func_find(unsigned long entry);
+int  flow_callers(unsigned long entry, const FLOW_CALL **calls, int max);
+
+int  check_flow(ImageHandle *fh, int skip);
+
+#endif
@@ -0,0 +1,170 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "funcindex.h"
+
+#define OP_RETS		0xDB		// rets          DB 00
+#define OP_RET		0xCB		// ret           CB 00
+#define OP_RETI		0xFB		// reti          FB 88
+#define OP_RETP		0xEB		// retp Rw       EB Fn
+#define OP_CALLS	0xDA		// calls seg,adr DA ss ll hh
+#define OP_CALLA	0xCA		// calla cc,adr  CA c0 ll hh (only cc_UC is taken)
+
+static unsigned long *func_starts;
+static int            func_num;
+static unsigned long  func_len;
+
+static int cmp_ulong(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+	return (x > y) - (x < y);
+}
+
+static int add_start(unsigned long **starts, int *num, int *max, unsigned long off)
+{
+	unsigned long *p;
+
+	if(*num == *max) {
+		p = realloc(*starts, (*max ? *max*2 : 1024) * sizeof(unsigned long));
+		if(p == 0) return -1;
+		*starts = p;
+		*max = *max ? *max*2 : 1024;
+	}
+	(*starts)[(*num)++] = off;
+	return 0;
+}
+
+/*
+ * Scan the image once and keep every function start, sorted and unique
+ */
+int func_index_build(ImageHandle *fh)
+{
+	unsigned char *rom = fh->d.u8;
+	unsigned long len = fh->len & ~1UL;
+	unsigned long i, target, segs = fh->len >> 16;
+	unsigned long *starts = 0;
+	int num = 0, max = 0, j, k;
+
+	func_index_free();
+
+	for(i=0;i+2<=len;i+=2) {
+		if(i == MAP_AREA_START) {
+			i = MAP_AREA_START + MAP_AREA_SIZE - 2;
+			continue;
+		}
+		target = FUNC_NONE;
+		switch(rom[i]) {
+			case OP_RETS:
+			case OP_RET:	if(rom[i+1] == 0x00) target = i+2;					break;
+			case OP_RETI:	if(rom[i+1] == 0x88) target = i+2;					break;
+			case OP_RETP:	if(rom[i+1] >= 0xF0) target = i+2;					break;
+			case OP_CALLS:
+				// far call into the rom (segment 0x80 onwards maps to file offset 0)
+				if(i+4 <= len && rom[i+1] >= 0x80 && rom[i+1] < 0x80+segs) {
+					target = (((unsigned long)rom[i+1] << 16) | get16(rom+i+2)) & ~(ROM_1MB_MASK);
+				}
+				break;
+			case OP_CALLA:
+				// unconditional call within the caller's segment
+				if(i+4 <= len && rom[i+1] == 0x00) target = (i & ~0xFFFFUL) | get16(rom+i+2);
+				break;
+		}
+		if(target != FUNC_NONE && target < len && (target & 1) == 0) {
+			if(add_start(&starts, &num, &max, target) != 0) {
+				free(starts);
+				return -1;
+			}
+		}
+	}
+
+	// returns come out in order, call targets don't
+	qsort(starts, num, sizeof(unsigned long), cmp_ulong);
+	for(j=0,k=0;j<num;j++) {
+		if(k == 0 || starts[k-1] != starts[j]) starts[k++] = starts[j];
+	}
+
+	func_starts = starts;
+	func_num    = k;
+	func_len    = fh->len;
+	return 0;
+}
+
+void func_index_free(void)
+{
+	free(func_starts);
+	func_starts = 0;
+	func_num    = 0;
+	func_len    = 0;
+}
+
+int func_index_num(void)
+{
+	return func_num;
+}
+
+/*
+ * The i'th function start (from 0, in address order), FUNC_NONE past the last one
+ */
+unsigned long func_at(int i)
+{
+	return (i >= 0 && i < func_num) ? func_starts[i] : FUNC_NONE;
+}
+
+// index of the last start <= offset, -1 if there is none
+static int find_start(unsigned long offset)
+{
+	int lo = 0, hi = func_num - 1, mid, res = -1;
+
+	while(lo <= hi) {
+		mid = (lo + hi) / 2;
+		if(func_starts[mid] <= offset) {
+			res = mid;
+			lo  = mid + 1;
+		} else {
+			hi  = mid - 1;
+		}
+	}
+	return res;
+}
+
+/*
+ * Start of the function containing offset, FUNC_NONE if unknown
+ */
+unsigned long func_start(unsigned long offset)
+{
+	int i;
+
+	if(offset >= func_len) return FUNC_NONE;
+	i = find_start(offset);
+	return i < 0 ? FUNC_NONE : func_starts[i];
+}
+
+/*
+ * Offset just past the function containing offset (the next function start), FUNC_NONE if unknown
+ */
+unsigned long func_end(unsigned long offset)
+{
+	int i;
+
+	if(offset >= func_len) return FUNC_NONE;
+	i = find_start(offset);
+	return (i+1 < func_num) ? func_starts[i+1] : func_len;
+}
@@ -0,0 +1,41 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _FUNCINDEX_SUPPORT_H
+#define _FUNCINDEX_SUPPORT_H
+#include "utils.h"
+
+// Sorted function boundaries of the rom being searched, built once by search_rom() so
+// "which function contains this offset" is a binary search instead of a backwards walk.
+//
+// C16x code is word aligned, a function starts after a return (rets/ret/reti/retp) or
+// at the target of a direct calls/calla. The 64KByte map area is skipped, it holds no code.
+
+#define FUNC_NONE		((unsigned long)-1)
+
+int  func_index_build(ImageHandle *fh);
+void func_index_free(void);
+int  func_index_num(void);
+unsigned long func_at(int i);
+unsigned long func_start(unsigned long offset);
+unsigned long func_end(unsigned long offset);
+
+#endif
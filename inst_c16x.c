@@ -20,6 +20,9 @@
    IN THE SOFTWARE.
 */
 #include "inst_c16x.h"
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
 
 /* C16x disassembler 
  *
@@ -28,585 +31,621 @@
  * Note: Not all opcodes and modes yet supported!!!
  */
 
-char *lookup16_regname(unsigned short regnum)
+//-[ Register Name Lookup ]-------------------------------------------------------------------------------------------------
+
+// Word SFRs only live in the SFR (0xFE00-0xFFFF) and ESFR (0xF000-0xF1FF) areas and are always even, so
+// address bits 1..8 plus bit 11 (set for the SFR area only) give every one of them its own slot.
+#define SFR16_SLOTS			512
+#define SFR16_SLOT(a)		((((a) >> 1) & 0xFF) | (((a) >> 3) & 0x100))
+#define SFR16_MAPPED(a)		((((a) & 0xFE01) == 0xF000) || (((a) & 0xFE01) == 0xFE00))
+
+static char *sfr16_names[SFR16_SLOTS];
+static char *sfr8_names[256];
+static char *rh_names[16];
+#ifndef NO_THREADS
+static pthread_once_t names_once = PTHREAD_ONCE_INIT;
+#else
+static int names_built;
+#endif
+
+// index the name tables, walking them backwards so the first entry of any duplicate wins like the old linear scans
+static void build_names(void)
 {
-	int i=0;
-	unsigned short hex_w;
-	char *name;
+	int i, n;
 
-	while(1) {
-	    name   = SFR_Entries[i].name;
-	    hex_w  = SFR_Entries[i].hex_w;
-	    if(hex_w == regnum) { break; } // found name
-	    if(name == 0)       { break; } // found end of table	    
-		i++;
+	for(n=0; SFR_Entries[n].name != 0; n++);
+	for(i=n-1; i>=0; i--) {
+		if(SFR16_MAPPED(SFR_Entries[i].hex_w)) sfr16_names[SFR16_SLOT(SFR_Entries[i].hex_w)] = SFR_Entries[i].name;
+	}
+	for(n=0; SFR8_Entries[n].name != 0; n++);
+	for(i=n-1; i>=0; i--) {
+		sfr8_names[SFR8_Entries[i].hex_b] = SFR8_Entries[i].name;
+	}
+	for(i=15; i>=0; i--) {
+		rh_names[RHNames[i].hex & 0xf] = RHNames[i].name;
 	}
-	return(name);
 }
 
-char *lookup_regname(unsigned char regnum)
+static void init_names(void)
 {
-	int i=0;
-	unsigned char hex_b;
-	char *name;
-	while(1) {
-	    name   = SFR8_Entries[i].name;
-	    hex_b  = SFR8_Entries[i].hex_b;
-	    if(hex_b == regnum) { break; } // found name
-	    if(name == 0)       { break; } // found end of table	    
-		i++;
+#ifndef NO_THREADS
+	pthread_once(&names_once, build_names);
+#else
+	if(names_built == 0) {
+		build_names();
+		names_built = 1;
 	}
-	return(name);
+#endif
+}
+
+char *lookup16_regname(unsigned short regnum)
+{
+	init_names();
+	if(!SFR16_MAPPED(regnum)) return(0);
+	return(sfr16_names[SFR16_SLOT(regnum)]);
+}
+
+char *lookup_regname(unsigned char regnum)
+{
+	init_names();
+	return(sfr8_names[regnum]);
 }
 
 char *lookup_rh_regname(unsigned char regnum)
 {
-	int i=0,hex;
-	char *name;
+	init_names();
+	if(regnum > 15) return(0);
+	return(rh_names[regnum]);
+}
+
+//-[ Decoder ]--------------------------------------------------------------------------------------------------------------
+
+// 4 bit register/value field selected by an argument's position (1 = high nibble, 2 = low nibble of the 2nd byte)
+static unsigned char arg_nibble(const unsigned char *raw, unsigned char pos)
+{
+	if(pos == 1) return get_hi_nibble(raw[1]);
+	if(pos == 2) return get_lo_nibble(raw[1]);
+	return raw[1];
+}
 
-	while(1) {
-	    name = RHNames[i].name;
-	    hex  = RHNames[i].hex;
-	    if(hex == regnum) { break; } // found name
-	    if(name == 0)     { break; } // found end of table	    
-		i++;
+// entry of a linked sub table, the 2nd byte says which one
+static int link_entry(unsigned char opcode, unsigned char b)
+{
+	switch(opcode) {
+		case 0x08:case 0x09:case 0x18:case 0x19:
+		case 0x28:case 0x29:case 0x38:case 0x39:
+		case 0x48:case 0x49:case 0x58:case 0x59:
+		case 0x68:case 0x69:case 0x78:case 0x79:
+			// AAAA0BBB #data3, AAAA10BB [Rw], AAAA11BB [Rw+]
+			if((b & 0x08) == 0) return 0;
+			return (b & 0x04) ? 2 : 1;
+		case 0xb7:
+			if(b == 0x48) return 0;					// srst
+			if(b == 0x58) return 1;					// srvwdt
+			return -1;
+		case 0xd1:
+			if((b & 0x40) != 0) return -1;			// atomic 00, extr 10
+			return b >> 7;
+		case 0xd7:
+		case 0xdc:
+			return b >> 6;							// exts, extp, extsr, extpr
 	}
-	return(name);
+	return -1;
 }
 
-void translate_arg_type(unsigned char *rom_start, uint8_t *buf, int rval, int rdata16, INST *p, unsigned char type, unsigned char pos)
+static void decode_op(DIS_INST *di, DIS_OP *op, unsigned char type, unsigned char pos)
 {
-	long int val;
-	int rval_l,num_opcodes;
-	char *name;
-	unsigned char nibble;
-	unsigned char data4;
-	unsigned char _byte;
-	unsigned char hi,lo;
-	int len = p->len;
-
-	// process different opcode modes
-	switch(type)
-	{
-		case RW_L:				// 	1       //  Rn
-					nibble = get_lo_nibble(rval);
-					printf("r%d",nibble);
-				break;
+	const unsigned char *raw = di->raw;
+
+	op->type = type;
+	op->pos  = pos;
+	op->reg  = raw[1];
+	op->val  = 0;
+
+	switch(type) {
+		case RW:
+		case RW_L:
+		case RB:
+		case RW_IND:
+		case RW_IND_POST_INC:
+		case RW_IND_POST_DEC:
+		case RW_IND_PRE_INC:
+		case RW_IND_PRE_DEC:
+		case DATA3:
+		case DATA4:
+		case IRANG2:
+			op->reg = arg_nibble(raw, pos);
+			break;
+		case RW_IND_1_DATA16_2:
+			op->reg = arg_nibble(raw, pos);
+			op->val = get16((unsigned char *)raw+2);
+			break;
+		case REGB2:
+			op->reg = get_lo_nibble(raw[1]);
+			break;
+		case MEM:
+		case DATA16:
+		case ADR:
+			op->val = get16((unsigned char *)raw+2);
+			break;
+		case SEG:
+		case DATA8:
+		case MASK8:
+		case BITOFF:
+			if(pos >= 1 && pos <= 3) op->reg = raw[pos];
+			break;
+		case BITADR:
+			// bitoff in val, bit number in reg: QQ.q is at positions 1/3, ZZ.z at 2/4
+			if(di->len == 2) {
+				op->val = raw[1];
+				op->reg = get_hi_nibble(raw[0]);
+			} else if(pos == 2 || pos == 4) {
+				op->val = raw[2];
+				op->reg = get_lo_nibble(raw[3]);
+			} else {
+				op->val = raw[1];
+				op->reg = get_hi_nibble(raw[3]);
+			}
+			break;
+		case BITADR_W:
+			op->val = raw[2];
+			op->reg = get_lo_nibble(raw[3]);
+			break;
+		case BITADR_W2:
+			op->val = raw[1];
+			op->reg = get_hi_nibble(raw[3]);
+			break;
+		case CC:
+			// jmpr keeps its condition in the opcode, everything else in the 2nd byte
+			op->reg = (get_lo_nibble(raw[0]) == 0x0d) ? get_hi_nibble(raw[0]) : get_hi_nibble(raw[1]);
+			break;
+		case REL:
+			op->reg = (pos == 2) ? raw[2] : raw[1];
+			break;
+		case TRAP7:
+			op->reg = raw[1] >> 1;
+			break;
+	}
+}
 
-		case RW:				// 	1       //  Rn
-				rval = *(buf+1);	
-				if(pos == 2)
-				{
-					nibble = get_lo_nibble(rval);
-					printf("r%d",nibble);
-					
-				} else if(pos == 1) {
-					nibble = get_hi_nibble(rval);
-					printf("r%d",nibble);
-				}
-				break;
+// branch/call/return flags and the target of direct transfers
+static void decode_flow(DIS_INST *di)
+{
+	const unsigned char *raw = di->raw;
+	unsigned long w = (di->len == 4) ? get16((unsigned char *)raw+2) : 0;
+
+	if(get_lo_nibble(raw[0]) == 0x0d) {									// jmpr cc,rel
+		di->flags |= DIS_JUMP;
+		if(raw[0] != 0x0d) di->flags |= DIS_COND;
+		di->target = di->adr + 2 + 2*(signed char)raw[1];
+		return;
+	}
+	switch(raw[0]) {
+		case 0xea:															// jmpa cc,caddr
+		case 0xca:															// calla cc,caddr
+			di->flags |= (raw[0] == 0xea) ? DIS_JUMP : DIS_CALL;
+			if(get_hi_nibble(raw[1]) != CC_UC) di->flags |= DIS_COND;
+			di->target = (di->adr & ~0xFFFFUL) | w;
+			break;
+		case 0xfa:															// jmps seg,caddr
+		case 0xda:															// calls seg,caddr
+			di->flags |= (raw[0] == 0xfa) ? DIS_JUMP : DIS_CALL;
+			di->target = (((unsigned long)raw[1] << 16) | w) & ~(ROM_1MB_MASK);
+			break;
+		case 0xe2:															// pcall reg,caddr
+			di->flags |= DIS_CALL;
+			di->target = (di->adr & ~0xFFFFUL) | w;
+			break;
+		case 0xbb:															// callr rel
+			di->flags |= DIS_CALL;
+			di->target = di->adr + 2 + 2*(signed char)raw[1];
+			break;
+		case 0x8a:case 0x9a:case 0xaa:case 0xba:							// jb/jnb/jbc/jnbs bitaddr,rel
+			di->flags |= DIS_JUMP | DIS_COND;
+			di->target = di->adr + 4 + 2*(signed char)raw[2];
+			break;
+		case 0x9c:															// jmpi cc,[Rw]
+		case 0xab:															// calli cc,[Rw]
+			di->flags |= ((raw[0] == 0x9c) ? DIS_JUMP : DIS_CALL) | DIS_INDIRECT;
+			if(get_hi_nibble(raw[1]) != CC_UC) di->flags |= DIS_COND;
+			break;
+		case 0x9b:															// trap #trap7
+			di->flags |= DIS_CALL;
+			di->target = (unsigned long)(raw[1] >> 1) * 4;
+			break;
+		case 0xcb:case 0xdb:case 0xeb:case 0xfb:							// ret, rets, retp, reti
+			di->flags |= DIS_RET;
+			break;
+	}
+}
 
-		case RW_IND:			//	2 	//  [Rn]
-				printf("[r%d]",rval);
-				break;
+/*
+ * Decode the instruction at buf (file offset adr, avail bytes readable) into *di
+ *
+ * returns its length (2 or 4), 0 if fewer bytes than that are available
+ */
+int c167x_decode(const uint8_t *buf, unsigned long avail, unsigned long adr, DIS_INST *di)
+{
+	INST *ci = &inst_set[buf[0]];
+	INST *link;
+	int i, sub;
+
+	if(avail < 2 || avail < ci->len) return 0;
+
+	di->adr    = adr;
+	di->target = DIS_NO_TARGET;
+	di->len    = ci->len ? ci->len : 2;				// undefined opcodes are skipped a word at a time
+	di->flags  = ci->len ? 0 : DIS_INVALID;
+	di->sub    = 0;
+	di->nops   = 0;
+	di->raw[0] = buf[0];
+	di->raw[1] = buf[1];
+	di->raw[2] = (ci->len == 4) ? buf[2] : 0;
+	di->raw[3] = (ci->len == 4) ? buf[3] : 0;
+	if(ci->len == 0) return di->len;
+
+	if(ci->link != 0) {
+		sub = link_entry(buf[0], buf[1]);
+		if(sub < 0) {
+			di->flags |= DIS_INVALID;
+			return di->len;
+		}
+		link       = (INST *)ci->link;
+		ci         = &link[sub];
+		di->sub    = sub;
+		di->flags |= DIS_LINK;
+	}
 
-		case RW_IND_POST_INC:	//	3 	//  [Rn]+
-				printf("[r%d+]",rval);
-				break;
+	di->nops = (ci->argcount > DIS_MAX_OPS) ? DIS_MAX_OPS : ci->argcount;
+	for(i=0;i<di->nops;i++) {
+		decode_op(di, &di->op[i], ci->args.list[i].type, ci->args.list[i].pos);
+	}
+	decode_flow(di);
+	return di->len;
+}
 
-		case RW_IND_POST_DEC:	//	4 	//  [Rn]-
-				printf("[r%d-]",rval);
-				break;
+/*
+ * Decode len bytes at buf (buf[0] is file offset adr) linearly into out, stops when max are decoded
+ *
+ * returns the number of instructions decoded
+ */
+int c167x_decode_buf(const uint8_t *buf, unsigned long len, unsigned long adr, DIS_INST *out, int max)
+{
+	unsigned long i = 0;
+	int n = 0, skip;
+
+	while(n < max && (skip = c167x_decode(buf+i, len-i, adr+i, &out[n])) != 0) {
+		i += skip;
+		n++;
+	}
+	return n;
+}
+
+/*
+ * Decode the rom file offsets [start,end) of an image, the caller must free() the array
+ */
+DIS_INST *c167x_decode_image(ImageHandle *fh, unsigned long start, unsigned long end, int *num)
+{
+	DIS_INST *di;
+
+	*num = 0;
+	if(end > fh->len) end = fh->len;
+	if(start >= end) return 0;
+
+	di = (DIS_INST *)malloc(((end-start)/2 + 1) * sizeof(DIS_INST));
+	if(di == 0) return 0;
+	*num = c167x_decode_buf(fh->d.u8 + start, end-start, start, di, (end-start)/2 + 1);
+	return di;
+}
+
+/*
+ * Index of the nth (from 0) instruction with this first byte, and second byte if b2 >= 0, -1 if there is none.
+ * Lets a check pick e.g. the 10th 'mov r12,#data16' (E6 FC) of a needle instead of counting bytes.
+ */
+int c167x_find(const DIS_INST *di, int num, int opcode, int b2, int nth)
+{
+	int i;
+
+	for(i=0;i<num;i++) {
+		if(di[i].raw[0] != opcode || (b2 >= 0 && di[i].raw[1] != b2)) continue;
+		if(nth-- == 0) return i;
+	}
+	return -1;
+}
+
+// the table entry the instruction was decoded with
+static INST *inst_entry(const DIS_INST *di)
+{
+	INST *ci = &inst_set[di->raw[0]];
+
+	if(di->flags & DIS_LINK) ci = &((INST *)ci->link)[di->sub];
+	return ci;
+}
+
+const char *c167x_name(const DIS_INST *di)
+{
+	return inst_entry(di)->name;
+}
+
+//-[ Printer ]--------------------------------------------------------------------------------------------------------------
+
+static void print_op(OUTBUF *ob, const DIS_INST *di, const DIS_OP *op)
+{
+	const unsigned char *raw = di->raw;
+	unsigned char _byte, nibble;
+	int rval, rval_l;
+	char *name;
 
-		case RW_IND_PRE_INC:	//	5 	// +[Rn]
-				printf("[+r%d]",rval);
+	switch(op->type)
+	{
+		case RW_L:
+				ob_printf(ob, "r%d", get_lo_nibble(op->reg));
 				break;
 
-		case RW_IND_PRE_DEC:	//	6 	// -[Rn]
-				printf("[-r%d]",rval);
+		case RW:
+				if(op->pos == 1 || op->pos == 2) ob_printf(ob, "r%d", op->reg);
 				break;
 
-		case RW_IND_1_DATA16_2:	//	7 	//  [Rn+Data16]
-				if(rdata16 < 10) {
-					printf("[r%d+%d]",rval,rdata16);
+		case RW_IND:			ob_printf(ob, "[r%d]",  op->reg);	break;
+		case RW_IND_POST_INC:	ob_printf(ob, "[r%d+]", op->reg);	break;
+		case RW_IND_POST_DEC:	ob_printf(ob, "[r%d-]", op->reg);	break;
+		case RW_IND_PRE_INC:	ob_printf(ob, "[+r%d]", op->reg);	break;
+		case RW_IND_PRE_DEC:	ob_printf(ob, "[-r%d]", op->reg);	break;
+
+		case RW_IND_1_DATA16_2:
+				if(op->val < 10) {
+					ob_printf(ob, "[r%d+%d]", op->reg, op->val);
 				} else {
-					printf("[r%d+%02Xh]",rval,rdata16);
+					ob_printf(ob, "[r%d+%02Xh]", op->reg, op->val);
 				}
 				break;
 
-		case RB:				// 8 
-
-				rval = *(buf+1);	
-				
-				
-				if(pos == 1)
-				{
-//					nibble = get_hi_nibble(rval);
-//					nibble = 0;
-//					printf("%.2Xh", nibble);					// (if not found in list) show as a number
-					nibble = get_hi_nibble(rval);
-//					printf(".cRB=[%x]",nibble);
-					if((name = lookup_rh_regname(nibble)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-						printf("^%.2Xh", rval);					// (if not found in list) show as a number
+		case RB:
+				if(op->pos == 1 || op->pos == 2) {
+					if((name = lookup_rh_regname(op->reg)) == 0) { 	// try to identify number as a named register, DPP0, etc.
+						ob_printf(ob, "^%.2Xh", raw[1]);					// (if not found in list) show as a number
 					} else {
-						printf("%s",name);						// if found as a name
-					}
-
-				} 
-				else if(pos == 2) 
-				{
-					nibble = get_lo_nibble(rval);
-//					printf(".cRB=[%x]",nibble);
-					if((name = lookup_rh_regname(nibble)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-						printf("^%.2Xh", rval);					// (if not found in list) show as a number
-					} else {
-						printf("%s",name);						// if found as a name
+						ob_printf(ob, "%s",name);						// if found as a name
 					}
 				}
-
-
-//				rval  = *(buf+1);	
-//				printf(".cRB=%x",rval);
-//					if((name = lookup_regname(rval)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-//						printf("%.2Xh", rval);					// (if not found in list) show as a number
-//					} else 
-//						printf("%s",name);						// if found as a name
-//					}
 				break;
 
-// cregb(RR)              SFR/GPR byte context
-		case REGB2:				// 10  [ SFR/GPR byte context ] 
-//				printf("REGB[%x]", rval);
-				rval  = *(buf+1);	
-					rval = get_lo_nibble(rval);
-//					if((name = lookup_regname(rval)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-//						printf("%.2Xh", rval);					// (if not found in list) show as a number
-//					} else {
-						printf("r%d", rval);						// if found as a name
-//					}
+		case REGB2:				// [ SFR/GPR byte context ]
+				ob_printf(ob, "r%d", op->reg);
 				break;
 
-		case REGB3:				// 10  [ SFR/GPR byte context ] 
-				rval  = *(buf+1);	
-				if((name = lookup_regname(rval)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-					printf("r%X", rval);					// (if not found in list) show as a number
+		case REGB3:				// [ SFR/GPR byte context ]
+				if((name = lookup_regname(raw[1])) == 0) {
+					ob_printf(ob, "r%X", raw[1]);
 				} else {
-					printf("%s", name);						// if found as a name
+					ob_printf(ob, "%s", name);
 				}
 				break;
 
-
-		case REGB:				// 10  [ SFR/GPR byte context ] 
-//				printf(".cREGW");
-				rval = *(buf+1);	
-				_byte = (unsigned char)rval;
-				
-				if(len == 4) {
-//					printf(".cREGB[4]");
-					rval  = *(buf+1);	
-					if((name = lookup_regname(rval)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-						printf("r%X", rval);					// (if not found in list) show as a number
+		case REGB:				// [ SFR/GPR byte context ]
+				_byte = raw[1];
+				if(di->len == 4) {
+					if((name = lookup_regname(_byte)) == 0) {
+						ob_printf(ob, "r%X", _byte);
 					} else {
-						printf("%s", name);						// if found as a name
+						ob_printf(ob, "%s", name);
 					}
-					
-				} else if(len == 2) {
-//					printf(".cREGB[2]");
-				
-	//				nibble = get_hi_nibble(rval);	
-					nibble = _byte;
-	//				printf("<%-2.2X:",nibble);
-	//				printBits(sizeof(nibble), &nibble);
-	//				printf(">");
-
-	//				nibble = (_byte & 0b00001111);
-					nibble = (_byte & 0b11110000) >> 4;
-	///				printf("<%-2.2X:",nibble);
-	///				printBits(sizeof(nibble), &nibble);
-	///				printf(">");
-
+				} else if(di->len == 2) {
 					// 1111 set ?
-					if( (((_byte & 0b11110000) >> 4) == 1) ) 
-					{
+					if( (((_byte & 0b11110000) >> 4) == 1) ) {
 						// RL or RH?
+						nibble = (_byte & 0b01110000) >> 3;
 						if( (((_byte & 0b10000000) >> 7) == 0) ) {
-							nibble = (_byte & 0b01110000) >> 3;
-							printf("***RL%d", nibble);
+							ob_printf(ob, "***RL%d", nibble);
 						} else {
-							nibble = (_byte & 0b01110000) >> 3;
-							printf("***RH%d", nibble);
-						
-						}					
-						break;
+							ob_printf(ob, "***RH%d", nibble);
+						}
 					} else {
-						rval = (_byte & 0b01110000) >> 3;
+						rval   = (_byte & 0b01110000) >> 3;
 						rval_l = get_lo_nibble(_byte);
-	//					printf("rXX");			// ... then show it as a R0-R15 	
-
-							if((name = lookup_rh_regname(rval_l)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-								printf("%.2Xh", rval);					// (if not found in list) show as a number
-							} else {
-								printf("%s",name);						// if found as a name
-							}
-						
-						break;
+						if((name = lookup_rh_regname(rval_l)) == 0) {
+							ob_printf(ob, "%.2Xh", rval);
+						} else {
+							ob_printf(ob, "%s",name);
+						}
 					}
 				}
-//				printf("_%d",nibble);			// ... then show it as a R0-R15 	
-				
 				break;
 
-		case REGW:				// 10  [ SFR/GPR byte context ] 
-//				printf(".cREGW");
-				rval = *(buf+1);
-				nibble = get_hi_nibble(rval);
-				if(nibble == 0xf) { 				// if high nibble is 1111 (0xf) 			
-					printf("r%d",get_lo_nibble(rval));			// ... then show it as a R0-R15 	
+		case REGW:				// [ SFR/GPR word context ]
+				if(get_hi_nibble(raw[1]) == 0xf) { 				// if high nibble is 1111 (0xf)
+					ob_printf(ob, "r%d",get_lo_nibble(raw[1]));		// ... then show it as a R0-R15
 				} else {
-					if((name = lookup_regname(rval)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-						printf("%.2Xh", rval);					// (if not found in list) show as a number
+					if((name = lookup_regname(raw[1])) == 0) { 	// try to identify number as a named register, DPP0, etc.
+						ob_printf(ob, "%.2Xh", raw[1]);				// (if not found in list) show as a number
 					} else {
-						printf("%s",name);						// if found as a name
+						ob_printf(ob, "%s",name);						// if found as a name
 					}
 				}
 				break;
 
-		case MEM:				// 11 
-				if( *(buf+0) == 0xc2 || *(buf+0) == 0xf7)
-				{ 
-					printf("byte_%X",rdata16);	//+0x378000);
+		case MEM:
+				if(raw[0] == 0xc2 || raw[0] == 0xf7) {
+					ob_printf(ob, "byte_%X", op->val);
+				} else if((name = lookup16_regname(op->val)) == 0) {
+					ob_printf(ob, "word_%X", op->val);
 				} else {
-
-					if((name = lookup16_regname(rdata16)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-						printf("word_%X",rdata16);	//+0x378000);
-					} else {
-						printf("%s",name);						// if found as a name
-					}
-
-
+					ob_printf(ob, "%s",name);
 				}
-//				printf("MEM");
 				break;
 
-		case BITADR_W:			// 12
-					rval = *(buf+3);	
-					lo = get_lo_nibble(rval);
-					rval = *(buf+2);	
-
-					printf("word_%X.%d",0xFD00+(rval*2), lo );
-					break;
-
-		case BITADR_W2:			// 12
-					rval = *(buf+1);	
-					printf("word_%X.%d",0xFD00+(rval*2), get_hi_nibble(*(buf+3)));
-					break;
-					 
-		case BITADR:			// 12
-#if 0
-				rval = *(buf+1);	
-				nibble = get_hi_nibble(rval);
-				if(nibble == 0xf) { 				// if high nibble is 1111 (0xf) 			
-					printf("r%d",get_lo_nibble(rval));			// ... then show it as a R0-R15 	
-				} else {
-					if((name = lookup_regname(rval)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-						printf("%.2Xh", rval);					// (if not found in list) show as a number
-					} else {
-						printf("%s",name);						// if found as a name
-					}
-				}
-				printf(".");
-#endif
-				//exper
-				if(p->len == 2) 
-				{
-					rval = *(buf+0);	
-					hi = get_hi_nibble(rval);
-
-					rval = *(buf+1);	
-					if((name = lookup_regname(rval)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-						printf("%.2Xh ??????????", rval);					// (if not found in list) show as a number
-					} else {
-						printf("%s",name);						// if found as a name
-					}
+		case BITADR_W:
+		case BITADR_W2:
+				ob_printf(ob, "word_%X.%d", 0xFD00+(op->val*2), op->reg);
+				break;
 
-//					printf("word_%X.%d [***************]",0xFD00+(rval*2), hi);
-					
-				} else {
-									
-					if(pos == 1) {
-						rval = *(buf+1);	
-						printf("word_%X.%d",0xFD00+(rval*2), get_hi_nibble(*(buf+3)));
+		case BITADR:
+				if(di->len == 2) {
+					if((name = lookup_regname(raw[1])) == 0) {
+						ob_printf(ob, "%.2Xh ??????????", raw[1]);
 					} else {
-	//					printf("BITADR");					
-						num_opcodes  = (*(buf+2))+2;
-						printf("loc_%X",rom_start+(num_opcodes << 1));
+						ob_printf(ob, "%s",name);
 					}
-				
+				} else {
+					ob_printf(ob, "word_%X.%d", 0xFD00+(op->val*2), op->reg);
 				}
 				break;
-				
-		case BITOFF:			// 13
-				printf("BITOFF");
-				break;
-
-		case IRANG2:			// 14
-				printf("IRANG2");
-				break;
 
-		case DATA3:				// 15
-				printf("#%d",rval);	//DATA3");
-				break;
+		case BITOFF:	ob_printf(ob, "BITOFF");	break;
+		case IRANG2:	ob_printf(ob, "IRANG2");	break;
+		case DATA3:		ob_printf(ob, "#%d", op->reg);	break;
 
-		case DATA4:				// 16
-				data4 = ((rval & 0b11110000) >> 4);
-				if(data4 < 10) {					
-					printf("#%x",data4 );		//DATA4");
+		case DATA4:
+				if(op->reg < 10) {
+					ob_printf(ob, "#%x", op->reg);
 				} else {
-					printf("#%02Xh",data4 );	//DATA4");
+					ob_printf(ob, "#%02Xh", op->reg);
 				}
 				break;
 
-		case DATA8:				// 17
-				printf("DATA8");
-				break;
+		case DATA8:		ob_printf(ob, "DATA8");	break;
 
-		case DATA16: 			// 18
-				if(rdata16 < 10) {
-					printf("#%d",rdata16);					
+		case DATA16:
+				if(op->val < 10) {
+					ob_printf(ob, "#%d", op->val);
 				} else {
-					printf("#%-4.4Xh",rdata16);
+					ob_printf(ob, "#%-4.4Xh", op->val);
 				}
-//				printf("DATA16");
 				break;
 
-		case MASK8: 			// 19
-				printf("MASK8");
-				break;
+		case MASK8:		ob_printf(ob, "MASK8");				break;
+		case ADR:		ob_printf(ob, "loc_%X", di->target);	break;
+		case SEG:		ob_printf(ob, "%Xh", raw[1]);			break;
+		case REG:		ob_printf(ob, "REG");					break;
+		case TRAP7:		ob_printf(ob, "TRAP7");				break;
+		case CC:		ob_printf(ob, "cc_%s", CCNames[op->reg & 0xf].name);	break;
+		case REL:		ob_printf(ob, "loc_%X", di->target);	break;
 
-		case ADR:				// 20
-				rval = get16(buf+2);	
-				printf("loc_%X",rval);
+		default:
+				ob_printf(ob, "????");
 				break;
+	}
+}
 
-		case SEG:				// 21
-				rval = *(buf+1);	
-				printf("%Xh",rval);
-//				printf("SEG");
-				break;
+// instructions from a linked sub table
+static void print_link(OUTBUF *ob, const DIS_INST *di)
+{
+	const unsigned char *raw = di->raw;
+	INST *link = (INST *)inst_set[raw[0]].link;
+	unsigned char hi = get_hi_nibble(raw[1]), lo = get_lo_nibble(raw[1]);
+	char regname[16];
+	char *name;
 
-		case REG: 				// 22
-				printf("REG");
-				break;
+	switch(raw[0]) {
+		case 0x08:case 0x09:
+		case 0x18:case 0x19:
+		case 0x28:case 0x29:
+		case 0x38:case 0x39:
+		case 0x48:case 0x49:
+		case 0x58:case 0x59:
+		case 0x68:case 0x69:
+		case 0x78:case 0x79:
+			regname[0] = 0;
+			if(link[0].args.list[0].type == RB) {
+				if((name = lookup_rh_regname(hi)) != 0) snprintf(regname, sizeof(regname), "%s", name);
+			} else if(link[0].args.list[0].type == RW) {
+				snprintf(regname, sizeof(regname), "r%d", hi);
+			}
+			if(di->sub == 0) {
+				ob_printf(ob, " %s%s, #%d", link[0].name, regname, lo);
+			} else if(di->sub == 1) {
+				ob_printf(ob, " %s%s, [r%d]", link[1].name, regname, lo & 3);
+			} else {
+				ob_printf(ob, " %s%s, [r%d+]", link[2].name, regname, lo & 3);
+			}
+			break;
 
-		case TRAP7: 			// 23
-				printf("TRAP7");
-				break;
+		case 0xd7:		// opcode: 'extX'
+			ob_printf(ob, " %s", link[di->sub].name);
+			if(di->sub & 1) {
+				ob_printf(ob, "#%-4.4Xh", get16((unsigned char *)raw+2));	// 01AA0000BBBBBBBBBBBBBBBB : extp/extpr, page : 16 bits
+			} else {
+				ob_printf(ob, "#%-2.2Xh", raw[2]);							// 00AA0000BBBBBBBB00000000 : exts/extsr, segment : 8 bits
+			}
+			ob_printf(ob, ", ");
+			ob_printf(ob, "#%d", ((raw[1] & 0b00110000) >> 4)+1);			// irang : 2 bits
+			break;
 
-		case CC: 				// 24
-				val = strtol(p->fmt,&p->fmt+4,2);
+		default:
+			ob_printf(ob, " %-8s", (char *)inst_set[raw[0]].name);
+			ob_printf(ob, "Link for [%#2x]", raw[0]);
+			break;
+	}
+}
 
-				printf("cc_%s",CCNames[val]);
-				break;
+/*
+ * Format the mnemonic and operands of a decoded instruction (no line feed)
+ */
+void c167x_format(OUTBUF *ob, const DIS_INST *di)
+{
+	INST *ci = &inst_set[di->raw[0]];
+	int i, n = 0;
+
+	if(ci->name == 0) {
+		ob_printf(ob, " %-8s", "???");
+	} else if(ci->link == 0) {
+		ob_printf(ob, " %-8s", (char *)ci->name);
+		for(i=0;i<di->nops && n<2;i++) {
+			// the bit number fields (q/z) of 4 byte bit instructions are part of the bitaddr already shown
+			if(di->op[i].type == BITADR && di->len == 4 && di->op[i].pos >= 3) continue;
+			if(n++ > 0) ob_printf(ob, ", ");
+			print_op(ob, di, &di->op[i]);
+		}
+	} else {
+		print_link(ob, di);
+	}
+}
 
-		case REL: 				// 25
-		{
-				int num_opcodes, skip_bytes;
-				num_opcodes  = (*(buf+1))+1;
-				skip_bytes   = num_opcodes << 1;		// jump offset is measured in words so x2
-				printf("loc_%X",rom_start+skip_bytes);
-		}				
-		break;
+void c167x_print(const DIS_INST *di, int rel)
+{
+	INST *ci = &inst_set[di->raw[0]];
+	OUTBUF *ob = ob_get();
 
-		default:
-				printf("????");
-				break;
+	ob_printf(ob, "0x%-8.8X: (+%-3d) ", (int)di->adr, rel);
+
+	// show hex dump of the opcode, opcodes can either be 2 or 4 bytes long
+	if(di->len == 2) {
+		ob_printf(ob, " %02X %02X       \t\t", di->raw[0], di->raw[1]);
+	} else {
+		ob_printf(ob, " %02X %02X %02X %02X \t\t", di->raw[0], di->raw[1], di->raw[2], di->raw[3]);
+	}
+	c167x_format(ob, di);
+	ob_printf(ob, "\n");
+
+	// support for line feed after specific opcodes, rets, calls, jmps, etc.
+	if(ci->addLF > 0) {
+		ob_printf(ob, "\n");
 	}
+	ob_flush(ob);
 }
 
+/*
+ * Disassemble len bytes at buf (rom file offset rom_start), decoded first then printed
+ */
 void c167x_diss(unsigned char *rom_start, uint8_t *buf, int len)
 {
- unsigned char chA, chB, chC, chD, rval, nibble, _byte, hi, lo, pos;
- int i=0,skip,ln,argc;
- int rdata16;
- int type, numbits, argnum, bitcount;
- INST *ci;
- INST *link;
- char s_bin[8*8];
- char s_tmp[8*8];
-
-	unsigned short val;
-//	len = len*10;
-	
-	i=0;
-	while(1) 
-	{
-		if(len > 4) {		
-			chA = *(buf+0); chB = *(buf+1); chC = *(buf+2); chD = *(buf+3);
-
-			ci=&inst_set[chA];
-			
-			// get length of opcode from lookup table
-			skip = ci->len;			
-
-			printf("0x%-8.8X: (+%-3d) ",(int)rom_start+i, (int)i);
-
-			// show hex dump of the opcode
-			if(skip == 2) {			// opcodes can either be 2 bytes
-				printf(" %02X %02X       \t\t", chA, chB);
-			} else if(skip == 4) { 	// or 4 bytes long...
-				printf(" %02X %02X %02X %02X \t\t", chA, chB, chC, chD);
-			} 
-
-			// show offsets and opcode name
-			link = ci->link;
-				
-			if(link == 0)
-			{
-				printf(" %-8s", (char *)ci->name);
-				//
-				// lets process arguments for this opcode
-				//
-				if(ci->argcount > 0)		// shows args for at least 1 argument
-				{
-#if 0
-					for(argc=0;argc < ci->argcount; argc++ )
-					{
-//						argnum  = find_argnum_by_offset(ci, argc, ci->argcount);
-						type    = ci->args.list[argc].type;
-						pos     = ci->args.list[argc].pos;
-						numbits = ci->bits.ops[argc];
-						printf("\n\t\t\t{ listpos+%d: bits=%2d , type=%2d, order=%2d }, ", argc, numbits, type, pos );
-
-					}
-#endif
-					rdata16 = get16((buf+2));	
-					rval    = *(buf+1);	
-					hi      = get_hi_nibble(rval);
-					lo      = get_lo_nibble(rval);
-
-					pos  = ci->args.list[0].pos;
-					type = ci->args.list[0].type;
-					if(pos == 1) {
-						rval    = get_hi_nibble(*(buf+1));
-					} else if(pos == 2){
-						rval    = get_lo_nibble(*(buf+1));
-					}
-					
-					translate_arg_type(rom_start+i, buf, rval, rdata16, ci, type, pos);
-					if(ci->argcount > 1)
-					{
-						printf(", ");
-
-						pos  = ci->args.list[1].pos;
-						type = ci->args.list[1].type;
-						if(pos == 1) {
-							rval    = *(buf+1);
-						} else if(pos == 2){
-							rval    = get_lo_nibble(*(buf+1));
-						}
-						translate_arg_type(rom_start+i, buf, rval, rdata16, ci, type, pos);							
-					}
-				}
-				
-			} else {
-				switch(chA) {
-						case 0x08:case 0x09:
-						case 0x18:case 0x19:
-						case 0x28:case 0x29:
-						case 0x38:case 0x39:
-						case 0x48:case 0x49:
-						case 0x58:case 0x59:
-						case 0x68:case 0x69:
-						case 0x78:case 0x79:
-						{
-							char *name;
-							char regname[16];
-							unsigned char type;
-							//determine which instruction we are dealing with... 1 of 3
-							//AAAA0BBB
-							//AAAA10BB
-							//AAAA11BB
-							_byte = *(buf+1);	
-							nibble = (_byte & 0b00001000) >> 3;
-							hi      = get_hi_nibble(_byte);
-							lo      = get_lo_nibble(_byte);
-
-							if(link[0].args.list[0].type == RB) {
-								type = RB;	//printf("ARG1 is RB!!!");
-								if((name = lookup_rh_regname(hi)) == 0) { 	// try to identify number as a named register, DPP0, etc.
-									sprintf(regname,"%.2Xh", rval);					// (if not found in list) show as a number
-								} else {
-									sprintf(regname,"%s",name);						// if found as a name
-								}
-							}
-							else if(link[0].args.list[0].type == RW) {
-								type = RW;	//]printf("ARG1 is RW!!!");
-								sprintf(regname,"r%d",hi);						// if found as a name
-							}
-							
-							if(nibble == 0) 
-							{
-								printf(" %s%s, #%d",link[0].name, regname, lo);								
-							} 
-							else 
-							{
-								nibble = (_byte & 0b00000100) >> 4;
-								if(nibble == 0) {
-									printf(" %s%s, #%d ; AAAA10BB {INCOMPLETE}",link[1].name, regname, lo);								
-								} else {
-									printf(" %s%s, #%d ; AAAA11BB {INCOMPLETE}",link[2].name, regname, lo);								
-								}
-							}
-							
-						}
-						break;
-
-						case 0xd7:		// opcode: 'extX'
-						{
-							int opcode;
-							_byte = *(buf+1);	
-							opcode = (_byte & 0b11000000) >> 6;			// instruction offset : 1st 2 bits
-							printf(" %s", link[opcode].name);
-							switch(opcode) 
-							{
-								case 0b00:	// 00AA0000BBBBBBBB00000000 : exts
-								case 0b10:  // 10AA0000BBBBBBBB00000000 : extsr
-									printf("#%-2.2Xh", *(buf+2));				// segment :  8 bits
-									printf(", ");
-									nibble = (_byte & 0b00110000) >> 4;			// irang   :  2 bits
-									printf("#%d", nibble+1);
-									break;
-								case 0b01:  // 01AA0000BBBBBBBBBBBBBBBB : extp
-								case 0b11:  // 11AA0000BBBBBBBBBBBBBBBB : extpr
-									printf("#%-4.4Xh", get16(buf+2));			// segment : 16 bits
-									printf(", ");
-									nibble = (_byte & 0b00110000) >> 4;			// irang   :  2 bits
-									printf("#%d", nibble+1);
-									break;
-							}
-						}
-						break;
-						default: 
-							printf(" %-8s", (char *)ci->name);
-							printf("Link for [%#2x]",chA);
-							break;
-				}
-
-			}
-			printf("\n");
-			
-			// support for line feed after specific opcodes, rets, calls, jmps, etc.
-			if(ci->addLF > 0) {
-				printf("\n");
-			} 
-			
-			// to next opcode in buffer
-			buf += skip;
-			i   += skip;
-			len -= skip;
-		} else {
-			break;
-		}
+	DIS_INST *di;
+	int i, num = 0;
+	unsigned long off = 0;
+
+	di = (DIS_INST *)malloc((len/2 + 1) * sizeof(DIS_INST));
+	if(di == 0) return;
+
+	// the listing stops once 4 bytes or less are left
+	while(len - (long)off > 4) {
+		int skip = c167x_decode(buf+off, len-off, (unsigned long)rom_start+off, &di[num]);
+		if(skip == 0) break;
+		off += skip;
+		num++;
+	}
+	for(i=0;i<num;i++) {
+		c167x_print(&di[i], (int)(di[i].adr - (unsigned long)rom_start));
 	}
-	printf("***\n");
+	con_printf("***\n");
+	free(di);
 }
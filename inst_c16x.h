@@ -165,6 +165,49 @@ extern INST inst_table_0xd7[];
 extern INST inst_table_0xdc[];                                                         
 extern INST inst_set[256];
 
+/*
+ * Decoded instructions (see c167x_decode), printing is a separate pass over them (c167x_print).
+ * Operands keep the addressing mode of the inst_set entry with its fields already extracted,
+ * so analysis can read e.g. the #data16 of a 'mov r12,#data16' without counting needle bytes.
+ */
+#define DIS_MAX_OPS		3
+
+#define DIS_JUMP		0x01	// jmpr, jmpa, jmpi, jmps and the bit jumps
+#define DIS_CALL		0x02	// callr, calla, calli, calls, pcall, trap
+#define DIS_RET			0x04	// ret, rets, retp, reti
+#define DIS_COND		0x08	// only taken on a condition (cc other than cc_UC or a bit test)
+#define DIS_INDIRECT	0x10	// target is in a register (jmpi, calli), no target
+#define DIS_LINK		0x20	// decoded from a linked sub table, 'sub' is the entry
+#define DIS_INVALID		0x80	// undefined opcode, or no sub table entry matches
+
+#define DIS_NO_TARGET	0xFFFFFFFFUL
+
+typedef struct DIS_OP {
+	unsigned char  type;		// addressing mode (RW, MEM, DATA16, ..)
+	unsigned char  pos;			// argument position in the inst_set entry
+	unsigned char  reg;			// register number, 4/8 bit field or bit number
+	unsigned short val;			// 16 bit field (mem address, #data16, caddr) or bitoff
+} DIS_OP;
+
+typedef struct DIS_INST {
+	uint32_t       adr;			// rom file offset
+	uint32_t       target;		// rom file offset of a direct jump/call target, DIS_NO_TARGET if none
+	unsigned char  raw[4];		// instruction bytes, raw[2..3] are 0 for 2 byte instructions
+	unsigned char  len;			// 2 or 4
+	unsigned char  nops;		// operands decoded
+	unsigned char  flags;		// DIS_xxx
+	unsigned char  sub;			// entry in the linked sub table (DIS_LINK)
+	DIS_OP         op[DIS_MAX_OPS];
+} DIS_INST;
+
+int  c167x_decode(const uint8_t *buf, unsigned long avail, unsigned long adr, DIS_INST *di);
+int  c167x_decode_buf(const uint8_t *buf, unsigned long len, unsigned long adr, DIS_INST *out, int max);
+DIS_INST *c167x_decode_image(ImageHandle *fh, unsigned long start, unsigned long end, int *num);
+int  c167x_find(const DIS_INST *di, int num, int opcode, int b2, int nth);
+const char *c167x_name(const DIS_INST *di);
+void c167x_format(OUTBUF *ob, const DIS_INST *di);
+void c167x_print(const DIS_INST *di, int rel);
+
 void c167x_diss(unsigned char *rom_start, uint8_t *buf, int len);
 
 #endif
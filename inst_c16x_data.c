@@ -825,7 +825,7 @@ INST inst_set[256] = {
  { .opcode = 0xb7, .len = 4, .name = "srXX  ...", .link = &inst_table_0xb7 },
  { .opcode = 0xb8, .len = 2, .name = "mov      ", .bits = { 4,4 },         .fmt = "AAAABBBB",                .argcount = 2, .args = { RW_IND, 2, RW, 1 }                            },
  { .opcode = 0xb9, .len = 2, .name = "movb     ", .bits = { 4,4 },         .fmt = "AAAABBBB",                .argcount = 2, .args = { RW_IND, 2, RB, 1 }                            },
- { .opcode = 0xba, .len = 4, .name = "jnbs     ", .bits = { 8,8,4,4 },     .fmt = "AAAAAAAABBBBBBBBCCCC0000",.argcount = 2, .args = { BITADR, 1, BITADR, 3, REL, 2 }, .addLF=1      },
+ { .opcode = 0xba, .len = 4, .name = "jnbs     ", .bits = { 8,8,4,4 },     .fmt = "AAAAAAAABBBBBBBBCCCC0000",.argcount = 3, .args = { BITADR, 1, BITADR, 3, REL, 2 }, .addLF=1      },
  { .opcode = 0xbb, .len = 2, .name = "callr    ", .bits = { 8 },           .fmt = "AAAAAAAA",                .argcount = 1, .args = { REL, 1 }, .addLF=1                            },
  { .opcode = 0xbc, .len = 2, .name = "ashr     ", .bits = { 4,4 },         .fmt = "AAAABBBB",                .argcount = 2, .args = { RW, 2, DATA4, 1 }                             },
  { .opcode = 0xbd, .len = 2, .name = "jmpr     ", .bits = { 4,4 },         .fmt = "1011AAAA",                .argcount = 2, .args = { CC, 2,  REL, 1 }, .addLF=1                    },
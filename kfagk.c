@@ -34,28 +34,28 @@ int check_kfagk(ImageHandle *fh, int skip)
 	int found = 0;
 	if(skip == 0) return found;		
 
-	printf("\n-[ Exhaust Valve KFAGK Table ]---------------------------------------------------------------------\n\n");
+	con_printf("\n-[ Exhaust Valve KFAGK Table ]---------------------------------------------------------------------\n\n");
 		
-	printf(">>> Scanning for KFAGK Table #1 Checking sub-routine Variant #1 [manages exhaust valve/flap opening] \n");
+	con_printf(">>> Scanning for KFAGK Table #1 Checking sub-routine Variant #1 [manages exhaust valve/flap opening] \n");
 	dump_len = KFAGK_needle_len+4;
 	addr     = search( fh, (unsigned char *)&KFAGK_needle, (unsigned char *)&KFAGK_mask, KFAGK_needle_len, 0 );
 	if(addr == NULL) {
-		printf("Sequence not found\n");		
-		printf("\n>>> Scanning for KFAGK Table #1 Checking sub-routine Variant #2 [manages exhaust valve/flap opening] \n");
+		con_printf("Sequence not found\n");		
+		con_printf("\n>>> Scanning for KFAGK Table #1 Checking sub-routine Variant #2 [manages exhaust valve/flap opening] \n");
 		dump_len = KFAGK_needle2_len+4;
 		addr     = search( fh, (unsigned char *)&KFAGK_needle2, (unsigned char *)&KFAGK_mask2, KFAGK_needle2_len, 0 );
 	}
 	
 	if(addr != NULL) {
-		printf("Found at offset=0x%x \n",(int)(addr-rom_load_addr) );
+		con_printf("Found at offset=0x%x \n",(int)(addr-rom_load_addr) );
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(addr-rom_load_addr, addr, dump_len); }
 		// dump KFAGK table
 		dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 2), get16((unsigned char *)addr + 6), &KFAGK_table, 0);						
 	} else {
-		printf("Sequence not found\n");				
+		con_printf("Sequence not found\n");				
 	}
-	printf("\n\n");
+	con_printf("\n\n");
 
 	return found;
 }
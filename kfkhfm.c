@@ -33,12 +33,12 @@ int check_kfkhfm(ImageHandle *fh, int skip)
 	 */
 	if(skip == 0) return found;		
 
-	printf("\n-[ MAF Sensor Correction KFKHFM ]-----------------------------------------------------------\n\n");
-	printf(">>> Scanning for KFKHFM Table Lookup code sequence... \n");
-	found = find_dump_table_dppx( fh->d.p, fh->len, &needle_KFKHFM, &mask_KFKHFM, needle_KFKHFM_len, +2, dpp1_value-1, &KFKHFM_table);
+	con_printf("\n-[ MAF Sensor Correction KFKHFM ]-----------------------------------------------------------\n\n");
+	con_printf(">>> Scanning for KFKHFM Table Lookup code sequence... \n");
+	found = find_dump_table_dppx( fh->d.p, fh->len, &needle_KFKHFM, &mask_KFKHFM, needle_KFKHFM_len, +2, SEG_DPP_TRACKED, &KFKHFM_table);
 
-	if(found == 0) { printf("Sequence not found\n"); }
-	if(found > 1)  { printf("**** Developer Warning****: False positive detected. >1 match found. Check needle is unique!\n"); }
+	if(found == 0) { con_printf("Sequence not found\n"); }
+	if(found > 1)  { con_printf("**** Developer Warning****: False positive detected. >1 match found. Check needle is unique!\n"); }
 
 	return found;
 }
@@ -22,6 +22,7 @@
 #include "kfmsnwdk.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "dpptrack.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -35,21 +36,21 @@ int check_kfmsnwdk(ImageHandle *fh, int skip)
 
 	if(skip == 0) return found;		
 
-	printf("\n>>> Scanning for BGMSZS() for calculation of mass flows into intake manifold, to discover KFMSNWDK map ...\n");
+	con_printf("\n>>> Scanning for BGMSZS() for calculation of mass flows into intake manifold, to discover KFMSNWDK map ...\n");
 	addr = search( fh, (unsigned char *)&needle_BGMSZS, (unsigned char *)&mask_BGMSZS, needle_BGMSZS_len, 0 );
 	if(addr != NULL) {
-		printf("\nfound at offset=0x%x \n\n",(int)(addr-(int)rom_load_addr) );
+		con_printf("\nfound at offset=0x%x \n\n",(int)(addr-(int)rom_load_addr) );
 		// get offset to 'BGMSZS'...
-		translate_seg(&_kfmsnwdk, "KFMSNWDK", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+46) /*val*/);
+		translate_seg(&_kfmsnwdk, "KFMSNWDK", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+46) /*seg*/, get16((unsigned char *)addr+46) /*val*/);
 		show_seg(&_kfmsnwdk); 
 		if(show_diss) { 
-			printf("Dumping ...\n");
+			con_printf("Dumping ...\n");
 			c167x_diss(addr-(int)rom_load_addr, addr, needle_BGMSZS_len+16); 
 		}
-		dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 46), dpp1_value-1, &KFMSNWDK_table, 0);	
+		dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 46), dpp_seg_at(fh, (unsigned char *)addr + 46), &KFMSNWDK_table, 0);	
 
 	} else {
-		printf("\nNot found\n");
+		con_printf("\nNot found\n");
 	}
 
 	return found;
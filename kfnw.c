@@ -34,16 +34,16 @@ int check_kfnw(ImageHandle *fh, int skip, int mode)
 	if(skip == 0) return found;		
 
 	if(mode == 0) {
-		printf("\n-[ KFNWWL Characteristic map for variable camshaft control during warm up ]------\n\n");
-		printf(">>> Scanning for KFNWWL Table Lookup code sequence... \n");
+		con_printf("\n-[ KFNWWL Characteristic map for variable camshaft control during warm up ]------\n\n");
+		con_printf(">>> Scanning for KFNWWL Table Lookup code sequence... \n");
 		found = find_dump_table_seg( fh->d.p, fh->len, &needle_NWS, &mask_NWS, needle_NWS_len, +2, +6, &KFNWWL_table);
 	} else if(mode == 1) {
-		printf("\n-[ KFNW Characteristic map for variable camshaft control ]------------------------\n\n");
-		printf(">>> Scanning for KFNW Table Lookup code sequence... \n");
+		con_printf("\n-[ KFNW Characteristic map for variable camshaft control ]------------------------\n\n");
+		con_printf(">>> Scanning for KFNW Table Lookup code sequence... \n");
 		found = find_dump_table_seg( fh->d.p, fh->len, &needle_NWS, &mask_NWS, needle_NWS_len, +28, +32, &KFNW_table);
 	}
-	if(found == 0) { printf("Sequence not found\n"); }
-	if(found > 1)  { printf("**** Developer Warning****: False positive detected. >1 match found. Check needle is unique!\n"); }
+	if(found == 0) { con_printf("Sequence not found\n"); }
+	if(found > 1)  { con_printf("**** Developer Warning****: False positive detected. >1 match found. Check needle is unique!\n"); }
 
 	return found;
 }
@@ -22,6 +22,7 @@
 #include "kfped.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "dpptrack.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -34,24 +35,24 @@ int check_kfped(ImageHandle *fh, int skip, int mode)
 
 	if(skip == 0) return found;		
 
-	printf("\n-[ Throttle Pedal KFPED/KFPEDR Table ]---------------------------------------------------------------------\n\n");
-	printf(">>> Scanning for KFPED/KFPEDR Table #1 Checking sub-routine Variant #1 [manages throttle pedal torque requests] \n");
+	con_printf("\n-[ Throttle Pedal KFPED/KFPEDR Table ]---------------------------------------------------------------------\n\n");
+	con_printf(">>> Scanning for KFPED/KFPEDR Table #1 Checking sub-routine Variant #1 [manages throttle pedal torque requests] \n");
 	addr = search( fh, (unsigned char *)&KFPED_needle, (unsigned char *)&KFPED_mask, KFPED_needle_len, 0 );
 	if(addr != NULL) {
-		printf("Found at offset=0x%x KFPEDR @+14, KFPED @ +36\n\n",(int)(addr-rom_load_addr));
+		con_printf("Found at offset=0x%x KFPEDR @+14, KFPED @ +36\n\n",(int)(addr-rom_load_addr));
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(addr-rom_load_addr, addr, KFPED_needle_len+4); }
 
 		if(mode == 2) {
 			// dump KPEDR table
-			dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 14), dpp1_value-1, &KPEDR_table, 0);
+			dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 14), dpp_seg_at(fh, (unsigned char *)addr + 14), &KPEDR_table, 0);
 		}
 		if(mode == 1) {
 			// dump KPED table (found table, rom, val, segment, table def)
-			dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 36), dpp1_value-1, &KPED_table, 0);
+			dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 36), dpp_seg_at(fh, (unsigned char *)addr + 36), &KPED_table, 0);
 		}
 	}
-	printf("\n\n");
+	con_printf("\n\n");
 
 	return found;
 }
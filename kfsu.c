@@ -36,12 +36,12 @@ int check_kfsu(ImageHandle *fh, int skip, int mode)
 
 	if(skip == 0) return found;		
 
-	printf("\n>>> Scanning for SU() for Intake manifold switch-over, to discover KFSU/KFSU2 maps...\n");
+	con_printf("\n>>> Scanning for SU() for Intake manifold switch-over, to discover KFSU/KFSU2 maps...\n");
 	addr = search( fh, (unsigned char *)&needle_SU, (unsigned char *)&mask_SU, needle_SU_len, 0 );
 	if(addr != NULL) {
-		printf("\nfound at offset=0x%x\n",(int)(addr-(int)rom_load_addr) );
+		con_printf("\nfound at offset=0x%x\n",(int)(addr-(int)rom_load_addr) );
 		if(show_diss) { 
-			printf("Dumping ...\n");
+			con_printf("Dumping ...\n");
 			c167x_diss(addr-(int)rom_load_addr, addr, needle_SU_len+16); 
 		}
 
@@ -61,7 +61,7 @@ int check_kfsu(ImageHandle *fh, int skip, int mode)
 		}
 
 	} else {
-		printf("\nNot found\n");
+		con_printf("\nNot found\n");
 	}
 
 	return found;
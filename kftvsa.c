@@ -36,18 +36,18 @@ int check_kftvsa(ImageHandle *fh, int skip, int mode)
 	if(skip == 0) return found;		
 
 	if(mode == 1) {
-		printf("\n-[ KFTVSA Delay time for fuel cutoff ]-----------------\n\n");
+		con_printf("\n-[ KFTVSA Delay time for fuel cutoff ]-----------------\n\n");
 	} else if(mode == 2) { 
-		printf("\n-[ KFTVSA0 Delay time for fuel cutoff ]----------------\n\n");
+		con_printf("\n-[ KFTVSA0 Delay time for fuel cutoff ]----------------\n\n");
 	}
 
 	/* search: *** Find BBSAWE() function by searching for byte sequence */
-	printf(">>> Scanning for BBSAWE() function lookup code sequence... \n");
+	con_printf(">>> Scanning for BBSAWE() function lookup code sequence... \n");
 	byte_offset    = search_offset( rom_load_addr, fh->len, (unsigned char *)&needle_BBSAWE, (unsigned char *)&mask_BBSAWE, needle_BBSAWE_len);
 	if(byte_offset != NULL) 
 	{
 		addr = rom_load_addr + byte_offset;
-		printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
+		con_printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
 
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(byte_offset, rom_load_addr + byte_offset, needle_BBSAWE_len+16); }
@@ -67,12 +67,12 @@ int check_kftvsa(ImageHandle *fh, int skip, int mode)
 		translate_seg(&_snm08__ub, "SNM08__UB", rom_load_addr, get16((unsigned char *)addr+26) /*seg*/, get16((unsigned char *)addr+22) /*val*/);
 		show_seg(&_snm08__ub);
 
-		printf("\n>>> Scanning for SSTB2() function lookup code sequence... \n");
+		con_printf("\n>>> Scanning for SSTB2() function lookup code sequence... \n");
 		byte_offset    = search_offset( rom_load_addr, fh->len, (unsigned char *)&needle_SSTB2, (unsigned char *)&mask_SSTB2, needle_SSTB2_len);
 		if(byte_offset != NULL) 
 		{
 			addr = rom_load_addr + byte_offset;
-			printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
+			con_printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
 
 			// disassemble needle found in rom
 			if(show_diss) { c167x_diss(byte_offset, rom_load_addr + byte_offset, needle_SSTB2_len+16); }
@@ -83,11 +83,9 @@ int check_kftvsa(ImageHandle *fh, int skip, int mode)
 
 			// show table
 			if(mode == 1) {
-				set_table_overrides(_stm05saub.ram, _snm08__ub.ram, _kftvsa.ram, &KFTVSA_table);				// ktfvsa
-				dump_table2(rom_load_addr, FULL_OVERRIDE);
+				dump_split_table((unsigned char *)rom_load_addr, _stm05saub.ram, _snm08__ub.ram, _kftvsa.ram, &KFTVSA_table);			// ktfvsa
 			} else if(mode == 2) {
-				set_table_overrides(_stm05saub.ram, _snm08__ub.ram, _kftvsa0.ram, &KFTVSA0_table);				// kftvsa0 
-				dump_table2(rom_load_addr, FULL_OVERRIDE);
+				dump_split_table((unsigned char *)rom_load_addr, _stm05saub.ram, _snm08__ub.ram, _kftvsa0.ram, &KFTVSA0_table);			// kftvsa0 
 			}
 		}
 	}
@@ -22,6 +22,7 @@
 #include "kfwdkmsn.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "dpptrack.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -35,20 +36,20 @@ int check_kfwdkmsn(ImageHandle *fh, int skip)
 
 	if(skip == 0) return found;		
 
-	printf("\n>>> Scanning for FUEDK() for charge control (calculation of nominal throttle-valve angle), to discover KFWDKMSN map...\n");
+	con_printf("\n>>> Scanning for FUEDK() for charge control (calculation of nominal throttle-valve angle), to discover KFWDKMSN map...\n");
 	addr = search( fh, (unsigned char *)&needle_FUEDK, (unsigned char *)&mask_FUEDK, needle_FUEDK_len, 0 );
 	if(addr != NULL) {
-		printf("\nfound at offset=0x%x \n\n",(int)(addr-(int)rom_load_addr) );
+		con_printf("\nfound at offset=0x%x \n\n",(int)(addr-(int)rom_load_addr) );
 		// get offset to 'FUEDK'...
-		translate_seg(&_kfwdkmsn, "KFWDKMSN", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+6) /*val*/);
+		translate_seg(&_kfwdkmsn, "KFWDKMSN", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+6) /*seg*/, get16((unsigned char *)addr+6) /*val*/);
 		show_seg(&_kfwdkmsn); 
 		if(show_diss) { 
-			printf("Dumping ...\n");
+			con_printf("Dumping ...\n");
 			c167x_diss(addr-(int)rom_load_addr, addr, needle_FUEDK_len+16); 
 		}
-		dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 6), dpp1_value-1, &KFWDKMSN_table, 0);
+		dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 6), dpp_seg_at(fh, (unsigned char *)addr + 6), &KFWDKMSN_table, 0);
 	} else {
-		printf("\nNot found\n");
+		con_printf("\nNot found\n");
 	}
 
 
@@ -22,6 +22,9 @@
 #include "kfzw.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "inst_c16x.h"
+#include "dpptrack.h"
+#include "labels.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -35,6 +38,8 @@ int check_kfzw(ImageHandle *fh, int skip, int mode)
 	unsigned long val_adr;
 	unsigned char *rom_load_addr = fh->d.p;
 	MPTR _kfzw,_kfzw2, _snm16zuub, _srl12zuub;
+	DIS_INST *sstb;
+	int num, snm, srl;
 
 	int found = 0;
 	/*
@@ -43,53 +48,66 @@ int check_kfzw(ImageHandle *fh, int skip, int mode)
 	if(skip == 0) return found;		
 
 	if(mode == 1) {
-		printf("\n-[ KFZW Ignition Timing ]-------------------------------------------------------------\n");
+		con_printf("\n-[ KFZW Ignition Timing ]-------------------------------------------------------------\n");
 	} else if (mode == 2) {
-		printf("\n-[ KFZW2 Ignition Timing Variant #2 ]-------------------------------------------------\n");
+		con_printf("\n-[ KFZW2 Ignition Timing Variant #2 ]-------------------------------------------------\n");
 	}
 
-	printf("\n>>> Scanning for SSTB() for required X-axis (SNM16ZUUB), Y-axis (SRL12ZUUB)... \n");
+	con_printf("\n>>> Scanning for SSTB() for required X-axis (SNM16ZUUB), Y-axis (SRL12ZUUB)... \n");
 	addr = search( fh, (unsigned char *)&needle_SSTB, (unsigned char *)&mask_SSTB, needle_SSTB_len, 0 );
 	if(addr != NULL) 
 	{
-		printf("found at offset=0x%x. \n",(int)(addr-rom_load_addr) );
+		con_printf("found at offset=0x%x. \n",(int)(addr-rom_load_addr) );
+		label_symbol(addr-rom_load_addr, SYM_CODE, "SSTB");
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(addr-rom_load_addr, addr, needle_SSTB_len); }
 
+		// the axes are the tables (mov r12,#data16) of the 9th and 10th lookup in SSTB()
+		sstb = (DIS_INST *)malloc((needle_SSTB_len/2) * sizeof(DIS_INST));
+		if(sstb == 0) return 0;
+		num  = c167x_decode_buf(addr, needle_SSTB_len, addr-rom_load_addr, sstb, needle_SSTB_len/2);
+		snm  = c167x_find(sstb, num, 0xE6, 0xFC, 8);
+		srl  = c167x_find(sstb, num, 0xE6, 0xFC, 9);
+		if(snm < 0 || srl < 0) {
+			con_printf("SSTB() axis lookups not found\n");
+			free(sstb);
+			return 0;
+		}
+
 		// get offset to 'SNM16ZUUB'...
-		translate_seg(&_snm16zuub, "SNM16ZUUB", rom_load_addr,  dpp1_value-1 /*seg*/, get16((unsigned char *)addr+150)    /*val*/);
+		translate_seg(&_snm16zuub, "SNM16ZUUB", rom_load_addr,  dpp_seg(sstb[snm].adr, sstb[snm].op[1].val) /*seg*/, sstb[snm].op[1].val    /*val*/);
 		show_seg(&_snm16zuub); 
 		// get offset to 'SRL12ZUUB'...
-		translate_seg(&_srl12zuub, "SRL12ZUUB", rom_load_addr,  dpp1_value-1 /*seg*/, get16((unsigned char *)addr+170)    /*val*/);
+		translate_seg(&_srl12zuub, "SRL12ZUUB", rom_load_addr,  dpp_seg(sstb[srl].adr, sstb[srl].op[1].val) /*seg*/, sstb[srl].op[1].val    /*val*/);
 		show_seg(&_srl12zuub); 
+		free(sstb);
 
-		printf("\n>>> Scanning for ZWGRU() method to search for KFZW table ... \n");
+		con_printf("\n>>> Scanning for ZWGRU() method to search for KFZW table ... \n");
 		addr_gru = search( fh, (unsigned char *)&needle_ZWGRU, (unsigned char *)&mask_ZWGRU, needle_ZWGRU_len, 0 );
 		if(addr_gru != NULL) 
 		{
-			printf("found at offset=0x%x. \n",(int)(addr_gru-rom_load_addr) );
+			con_printf("found at offset=0x%x. \n",(int)(addr_gru-rom_load_addr) );
+			label_symbol(addr_gru-rom_load_addr, SYM_CODE, "ZWGRU");
 			// disassemble needle found in rom
 			if(show_diss) { c167x_diss(addr_gru-rom_load_addr, addr_gru, needle_SSTB_len); }
 
 			if( mode == 1) {
 				// get offset to 'KFZW' cell data...
-				translate_seg(&_kfzw,      "KFZW",      rom_load_addr,  dpp1_value-1 /*seg*/, get16((unsigned char *)addr_gru+58) /*val*/);
+				translate_seg(&_kfzw,      "KFZW",      rom_load_addr,  dpp_seg_at(fh, (unsigned char *)addr_gru+58) /*seg*/, get16((unsigned char *)addr_gru+58) /*val*/);
 				show_seg(&_kfzw);
-				set_table_overrides( _snm16zuub.ram, _srl12zuub.ram, _kfzw.ram, &KFZW_table);
-				dump_table2(rom_load_addr, FULL_OVERRIDE);
+				dump_split_table(rom_load_addr, _snm16zuub.ram, _srl12zuub.ram, _kfzw.ram, &KFZW_table);
 			}
 			else if( mode == 2) {
 				// get offset to 'KFZW2' cell data...
-				translate_seg(&_kfzw2,     "KFZW2",     rom_load_addr,  dpp1_value-1 /*seg*/, get16((unsigned char *)addr_gru+20) /*val*/);
+				translate_seg(&_kfzw2,     "KFZW2",     rom_load_addr,  dpp_seg_at(fh, (unsigned char *)addr_gru+20) /*seg*/, get16((unsigned char *)addr_gru+20) /*val*/);
 				show_seg(&_kfzw2);
-				set_table_overrides( _snm16zuub.ram, _srl12zuub.ram, _kfzw2.ram, &KFZW2_table);
-				dump_table2(rom_load_addr, FULL_OVERRIDE);
+				dump_split_table(rom_load_addr, _snm16zuub.ram, _srl12zuub.ram, _kfzw2.ram, &KFZW2_table);
 			}
 		}
 					
 	} else {
-		printf("Not found\n");
+		con_printf("Not found\n");
 	}
-	printf("\n");
+	con_printf("\n");
 	return 0;
 }
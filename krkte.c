@@ -22,6 +22,8 @@
 #include "krkte.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "export.h"
+#include "maplookup.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -36,14 +38,14 @@ int check_krkte(ImageHandle *fh, int skip)
 	double krkte_conv;
 	if(skip == 0) return found;		
 
-	printf("\n-[ KRKTE Airmass to injector 'on time' conv. based on inj size & fuel pressure]-----------------\n\n");
-	printf(">>> Scanning for KRKTE Lookup code sequence... \n");
+	con_printf("\n-[ KRKTE Airmass to injector 'on time' conv. based on inj size & fuel pressure]-----------------\n\n");
+	con_printf(">>> Scanning for KRKTE Lookup code sequence... \n");
 	/* search: *** Find KRKTE Value by searching for correct function code byte sequence */
 	byte_offset    = search_offset( rom_load_addr, fh->len, (unsigned char *)&needle_KRKTE, (unsigned char *)&mask_KRKTE, needle_KRKTE_len);
 	if(byte_offset != 0) 
 	{
 		addr = rom_load_addr + byte_offset;
-		printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
+		con_printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
 
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(byte_offset, rom_load_addr + byte_offset, needle_KRKTE_len+16); }
@@ -53,7 +55,9 @@ int check_krkte(ImageHandle *fh, int skip)
 
 		krkte         = *(_krkte.ram);		// get 8-bits
 		krkte_conv    = (krkte/468.75);		// conversion to ms/%
-		printf("%#x (%-3.4f ms/%%) \n\n", krkte, krkte_conv );
+		con_printf("%#x (%-3.4f ms/%%) \n\n", krkte, krkte_conv );
+		export_scalar("KRKTE", "Conv. of relative fuel mass rk into effective injection time te", (unsigned long)_krkte.rom, krkte, krkte_conv, "ms/%");
+		map_registry_add_value("KRKTE", krkte_conv);
 	}
 
 	return found;
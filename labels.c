@@ -0,0 +1,435 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "labels.h"
+#include "funcindex.h"
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
+//-[ Address Labels ] ------------------------------------------------------------------------------------------------------
+
+static LABEL         *labels;
+static unsigned long *end_tree;			// max tree of the label ends once sorted, leaf i at tree_leaves+i
+static int            tree_leaves;		// power of two >= num_labels
+static int            num_labels, max_labels;
+static int            sorted = 1;
+static SYMBOL        *symbols;
+static int            num_symbols, max_symbols;
+static int            symbols_sorted = 1;
+#ifndef NO_THREADS
+static pthread_mutex_t label_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static const char *kind_names[LBL_KINDS] = { "area", "x_num", "y_num", "x-axis", "y-axis", "cells", "block", "string" };
+
+static void lock(void)
+{
+#ifndef NO_THREADS
+	pthread_mutex_lock(&label_lock);
+#endif
+}
+
+static void unlock(void)
+{
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&label_lock);
+#endif
+}
+
+// by start, enclosing ranges first, then by name so shared ranges (e.g. KFZW/KFZW2 axes) always resolve the same way
+static int cmp_label(const void *a, const void *b)
+{
+	const LABEL *x = (const LABEL *)a, *y = (const LABEL *)b;
+	int r;
+
+	if(x->start != y->start) return (x->start > y->start) - (x->start < y->start);
+	if(x->end   != y->end)   return (x->end   < y->end)   - (x->end   > y->end);
+	if((r = strcmp(x->name, y->name)) != 0) return r;
+	return x->kind - y->kind;
+}
+
+// call with the lock held, returns -1 if the end tree couldn't grow (queries then find nothing)
+static int sort_labels(void)
+{
+	int i, n = 1;
+
+	if(sorted) return end_tree ? 0 : -1;
+	qsort(labels, num_labels, sizeof(LABEL), cmp_label);
+	while(n < num_labels) n *= 2;
+	if(n != tree_leaves || end_tree == 0) {
+		free(end_tree);
+		tree_leaves = 0;
+		if((end_tree = (unsigned long *)calloc(2*n, sizeof(unsigned long))) == 0) return -1;
+		tree_leaves = n;
+	}
+	for(i=0;i<n;i++) end_tree[n+i] = i < num_labels ? labels[i].end : 0;
+	for(i=n-1;i>0;i--) end_tree[i] = end_tree[2*i] > end_tree[2*i+1] ? end_tree[2*i] : end_tree[2*i+1];
+	sorted = 1;
+	return 0;
+}
+
+/*
+ * Call fn for every label i <= last with end > offset, in sort order (lock held, sorted)
+ *
+ * Subtrees whose largest end doesn't reach past offset are skipped, so this costs
+ * O(log n) per label visited however wide the ranges around it are.
+ */
+static void visit_ends(int node, int lo, int hi, int last, unsigned long offset, void (*fn)(int, void *), void *ctx)
+{
+	int mid;
+
+	if(lo > last || end_tree[node] <= offset) return;
+	if(hi - lo == 1) {
+		fn(lo, ctx);
+		return;
+	}
+	mid = (lo + hi) / 2;
+	visit_ends(2*node,   lo,  mid, last, offset, fn, ctx);
+	visit_ends(2*node+1, mid, hi,  last, offset, fn, ctx);
+}
+
+// index of the last label starting at or before offset, -1 if there is none (lock held, sorted)
+static int last_start(unsigned long offset)
+{
+	int lo = 0, hi = num_labels;
+
+	while(lo < hi) {
+		int mid = (lo + hi) / 2;
+		if(labels[mid].start <= offset) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo - 1;
+}
+
+void label_clear(void)
+{
+	lock();
+	free(labels);
+	free(end_tree);
+	labels     = 0;
+	end_tree   = 0;
+	tree_leaves = 0;
+	num_labels = 0;
+	max_labels = 0;
+	sorted     = 1;
+	free(symbols);
+	symbols        = 0;
+	num_symbols    = 0;
+	max_symbols    = 0;
+	symbols_sorted = 1;
+	unlock();
+}
+
+int label_num(void)
+{
+	return num_labels;
+}
+
+/*
+ * Add the range [start,end) of rom file offsets (any thread)
+ *
+ * returns 0 on success, -1 for an empty range or if the index couldn't grow
+ */
+int label_add(unsigned long start, unsigned long end, int kind, const char *name, int index, int width, int stride)
+{
+	LABEL *l;
+
+	if(end <= start || name == 0) return -1;
+	lock();
+	if(num_labels == max_labels) {
+		int n = max_labels ? max_labels*2 : LABELS_INITIAL_SIZE;
+		LABEL *nl = (LABEL *)realloc(labels, n*sizeof(LABEL));
+
+		if(nl == 0) { unlock(); return -1; }
+		labels     = nl;
+		max_labels = n;
+	}
+	l = &labels[num_labels++];
+	l->start  = start;
+	l->end    = end;
+	l->kind   = kind;
+	l->name   = name;
+	l->index  = index;
+	l->width  = width;
+	l->stride = stride;
+	sorted = 0;
+	unlock();
+	return 0;
+}
+
+/*
+ * Label the header fields, axes and cells of a decoded table (called from dump_table/dump_split_table)
+ */
+void label_add_map(MAP_DATA *m)
+{
+	TABLE_DEF *td = m->td;
+	int cell_width = m->y_num ? td->cell_nwidth : td->x_axis_nwidth;
+
+	label_add(m->x_num_adr,  m->x_num_adr  + td->x_num_nwidth,             LBL_X_NUM,  td->table_name, -1, td->x_num_nwidth,  0);
+	label_add(m->y_num_adr,  m->y_num_adr  + td->y_num_nwidth,             LBL_Y_NUM,  td->table_name, -1, td->y_num_nwidth,  0);
+	label_add(m->x_axis_adr, m->x_axis_adr + m->x_num*td->x_axis_nwidth,   LBL_X_AXIS, td->table_name, -1, td->x_axis_nwidth, 0);
+	if(m->y_num) {
+		label_add(m->y_axis_adr, m->y_axis_adr + m->y_num*td->y_axis_nwidth, LBL_Y_AXIS, td->table_name, -1, td->y_axis_nwidth, 0);
+	}
+	label_add(m->cell_adr,   m->cell_adr   + (unsigned long)m->cell_num*cell_width, LBL_CELLS, td->table_name, -1, cell_width, m->y_num ? m->y_num : 1);
+}
+
+/*
+ * Innermost (shortest) range containing offset
+ *
+ * returns 1 and fills in *out if there is one, 0 otherwise
+ */
+static void find_innermost(int i, void *ctx)
+{
+	int *best = (int *)ctx;
+
+	// visited in sort order, so on a tie the earlier one wins
+	if(*best < 0 || labels[i].end - labels[i].start < labels[*best].end - labels[*best].start) *best = i;
+}
+
+int label_find(unsigned long offset, LABEL *out)
+{
+	int best = -1;
+
+	lock();
+	if(sort_labels() == 0 && num_labels > 0) {
+		visit_ends(1, 0, tree_leaves, last_start(offset), offset, find_innermost, &best);
+	}
+	if(best >= 0) *out = labels[best];
+	unlock();
+	return best >= 0;
+}
+
+/*
+ * Every range overlapping [start,end), in start order
+ *
+ * returns the number found, at most max are copied to out
+ */
+typedef struct {
+	LABEL *out;
+	int    max, n;
+} RANGE_HITS;
+
+static void copy_overlap(int i, void *ctx)
+{
+	RANGE_HITS *h = (RANGE_HITS *)ctx;
+
+	if(h->n < h->max) h->out[h->n] = labels[i];
+	h->n++;
+}
+
+int label_range(unsigned long start, unsigned long end, LABEL *out, int max)
+{
+	RANGE_HITS h;
+
+	if(end <= start) return 0;
+	h.out = out;
+	h.max = max;
+	h.n   = 0;
+	lock();
+	if(sort_labels() == 0 && num_labels > 0) {
+		visit_ends(1, 0, tree_leaves, last_start(end - 1), start, copy_overlap, &h);
+	}
+	unlock();
+	return h.n;
+}
+
+/*
+ * Describe offset, e.g. "KFZW cell (3,7)", "LAMFA x-axis [2] +1", "multipoint block 12 +0x10" or "sub_2A3E4 +0x1c"
+ *
+ * returns 1 if offset was named, 0 if nothing is known about it (buf is then empty)
+ */
+int label_format(unsigned long offset, char *buf, int len)
+{
+	LABEL l;
+	unsigned long rel, fn;
+	int elem, rem, n;
+
+	if(len <= 0) return 0;
+	*buf = 0;
+	if(label_find(offset, &l) == 0) {
+		// code is named after its function
+		if(offset >= ROM_MAIN_START && (fn = func_start(offset)) != FUNC_NONE) {
+			snprintf(buf, len, "sub_%lX +0x%lx", fn, offset - fn);
+			return 1;
+		}
+		return 0;
+	}
+
+	rel  = offset - l.start;
+	elem = l.width ? (int)(rel / l.width) : 0;
+	rem  = l.width ? (int)(rel % l.width) : 0;
+
+	switch(l.kind) {
+		case LBL_X_NUM:
+		case LBL_Y_NUM:
+			n = snprintf(buf, len, "%s %s", l.name, kind_names[l.kind]);
+			break;
+		case LBL_X_AXIS:
+		case LBL_Y_AXIS:
+			n = snprintf(buf, len, "%s %s [%d]", l.name, kind_names[l.kind], elem);
+			break;
+		case LBL_CELLS:
+			if(l.stride > 1) n = snprintf(buf, len, "%s cell (%d,%d)", l.name, elem / l.stride, elem % l.stride);
+			else             n = snprintf(buf, len, "%s cell [%d]", l.name, elem);
+			break;
+		case LBL_BLOCK:
+			// code inside a checksummed block is better known by its function
+			if(offset >= ROM_MAIN_START && (fn = func_start(offset)) != FUNC_NONE) {
+				snprintf(buf, len, "sub_%lX +0x%lx in %s %d", fn, offset - fn, l.name, l.index);
+			} else {
+				snprintf(buf, len, "%s %d +0x%lx", l.name, l.index, rel);
+			}
+			return 1;
+		case LBL_STRING:
+			snprintf(buf, len, "%s string (info %d) +%lu", l.name, l.index, rel);
+			return 1;
+		default:
+			snprintf(buf, len, "%s +0x%lx", l.name, rel);
+			return 1;
+	}
+	if(rem && n > 0 && n < len) snprintf(buf + n, len - n, " +%d", rem);
+	return 1;
+}
+
+// by offset, code before data, then by name
+static int cmp_symbol(const void *a, const void *b)
+{
+	const SYMBOL *x = (const SYMBOL *)a, *y = (const SYMBOL *)b;
+
+	if(x->offset != y->offset) return (x->offset > y->offset) - (x->offset < y->offset);
+	if(x->kind   != y->kind)   return y->kind - x->kind;
+	return strcmp(x->name, y->name);
+}
+
+/*
+ * Name a single rom offset, SYM_CODE for a routine (any thread)
+ *
+ * returns 0 on success, -1 if the table couldn't grow
+ */
+int label_symbol(unsigned long offset, int kind, const char *name)
+{
+	if(name == 0) return -1;
+	lock();
+	if(num_symbols == max_symbols) {
+		int n = max_symbols ? max_symbols*2 : LABELS_INITIAL_SIZE;
+		SYMBOL *ns = (SYMBOL *)realloc(symbols, n*sizeof(SYMBOL));
+
+		if(ns == 0) { unlock(); return -1; }
+		symbols     = ns;
+		max_symbols = n;
+	}
+	symbols[num_symbols].offset = offset;
+	symbols[num_symbols].kind   = kind;
+	symbols[num_symbols].name   = name;
+	num_symbols++;
+	symbols_sorted = 0;
+	unlock();
+	return 0;
+}
+
+/*
+ * All symbols in offset order with duplicates (the same name found twice) removed
+ *
+ * returns the number of symbols, the table stays valid until the next label_symbol/label_clear
+ */
+int label_symbols(const SYMBOL **out)
+{
+	int i, n;
+
+	lock();
+	if(symbols_sorted == 0) {
+		qsort(symbols, num_symbols, sizeof(SYMBOL), cmp_symbol);
+		for(i=0, n=0;i<num_symbols;i++) {
+			if(n > 0 && cmp_symbol(&symbols[n-1], &symbols[i]) == 0) continue;
+			symbols[n++] = symbols[i];
+		}
+		num_symbols    = n;
+		symbols_sorted = 1;
+	}
+	*out = symbols;
+	n = num_symbols;
+	unlock();
+	return n;
+}
+
+const char *label_kind_name(int kind)
+{
+	return (kind >= 0 && kind < LBL_KINDS) ? kind_names[kind] : "";
+}
+
+// one line per range for a range query
+static void show_label(LABEL *l)
+{
+	con_printf("  0x%-6.6lx-0x%-6.6lx ", l->start, l->end - 1);
+	if(l->kind == LBL_BLOCK) con_printf("%s %d", l->name, l->index);
+	else                     con_printf("%-10s %s", l->name, kind_names[l->kind]);
+	if(l->kind == LBL_STRING && l->index >= 0) con_printf(" (info %d)", l->index);
+	if(l->kind == LBL_CELLS && l->stride > 1) {
+		con_printf(" %dx%d", (int)((l->end - l->start) / l->width / l->stride), l->stride);
+	}
+	con_printf("\n");
+}
+
+/*
+ * Name what lies at each comma separated rom offset or range in list, e.g. "0x1b740,0x812000-0x812100"
+ * (physical 0x8xxxxx addresses are accepted as well)
+ */
+int check_where(ImageHandle *fh, char *list)
+{
+	char *p = list, *end, desc[96];
+	unsigned long a, b;
+	LABEL found[64];
+	int i, n;
+
+	if(list == 0) return 0;
+
+	con_printf("\n-[ Address Labels ]-----------------------------------------------------------------\n\n");
+	con_printf("%d labelled ranges, %d functions\n\n", label_num(), func_index_num());
+
+	while(*p) {
+		a = strtoul(p, &end, 0) & ~(ROM_1MB_MASK);
+		if(end == p) break;
+		b = a;
+		p = end;
+		if(*p == '-') {
+			b = strtoul(p+1, &end, 0) & ~(ROM_1MB_MASK);
+			if(end == p+1) break;
+			p = end;
+		}
+
+		if(a >= fh->len) {
+			con_printf("0x%-6.6lx : outside the rom image\n", a);
+		} else if(b > a) {
+			n = label_range(a, b+1, found, sizeof(found)/sizeof(LABEL));
+			con_printf("0x%-6.6lx-0x%-6.6lx : %d labelled ranges\n", a, b, n);
+			for(i=0;i<n && i<(int)(sizeof(found)/sizeof(LABEL));i++) show_label(&found[i]);
+		} else {
+			if(label_format(a, desc, sizeof(desc)) == 0) snprintf(desc, sizeof(desc), "unknown");
+			con_printf("0x%-6.6lx : %s\n", a, desc);
+		}
+
+		while(*p == ',' || *p == ' ') p++;
+	}
+	con_printf("\n");
+	return 0;
+}
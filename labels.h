@@ -0,0 +1,84 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _LABELS_SUPPORT_H
+#define _LABELS_SUPPORT_H
+#include "utils.h"
+#include "show_tables.h"
+
+// Address ranges of everything identified in the rom being searched (table headers, axes
+// and cells, checksum blocks, rom info strings) so that any file offset can be named, e.g.
+// "KFZW cell (3,7)" or "multipoint block 12 +0x10".
+//
+// Modules add ranges as they find them (from any check thread). The index is sorted by
+// start on the first query after an add, with a max tree of the range ends over that order,
+// so a query only descends to the ranges that overlap it: O(log n) per range found, even
+// with checksum blocks spanning most of the image.
+
+#define LBL_AREA		0		// plain named range
+#define LBL_X_NUM		1		// number of x-axis points of a table
+#define LBL_Y_NUM		2
+#define LBL_X_AXIS		3		// axis points of 'width' bytes each
+#define LBL_Y_AXIS		4
+#define LBL_CELLS		5		// cells of 'width' bytes, 'stride' cells per column
+#define LBL_BLOCK		6		// checksummed block, 'index' is its number
+#define LBL_STRING		7		// rom info string, 'index' is its table index
+#define LBL_KINDS		8
+
+#define LABELS_INITIAL_SIZE	256
+
+// Point symbols (routines found by needle, stored checksums, setup code) for listings and
+// symbol scripts. Kept apart from the ranges so they never change how an offset is named.
+#define SYM_DATA		0
+#define SYM_CODE		1
+
+typedef struct LABEL {
+	unsigned long  start;		// rom file offsets, end is exclusive
+	unsigned long  end;
+	int            kind;		// LBL_xxx
+	const char    *name;		// must outlive the index (table or static names)
+	int            index;		// block/string number, -1 if none
+	int            width;		// element width in bytes, 0 if the range has no elements
+	int            stride;		// LBL_CELLS: cells per column (y_num), 1 for a 1-axis table
+} LABEL;
+
+typedef struct SYMBOL {
+	unsigned long  offset;		// rom file offset
+	int            kind;		// SYM_DATA or SYM_CODE
+	const char    *name;		// must outlive the index, like LABEL names
+} SYMBOL;
+
+void label_clear(void);
+int  label_add(unsigned long start, unsigned long end, int kind, const char *name, int index, int width, int stride);
+void label_add_map(MAP_DATA *m);
+int  label_num(void);
+
+int  label_find(unsigned long offset, LABEL *out);
+int  label_range(unsigned long start, unsigned long end, LABEL *out, int max);
+int  label_format(unsigned long offset, char *buf, int len);
+const char *label_kind_name(int kind);
+
+int  label_symbol(unsigned long offset, int kind, const char *name);
+int  label_symbols(const SYMBOL **out);
+
+int  check_where(ImageHandle *fh, char *list);
+
+#endif
@@ -0,0 +1,444 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "listing.h"
+#include "labels.h"
+#include "flowgraph.h"
+#include "xref.h"
+#include "inst_c16x.h"
+#include "mapcatalog.h"
+#include "outbuf.h"
+#include <time.h>
+
+#define LISTING_NAME_LEN	64
+#define LISTING_DUP_MIN		32		// runs of one byte value at least this long are a single 'dup' line
+
+typedef char SYM_NAME[LISTING_NAME_LEN];
+
+typedef struct LISTING {
+	const uint8_t      *rom;
+	unsigned long       len;
+	const FLOW_GRAPH   *g;
+	LABEL              *labels;
+	int                 num_labels;
+	const SYMBOL       *syms;
+	int                 num_syms;
+	unsigned long      *bounds;		// sorted starts/ends of ranges and symbol offsets, data lines break there
+	int                 num_bounds;
+	int                 insts, lines;
+	unsigned long       data_bytes;
+} LISTING;
+
+static int cmp_ulong(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+	return (x > y) - (x < y);
+}
+
+// symbol name as an identifier, "main rom checksum" -> "main_rom_checksum"
+static void ident(char *dst, const char *src, int len)
+{
+	int i = 0;
+
+	if(*src >= '0' && *src <= '9' && i < len-1) dst[i++] = '_';
+	for(;*src && i < len-1;src++) {
+		char c = *src;
+		dst[i++] = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_') ? c : '_';
+	}
+	dst[i] = 0;
+}
+
+// one line description of a range, also used for the script comments
+static void range_text(const LABEL *l, char *buf, int len)
+{
+	int n;
+
+	if(l->kind == LBL_BLOCK)       n = snprintf(buf, len, "%s %d", l->name, l->index);
+	else if(l->kind == LBL_AREA)   n = snprintf(buf, len, "%s", l->name);
+	else                           n = snprintf(buf, len, "%s %s", l->name, label_kind_name(l->kind));
+	if(n < 0 || n >= len) return;
+	if(l->kind == LBL_STRING && l->index >= 0) {
+		n += snprintf(buf + n, len - n, " (info %d)", l->index);
+	} else if(l->kind == LBL_CELLS && l->stride > 1) {
+		n += snprintf(buf + n, len - n, " %dx%d", (int)((l->end - l->start) / l->width / l->stride), l->stride);
+	}
+	if(n < len) snprintf(buf + n, len - n, ", 0x%06lx-0x%06lx", l->start, l->end - 1);
+}
+
+// pad the line started at ob->data[line] out to the comment column
+static void comment_col(OUTBUF *ob, size_t line)
+{
+	size_t col = ob->len - line;
+
+	if(col >= LISTING_COMMENT_COL) {
+		ob_putc(ob, ' ');
+	} else {
+		for(;col < LISTING_COMMENT_COL;col++) ob_putc(ob, ' ');
+	}
+	ob_puts(ob, "; ");
+}
+
+// every range starting at or before offset not written yet, one blank line ahead of them
+static void write_ranges(OUTBUF *ob, LISTING *ls, int *li, unsigned long offset)
+{
+	char text[160];
+
+	if(*li < ls->num_labels && ls->labels[*li].start <= offset) {
+		ob_putc(ob, '\n');
+		ls->lines++;
+	}
+	for(;*li < ls->num_labels && ls->labels[*li].start <= offset;(*li)++) {
+		range_text(&ls->labels[*li], text, sizeof(text));
+		ob_printf(ob, "; ---- %s\n", text);
+		ls->lines++;
+	}
+}
+
+// every symbol at or before offset not written yet, data as a label, code as a comment
+static void write_symbols(OUTBUF *ob, LISTING *ls, int *si, unsigned long offset)
+{
+	char name[LISTING_NAME_LEN];
+
+	for(;*si < ls->num_syms && ls->syms[*si].offset <= offset;(*si)++) {
+		if(ls->syms[*si].kind == SYM_CODE) {
+			ob_printf(ob, "; >>> %s\n", ls->syms[*si].name);
+		} else {
+			ident(name, ls->syms[*si].name, LISTING_NAME_LEN);
+			ob_printf(ob, "%s:\n", name);
+		}
+		ls->lines++;
+	}
+}
+
+// function header ahead of an entry
+static void write_func(OUTBUF *ob, LISTING *ls, unsigned long offset)
+{
+	int fi = flow_func_find(offset);
+
+	if(fi >= 0) ob_printf(ob, "\n; ---- sub_%lX, %d callers\n", offset, ls->g->funcs[fi].callers);
+	else        ob_printf(ob, "\n; ---- sub_%lX\n", offset);
+	ls->lines += 2;
+}
+
+// one instruction, with the rom data it references, returns its length
+static unsigned long write_inst(OUTBUF *ob, LISTING *ls, unsigned long offset)
+{
+	const DIS_INST *di = &ls->g->insts[offset/2];
+	const XREF *found[LISTING_XREF_MAX];
+	unsigned long len = di->len ? di->len : 2;
+	unsigned char state = ls->g->state[offset/2];
+	char desc[96];
+	size_t line;
+	int i, n;
+
+	if(state & (FL_FUNC | FL_LEADER)) {
+		ob_printf(ob, "loc_%lX:\n", offset);
+		ls->lines++;
+	}
+
+	line = ob->len;
+	if(len == 2) ob_printf(ob, "  %06lX  %02X %02X       ", offset, di->raw[0], di->raw[1]);
+	else         ob_printf(ob, "  %06lX  %02X %02X %02X %02X ", offset, di->raw[0], di->raw[1], di->raw[2], di->raw[3]);
+	c167x_format(ob, di);
+
+	n = xref_by_code(offset, offset + len, found, LISTING_XREF_MAX);
+	for(i=0;i<n && i<LISTING_XREF_MAX;i++) {
+		if(i == 0) comment_col(ob, line);
+		else       ob_puts(ob, ", ");
+		if(label_format(found[i]->data, desc, sizeof(desc))) ob_puts(ob, desc);
+		else ob_printf(ob, "0x%06lx", (unsigned long)found[i]->data);
+	}
+	if(n > LISTING_XREF_MAX) ob_printf(ob, " (+%d)", n - LISTING_XREF_MAX);
+	ob_putc(ob, '\n');
+	ls->insts++;
+	ls->lines++;
+	return len;
+}
+
+// bytes up to the next instruction, range boundary, symbol or end of segment, returns how many
+static unsigned long write_data(OUTBUF *ob, LISTING *ls, unsigned long offset, unsigned long seg_end, int *bi)
+{
+	static const char hex_uc[] = "0123456789ABCDEF";
+	const uint8_t *rom = ls->rom;
+	unsigned long end = seg_end, e;
+	char desc[96];
+	size_t line;
+
+	for(e = (offset + 2) & ~1UL;e < end;e += 2) {
+		if(ls->g->state[e/2] & FL_INST) { end = e; break; }
+	}
+	while(*bi < ls->num_bounds && ls->bounds[*bi] <= offset) (*bi)++;
+	if(*bi < ls->num_bounds && ls->bounds[*bi] < end) end = ls->bounds[*bi];
+
+	line = ob->len;
+	ob_printf(ob, "  %06lX  ", offset);
+	for(e = offset + 1;e < end && rom[e] == rom[offset];e++);
+	if(e - offset >= LISTING_DUP_MIN) {
+		// filler (erased flash, padding) as one line
+		end = e;
+		ob_printf(ob, "             db       %lu dup(%02Xh)", end - offset, rom[offset]);
+	} else {
+		if(end > offset + LISTING_DATA_LINE) end = offset + LISTING_DATA_LINE;
+		ob_puts(ob, "             db       ");
+		for(e = offset;e < end;e++) {
+			ob_putc(ob, hex_uc[rom[e] >> 4]);
+			ob_putc(ob, hex_uc[rom[e] & 15]);
+			if(e + 1 < end) ob_putc(ob, ' ');
+		}
+	}
+	if(label_format(offset, desc, sizeof(desc))) {
+		comment_col(ob, line);
+		ob_puts(ob, desc);
+	}
+	ob_putc(ob, '\n');
+	ls->data_bytes += end - offset;
+	ls->lines++;
+	return end - offset;
+}
+
+static int write_listing(FILE *fp, LISTING *ls, const char *romfile, unsigned long base)
+{
+	OUTBUF ob;
+	unsigned long offset = 0, seg_end = 0;
+	int li = 0, si = 0, bi = 0;
+
+	memset(&ob, 0, sizeof(ob));
+	ob.fp = fp;
+	ob_printf(&ob, "; %s\n", romfile ? romfile : "");
+	ob_printf(&ob, "; %lu bytes, offsets are from the start of the image at physical 0x%lx\n", ls->len, base);
+	ob_printf(&ob, "; %d functions, %d labelled ranges, %d symbols\n", ls->g->num_funcs, ls->num_labels, ls->num_syms);
+
+	while(offset < ls->len) {
+		if(offset >= seg_end) {
+			// one write per segment
+			ob_flush(&ob);
+			if(ferror(fp)) break;
+			seg_end = (offset / SEGMENT_SIZE + 1) * SEGMENT_SIZE;
+			if(seg_end > ls->len) seg_end = ls->len;
+			ob_printf(&ob, "\n; ==== segment %d, 0x%06lx-0x%06lx (0x%lx)\n", (int)(offset / SEGMENT_SIZE), offset, seg_end - 1, base + offset);
+			ls->lines += 2;
+		}
+		write_ranges(&ob, ls, &li, offset);
+		if((offset & 1) == 0 && (ls->g->state[offset/2] & FL_INST)) {
+			if(ls->g->state[offset/2] & FL_FUNC) write_func(&ob, ls, offset);
+			write_symbols(&ob, ls, &si, offset);
+			offset += write_inst(&ob, ls, offset);
+		} else {
+			write_symbols(&ob, ls, &si, offset);
+			offset += write_data(&ob, ls, offset, seg_end, &bi);
+		}
+	}
+	ob_free(&ob);
+	return ferror(fp) ? -1 : 0;
+}
+
+//-[ Symbol scripts ]-------------------------------------------------------------------------------------------------------
+
+// names unique across the script (a name found twice gets a _2, _3 ... suffix)
+static SYM_NAME *unique_names(LISTING *ls)
+{
+	SYM_NAME *names = calloc(ls->num_syms ? ls->num_syms : 1, LISTING_NAME_LEN);
+	char base[LISTING_NAME_LEN];
+	int i, j, n;
+
+	if(names == 0) return 0;
+	for(i=0;i<ls->num_syms;i++) {
+		if(i > 0 && ls->syms[i].offset == ls->syms[i-1].offset) continue;	// one name per address, the rest are comments
+		ident(base, ls->syms[i].name, LISTING_NAME_LEN - 8);
+		snprintf(names[i], LISTING_NAME_LEN, "%s", base);
+		for(n=2;;n++) {
+			for(j=0;j<i && strcmp(names[j], names[i]) != 0;j++);
+			if(j == i) break;
+			snprintf(names[i], LISTING_NAME_LEN, "%s_%d", base, n);
+		}
+	}
+	return names;
+}
+
+// comment text safe inside a double quoted string of either script language
+static void quote_safe(char *s)
+{
+	for(;*s;s++) if(*s == '"' || *s == '\\' || (unsigned char)*s < ' ') *s = '\'';
+}
+
+static int write_idc(const char *name, LISTING *ls, SYM_NAME *names, const char *romfile, unsigned long base)
+{
+	OUTBUF ob;
+	FILE *fp = fopen(name, "w");
+	char text[160];
+	int i;
+
+	if(fp == 0) return -1;
+	memset(&ob, 0, sizeof(ob));
+	ob.fp = fp;
+	ob_printf(&ob, "// symbols of %s (me7romtool -listing)\n\n#include <idc.idc>\n\nstatic main(void)\n{\n", romfile ? romfile : "");
+	for(i=0;i<ls->g->num_funcs;i++) {
+		ob_printf(&ob, "\tadd_func(0x%lX, BADADDR);\n", base + ls->g->funcs[i].entry);
+	}
+	for(i=0;i<ls->num_syms;i++) {
+		if(names[i][0]) {
+			ob_printf(&ob, "\tset_name(0x%lX, \"%s\", SN_NOWARN);\n", base + ls->syms[i].offset, names[i]);
+		} else {
+			snprintf(text, sizeof(text), "%s", ls->syms[i].name);
+			quote_safe(text);
+			ob_printf(&ob, "\tset_cmt(0x%lX, \"%s\", 1);\n", base + ls->syms[i].offset, text);
+		}
+	}
+	for(i=0;i<ls->num_labels;i++) {
+		range_text(&ls->labels[i], text, sizeof(text));
+		quote_safe(text);
+		ob_printf(&ob, "\tset_cmt(0x%lX, \"%s\", 0);\n", base + ls->labels[i].start, text);
+	}
+	ob_puts(&ob, "}\n");
+	ob_free(&ob);
+	i = ferror(fp) ? -1 : 0;
+	fclose(fp);
+	return i;
+}
+
+static int write_ghidra(const char *name, LISTING *ls, SYM_NAME *names, const char *romfile, unsigned long base)
+{
+	OUTBUF ob;
+	FILE *fp = fopen(name, "w");
+	char text[160];
+	int i;
+
+	if(fp == 0) return -1;
+	memset(&ob, 0, sizeof(ob));
+	ob.fp = fp;
+	ob_printf(&ob, "# symbols of %s (me7romtool -listing), run from the Ghidra script manager\n", romfile ? romfile : "");
+	ob_puts(&ob, "#@category ME7\n\nfrom ghidra.program.model.symbol import SourceType\n\nfuncs = [\n");
+	for(i=0;i<ls->g->num_funcs;i++) ob_printf(&ob, "    0x%lX,\n", base + ls->g->funcs[i].entry);
+	ob_puts(&ob, "]\n\nnames = [\n");
+	for(i=0;i<ls->num_syms;i++) {
+		if(names[i][0]) ob_printf(&ob, "    (0x%lX, \"%s\"),\n", base + ls->syms[i].offset, names[i]);
+	}
+	ob_puts(&ob, "]\n\ncomments = [\n");
+	for(i=0;i<ls->num_syms;i++) {
+		if(names[i][0]) continue;
+		snprintf(text, sizeof(text), "%s", ls->syms[i].name);
+		quote_safe(text);
+		ob_printf(&ob, "    (0x%lX, \"%s\"),\n", base + ls->syms[i].offset, text);
+	}
+	for(i=0;i<ls->num_labels;i++) {
+		range_text(&ls->labels[i], text, sizeof(text));
+		quote_safe(text);
+		ob_printf(&ob, "    (0x%lX, \"%s\"),\n", base + ls->labels[i].start, text);
+	}
+	ob_puts(&ob, "]\n\n"
+		"for ea in funcs:\n"
+		"    a = toAddr(ea)\n"
+		"    disassemble(a)\n"
+		"    if getFunctionAt(a) is None:\n"
+		"        createFunction(a, None)\n"
+		"for ea, name in names:\n"
+		"    createLabel(toAddr(ea), name, True, SourceType.USER_DEFINED)\n"
+		"for ea, text in comments:\n"
+		"    setPreComment(toAddr(ea), text)\n");
+	ob_free(&ob);
+	i = ferror(fp) ? -1 : 0;
+	fclose(fp);
+	return i;
+}
+
+/*
+ * Write the annotated disassembly to filename, and the symbols to filename.idc and filename.py
+ *
+ * returns 0 on success, -1 if the control flow graph couldn't be built or a file not written
+ */
+int check_listing(ImageHandle *fh, const char *romfile, const char *filename)
+{
+	LISTING ls;
+	char name[MAX_FILENAME+8];
+	SYM_NAME *names = 0;
+	unsigned long base = CAT_ROM_BASE;
+	clock_t start;
+	double ms_build, ms_write;
+	long size = 0;
+	FILE *fp;
+	int i, n, res = -1;
+
+	if(filename == 0) return 0;
+
+	con_printf("\n-[ Listing ]------------------------------------------------------------------------\n\n");
+	con_printf(">>> Writing the annotated disassembly to '%s'\n\n", filename);
+
+	memset(&ls, 0, sizeof(ls));
+	start = clock();
+	if((ls.g = flow_graph()) == 0 && (flow_build(fh) != 0 || (ls.g = flow_graph()) == 0)) {
+		con_printf("failed to build the control flow graph\n");
+		return -1;
+	}
+	if(xref_open(fh, romfile) < 0) {
+		con_printf("failed to build the cross references\n");
+		return -1;
+	}
+	ms_build = 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC;
+
+	ls.rom = fh->d.u8;
+	ls.len = ls.g->len;
+	ls.num_syms = label_symbols(&ls.syms);
+	n = label_num();
+	ls.labels = (LABEL *)malloc((n ? n : 1) * sizeof(LABEL));
+	ls.bounds = (unsigned long *)malloc((2*n + ls.num_syms + 1) * sizeof(unsigned long));
+	if(ls.labels == 0 || ls.bounds == 0) goto done;
+	ls.num_labels = label_range(0, fh->len, ls.labels, n);
+	if(ls.num_labels > n) ls.num_labels = n;
+
+	for(i=0;i<ls.num_labels;i++) {
+		ls.bounds[ls.num_bounds++] = ls.labels[i].start;
+		ls.bounds[ls.num_bounds++] = ls.labels[i].end;
+	}
+	for(i=0;i<ls.num_syms;i++) ls.bounds[ls.num_bounds++] = ls.syms[i].offset;
+	qsort(ls.bounds, ls.num_bounds, sizeof(unsigned long), cmp_ulong);
+
+	start = clock();
+	if((fp = fopen(filename, "w")) == 0) {
+		con_printf("failed to create '%s'\n", filename);
+		goto done;
+	}
+	res = write_listing(fp, &ls, romfile, base);
+	size = ftell(fp);
+	fclose(fp);
+	if(res == 0 && (names = unique_names(&ls)) != 0) {
+		snprintf(name, sizeof(name), "%s.idc", filename);
+		res = write_idc(name, &ls, names, romfile, base);
+		snprintf(name, sizeof(name), "%s.py", filename);
+		if(res == 0) res = write_ghidra(name, &ls, names, romfile, base);
+	}
+	ms_write = 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC;
+
+	if(res != 0) {
+		con_printf("failed to write the listing or its symbol scripts\n");
+		goto done;
+	}
+	con_printf("%d instructions, %lu bytes of data, %d lines (%ld bytes) in %d segments\n",
+		ls.insts, ls.data_bytes, ls.lines, size, (int)((ls.len + SEGMENT_SIZE - 1) / SEGMENT_SIZE));
+	con_printf("%d functions, %d symbols, %d labelled ranges\n", ls.g->num_funcs, ls.num_syms, ls.num_labels);
+	con_printf("symbols for IDA in '%s.idc', for Ghidra in '%s.py'\n", filename, filename);
+	con_printf("(%.2f ms control flow and cross references, %.2f ms writing)\n", ms_build, ms_write);
+
+done:
+	free(names);
+	free(ls.labels);
+	free(ls.bounds);
+	return res;
+}
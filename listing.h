@@ -0,0 +1,42 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+#ifndef _LISTING_SUPPORT_H
+#define _LISTING_SUPPORT_H
+#include "utils.h"
+
+// Complete disassembly of the image to a text file, every reached instruction (see flowgraph.h)
+// and the data between them, annotated with what the checks found: table headers, axes and
+// cells, checksum blocks and stored sums, the rom info strings, the needle routines (SSTB,
+// ZWGRU, dpp setup, ...) and the rom data each instruction references (see xref.h).
+//
+// The text of each 16KByte segment is built in one growing buffer and written with a single
+// fwrite, a 1MByte image is a few hundred thousand lines. The symbols are also written as an
+// IDA script (<listing>.idc) and a Ghidra script (<listing>.py), addresses are physical.
+
+#define LISTING_COMMENT_COL		48		// column of the ';' annotation after an instruction
+#define LISTING_DATA_LINE		16		// bytes per 'db' line
+#define LISTING_XREF_MAX		4		// references shown per instruction
+
+int  check_listing(ImageHandle *fh, const char *romfile, const char *filename);
+
+#endif
@@ -22,6 +22,8 @@
 #include "lrstpza.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "export.h"
+#include "dpptrack.h"
 
 extern unsigned dpp1_value;
 extern int show_diss;
@@ -35,23 +37,24 @@ int check_lrstpza(ImageHandle *fh, int skip)
 
 	if(skip == 0) return found;		
 				
-	printf("\n>>> Scanning for LRSTPZA [Period duration of the LRS forced amplitude]\n");
+	con_printf("\n>>> Scanning for LRSTPZA [Period duration of the LRS forced amplitude]\n");
 	addr = search( fh, (unsigned char *)&needle_LRSTPZA, (unsigned char *)&mask_LRSTPZA, needle_LRSTPZA_len, 0 );
 	if(addr != NULL) {
-		printf("found LRS() function at offset=0x%x.\n\n",(int)(addr-rom_load_addr) );
+		con_printf("found LRS() function at offset=0x%x.\n\n",(int)(addr-rom_load_addr) );
 
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(addr-rom_load_addr, addr, needle_LRSTPZA_len+20); }
 
 		// extract lrstpza from LRS() function in romcode using segment and offset directly from code
-		translate_seg(&_lrstpza, "LRSTPZA", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+4) /*val*/);
+		translate_seg(&_lrstpza, "LRSTPZA", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+4) /*seg*/, get16((unsigned char *)addr+4) /*val*/);
 		show_seg(&_lrstpza);
 
 		val = *(_lrstpza.ram);	// get byte and show it...
-		printf("LRSTPZA: 0x%-2.2x (0.%d s)\n",val,val*100);
+		con_printf("LRSTPZA: 0x%-2.2x (0.%d s)\n",val,val*100);
+		export_scalar("LRSTPZA", "Period duration of the LRS forced amplitude", (unsigned long)_lrstpza.rom, val, val*0.1, "s");
 
 	} else {
-		printf("not found\n");
+		con_printf("not found\n");
 	}
 
 	return found;
@@ -41,6 +41,43 @@
 #include "krkte.h"
 #include "eskonf.h"
 #include "rominfo.h"
+#include "cwkonfz1.h"
+#include "cwkonls.h"
+#include "cwkonabg.h"
+#include "pukans.h"
+#include "kfkhfm.h"
+#include "lamfa.h"
+#include "kfnw.h"
+#include "fkkvs.h"
+#include "nswo.h"
+#include "nmax.h"
+#include "kfsu.h"
+#include "kfmsnwdk.h"
+#include "kfwdkmsn.h"
+#include "kfzw.h"
+#include "tvkup.h"
+#include "lrstpza.h"
+#include "seedkey.h"
+#include "kfagk.h"
+#include "kfped.h"
+#include "kftvsa.h"
+#include "multimap.h"
+#include "mapscan.h"
+#include "export.h"
+#include "checkjobs.h"
+#include "maplookup.h"
+#include "replay.h"
+#include "table_ini.h"
+#include "funcindex.h"
+#include "labels.h"
+#include "flowgraph.h"
+#include "xref.h"
+#include "emu_c16x.h"
+#include "listing.h"
+#include "needlegen.h"
+#include "needlemine.h"
+#include "sigdb.h"
+#include "dpptrack.h"
 
 // this globals will be eliminated later (fixme)
 char *rom_name=NULL;
@@ -64,6 +101,10 @@ int show_adr=0;
 int show_phy=1;
 int show_help=0;
 int show_multimap=0;
+int show_maptables=0;
+int show_mapscan=0;
+int show_lookupcheck=0;
+int show_cfg=0;
 int show_rominfo=1;
 int show_pukans=0;
 int show_kfkhfm=0;
@@ -92,6 +133,43 @@ int show_kfwdkmsn=0;
 int show_kfsu=0;
 int show_kfsu2=0;
 int show_mlhfm=0;
+int verify_sums=0;
+int export_data=0;
+int got_exportfile=0;
+char *export_type=NULL;
+char *export_name=NULL;
+int eval_log=0;
+int got_evalmap=0;
+int got_evalout=0;
+char *eval_name=NULL;
+char *eval_spec=NULL;
+char *evalout_name=NULL;
+int replay_log=0;
+int got_replayrom=0;
+int got_replaycols=0;
+int got_replayout=0;
+char *replay_name=NULL;
+char *replayrom_name=NULL;
+char *replaycols=NULL;
+char *replayout_name=NULL;
+int got_tables=0;
+char *tables_name=NULL;
+int got_where=0;
+char *where_list=NULL;
+int got_xref=0;
+char *xref_list=NULL;
+int got_run=0;
+char *run_spec=NULL;
+int got_listing=0;
+char *listing_name=NULL;
+int got_mkneedle=0;
+char *mkneedle_spec=NULL;
+int got_mine=0;
+char *mine_dir=NULL;
+int got_mksig=0;
+char *mksig_name=NULL;
+int got_sigs=0;
+char *sigs_name=NULL;
 
 unsigned long dpp0_value, dpp1_value, dpp2_value, dpp3_value;
 
@@ -134,9 +212,36 @@ OPTS_ENTRY opts_table[] = {
 	{ "-whfm",    &find_mlhfm,        HFM_WRITING,  &hfm_name,  MANDATORY, "Write hfm into specified romfile. A Mandatory <hfm bin filename> must be specified.\n"              },
 	{ "-ihfm",    &find_mlhfm,        HFM_IDENTIFY, &hfm_name,  OPTIONAL,  "Try to identify mlhfm table in specified romfile.\n"                                                },
 	{ "-maps",    &show_multimap,     OPTION_SET,   0,          OPTIONAL,  "Try to identify map in the firmware (Experimental!).\n"                                             },
+	{ "-maptables",&show_maptables,   OPTION_SET,   0,          OPTIONAL,  "With -maps, decode and show every unknown map table instead of listing it on one line.\n"  },
+	{ "-mapscan", &show_mapscan,      OPTION_SET,   0,          OPTIONAL,  "Scan the map area for map headers, also finds maps no lookup code references (heuristic).\n" },
+	{ "-cfg",     &show_cfg,          OPTION_SET,   0,          OPTIONAL,  "Disassemble the whole rom from the reset/trap vectors, show its functions, basic blocks and call graph.\n" },
+	{ "-tables",  &got_tables,        OPTION_SET,   &tables_name, MANDATORY, "Load table definitions and needles from an .ini file, show every table with a needle.\n"    },
+	{ "-where",   &got_where,         OPTION_SET,   &where_list, MANDATORY, "Name what lies at rom offsets or ranges, e.g. 0x1b740,0x12000-0x120ff (tables, cells, checksum blocks).\n" },
+	{ "-xref",    &got_xref,          OPTION_SET,   &xref_list, MANDATORY, "Show the code referencing rom offsets/ranges, and for code what its function references (kept in <romfile>.xref).\n" },
+	{ "-run",     &got_run,           OPTION_SET,   &run_spec,  MANDATORY, "Run a rom routine in the C167 emulator, e.g. 0x6bb2e,0x1ff8 (address, then r12-r15), show its result.\n" },
+	{ "-lookupcheck",&show_lookupcheck,OPTION_SET, 0,          OPTIONAL,  "Check the -eval lookup arithmetic against the rom's own group map lookups, run in the C167 emulator.\n" },
+	{ "-mkneedle",&got_mkneedle,      OPTION_SET,   &mkneedle_spec, MANDATORY, "Make a needle/mask pair from rom offsets start-end[:name] of the romfile, check it against every romfile given.\n" },
+	{ "-mine",    &got_mine,          OPTION_SET,   &mine_dir,  MANDATORY, "Hash the code of every rom under a directory, propose new variants of the built in needles.\n" },
+	{ "-mksig",   &got_mksig,         OPTION_SET,   &mksig_name, MANDATORY, "Add the functions the needles (and <romfile>.sym) name in every romfile given to a signature database.\n" },
+	{ "-sigs",    &got_sigs,          OPTION_SET,   &sigs_name, MANDATORY, "Name every function of the rom that has a signature in a database made with -mksig.\n" },
+	{ "-listing", &got_listing,       OPTION_SET,   &listing_name, MANDATORY, "Write an annotated disassembly of the whole rom to a file, with IDA (.idc) and Ghidra (.py) symbol scripts.\n" },
 	{ "-seedkey", &seedkey_patch,     OPTION_SET,   0,          OPTIONAL,  "Try to identify seedkey function and patch login so any login password works.\n\n"                  },
 
-	{ "-fixsums", &correct_checksums, OPTION_SET,   0,          OPTIONAL,  "Try to correct checksums, if corrected it saves appending '_corrected.bin'.\n\n"                    },
+	{ "-fixsums", &correct_checksums, OPTION_SET,   0,          OPTIONAL,  "Try to correct checksums, if corrected it saves appending '_corrected.bin'.\n"                      },
+	{ "-verify",  &verify_sums,       VERIFY_CSV,   0,          OPTIONAL,  "Only verify main and multipoint checksums, prints one csv line per romfile.\n"                     },
+	{ "-verifyjson",&verify_sums,     VERIFY_JSON,  0,          OPTIONAL,  "Only verify main and multipoint checksums, prints one json line per romfile.\n\n"                  },
+
+	{ "-export",  &export_data,       OPTION_SET,   &export_type, MANDATORY, "Also export every decoded table and value as 'json' or 'csv' (default file <romfile>.json/.csv).\n" },
+	{ "-exportfile",&got_exportfile,  OPTION_SET,   &export_name, MANDATORY, "Filename for -export output, use '-' for stdout.\n\n"                                          },
+
+	{ "-eval",    &eval_log,          OPTION_SET,   &eval_name, MANDATORY, "Evaluate the -evalmap maps at every row of a csv datalog (default output <log>.eval.csv).\n"     },
+	{ "-evalmap", &got_evalmap,       OPTION_SET,   &eval_spec, MANDATORY, "Maps and datalog columns to evaluate, e.g. KFZW=nmot:rl,LAMFA=nmot:rl (also enables -KFZW ..).\n" },
+	{ "-evalout", &got_evalout,       OPTION_SET,   &evalout_name, MANDATORY, "Filename for -eval output, use '-' for stdout.\n\n"                                            },
+
+	{ "-replay",  &replay_log,        OPTION_SET,   &replay_name, MANDATORY, "Replay a csv datalog through the rom's MLHFM/KFKHFM/PUKANS/LAMFA/KRKTE/FKKVS/KFZW (default output <log>.replay.csv).\n" },
+	{ "-replayrom",&got_replayrom,    OPTION_SET,   &replayrom_name, MANDATORY, "Second romfile to replay side by side with -romfile.\n"                                     },
+	{ "-replaycols",&got_replaycols,  OPTION_SET,   &replaycols, MANDATORY, "Datalog columns for hfm voltage, rpm, load and intake temp (default uhfm,nmot,rl,tans).\n"    },
+	{ "-replayout",&got_replayout,    OPTION_SET,   &replayout_name, MANDATORY, "Filename for -replay output, use '-' for stdout.\n\n"                                      },
 
 	{ "-noinfo",  &show_rominfo,      OPTION_CLR,   0,          OPTIONAL,  "Disable rom information report scanning (on as default).\n"                                         },
 	{ "-hex",     &show_hex,          OPTION_SET,   0,          OPTIONAL,  "Also show non formatted raw hex values in map table output.\n"                                      },
@@ -155,13 +260,75 @@ int show_usage(char *argv[], int argc)
 	return 0;
 }
 
+/*
+ * -verify / -verifyjson : every argument following -romfile (up to the next option)
+ * is treated as a romfile, so shell wildcards work e.g. -verify -romfile dumps/ *.bin
+ */
+int verify_romfiles(int argc, char *argv[])
+{
+	int i, j, first=1, bad=0;
+
+	for (i=1 ; i < argc; i++) 
+	{
+		if(strcmp(argv[i], "-romfile") != 0) continue;
+		for(j=i+1; j < argc && argv[j][0] != '-'; j++) {
+			bad |= verify_rom(argv[j], verify_sums, first);
+			first = 0;
+		}
+		i = j-1;
+	}
+	return bad;
+}
+
+/*
+ * -mkneedle, -mksig : every romfile given (up to the next option), for -mkneedle the first is
+ * the reference, e.g. -mkneedle 0x6bb2e-0x6bb7f -romfile ref.bin dumps/ *.bin
+ */
+int many_romfiles(int argc, char *argv[])
+{
+	char **list;
+	int i, j, n = 0, res = 0;
+
+	list = (char **)malloc(argc * sizeof(char *));
+	if(list == 0) return 0;
+	for (i=1 ; i < argc; i++) 
+	{
+		if(strcmp(argv[i], "-romfile") != 0) continue;
+		for(j=i+1; j < argc && argv[j][0] != '-'; j++) list[n++] = argv[j];
+		i = j-1;
+	}
+	if(got_mkneedle) res = check_needlegen(mkneedle_spec, list, n);
+	if(got_mksig)    res = check_sigbuild(mksig_name, list, n);
+	free(list);
+	return res;
+}
+
+/*
+ * Switch on the check that finds each map named in -evalmap, e.g. KFZW -> -KFZW
+ */
+void enable_eval_checks(EVAL_MAP *maps, int num)
+{
+	char opt[40];
+	int i, j, len;
+
+	for(i=0;i<num;i++) {
+		len = strcspn(maps[i].name, "#");
+		snprintf(opt, sizeof(opt), "-%.*s", len, maps[i].name);
+		for(j=0;j<(int)(sizeof(opts_table)/sizeof(OPTS_ENTRY));j++) {
+			if(strcmp(opt, opts_table[j].option_name) == 0 && opts_table[j].filename == 0) {
+				*opts_table[j].option_var = opts_table[j].option_value;
+			}
+		}
+	}
+}
+
 int main(int argc, char *argv[])
 {
     int ok;
     int i=0, result;
-	printf("Ferrari 360 ME7.3H4 Rom Tool. *BETA TEST* Last Built: %s %s v1.6\n",__DATE__,__TIME__);
-	printf("by 360trev.  Needle lookup function borrowed from nyet (Thanks man!) from\nthe ME7sum tool development (see github). \n\n");
-	printf("..Now fixed and working on 64-bit hosts, Linux, Apple and Android devices ;)\n\n");
+	EVAL_MAP eval_maps[MAX_EVAL_MAPS];
+	int eval_num=0;
+	REPLAY_MODEL replay_a, replay_b;
 	
 	/* parse and check which options provided by console */	
     for (i=0 ; i < argc; i++) 
@@ -170,18 +337,41 @@ int main(int argc, char *argv[])
 		if(result == 1) { exit(0); }
 	}
 
+	/* checksum triage mode, keep stdout machine readable */
+	if(verify_sums != 0 && rom_name != 0) {
+		return verify_romfiles(argc, argv);
+	}
+
+	printf("Ferrari 360 ME7.3H4 Rom Tool. *BETA TEST* Last Built: %s %s v1.6\n",__DATE__,__TIME__);
+	printf("by 360trev.  Needle lookup function borrowed from nyet (Thanks man!) from\nthe ME7sum tool development (see github). \n\n");
+	printf("..Now fixed and working on 64-bit hosts, Linux, Apple and Android devices ;)\n\n");
+
 	/* if no arguments are specified show usage */
 	if(argc < 2 || show_help == 1) {
 		show_usage(argv, argc);
 		return 0;
 	}
 
+	/* needle variant mining works on a directory of roms, not on -romfile */
+	if(got_mine) {
+		check_needlemine(mine_dir);
+		printf("\n\n");
+		return 0;
+	}
+
 	/* only proceed if we have been passed a valid romfile name */
 	if(rom_name == 0) {
 		printf("**No rom filename specified, e.g. -romfile rom.bin\n\n");
 		return 0;		
 	}
 
+	/* needle synthesis and signature building, nothing else is analysed */
+	if(got_mkneedle || got_mksig) {
+		many_romfiles(argc, argv);
+		printf("\n\n");
+		return 0;
+	}
+
 	/* sanity check any options for the given operational find_mlhfm  */
 	switch(find_mlhfm)
 	{
@@ -207,13 +397,87 @@ int main(int argc, char *argv[])
 		default:
 		break;
 	}
+
+	/* table formats from an .ini override the built-in ones, so load them before any check runs */
+	if(got_tables != 0) {
+		if(tables_name == NULL || table_ini_load(tables_name) != 0) {
+			return 0;
+		}
+	}
 		
+	/* structured export of everything decoded during the search */
+	if(export_data != 0) {
+		int format = export_parse_format(export_type);
+		char export_default[MAX_FILENAME];
+
+		if(format == EXPORT_NONE) {
+			printf("Unknown export format '%s', use -export json or -export csv\n", export_type ? export_type : "");
+			return 0;
+		}
+		if(export_name == NULL) {
+			snprintf(export_default, sizeof(export_default), "%s.%s", rom_name, format == EXPORT_JSON ? "json" : "csv");
+			export_name = export_default;
+		}
+		if(export_open(export_name, format, rom_name) != 0) {
+			return 0;
+		}
+	}
+
+	/* keep the maps found by the checks so they can be evaluated against a datalog afterwards */
+	if(eval_log != 0) {
+		eval_num = map_eval_parse(eval_spec, eval_maps, MAX_EVAL_MAPS);
+		if(eval_num <= 0) {
+			printf("-eval needs the maps to evaluate, e.g. -evalmap KFZW=nmot:rl\n");
+			return 0;
+		}
+		enable_eval_checks(eval_maps, eval_num);
+		map_registry_enable();
+	}
+	/* the replay needs every table of the air/fuel/ignition path */
+	if(replay_log != 0) {
+		show_mlhfm = show_kfkhfm = show_pukans = show_lamfa = show_krkte = show_fkkvs = show_kfzw = show_kfzw2 = 1;
+		map_registry_enable();
+	}
+
 	/*
 	 * now lets search rom 
 	 */
     ok = search_rom(find_mlhfm, rom_name,hfm_name);
     if (ok) { printf("File could not be found. Please check and try again."); }
 
+	export_close();
+
+	if(ok == 0 && eval_num > 0) {
+		char eval_default[MAX_FILENAME];
+
+		if(evalout_name == NULL) {
+			snprintf(eval_default, sizeof(eval_default), "%s.eval.csv", eval_name);
+			evalout_name = eval_default;
+		}
+		map_eval_datalog(eval_name, eval_maps, eval_num, evalout_name);
+	}
+
+	if(ok == 0 && replay_log != 0) {
+		char replay_default[MAX_FILENAME];
+
+		replay_model_init(&replay_a, rom_name);
+		if(replayrom_name != NULL) {
+			/* only read the second rom, never patch or save it */
+			seedkey_patch = correct_checksums = find_mlhfm = 0;
+			printf("Replay: searching second rom '%s'\n\n", replayrom_name);
+			search_rom(0, replayrom_name, NULL);
+			replay_model_init(&replay_b, replayrom_name);
+		}
+		if(replayout_name == NULL) {
+			snprintf(replay_default, sizeof(replay_default), "%s.replay.csv", replay_name);
+			replayout_name = replay_default;
+		}
+		replay_datalog(replay_name, replaycols, &replay_a, replayrom_name ? &replay_b : NULL, replayout_name);
+		replay_model_free(&replay_a);
+		if(replayrom_name != NULL) replay_model_free(&replay_b);
+	}
+	map_registry_free(NULL);
+
 	return 0;
 }
 
@@ -243,80 +507,142 @@ int search_rom(int find_mlhfm, char *filename_rom, char *filename_hfm)
 			}
 			printf("\n");
 					
+			// everything identified from here on is labelled by address for -where
+			label_clear();
 			// check for dppx registers
 			check_dppx(fh, show_dppx);
+			// function boundaries, shared by every check that needs to know the enclosing function
+			func_index_build(fh);
+			// data page of every code offset, resolves the near addresses the checks find
+			dpp_track_build(fh);
 			// check for rom info
 			check_rominfo(fh, show_rominfo);
+			// name the functions with a known signature
+			check_sigs(fh, sigs_name);
+			// tables shown by the named checks (for the -maps catalog) are kept per rom
+			catalog_known_clear();
 	
-			// check for display of cwkonfz1 - configuration of vehicle
-			check_cwkonfz(fh, show_cwkonfz1);
-			// check for display of cwkonls  - conﬁguration lambda sensor
-			check_cwkonls(fh, show_cwkonls);
-			// check for display of cwkonabg - configuration of exhaust emissions treatment
-			check_cwkonabg(fh, show_cwkonabg);
-
-			// check for display of pukans table
-			check_pukans(fh, show_pukans);
-			// check for display of kfkhfm table
-			check_kfkhfm(fh, show_kfkhfm);
-			// check for display of lamfa table
-			check_lamfa(fh, show_lamfa);
-			// check for display of kfnw table - variable camshaft control
-			check_kfnw(fh, show_kfnw,   1);
-			check_kfnw(fh, show_kfnwwl, 0);
-
-			// check for display of krkte
-			check_krkte(fh, show_krkte);
-			// check for display of krkte
-			check_fkkvs(fh, show_fkkvs);
-			// check for display of eskonf
-			check_eskonf(fh, show_eskonf);
-
-			// check for display of nswo
-			check_nswo(fh, show_nswo1,  1);
-			check_nswo(fh, show_nswo2,  2);
-
-			check_nmax(fh, show_nmax);
-
-			check_kfsu(fh, show_kfsu,  1);
-			check_kfsu(fh, show_kfsu2, 2);
-
-			check_kfmsnwdk(fh, show_kfmsnwdk);
-			check_kfwdkmsn(fh, show_kfwdkmsn);
-
-			// check for dislay of kfzw
-			check_kfzw(fh, show_kfzw,   1);
-			check_kfzw(fh, show_kfzw2,  2);
-
-			// check for display of tvkup
-			check_tvkup(fh, show_tvkup);
-			// check for display of lrstpza
-			check_lrstpza(fh, show_lrstpza);
-
-			// check for seedkey_patch
+			// the table and value checks only read the image, each group runs in parallel with
+			// its output printed in this order (sequential while exporting, the export is one stream)
+			CHECK_JOB tables_1[] = {
+				CHECK_JOB(check_cwkonfz,       show_cwkonfz1),	// configuration of vehicle
+				CHECK_JOB(check_cwkonls,       show_cwkonls),	// configuration lambda sensor
+				CHECK_JOB(check_cwkonabg,      show_cwkonabg),	// configuration of exhaust emissions treatment
+				CHECK_JOB(check_pukans,        show_pukans),
+				CHECK_JOB(check_kfkhfm,        show_kfkhfm),
+				CHECK_JOB(check_lamfa,         show_lamfa),
+				CHECK_JOB_MODE(check_kfnw,     show_kfnw,   1),	// variable camshaft control
+				CHECK_JOB_MODE(check_kfnw,     show_kfnwwl, 0),
+				CHECK_JOB(check_krkte,         show_krkte),
+				CHECK_JOB(check_fkkvs,         show_fkkvs),
+				CHECK_JOB(check_eskonf,        show_eskonf),
+				CHECK_JOB_MODE(check_nswo,     show_nswo1,  1),
+				CHECK_JOB_MODE(check_nswo,     show_nswo2,  2),
+				CHECK_JOB(check_nmax,          show_nmax),
+				CHECK_JOB_MODE(check_kfsu,     show_kfsu,   1),
+				CHECK_JOB_MODE(check_kfsu,     show_kfsu2,  2),
+				CHECK_JOB(check_kfmsnwdk,      show_kfmsnwdk),
+				CHECK_JOB(check_kfwdkmsn,      show_kfwdkmsn),
+				CHECK_JOB_MODE(check_kfzw,     show_kfzw,   1),
+				CHECK_JOB_MODE(check_kfzw,     show_kfzw2,  2),
+				CHECK_JOB(check_tvkup,         show_tvkup),
+				CHECK_JOB(check_lrstpza,       show_lrstpza),
+			};
+			CHECK_JOB tables_2[] = {
+				CHECK_JOB(check_kfagk,         valves),			// exhaust valves maps
+				CHECK_JOB_MODE(check_kfped,    show_kfped,  1),	// throttle
+				CHECK_JOB_MODE(check_kfped,    show_kfpedr, 2),
+				CHECK_JOB_MODE(check_kftvsa,   show_kftvsa, 1),
+				CHECK_JOB_MODE(check_kftvsa,   show_kftvsa0,2),
+				CHECK_JOB(check_ini_tables,    got_tables),		// -tables .ini needles
+			};
+			int parallel = !export_active();
+
+			run_check_jobs(fh, tables_1, sizeof(tables_1)/sizeof(CHECK_JOB), parallel);
+
+			// check for seedkey_patch (patches the image, so it runs on its own)
 			check_seedkey(fh, seedkey_patch);
-			
-			// check for kfagk (exhaust valves maps)
-			check_kfagk(fh, valves);
-			
-			// check for kfed (throttle)
-			check_kfped(fh, show_kfped,  1);
-			check_kfped(fh, show_kfpedr, 2);
-
-			// check for kftvsa
-			check_kftvsa(fh, show_kftvsa, 1);
-			// check for kftvsa0
-			check_kftvsa(fh, show_kftvsa0, 2);
-			
-			// check for multimaps
-			check_multimap(fh, show_multimap);
-	
+
+			run_check_jobs(fh, tables_2, sizeof(tables_2)/sizeof(CHECK_JOB), parallel);
+
+			// the map catalog leaves out every table a named check shows (and -where names them), those
+			// that weren't asked for are run quietly first (not while exporting, the export would pick them up)
+			if((show_multimap || show_mapscan || show_lookupcheck || got_where || got_xref || got_listing) && !export_active()) {
+				CHECK_JOB known_maps[] = {
+					CHECK_JOB(check_pukans,        !show_pukans),
+					CHECK_JOB(check_kfkhfm,        !show_kfkhfm),
+					CHECK_JOB(check_lamfa,         !show_lamfa),
+					CHECK_JOB_MODE(check_kfnw,     !show_kfnw,   1),
+					CHECK_JOB_MODE(check_kfnw,     !show_kfnwwl, 0),
+					CHECK_JOB(check_fkkvs,         !show_fkkvs),
+					CHECK_JOB_MODE(check_kfsu,     !show_kfsu,   1),
+					CHECK_JOB_MODE(check_kfsu,     !show_kfsu2,  2),
+					CHECK_JOB(check_kfmsnwdk,      !show_kfmsnwdk),
+					CHECK_JOB(check_kfwdkmsn,      !show_kfwdkmsn),
+					CHECK_JOB_MODE(check_kfzw,     !show_kfzw,   1),
+					CHECK_JOB_MODE(check_kfzw,     !show_kfzw2,  2),
+					CHECK_JOB(check_kfagk,         !valves),
+					CHECK_JOB_MODE(check_kfped,    !show_kfped,  1),
+					CHECK_JOB_MODE(check_kfped,    !show_kfpedr, 2),
+					CHECK_JOB_MODE(check_kftvsa,   !show_kftvsa, 1),
+					CHECK_JOB_MODE(check_kftvsa,   !show_kftvsa0,2),
+					CHECK_JOB(check_mlhfm,         1),		// shown after the catalog, so always noted here
+				};
+				run_check_jobs_quiet(fh, known_maps, sizeof(known_maps)/sizeof(CHECK_JOB), parallel);
+			}
+			// the listing names everything the value checks find as well
+			if(got_listing && !export_active()) {
+				CHECK_JOB known_values[] = {
+					CHECK_JOB(check_cwkonfz,       !show_cwkonfz1),
+					CHECK_JOB(check_cwkonls,       !show_cwkonls),
+					CHECK_JOB(check_cwkonabg,      !show_cwkonabg),
+					CHECK_JOB(check_krkte,         !show_krkte),
+					CHECK_JOB(check_eskonf,        !show_eskonf),
+					CHECK_JOB_MODE(check_nswo,     !show_nswo1,  1),
+					CHECK_JOB_MODE(check_nswo,     !show_nswo2,  2),
+					CHECK_JOB(check_nmax,          !show_nmax),
+					CHECK_JOB(check_tvkup,         !show_tvkup),
+					CHECK_JOB(check_lrstpza,       !show_lrstpza),
+				};
+				run_check_jobs_quiet(fh, known_values, sizeof(known_values)/sizeof(CHECK_JOB), parallel);
+			}
+			check_multimap(fh, show_multimap, show_maptables);
+			// mlhfm is shown after the map catalog, as it always was
 			check_mlhfm(fh, show_mlhfm);
+			check_mapscan(fh, show_mapscan);
+			check_lookup(fh, show_lookupcheck);
+			check_flow(fh, show_cfg);
 			
 			// mlhfm support
 			check_mlhfm2(fh, addr, filename_rom, filename_hfm, dynamic_ROM_FILESIZE, rom_load_addr);
+			// checksum status (of the image as loaded) for -export
+			if(export_active()) {
+				CHECKSUM_REPORT r;
+				memset(&r, 0, sizeof(r));
+				if(verify_checksums(fh, &r) == 0) {
+					export_checksums(&r);
+				}
+			}
 			// do correction
 			fix_checksums(fh, addr, filename_rom, dynamic_ROM_FILESIZE, rom_load_addr);
+
+			// name the requested addresses (the checksum blocks are labelled by verify_checksums)
+			if((got_where || got_xref || got_listing) && !export_active()) {
+				CHECKSUM_REPORT r;
+				verify_checksums(fh, &r);
+			}
+			if(got_where) {
+				check_where(fh, where_list);
+			}
+			if(got_xref) {
+				check_xref(fh, filename_rom, xref_list);
+			}
+			if(got_run) {
+				check_run(fh, run_spec);
+			}
+			if(got_listing) {
+				check_listing(fh, filename_rom, listing_name);
+			}
 			
 		} else {
 			printf("File size isn't a supported firmware size. Only 512kbyte and 1Mb images supported. ");
@@ -325,6 +651,11 @@ int search_rom(int find_mlhfm, char *filename_rom, char *filename_hfm)
 		printf("\nFailed to load, result = %d\n", load_result);
 	}
 	/* free file if allocated */
+	func_index_free();
+	dpp_track_free();
+	flow_free();
+	xref_close();
+	label_clear();
 	load_result = ifree_file(fh);
 	printf("\n\n");
 	return 0;
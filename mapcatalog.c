@@ -0,0 +1,851 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "mapcatalog.h"
+#include "table_spec.h"
+#include "funcindex.h"
+#include "dpptrack.h"
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
+//-[ Map Catalog ] ---------------------------------------------------------------------------------------------------------
+
+/*
+ * The lookup routines are always called the same handful of ways, so a single walk over the code (word aligned,
+ * boot loader and map area skipped) tries each call pattern at every offset:
+ *
+ *   mapfinder_needle       r12/r13 = table, r14 = byte or word input      -> CAT_CURVE (or CAT_AXIS, see below)
+ *   mapfinder_xy_needle    r12/r13 = table, r14/r15 = inputs              -> CAT_MAP, word or byte header
+ *                          r12/r13 = axis, r14 = input, r15 = previous    -> CAT_AXIS
+ *                          r12 = cells, r13 = axis, r14/r15 = axis index  -> CAT_GROUP
+ *   mapfinder_xy2_needle   cells, y-axis, x_num, x-axis, y_num            -> CAT_MAP, byte header
+ *   mapfinder_xy3_needle   r12/r13 = cells, r14/r15 = axis                -> CAT_SPLIT
+ *   mapfinder_xy4_needle   r12 = table, r13 = register, r14 = input       -> CAT_MAP
+ *   mapfinder_axis_needle  r12 = axis, r13 = byte or word input           -> CAT_AXIS
+ *                          r12 = table, r13/r14 = inputs                  -> CAT_MAP
+ *   mapfinder_index_needle cmp rX,#num, [rX*2 + array]                   -> CAT_ARRAY
+ *
+ * An axis distribution gets its own previous result (as a search hint) in the register after its input and
+ * stores the new one back, the same call with a second input there is a 2D lookup (e.g. loc_73DE).
+ *
+ * Group maps and shared axes are addressed relative to the map segment (dpp1-1, as kfzw.c), everything else
+ * comes with its own page. Each table goes into the MAP_SET once however often it is looked up.
+ *
+ * What the call site doesn't say (e.g. the cell width) is taken from where the next table starts: tables are
+ * packed, so the space up to the next catalogued table tells byte cells from word cells, and a 'curve' that is
+ * directly followed by another table has no cells at all, it is an axis distribution (like SNM16ZUUB).
+ *
+ * Curves and split curves take their point count straight from the rom, so the header must hold up before
+ * it is used: at most CAT_MAX_POINTS points, an ordered axis and the whole table inside the map area (shared
+ * axes the count and the area only). A group map needs both of its axes, a 2D map a header that holds up. A call site that fails this stays in
+ * the catalog as rejected, without table parts or size, and is neither known nor unknown.
+ */
+
+
+#define CAT_MAX_POINTS           32			// sanity limit on x_num/y_num of a header read from the rom
+
+typedef struct KNOWN_MAP {
+	unsigned long  x_num_adr, y_num_adr;
+	unsigned long  cell_adr;
+	const char    *name;
+} KNOWN_MAP;
+
+static KNOWN_MAP known_maps[MAX_KNOWN_MAPS];
+static int num_known_maps;
+#ifndef NO_THREADS
+static pthread_mutex_t known_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static const char *kind_names[CAT_KINDS] = { "curve", "map", "split", "group", "axis", "array" };
+
+const char *catalog_kind_name(int kind)
+{
+	if(kind < 0 || kind >= CAT_KINDS) return "?";
+	return kind_names[kind];
+}
+
+/*
+ * Remember a table shown by one of the named checks (called from dump_table/dump_split_table, any thread)
+ */
+void catalog_note_map(MAP_DATA *m)
+{
+	if(m->td == &XXXX_table || m->td == &XXXXB_table) return;		// generic formats say nothing about the table
+	catalog_note_table(m->td->table_name, m->x_num_adr, m->y_num ? m->y_num_adr : CAT_NO_ADR, m->cell_adr);
+}
+
+/*
+ * As catalog_note_map() for a table that isn't decoded as a map (e.g. the MLHFM array),
+ * parts it doesn't have are CAT_NO_ADR
+ */
+void catalog_note_table(const char *name, unsigned long x_num_adr, unsigned long y_num_adr, unsigned long cell_adr)
+{
+#ifndef NO_THREADS
+	pthread_mutex_lock(&known_lock);
+#endif
+	if(num_known_maps < MAX_KNOWN_MAPS) {
+		known_maps[num_known_maps].x_num_adr = x_num_adr;
+		known_maps[num_known_maps].y_num_adr = y_num_adr;
+		known_maps[num_known_maps].cell_adr  = cell_adr;
+		known_maps[num_known_maps].name      = name;
+		num_known_maps++;
+	}
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&known_lock);
+#endif
+}
+
+void catalog_known_clear(void)
+{
+#ifndef NO_THREADS
+	pthread_mutex_lock(&known_lock);
+#endif
+	num_known_maps = 0;
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&known_lock);
+#endif
+}
+
+//
+// hash set of tables, keyed by kind and physical address
+//
+
+static int map_set_init(MAP_SET *ms)
+{
+	memset(ms, 0, sizeof(MAP_SET));
+	ms->slots = calloc(MAP_SET_INITIAL_SLOTS, sizeof(int));
+	if(ms->slots == 0) return -1;
+	ms->num_slots = MAP_SET_INITIAL_SLOTS;
+	return 0;
+}
+
+static void map_set_free(MAP_SET *ms)
+{
+	free(ms->slots);
+	free(ms->sites);
+	free(ms->refs);
+	memset(ms, 0, sizeof(MAP_SET));
+}
+
+static unsigned int map_hash(int type, unsigned long adr, unsigned long adr2)
+{
+	unsigned long h = adr * 0x9E3779B1UL;
+
+	h ^= (adr2 + type) * 0x85EBCA77UL;
+	return (unsigned int)(h ^ (h >> 16));
+}
+
+// slot holding the table (or the empty slot it belongs in)
+static int map_set_slot(MAP_SET *ms, int type, unsigned long adr, unsigned long adr2)
+{
+	int mask = ms->num_slots - 1;
+	int i = map_hash(type, adr, adr2) & mask;
+	MAP_SITE *site;
+
+	while(ms->slots[i] != 0) {
+		site = &ms->sites[ms->slots[i]-1];
+		if(site->adr == adr && site->adr2 == adr2 && site->type == type) break;
+		i = (i+1) & mask;
+	}
+	return i;
+}
+
+static int map_set_grow(MAP_SET *ms)
+{
+	int *old = ms->slots, old_num = ms->num_slots;
+	int i;
+
+	ms->slots = calloc(old_num*2, sizeof(int));
+	if(ms->slots == 0) {
+		ms->slots = old;
+		return -1;
+	}
+	ms->num_slots = old_num*2;
+	for(i=0;i<old_num;i++) {
+		if(old[i] != 0) {
+			MAP_SITE *site = &ms->sites[old[i]-1];
+			ms->slots[map_set_slot(ms, site->type, site->adr, site->adr2)] = old[i];
+		}
+	}
+	free(old);
+	return 0;
+}
+
+/*
+ * Record a call site of the table at adr (and adr2), returns the table's index or -1 if out of memory
+ */
+static int map_set_add(MAP_SET *ms, int type, unsigned long adr, unsigned long adr2, unsigned char *code, unsigned long offset, unsigned long func)
+{
+	MAP_SITE *site;
+	MAP_REF *ref;
+	void *p;
+	int slot, idx;
+
+	if(ms->num_refs == ms->max_refs) {
+		p = realloc(ms->refs, (ms->max_refs ? ms->max_refs*2 : 64) * sizeof(MAP_REF));
+		if(p == 0) return -1;
+		ms->refs = p;
+		ms->max_refs = ms->max_refs ? ms->max_refs*2 : 64;
+	}
+
+	slot = map_set_slot(ms, type, adr, adr2);
+	if(ms->slots[slot] == 0) {
+		if(ms->num_sites == ms->max_sites) {
+			p = realloc(ms->sites, (ms->max_sites ? ms->max_sites*2 : 64) * sizeof(MAP_SITE));
+			if(p == 0) return -1;
+			ms->sites = p;
+			ms->max_sites = ms->max_sites ? ms->max_sites*2 : 64;
+		}
+		site = &ms->sites[ms->num_sites];
+		memset(site, 0, sizeof(MAP_SITE));
+		site->type      = type;
+		site->adr       = adr;
+		site->adr2      = adr2;
+		site->code      = code;
+		site->first_ref = -1;
+		site->last_ref  = -1;
+		ms->slots[slot] = ++ms->num_sites;
+
+		if(ms->num_sites*2 > ms->num_slots) map_set_grow(ms);
+	}
+	idx  = ms->slots[map_set_slot(ms, type, adr, adr2)] - 1;
+	site = &ms->sites[idx];
+
+	// references stay in the order they were found
+	ref = &ms->refs[ms->num_refs];
+	ref->offset = offset;
+	ref->func   = func;
+	ref->next   = -1;
+	if(site->last_ref < 0) site->first_ref = ms->num_refs;
+	else ms->refs[site->last_ref].next = ms->num_refs;
+	site->last_ref = ms->num_refs++;
+	site->num_refs++;
+	return idx;
+}
+
+//
+// classification helpers
+//
+
+// rom file offset of a physical address, CAT_NO_ADR if it isn't inside the image
+static unsigned long rom_offset(ImageHandle *fh, unsigned long phy)
+{
+	if(phy < CAT_ROM_BASE || phy - CAT_ROM_BASE >= fh->len) return CAT_NO_ADR;
+	return phy & ~(ROM_1MB_MASK);
+}
+
+static unsigned long get_num(ImageHandle *fh, unsigned long off, int nwidth)
+{
+	if(off == CAT_NO_ADR || off + nwidth > fh->len) return 0;
+	return nwidth == 1 ? fh->d.u8[off] : get16(fh->d.u8 + off);
+}
+
+// axis values must be strictly increasing, either read as unsigned or as signed
+static int axis_ordered(ImageHandle *fh, unsigned long off, int num, int nwidth)
+{
+	long prev_u = 0, prev_s = 0, u, s;
+	int i, up = 1, sp = 1;
+
+	if(num <= 0 || num > CAT_MAX_POINTS || off + (unsigned long)num*nwidth > fh->len) return 0;
+	for(i=0;i<num;i++) {
+		u = get_num(fh, off + i*nwidth, nwidth);
+		s = nwidth == 1 ? (signed char)u : (short)u;
+		if(i > 0 && u <= prev_u) up = 0;
+		if(i > 0 && s <= prev_s) sp = 0;
+		prev_u = u;
+		prev_s = s;
+	}
+	return up || sp;
+}
+
+// [off, off+len) lies in the map area
+static int in_map_area(unsigned long off, unsigned long len)
+{
+	return off >= MAP_AREA_START && off + len <= MAP_AREA_START + MAP_AREA_SIZE;
+}
+
+/*
+ * Check a 1D header of x_num points read from the rom, the axis order only when it
+ * has to follow x_num (a shared axis may be the x half of a 2D header),
+ * returns 0 if it holds up, otherwise -1 with the table parts cleared and the reason noted
+ */
+static int check_curve(CATALOG_MAP *cm, ImageHandle *fh, int ordered)
+{
+	if(cm->x_num <= 0 || cm->x_num > CAT_MAX_POINTS) {
+		cm->rejected = "point count out of range";
+	} else if(ordered && !axis_ordered(fh, cm->x_axis_adr, cm->x_num, cm->x_width)) {
+		cm->rejected = "axis not ordered";
+	} else if(!in_map_area(cm->x_num_adr, cm->num_width + (unsigned long)cm->x_num*cm->x_width)
+		|| (cm->cell_adr != CAT_NO_ADR && !in_map_area(cm->cell_adr, (unsigned long)cm->x_num*cm->cell_width))) {
+		cm->rejected = "runs past the map area";
+	} else {
+		return 0;
+	}
+	cm->x_axis_adr = CAT_NO_ADR;
+	cm->cell_adr   = CAT_NO_ADR;
+	cm->x_width    = 0;
+	cm->cell_width = 0;
+	cm->layout     = -1;
+	return -1;
+}
+
+// the catalog entry of a table, filled with the defaults for a new one
+static CATALOG_MAP *catalog_add(MAP_CATALOG *cat, ImageHandle *fh, int kind, unsigned long adr, unsigned long adr2, unsigned char *code, int *is_new)
+{
+	unsigned long offset = code - fh->d.u8;
+	unsigned long func   = (kind == CAT_SPLIT) ? func_start(offset) : FUNC_NONE;
+	int before = cat->set.num_sites;
+	CATALOG_MAP *cm;
+	void *p;
+	int idx;
+
+	*is_new = 0;
+	if(cat->max_maps == before) {
+		p = realloc(cat->maps, (cat->max_maps ? cat->max_maps*2 : 64) * sizeof(CATALOG_MAP));
+		if(p == 0) return 0;
+		cat->maps = p;
+		cat->max_maps = cat->max_maps ? cat->max_maps*2 : 64;
+	}
+	idx = map_set_add(&cat->set, kind, adr, adr2, code, offset, func);
+	if(idx < 0) return 0;
+	if(cat->set.num_sites == before) return &cat->maps[idx];
+
+	cm = &cat->maps[idx];
+	memset(cm, 0, sizeof(CATALOG_MAP));
+	cm->kind       = kind;
+	cm->adr        = adr;
+	cm->x_num_adr  = CAT_NO_ADR;
+	cm->y_num_adr  = CAT_NO_ADR;
+	cm->x_axis_adr = CAT_NO_ADR;
+	cm->y_axis_adr = CAT_NO_ADR;
+	cm->cell_adr   = CAT_NO_ADR;
+	cm->layout     = -1;
+	cm->x_axis     = -1;
+	cm->y_axis     = -1;
+	*is_new = 1;
+	return cm;
+}
+
+// physical address of a 'calls seg, addr' at p
+static unsigned long call_target(unsigned char *p)
+{
+	return ((unsigned long)p[1] << 16) | get16(p+2);
+}
+
+// ram word a 'mov word_XXXX, r4' right after the call stores the result to
+static unsigned int stored_result(ImageHandle *fh, unsigned char *p)
+{
+	if(p+4 > fh->d.u8 + fh->len || p[0] != 0xF6 || p[1] != 0xF4) return 0;
+	return get16(p+2);
+}
+
+// x_num and axis (and cells straight after it) at off, nwidth wide
+static void set_curve(CATALOG_MAP *cm, ImageHandle *fh, unsigned long off, int nwidth)
+{
+	if(off & 1) nwidth = 1;									// words are never stored at odd addresses
+	cm->num_width  = nwidth;
+	cm->x_width    = nwidth;
+	cm->cell_width = nwidth;
+	cm->x_num_adr  = off;
+	cm->x_num      = get_num(fh, off, nwidth);
+	cm->x_axis_adr = off + nwidth;
+	cm->cell_adr   = cm->x_axis_adr + cm->x_num*nwidth;
+	cm->layout     = MAP_LAYOUT_HEADER;
+}
+
+/*
+ * 2D table with its own header, three header layouts are in use:
+ *   x_num, x-axis, y_num, y-axis, cells   words (MAP_LAYOUT_INTERLEAVED with the cells following)
+ *   x_num, y_num, x-axis, y-axis, cells   words (MAP_LAYOUT_HEADER, e.g. KFWDKMSN)
+ *   x_num, y_num, x-axis, y-axis, cells   bytes (MAP_LAYOUT_HEADER, e.g. KFSU)
+ * the one whose counts and axes make sense is taken.
+ */
+static void set_map(CATALOG_MAP *cm, ImageHandle *fh, unsigned long off)
+{
+	int w = (off & 1) ? 1 : 2;
+	int xn = get_num(fh, off, w), yn;
+
+	cm->num_width  = w;
+	cm->x_width    = w;
+	cm->y_width    = w;
+	cm->cell_width = w;
+	cm->x_num_adr  = off;
+	cm->x_num      = xn;
+
+	yn = get_num(fh, off + w + xn*w, w);
+	if(axis_ordered(fh, off + w, xn, w) && axis_ordered(fh, off + 2*w + xn*w, yn, w)) {
+		cm->layout     = MAP_LAYOUT_INTERLEAVED;
+		cm->x_axis_adr = off + w;
+		cm->y_num_adr  = cm->x_axis_adr + xn*w;
+		cm->y_num      = yn;
+		cm->y_axis_adr = cm->y_num_adr + w;
+		cm->cell_adr   = cm->y_axis_adr + yn*w;
+		return;
+	}
+	yn = get_num(fh, off + w, w);
+	if(axis_ordered(fh, off + 2*w, xn, w) && axis_ordered(fh, off + 2*w + xn*w, yn, w)) {
+		cm->layout     = MAP_LAYOUT_HEADER;
+		cm->y_num_adr  = off + w;
+		cm->y_num      = yn;
+		cm->x_axis_adr = off + 2*w;
+		cm->y_axis_adr = cm->x_axis_adr + xn*w;
+		cm->cell_adr   = cm->y_axis_adr + yn*w;
+		return;
+	}
+	xn = get_num(fh, off, 1);
+	yn = get_num(fh, off + 1, 1);
+	if(axis_ordered(fh, off + 2, xn, 1) && axis_ordered(fh, off + 2 + xn, yn, 1)) {
+		cm->layout     = MAP_LAYOUT_HEADER;
+		cm->num_width  = 1;
+		cm->x_width    = 1;
+		cm->y_width    = 1;
+		cm->cell_width = 1;
+		cm->x_num      = xn;
+		cm->y_num_adr  = off + 1;
+		cm->y_num      = yn;
+		cm->x_axis_adr = off + 2;
+		cm->y_axis_adr = cm->x_axis_adr + xn;
+		cm->cell_adr   = cm->y_axis_adr + yn;
+		return;
+	}
+	// none, only the address is known
+	cm->x_num = 0;
+}
+
+/*
+ * Match every lookup call pattern at p (rom file offset i), returns the bytes consumed by a match or 0
+ */
+static int catalog_match(MAP_CATALOG *cat, ImageHandle *fh, unsigned char *p)
+{
+	unsigned long left = fh->d.u8 + fh->len - p;
+	unsigned long off, phy;
+	CATALOG_MAP *cm;
+	int is_new;
+
+	// 2D map, byte header, every part passed separately
+	if(p[0] == 0xE6 && p[1] == 0xF4 && left >= mapfinder_xy2_needle_len+6
+		&& memcmp_mask(p, mapfinder_xy2_needle, mapfinder_xy2_mask, mapfinder_xy2_needle_len) == 0)
+	{
+		unsigned long xn   = rom_offset(fh, get16(p+26)*SEGMENT_SIZE + (get16(p+30) & 0x3FFF));	// extp page, #1
+		unsigned long yn   = rom_offset(fh, get16(p+42)*SEGMENT_SIZE + (get16(p+46) & 0x3FFF));
+		unsigned long xa   = rom_offset(fh, get16(p+38)*SEGMENT_SIZE + get16(p+34));
+		unsigned long ya   = rom_offset(fh, get16(p+18)*SEGMENT_SIZE + get16(p+14));
+		unsigned long cell = rom_offset(fh, get16(p+6)*SEGMENT_SIZE  + get16(p+2));
+
+		if(xn == CAT_NO_ADR || yn == CAT_NO_ADR || xa == CAT_NO_ADR || ya == CAT_NO_ADR || cell == CAT_NO_ADR) return 0;
+		cm = catalog_add(cat, fh, CAT_MAP, get16(p+26)*SEGMENT_SIZE + (get16(p+30) & 0x3FFF), 0, p, &is_new);
+		if(cm && is_new) {
+			cm->lookup     = call_target(p+48);
+			cm->var        = stored_result(fh, p+52);
+			cm->num_width  = 1;
+			cm->x_num_adr  = xn;
+			cm->y_num_adr  = yn;
+			cm->x_axis_adr = xa;
+			cm->y_axis_adr = ya;
+			cm->cell_adr   = cell;
+			cm->x_num      = fh->d.u8[xn];
+			cm->y_num      = fh->d.u8[yn];
+			// the axis widths follow from where the next part starts, XXXX_table's if that doesn't work out
+			cm->x_width    = (cm->x_num && (ya-xa) == (unsigned long)cm->x_num*2) ? 2 : 1;
+			cm->y_width    = (cm->y_num && (cell-ya) == (unsigned long)cm->y_num) ? 1 : 2;
+			cm->cell_width = 2;
+			if(yn == xn+1 && xa == yn+1 && ya == xa + cm->x_num*cm->x_width && cell == ya + cm->y_num*cm->y_width) {
+				cm->layout = MAP_LAYOUT_HEADER;
+			}
+		}
+		return mapfinder_xy2_needle_len;
+	}
+
+	// 1D table with its cells apart from a shared axis
+	if(p[0] == 0x88 && p[1] == 0x50 && left >= mapfinder_xy3_needle_len
+		&& memcmp_mask(p, mapfinder_xy3_needle, mapfinder_xy3_mask, mapfinder_xy3_needle_len) == 0)
+	{
+		unsigned long cell_phy = get16(p+8)*SEGMENT_SIZE  + get16(p+4);
+		unsigned long axis_phy = get16(p+16)*SEGMENT_SIZE + get16(p+12);
+		unsigned long cell = rom_offset(fh, cell_phy), axis = rom_offset(fh, axis_phy);
+
+		if(cell == CAT_NO_ADR || axis == CAT_NO_ADR) return 0;
+		// cells and axis are apart, it is only the same table if both match
+		cm = catalog_add(cat, fh, CAT_SPLIT, cell_phy, axis_phy, p, &is_new);
+		if(cm && is_new) {
+			cm->lookup     = call_target(p+18);
+			cm->num_width  = 1;										// as XXXXB_table
+			cm->x_width    = 1;
+			cm->cell_width = 1;
+			cm->x_num_adr  = axis;
+			cm->x_num      = fh->d.u8[axis];
+			cm->x_axis_adr = axis + 1;
+			cm->cell_adr   = cell;
+			check_curve(cm, fh, 1);
+		}
+		return mapfinder_xy3_needle_len;
+	}
+
+	// word array read through a bounds checked index, the register compared must be the one indexed
+	if(p[0] == 0x46 && left >= mapfinder_index_needle_len
+		&& memcmp_mask(p, mapfinder_index_needle, mapfinder_index_mask, mapfinder_index_needle_len) == 0
+		&& (p[1] & 0x0F) == (p[7] & 0x0F))
+	{
+		phy = dpp_near(p+12 - fh->d.u8, get16(p+12));
+		if((off = rom_offset(fh, phy)) == CAT_NO_ADR) return 0;
+		cm = catalog_add(cat, fh, CAT_ARRAY, phy, 0, p, &is_new);
+		if(cm && is_new) {
+			cm->x_num      = get16(p+2);
+			cm->cell_adr   = off;
+			cm->cell_width = 2;
+			if(cm->x_num <= 0 || !in_map_area(off, (unsigned long)cm->x_num*2)) {
+				cm->rejected   = "runs past the map area";
+				cm->cell_adr   = CAT_NO_ADR;
+				cm->cell_width = 0;
+			}
+		}
+		return mapfinder_index_needle_len;
+	}
+
+	if(p[0] != 0xE6 || p[1] != 0xFC) return 0;
+
+	// 2D map with its own header near the map segment, the x input in a register
+	if(left >= mapfinder_xy4_needle_len && memcmp_mask(p, mapfinder_xy4_needle, mapfinder_xy4_mask, mapfinder_xy4_needle_len) == 0)
+	{
+		phy = dpp_near(p+2 - fh->d.u8, get16(p+2));
+		if((off = rom_offset(fh, phy)) == CAT_NO_ADR) return 0;
+		cm = catalog_add(cat, fh, CAT_MAP, phy, 0, p, &is_new);
+		if(cm && is_new) {
+			cm->lookup = call_target(p+10);
+			cm->var    = stored_result(fh, p+14);
+			cm->in_y   = get16(p+8);
+			set_map(cm, fh, off);
+		}
+		return mapfinder_xy4_needle_len;
+	}
+
+	// curve with its own page, byte or word input
+	if(left >= mapfinder_needle_len+4 && memcmp_mask(p, mapfinder_needle, mapfinder_mask, mapfinder_needle_len) == 0)
+	{
+		phy = get16(p+6)*SEGMENT_SIZE + get16(p+2);
+		if((off = rom_offset(fh, phy)) == CAT_NO_ADR) return 0;
+		cm = catalog_add(cat, fh, CAT_CURVE, phy, 0, p, &is_new);
+		if(cm && is_new) {
+			cm->lookup = call_target(p+12);
+			cm->var    = stored_result(fh, p+16);
+			cm->in_x   = get16(p+10);
+			set_curve(cm, fh, off, p[8] == 0xC2 ? 1 : 2);
+			check_curve(cm, fh, 1);
+		}
+		return mapfinder_needle_len;
+	}
+
+	// 2D map with its own page, or a group map when r13 is an axis rather than a page
+	if(left >= mapfinder_xy_needle_len && memcmp_mask(p, mapfinder_xy_needle, mapfinder_xy_mask, mapfinder_xy_needle_len) == 0)
+	{
+		unsigned long r12 = get16(p+2), r13 = get16(p+6);
+
+		if(rom_offset(fh, r13*SEGMENT_SIZE) != CAT_NO_ADR && (off = rom_offset(fh, r13*SEGMENT_SIZE + r12)) != CAT_NO_ADR
+			&& stored_result(fh, p+20) != 0 && stored_result(fh, p+20) == get16(p+14)) {
+			// r15 is the previous result, an axis distribution with its own page
+			cm = catalog_add(cat, fh, CAT_AXIS, r13*SEGMENT_SIZE + r12, 0, p, &is_new);
+			if(cm && is_new) {
+				cm->lookup = call_target(p+16);
+				cm->var    = get16(p+14);
+				cm->in_x   = get16(p+10);
+				set_curve(cm, fh, off, p[8] == 0xC2 ? 1 : 2);
+				cm->cell_adr   = CAT_NO_ADR;
+				cm->cell_width = 0;
+				cm->layout     = -1;
+				check_curve(cm, fh, 0);
+			}
+		} else if(rom_offset(fh, r13*SEGMENT_SIZE) != CAT_NO_ADR && (off = rom_offset(fh, r13*SEGMENT_SIZE + r12)) != CAT_NO_ADR) {
+			cm = catalog_add(cat, fh, CAT_MAP, r13*SEGMENT_SIZE + r12, 0, p, &is_new);
+			if(cm && is_new) {
+				cm->lookup = call_target(p+16);
+				cm->var    = stored_result(fh, p+20);
+				cm->in_x   = get16(p+10);
+				cm->in_y   = get16(p+14);
+				set_map(cm, fh, off);
+			}
+		} else {
+			phy = dpp_near(p+2 - fh->d.u8, r12);		// near pointer, paged by the dpps
+			if((off = rom_offset(fh, phy)) == CAT_NO_ADR) return 0;
+			cm = catalog_add(cat, fh, CAT_GROUP, phy, ((unsigned long)get16(p+10) << 16) | get16(p+14), p, &is_new);
+			if(cm && is_new) {
+				cm->lookup   = call_target(p+16);
+				cm->var      = stored_result(fh, p+20);
+				cm->in_x     = get16(p+10);
+				cm->in_y     = get16(p+14);
+				cm->cell_adr = off;
+				cm->cell_width = 1;									// as KFZW_table
+			}
+		}
+		return mapfinder_xy_needle_len;
+	}
+
+	// shared axis distribution in the map segment
+	if(left >= mapfinder_axis_needle_len && memcmp_mask(p, mapfinder_axis_needle, mapfinder_axis_mask, mapfinder_axis_needle_len) == 0) {
+		off = mapfinder_axis_needle_len;
+	} else if(left >= mapfinder_axis2_needle_len && memcmp_mask(p, mapfinder_axis2_needle, mapfinder_axis2_mask, mapfinder_axis2_needle_len) == 0) {
+		off = mapfinder_axis2_needle_len;
+	} else {
+		return 0;
+	}
+	{
+		unsigned long len = off, axis;
+
+		phy  = dpp_near(p+2 - fh->d.u8, get16(p+2));
+		axis = rom_offset(fh, phy);
+		if(axis == CAT_NO_ADR) return 0;
+
+		// r14 isn't the previous result, so it is a second input: a 2D map if its header holds up
+		if(len == mapfinder_axis_needle_len && get16(p+10) != get16(p+18)) {
+			CATALOG_MAP hdr;
+
+			memset(&hdr, 0, sizeof(hdr));
+			set_map(&hdr, fh, axis);
+			if(hdr.x_num > 0) {
+				cm = catalog_add(cat, fh, CAT_MAP, phy, 0, p, &is_new);
+				if(cm && is_new) {
+					cm->lookup = call_target(p+12);
+					cm->var    = get16(p+18);
+					cm->in_x   = get16(p+6);
+					cm->in_y   = get16(p+10);
+					set_map(cm, fh, axis);
+				}
+				return len;
+			}
+		}
+		cm = catalog_add(cat, fh, CAT_AXIS, phy, 0, p, &is_new);
+		if(cm && is_new) {
+			cm->lookup = call_target(p+len-8);
+			cm->var    = get16(p+len-2);
+			cm->in_x   = get16(p+6);
+			set_curve(cm, fh, axis, p[4] == 0xC2 ? 1 : 2);
+			cm->cell_adr   = CAT_NO_ADR;
+			cm->cell_width = 0;
+			cm->layout     = -1;
+			check_curve(cm, fh, 0);
+		}
+		return len;
+	}
+}
+
+// catalog entry holding the axis whose result is stored to var, -1 if there is none
+static int find_axis(MAP_CATALOG *cat, unsigned int var)
+{
+	int i, found = -1;
+
+	if(var == 0) return -1;
+	for(i=0;i<cat->set.num_sites;i++) {
+		CATALOG_MAP *cm = &cat->maps[i];
+		if(cm->var != var || cm->rejected || (cm->kind != CAT_AXIS && cm->kind != CAT_CURVE)) continue;
+		if(cm->kind == CAT_AXIS) return i;
+		if(found < 0) found = i;
+	}
+	return found;
+}
+
+static int cmp_offset(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+	return (x > y) - (x < y);
+}
+
+// first table start above 'after', CAT_NO_ADR if there is none
+static unsigned long next_start(unsigned long *starts, int num, unsigned long after)
+{
+	int lo = 0, hi = num;
+
+	while(lo < hi) {
+		int mid = (lo+hi)/2;
+		if(starts[mid] <= after) lo = mid+1;
+		else hi = mid;
+	}
+	return lo < num ? starts[lo] : CAT_NO_ADR;
+}
+
+/*
+ * Fill in what the call sites leave open: the axes of the group maps, the cell widths (from the gap
+ * up to the next table) and the size of each table
+ */
+static void catalog_resolve(MAP_CATALOG *cat)
+{
+	unsigned long *starts, nx, gap, cells;
+	int i, j, num = 0;
+	CATALOG_MAP *cm, *ax;
+
+	// group maps take their dimensions from the axes distributed into their inputs
+	for(i=0;i<cat->set.num_sites;i++) {
+		cm = &cat->maps[i];
+		if(cm->kind != CAT_GROUP) continue;
+		cm->x_axis = find_axis(cat, cm->in_x);
+		cm->y_axis = find_axis(cat, cm->in_y);
+		if(cm->x_axis < 0 || cm->y_axis < 0) {
+			// without both axes there is nothing to size or decode (the cells still mark a table start)
+			cm->rejected = "axes not found";
+			continue;
+		}
+		cat->maps[cm->x_axis].kind = CAT_AXIS;
+		cat->maps[cm->y_axis].kind = CAT_AXIS;
+		cm->x_num   = cat->maps[cm->x_axis].x_num;
+		cm->y_num   = cat->maps[cm->y_axis].x_num;
+		cm->x_width = cat->maps[cm->x_axis].x_width;
+		cm->y_width = cat->maps[cm->y_axis].x_width;
+	}
+
+	// split curves share their axis with whichever entry has the same header
+	for(i=0;i<cat->set.num_sites;i++) {
+		cm = &cat->maps[i];
+		if(cm->kind != CAT_SPLIT || cm->rejected) continue;
+		for(j=0;j<cat->set.num_sites;j++) {
+			ax = &cat->maps[j];
+			if(j != i && ax->kind != CAT_SPLIT && !ax->rejected && ax->x_num_adr == cm->x_num_adr) {
+				cm->x_axis = j;
+				break;
+			}
+		}
+	}
+
+	// a 2D map whose header didn't make sense has nothing to size or decode
+	for(i=0;i<cat->set.num_sites;i++) {
+		cm = &cat->maps[i];
+		if(cm->kind == CAT_MAP && cm->x_num == 0 && !cm->rejected) cm->rejected = "header not recognised";
+	}
+
+	// table starts, sorted (a rejected call site still points at where some table starts)
+	starts = malloc((size_t)2*(cat->set.num_sites+1)*sizeof(unsigned long));
+	if(starts != 0) {
+		for(i=0;i<cat->set.num_sites;i++) {
+			cm = &cat->maps[i];
+			if(cm->x_num_adr != CAT_NO_ADR) starts[num++] = cm->x_num_adr;
+			if(CAT_CELLS_APART(cm) && cm->cell_adr != CAT_NO_ADR) starts[num++] = cm->cell_adr;
+		}
+		qsort(starts, num, sizeof(unsigned long), cmp_offset);
+	}
+
+	for(i=0;i<cat->set.num_sites;i++) {
+		cm = &cat->maps[i];
+		cm->size = 0;
+		if(cm->rejected) continue;
+		cells = (unsigned long)cm->x_num * (cm->y_num ? cm->y_num : 1);
+
+		// only an exact fit up to the next table changes the cell width the lookup suggests (an array's
+		// index is scaled to words, whatever follows)
+		if(starts != 0 && cm->cell_adr != CAT_NO_ADR && cells != 0 && cm->kind != CAT_ARRAY) {
+			nx = next_start(starts, num, CAT_CELLS_APART(cm) ? cm->cell_adr : cm->cell_adr-1);
+			if(nx != CAT_NO_ADR) {
+				gap = nx - cm->cell_adr;
+				if(gap == 0 && cm->kind == CAT_CURVE) {
+					// nothing after the axis, it is an axis distribution
+					cm->kind       = CAT_AXIS;
+					cm->cell_adr   = CAT_NO_ADR;
+					cm->cell_width = 0;
+					cm->layout     = -1;
+				} else if(gap >= cells && gap < 2*cells) {
+					cm->cell_width = 1;
+				} else if(gap == 2*cells) {
+					cm->cell_width = 2;
+				}
+			}
+		}
+		// a 1D table is decoded with its cells as wide as its axis
+		if(cm->kind == CAT_CURVE && cm->cell_width != cm->x_width) cm->layout = -1;
+
+		if(cm->x_num_adr != CAT_NO_ADR && (cm->kind != CAT_SPLIT || cm->x_axis < 0)) {
+			cm->size += cm->num_width + (unsigned long)cm->x_num*cm->x_width;
+		}
+		if(cm->y_num_adr != CAT_NO_ADR) {
+			cm->size += cm->num_width + (unsigned long)cm->y_num*cm->y_width;
+		}
+		if(cm->cell_adr != CAT_NO_ADR) {
+			cm->size += cells*cm->cell_width;
+		}
+	}
+	free(starts);
+
+	memset(cat->num_kind, 0, sizeof(cat->num_kind));
+	cat->num_rejected = 0;
+	for(i=0;i<cat->set.num_sites;i++) {
+		if(cat->maps[i].rejected) cat->num_rejected++;
+		else cat->num_kind[cat->maps[i].kind]++;
+	}
+}
+
+/*
+ * Match every lookup call site of the rom in one pass and classify the tables found,
+ * returns the number of tables or -1 if out of memory
+ */
+int catalog_build(MAP_CATALOG *cat, ImageHandle *fh)
+{
+	unsigned long i;
+	int n;
+
+	memset(cat, 0, sizeof(MAP_CATALOG));
+	if(map_set_init(&cat->set) != 0) return -1;
+
+	for(i=ROM_MAIN_START; i+8 < fh->len; ) {
+		n = catalog_match(cat, fh, fh->d.u8 + i);
+		i += n ? (n+1) & ~1 : 2;
+	}
+	catalog_resolve(cat);
+	return cat->set.num_sites;
+}
+
+void catalog_free(MAP_CATALOG *cat)
+{
+	map_set_free(&cat->set);
+	free(cat->maps);
+	memset(cat, 0, sizeof(MAP_CATALOG));
+}
+
+/*
+ * Name every catalog entry that one of the named checks has shown (see catalog_note_map).
+ * Checks run in parallel so the known list is in no particular order, when several
+ * tables share an entry (eg. an axis) the alphabetically first name is used.
+ */
+void catalog_match_known(MAP_CATALOG *cat)
+{
+	CATALOG_MAP *cm;
+	KNOWN_MAP *k;
+	int i, j;
+
+	cat->num_known = 0;
+#ifndef NO_THREADS
+	pthread_mutex_lock(&known_lock);
+#endif
+	for(i=0;i<cat->set.num_sites;i++) {
+		cm = &cat->maps[i];
+		cm->known = 0;
+		if(cm->rejected) continue;
+		for(j=0;j<num_known_maps;j++) {
+			k = &known_maps[j];
+			if(cm->known && strcmp(k->name, cm->known) >= 0) continue;
+			if(cm->cell_adr != CAT_NO_ADR && cm->cell_adr == k->cell_adr) {
+				cm->known = k->name;
+			} else if(cm->kind == CAT_AXIS && (cm->x_num_adr == k->x_num_adr || cm->x_num_adr == k->y_num_adr)) {
+				cm->known = k->name;
+			} else if(!CAT_CELLS_APART(cm) && cm->x_num_adr != CAT_NO_ADR && cm->x_num_adr == k->x_num_adr) {
+				cm->known = k->name;
+			}
+		}
+		if(cm->known) cat->num_known++;
+	}
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&known_lock);
+#endif
+}
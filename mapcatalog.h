@@ -0,0 +1,120 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _MAPCATALOG_SUPPORT_H
+#define _MAPCATALOG_SUPPORT_H
+#include "utils.h"
+#include "needles.h"
+#include "show_tables.h"
+
+// The map catalog: every lookup routine call site in the rom is matched in a single pass
+// over the code, classified and turned into one entry per unique table with its layout,
+// dimensions and size. Tables decoded by the named checks are noted as they are shown
+// (catalog_note_map), so the catalog can tell the known maps from the unknown ones.
+
+#define MAP_SET_INITIAL_SLOTS    256		// power of two, doubled whenever the set gets half full
+#define MAX_KNOWN_MAPS           512
+
+#define CAT_CURVE                0			// x_num, x-axis and cells together, 1D table (mapfinder_needle)
+#define CAT_MAP                  1			// x_num, y_num, both axes and cells together (mapfinder_xy2_needle, mapfinder_xy_needle)
+#define CAT_SPLIT                2			// 1D table with its cells apart from a shared axis (mapfinder_xy3_needle)
+#define CAT_GROUP                3			// 2D cells only, both axes are shared and distributed beforehand, e.g. KFZW
+#define CAT_AXIS                 4			// x_num and axis only, the lookup result is an index into a group map (SNM16ZUUB...)
+#define CAT_ARRAY                5			// word cells only, read by a bounds checked index (mapfinder_index_needle), e.g. MLHFM
+#define CAT_KINDS                6
+
+// the cells are a table of their own rather than following an axis, they are where the table starts
+#define CAT_CELLS_APART(cm)      ((cm)->kind == CAT_SPLIT || (cm)->kind == CAT_GROUP || (cm)->kind == CAT_ARRAY)
+
+#define CAT_NO_ADR               ((unsigned long)-1)
+#define CAT_ROM_BASE             0x800000	// physical address of the first byte of the image
+
+// one lookup routine call site referencing a table
+typedef struct MAP_REF {
+	unsigned long  offset;					// rom file offset of the matched lookup code
+	unsigned long  func;					// start of the calling function (see func_start()), FUNC_NONE if unknown
+	int            next;					// next reference to the same table, -1 ends the list
+} MAP_REF;
+
+// one unique table, found through one or more call sites
+typedef struct MAP_SITE {
+	int            type;					// CAT_xxx the site was matched as
+	unsigned long  adr;						// physical address of the table (of the cells for CAT_SPLIT/CAT_GROUP/CAT_ARRAY)
+	unsigned long  adr2;					// CAT_SPLIT: physical address of the axis, CAT_GROUP: the two axis variables
+	unsigned char *code;					// first call site
+	int            first_ref, last_ref;
+	int            num_refs;
+} MAP_SITE;
+
+// open addressing hash set of tables keyed by physical address
+typedef struct MAP_SET {
+	int           *slots;					// index+1 into sites, 0 is an empty slot
+	int            num_slots;
+	MAP_SITE      *sites;
+	int            num_sites, max_sites;
+	MAP_REF       *refs;
+	int            num_refs, max_refs;
+} MAP_SET;
+
+// a classified table, catalog entry i belongs to MAP_SET site i
+typedef struct CATALOG_MAP {
+	int            kind;					// CAT_xxx
+	unsigned long  adr;						// physical address, as MAP_SITE
+	unsigned long  lookup;					// physical address of the lookup routine called
+	unsigned int   in_x, in_y;				// ram words passed as x/y input (axis result variables for CAT_GROUP), 0 if none
+	unsigned int   var;						// ram word the lookup result is stored to, 0 if not stored straight away
+
+	unsigned long  x_num_adr, y_num_adr;	// rom file offsets of each part, CAT_NO_ADR if not part of this table
+	unsigned long  x_axis_adr, y_axis_adr;
+	unsigned long  cell_adr;
+	int            layout;					// MAP_LAYOUT_xxx the parts can be decoded with, -1 if decode_map() can't
+
+	int            x_num, y_num;			// dimensions, y_num is 0 for 1D tables
+	int            num_width;				// byte width of x_num/y_num
+	int            x_width, y_width;		// byte width of the axis values, 0 if not present
+	int            cell_width;				// byte width of the cells, 0 if not present
+	unsigned long  size;					// bytes occupied in rom, shared axes are counted with their CAT_AXIS entry
+	int            x_axis, y_axis;			// CAT_SPLIT/CAT_GROUP: catalog entry of the shared axis, -1 if not found
+
+	const char    *known;					// table name of the named check showing the same table, 0 if unknown
+	const char    *rejected;				// why the header found at the call site can't be a table, 0 if it can
+} CATALOG_MAP;
+
+typedef struct MAP_CATALOG {
+	MAP_SET        set;
+	CATALOG_MAP   *maps;					// set.num_sites entries
+	int            max_maps;
+	int            num_kind[CAT_KINDS];
+	int            num_known;
+	int            num_rejected;
+} MAP_CATALOG;
+
+int  catalog_build(MAP_CATALOG *cat, ImageHandle *fh);
+void catalog_free(MAP_CATALOG *cat);
+void catalog_match_known(MAP_CATALOG *cat);
+const char *catalog_kind_name(int kind);
+
+// tables shown by the named checks, kept per rom until catalog_known_clear()
+void catalog_note_map(MAP_DATA *m);
+void catalog_note_table(const char *name, unsigned long x_num_adr, unsigned long y_num_adr, unsigned long cell_adr);
+void catalog_known_clear(void);
+
+#endif
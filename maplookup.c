@@ -0,0 +1,829 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+#include "maplookup.h"
+#include "datalog.h"
+#include "outbuf.h"
+#include "mapcatalog.h"
+#include "emu_c16x.h"
+
+static MAP_REGISTRY registry;
+static int registry_enabled = 0;
+#ifndef NO_THREADS
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*
+ * Prepare a decoded map for lookups, the raw axes and cells are widened to 32 bits once
+ * so the interpolation never has to care about the table widths again.
+ *
+ * returns 0 on success, -1 if memory couldn't be allocated
+ */
+int map_lookup_init(MAP_LOOKUP *lk, MAP_DATA *m)
+{
+	TABLE_DEF *td = m->td;
+	int i, total = m->x_num + m->y_num + m->cell_num;
+
+	memset(lk, 0, sizeof(MAP_LOOKUP));
+	lk->m      = m;
+	lk->x_num  = m->x_num;
+	lk->y_num  = m->y_num;
+	lk->x_axis = (int32_t *)malloc((total ? total : 1)*sizeof(int32_t));
+	if(lk->x_axis == 0) return -1;
+	lk->y_axis = lk->x_axis + m->x_num;
+	lk->cells  = lk->y_axis + m->y_num;
+
+	for(i=0;i<m->x_num;i++)    lk->x_axis[i] = m->x_raw[i];
+	for(i=0;i<m->y_num;i++)    lk->y_axis[i] = m->y_raw[i];
+	for(i=0;i<m->cell_num;i++) lk->cells[i]  = m->cell_raw[i];
+
+	lk->x_max = (td->x_axis_nwidth == UWORD) ? 0xffff : 0xff;
+	lk->y_max = (td->y_axis_nwidth == UWORD) ? 0xffff : 0xff;
+	lk->frac8      = (m->layout == MAP_LAYOUT_SPLIT);
+	lk->cell_width = (m->y_num == 0) ? td->x_axis_nwidth : td->cell_nwidth;
+	if(td->cell_signed && m->y_num != 0) {
+		// interpolated as the ecu sees them, so e.g. a KFZW of -3 grad KW stays negative
+		for(i=0;i<m->cell_num;i++) lk->cells[i] = (lk->cell_width == UWORD) ? (int16_t)m->cell_raw[i] : (int8_t)m->cell_raw[i];
+	}
+	return 0;
+}
+
+void map_lookup_free(MAP_LOOKUP *lk)
+{
+	free(lk->x_axis);
+	memset(lk, 0, sizeof(MAP_LOOKUP));
+}
+
+/*
+ * Breakpoint search. Finds the axis segment [i0,i1] holding v and how far into it v lies
+ * (dv of da). Inputs off either end of the axis are clamped to the end breakpoint (dv 0).
+ * The previous segment is tried first, only a miss costs a binary search.
+ */
+static inline void axis_pos(const int32_t *a, int n, int32_t v, int *hint, int *i0, int *i1, int32_t *dv, int32_t *da)
+{
+	int lo, hi, mid, i = *hint;
+
+	*dv = 0;
+	*da = 1;
+	if(n < 2 || v <= a[0]) {
+		*i0 = *i1 = 0;
+		return;
+	}
+	if(v >= a[n-1]) {
+		*i0 = *i1 = n-1;
+		return;
+	}
+	if(!(a[i] <= v && v < a[i+1])) {
+		// a[lo] <= v < a[hi] holds throughout
+		for(lo=0, hi=n-1; hi-lo > 1; ) {
+			mid = (lo+hi) >> 1;
+			if(a[mid] <= v) lo = mid;
+			else            hi = mid;
+		}
+		i = lo;
+		*hint = i;
+	}
+	*i0 = i;
+	*i1 = i+1;
+	if(a[i+1] > a[i]) {
+		*dv = v - a[i];
+		*da = a[i+1] - a[i];
+	}
+}
+
+// one interpolation step, truncating toward zero like the C167 signed divide
+static inline int32_t interp(int32_t c0, int32_t c1, int32_t dv, int32_t da)
+{
+	return c0 + (int32_t)(((int64_t)(c1 - c0) * dv) / da);
+}
+
+/*
+ * Position on the axis as the ecu's axis lookup returns it, index i0 in the high byte and the
+ * truncated 8 bit fraction of the segment in the low byte
+ */
+static inline int32_t axis_pos8(const int32_t *a, int n, int32_t v, int *hint, int *i0, int *i1)
+{
+	int32_t dv, da;
+
+	axis_pos(a, n, v, hint, i0, i1, &dv, &da);
+	return (*i0 << 8) | ((dv << 8) / da);
+}
+
+// one group lookup step: the product's high word (MDH) is the step, bytes round down, words toward c0
+static inline int32_t interp8(int32_t c0, int32_t c1, int32_t frac, int width)
+{
+	if(width == UWORD && c1 < c0) return c0 - (((c0 - c1) * frac) >> 8);
+	return c0 + (((c1 - c0) * frac) >> 8);
+}
+
+static inline int32_t lookup_group(MAP_LOOKUP *lk, int32_t x, int32_t y)
+{
+	int x0, x1, y0, y1, w = lk->cell_width;
+	int32_t fx, fy, r0, r1;
+	const int32_t *c = lk->cells;
+
+	fx = axis_pos8(lk->x_axis, lk->x_num, x, &lk->x_hint, &x0, &x1) & 0xff;
+	if(lk->y_num == 0) {
+		return interp8(c[x0], c[x1], fx, w);
+	}
+	fy = axis_pos8(lk->y_axis, lk->y_num, y, &lk->y_hint, &y0, &y1) & 0xff;
+	// y first, the ecu walks the cells in rom order and a rom row is one x column
+	r0 = interp8(c[y0*lk->x_num+x0], c[y1*lk->x_num+x0], fy, w);
+	r1 = interp8(c[y0*lk->x_num+x1], c[y1*lk->x_num+x1], fy, w);
+	return interp8(r0, r1, fx, w);
+}
+
+static inline int32_t lookup_one(MAP_LOOKUP *lk, int32_t x, int32_t y)
+{
+	int x0, x1, y0, y1;
+	int32_t dx, ax, dy, ay, r0, r1;
+	const int32_t *c = lk->cells;
+
+	if(lk->frac8) return lookup_group(lk, x, y);
+	axis_pos(lk->x_axis, lk->x_num, x, &lk->x_hint, &x0, &x1, &dx, &ax);
+	if(lk->y_num == 0) {
+		return interp(c[x0], c[x1], dx, ax);
+	}
+	axis_pos(lk->y_axis, lk->y_num, y, &lk->y_hint, &y0, &y1, &dy, &ay);
+	r0 = interp(c[y0*lk->x_num+x0], c[y0*lk->x_num+x1], dx, ax);
+	r1 = interp(c[y1*lk->x_num+x0], c[y1*lk->x_num+x1], dx, ax);
+	return interp(r0, r1, dy, ay);
+}
+
+/*
+ * Look up a map at raw axis values (y is ignored for 1-axis maps), returns the raw cell value
+ */
+long map_lookup_raw(MAP_LOOKUP *lk, long x, long y)
+{
+	if(lk->x_num == 0) return 0;
+	return lookup_one(lk, (int32_t)x, (int32_t)y);
+}
+
+void map_lookup_batch_raw(MAP_LOOKUP *lk, const int32_t *x, const int32_t *y, int32_t *out, int num)
+{
+	int i;
+
+	if(lk->x_num == 0) {
+		memset(out, 0, num*sizeof(int32_t));
+		return;
+	}
+	if(lk->y_num == 0 || y == 0) {
+		for(i=0;i<num;i++) out[i] = lookup_one(lk, x[i], 0);
+	} else {
+		for(i=0;i<num;i++) out[i] = lookup_one(lk, x[i], y[i]);
+	}
+}
+
+// physical axis value to the nearest raw value the ecu could hold, the inverse of conv_entry_value()
+static inline int32_t phy_to_raw(double v, int otype, ENTRY_DEF *e, int32_t max)
+{
+	double r;
+
+	switch(otype) {
+		case 'd':	r = (v + e->fconv2) * e->fconv;	break;
+		case 'x':	r = (v + e->fconv2) / e->fconv;	break;
+		case '*':	r = v / e->fconv;				break;
+		case '/':
+		default:	r = v * e->fconv;				break;
+	}
+	if(!(r > 0)) return 0;
+	if(r >= max) return max;
+	return (int32_t)(r + 0.5);
+}
+
+/*
+ * Look up a map at physical axis values, returns the physical cell value (NAN if x or y is NAN)
+ */
+double map_lookup(MAP_LOOKUP *lk, double x, double y)
+{
+	double r;
+
+	map_lookup_batch(lk, &x, &y, &r, 1);
+	return r;
+}
+
+/*
+ * Look up num operating points given in physical units, out[i] is NAN where x[i] (or y[i]) is.
+ * Work is done LOOKUP_CHUNK points at a time: quantise, look up raw, convert.
+ */
+void map_lookup_batch(MAP_LOOKUP *lk, const double *x, const double *y, double *out, int num)
+{
+	TABLE_DEF *td = lk->m->td;
+	int32_t xr[LOOKUP_CHUNK], yr[LOOKUP_CHUNK], r[LOOKUP_CHUNK];
+	int i, n, base, two_axis = (lk->y_num != 0 && y != 0);
+
+	for(base=0; base < num; base += n) {
+		n = num - base;
+		if(n > LOOKUP_CHUNK) n = LOOKUP_CHUNK;
+
+		for(i=0;i<n;i++) xr[i] = phy_to_raw(x[base+i], td->x_axis.otype, &td->x_axis, lk->x_max);
+		if(two_axis) {
+			// the y-axis is always converted as raw/conv (see DEFINE_MAP_DECODER)
+			for(i=0;i<n;i++) yr[i] = phy_to_raw(y[base+i], '/', &td->y_axis, lk->y_max);
+		}
+		map_lookup_batch_raw(lk, xr, two_axis ? yr : 0, r, n);
+
+		for(i=0;i<n;i++) {
+			if(isnan(x[base+i]) || (two_axis && isnan(y[base+i]))) {
+				out[base+i] = NAN;
+			} else {
+				out[base+i] = conv_entry_value(&td->cell, (double)r[i]);
+			}
+		}
+	}
+}
+
+void map_registry_enable(void)
+{
+	registry_enabled = 1;
+}
+
+/*
+ * Keep a decoded map for evaluation, called by the checks from whichever thread they run on.
+ *
+ * returns 1 if the registry took the map (the caller must not free_map() it), 0 otherwise
+ */
+int map_registry_add(MAP_DATA *m)
+{
+	MAP_DATA *copy;
+	int kept = 0;
+
+	if(registry_enabled == 0) return 0;
+	copy = (MAP_DATA *)malloc(sizeof(MAP_DATA));
+	if(copy == 0) return 0;
+	*copy = *m;
+
+#ifndef NO_THREADS
+	pthread_mutex_lock(&registry_lock);
+#endif
+	if(registry.num < MAX_REGISTERED_MAPS) {
+		registry.maps[registry.num++] = copy;
+		kept = 1;
+	}
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&registry_lock);
+#endif
+	if(kept == 0) free(copy);
+	return kept;
+}
+
+/*
+ * Keep a table stored as a bare array of num values over an implicit equidistant axis
+ * (e.g. MLHFM), breakpoint i lies at i*x_step in the x-axis' raw units.
+ *
+ * returns 1 if it was kept
+ */
+int map_registry_add_curve(TABLE_DEF *td, const unsigned char *data, int num, int nwidth, int x_step, unsigned long adr)
+{
+	MAP_DATA m;
+	int i;
+
+	if(registry_enabled == 0 || num <= 0) return 0;
+	memset(&m, 0, sizeof(m));
+	m.td         = td;
+	m.layout     = MAP_LAYOUT_HEADER;
+	m.cell_adr   = adr;
+	m.x_num      = num;
+	m.cell_num   = num;
+
+	// same single allocation as decode_map() so free_map() releases it
+	m.x_phy = (double *)malloc((size_t)2*num*(sizeof(double)+sizeof(uint16_t)));
+	if(m.x_phy == 0) return 0;
+	m.y_phy    = m.x_phy + num;
+	m.cell_phy = m.y_phy;
+	m.x_raw    = (uint16_t *)(m.cell_phy + num);
+	m.y_raw    = m.x_raw + num;
+	m.cell_raw = m.y_raw;
+
+	for(i=0;i<num;i++) {
+		m.x_raw[i]    = (uint16_t)(i*x_step);
+		m.cell_raw[i] = (uint16_t)get_nwidth((unsigned char *)data + i*nwidth, nwidth);
+		m.x_phy[i]    = conv_entry_value(&td->x_axis, m.x_raw[i]);
+		m.cell_phy[i] = conv_entry_value(&td->cell, m.cell_raw[i]);
+	}
+	if(map_registry_add(&m) == 0) {
+		free_map(&m);
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Keep a single converted value, e.g. KRKTE
+ */
+int map_registry_add_value(const char *name, double value)
+{
+	int kept = 0;
+
+	if(registry_enabled == 0) return 0;
+#ifndef NO_THREADS
+	pthread_mutex_lock(&registry_lock);
+#endif
+	if(registry.num_values < MAX_REGISTERED_VALUES) {
+		registry.value_names[registry.num_values] = strdup(name);
+		registry.values[registry.num_values++]    = value;
+		kept = 1;
+	}
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&registry_lock);
+#endif
+	return kept;
+}
+
+/*
+ * Move everything kept so far into 'r' (which the caller frees), so another rom can be searched
+ */
+void map_registry_take(MAP_REGISTRY *r)
+{
+	*r = registry;
+	memset(&registry, 0, sizeof(registry));
+}
+
+/*
+ * Find a kept map by table name, r of 0 searches the maps kept so far. Checks run in
+ * parallel so the order maps are added in varies, "NAME#n" therefore counts tables of
+ * the same name by rom address.
+ */
+MAP_DATA *map_registry_find(MAP_REGISTRY *r, const char *name)
+{
+	char base[32];
+	const char *hash = strchr(name, '#');
+	int i, j, nth = 1, len, below;
+
+	if(r == 0) r = &registry;
+	len = hash ? (int)(hash - name) : (int)strlen(name);
+	if(len >= (int)sizeof(base)) return 0;
+	memcpy(base, name, len);
+	base[len] = 0;
+	if(hash) nth = atoi(hash+1);
+
+	for(i=0;i<r->num;i++) {
+		if(strcmp(r->maps[i]->td->table_name, base) != 0) continue;
+		for(j=0, below=0; j<r->num; j++) {
+			if(strcmp(r->maps[j]->td->table_name, base) == 0 && r->maps[j]->cell_adr < r->maps[i]->cell_adr) below++;
+		}
+		if(below == nth-1) return r->maps[i];
+	}
+	return 0;
+}
+
+/*
+ * returns 1 and sets *value if a value of that name was kept, 0 otherwise
+ */
+int map_registry_value(MAP_REGISTRY *r, const char *name, double *value)
+{
+	int i;
+
+	if(r == 0) r = &registry;
+	for(i=0;i<r->num_values;i++) {
+		if(strcmp(r->value_names[i], name) == 0) {
+			*value = r->values[i];
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void map_registry_free(MAP_REGISTRY *r)
+{
+	int i;
+
+	if(r == 0) r = &registry;
+	for(i=0;i<r->num;i++) {
+		free_map(r->maps[i]);
+		free(r->maps[i]);
+	}
+	for(i=0;i<r->num_values;i++) free(r->value_names[i]);
+	memset(r, 0, sizeof(MAP_REGISTRY));
+}
+
+// copy at most max-1 chars of s up to any of the stop chars, returns a pointer to the stop char
+static const char *copy_token(char *dst, int max, const char *s, const char *stop)
+{
+	int n = 0;
+
+	for(; *s && strchr(stop, *s) == 0; s++) {
+		if(n < max-1) dst[n++] = *s;
+	}
+	dst[n] = 0;
+	return s;
+}
+
+/*
+ * Parse a -evalmap list, e.g. "KFZW=nmot:rl,LAMFA=nmot:rl,MLHFM=uhfm"
+ *
+ * returns the number of maps, -1 on a syntax error
+ */
+int map_eval_parse(const char *spec, EVAL_MAP *maps, int max)
+{
+	const char *s = spec;
+	int num = 0;
+
+	if(spec == 0) return 0;
+	while(*s && num < max) {
+		memset(&maps[num], 0, sizeof(EVAL_MAP));
+		s = copy_token(maps[num].name, sizeof(maps[num].name), s, "=,");
+		if(*s != '=' || maps[num].name[0] == 0) {
+			printf("-evalmap expects NAME=xcolumn[:ycolumn], got '%s'\n", spec);
+			return -1;
+		}
+		s = copy_token(maps[num].x_col, sizeof(maps[num].x_col), s+1, ":,");
+		if(*s == ':') s = copy_token(maps[num].y_col, sizeof(maps[num].y_col), s+1, ",");
+		if(*s == ',') s++;
+		num++;
+	}
+	return num;
+}
+
+/*
+ * Evaluate the requested maps at every row of a csv datalog and write a csv with one
+ * column per map. The log is streamed DATALOG_BLOCK_ROWS rows at a time, columns are
+ * read once however many maps use them.
+ *
+ * returns 0 on success, -1 on error
+ */
+int map_eval_datalog(const char *logfile, EVAL_MAP *maps, int num, const char *outfile)
+{
+	DATALOG *dl;
+	MAP_LOOKUP lk[MAX_EVAL_MAPS];
+	int   cols[2*MAX_EVAL_MAPS], xs[MAX_EVAL_MAPS], ys[MAX_EVAL_MAPS], use[MAX_EVAL_MAPS];
+	double *in[2*MAX_EVAL_MAPS], *res[MAX_EVAL_MAPS];
+	double *mem;
+	OUTBUF ob;
+	clock_t start = clock();
+	int i, k, c, rows, ncols = 0, nmaps = 0, result = -1;
+
+	dl = datalog_open(logfile);
+	if(dl == 0) return -1;
+
+	for(i=0;i<num;i++) {
+		MAP_DATA *m = map_registry_find(0, maps[i].name);
+		int x, y = -1;
+
+		use[i] = 0;
+		if(m == 0) {
+			printf("%s was not found in the rom, it is not evaluated\n", maps[i].name);
+			continue;
+		}
+		x = datalog_column(dl, maps[i].x_col);
+		if(m->y_num != 0) y = datalog_column(dl, maps[i].y_col);
+		if(x < 0 || (m->y_num != 0 && y < 0)) {
+			printf("%s: datalog has no column '%s', it is not evaluated\n", maps[i].name, x < 0 ? maps[i].x_col : maps[i].y_col);
+			continue;
+		}
+		if(map_lookup_init(&lk[i], m) != 0) continue;
+
+		// share columns between maps
+		for(c=0; c<ncols && cols[c] != x; c++);
+		if(c == ncols) cols[ncols++] = x;
+		xs[i] = c;
+		ys[i] = -1;
+		if(y >= 0) {
+			for(c=0; c<ncols && cols[c] != y; c++);
+			if(c == ncols) cols[ncols++] = y;
+			ys[i] = c;
+		}
+		use[i] = 1;
+		nmaps++;
+	}
+	if(nmaps == 0) {
+		printf("Nothing to evaluate.\n");
+		datalog_close(dl);
+		return -1;
+	}
+
+	mem = (double *)malloc((size_t)(ncols + num) * DATALOG_BLOCK_ROWS * sizeof(double));
+	if(mem == 0) goto done;
+	for(c=0;c<ncols;c++) in[c]  = mem + (size_t)c*DATALOG_BLOCK_ROWS;
+	for(i=0;i<num;i++)   res[i] = mem + (size_t)(ncols+i)*DATALOG_BLOCK_ROWS;
+
+	memset(&ob, 0, sizeof(ob));
+	ob.fp = stdout;
+	if(strcmp(outfile, "-") != 0) {
+		ob.fp = fopen(outfile, "wb");
+		if(ob.fp == 0) {
+			printf("Failed to create '%s'\n", outfile);
+			free(mem);
+			goto done;
+		}
+	}
+
+	ob_puts(&ob, "row");
+	for(i=0;i<num;i++) {
+		if(use[i] == 0) continue;
+		ob_putc(&ob, ',');
+		ob_puts(&ob, maps[i].name);
+	}
+	ob_putc(&ob, '\n');
+
+	while((rows = datalog_read(dl, cols, ncols, in, DATALOG_BLOCK_ROWS)) > 0) {
+		for(i=0;i<num;i++) {
+			if(use[i] == 0) continue;
+			map_lookup_batch(&lk[i], in[xs[i]], ys[i] >= 0 ? in[ys[i]] : 0, res[i], rows);
+		}
+		for(k=0;k<rows;k++) {
+			ob_fmt_int(&ob, "%ld", (long)(dl->rows - rows + k + 1));
+			for(i=0;i<num;i++) {
+				if(use[i] == 0) continue;
+				ob_putc(&ob, ',');
+				if(!isnan(res[i][k])) ob_fmt_double(&ob, "%.3f", res[i][k]);
+			}
+			ob_putc(&ob, '\n');
+		}
+		ob_flush(&ob);
+	}
+	ob_flush(&ob);
+	free(ob.data);
+	if(ob.fp != stdout) fclose(ob.fp);
+	free(mem);
+
+	printf("Evaluated %lu datalog rows against %d map(s) in %.3f seconds, output '%s'\n",
+		dl->rows, nmaps, (double)(clock() - start)/CLOCKS_PER_SEC, outfile);
+	result = 0;
+
+done:
+	for(i=0;i<num;i++) {
+		if(use[i]) map_lookup_free(&lk[i]);
+	}
+	datalog_close(dl);
+	return result;
+}
+
+/*
+ * How a lookup routine treats the table: whether it sign extends (movbs) or compares (jmpr
+ * cc_SGT..cc_SGE) the values signed, and for a group lookup the width of the cells it reads
+ * through r12, byte (movb ..,[r12]) or word (mov ..,[r12]), 0 if none.
+ *
+ * returns 1 if the values are signed, else 0
+ */
+static int lookup_reads(ImageHandle *fh, unsigned long lookup, int *width)
+{
+	unsigned long off = (lookup >= CAT_ROM_BASE) ? lookup - CAT_ROM_BASE : lookup;
+	DIS_INST di;
+	int i, cc, is_signed = 0;
+
+	*width = 0;
+	for(i=0; i < 64 && off < fh->len; i++, off += di.len) {
+		if(c167x_decode(fh->d.u8 + off, fh->len - off, off, &di) == 0 || (di.flags & (DIS_INVALID | DIS_RET))) break;
+		if(*width == 0 && (di.raw[0] == 0xA8 || di.raw[0] == 0xA9) && (di.raw[1] & 0x0F) == 12) {
+			*width = (di.raw[0] == 0xA9) ? UBYTE : UWORD;
+		}
+		cc = di.raw[0] >> 4;
+		if(di.raw[0] == 0xD0 || ((di.raw[0] & 0x0F) == 0x0D && cc >= CC_SGT && cc <= CC_SGE)) is_signed = 1;
+	}
+	return is_signed;
+}
+
+static inline int32_t sext(int32_t v, int width, int is_signed)
+{
+	if(is_signed == 0) return v;
+	return (width == UWORD) ? (int16_t)v : (int8_t)v;
+}
+
+/*
+ * r12-r15 as the call site sets them up for its lookup routine: args gets the immediates, vars the
+ * ram word loaded into the register (0 if none).
+ *
+ * returns 0, -1 if the call isn't reached within a few instructions
+ */
+static int site_args(ImageHandle *fh, unsigned char *code, unsigned short *args, unsigned int *vars)
+{
+	unsigned long off = code - fh->d.u8;
+	DIS_INST di;
+	int i, n;
+
+	memset(args, 0, EMU_MAX_ARGS*sizeof(unsigned short));
+	memset(vars, 0, EMU_MAX_ARGS*sizeof(unsigned int));
+	for(i=0; i < 16 && off < fh->len; i++, off += di.len) {
+		if(c167x_decode(fh->d.u8 + off, fh->len - off, off, &di) == 0 || (di.flags & DIS_INVALID)) break;
+		if(di.flags & DIS_CALL) return 0;
+		n = (di.raw[1] & 0x0F) - EMU_ARG_FIRST;
+		if(n < 0) continue;
+		switch(di.raw[0]) {
+			case 0xE0:											// mov Rn,#data4
+				args[n] = di.raw[1] >> 4;
+				vars[n] = 0;
+				break;
+			case 0xE6:											// mov Rn,#data16
+				if((di.raw[1] & 0xF0) != 0xF0) break;
+				args[n] = di.raw[2] | (di.raw[3] << 8);
+				vars[n] = 0;
+				break;
+			case 0xF2: case 0xC2: case 0xD2:					// mov/movbz/movbs Rn,mem
+				if((di.raw[1] & 0xF0) != 0xF0) break;
+				args[n] = 0;
+				vars[n] = di.raw[2] | (di.raw[3] << 8);
+				break;
+		}
+	}
+	return -1;
+}
+
+// argument register loaded from var, -1 if there is none
+static int site_input(const unsigned int *vars, unsigned int var)
+{
+	int i;
+
+	for(i=0;i<EMU_MAX_ARGS;i++) {
+		if(var != 0 && vars[i] == var) return i;
+	}
+	return -1;
+}
+
+/*
+ * Inputs to try on an axis: every byte value, or for word axes each breakpoint, its neighbours
+ * and 7 points inside every segment
+ */
+static int axis_inputs(const int32_t *a, int n, int width, int is_signed, int32_t *in)
+{
+	int32_t lo = is_signed ? -0x8000 : 0, hi = is_signed ? 0x7fff : 0xffff;
+	int i, k, num = 0;
+
+	if(width != UWORD) {
+		for(i=0;i<=0xff;i++) in[num++] = sext(i, UBYTE, is_signed);
+		return num;
+	}
+	in[num++] = lo;
+	in[num++] = hi;
+	for(i=0;i<n;i++) {
+		if(a[i] > lo) in[num++] = a[i]-1;
+		in[num++] = a[i];
+		if(a[i] < hi) in[num++] = a[i]+1;
+		for(k=1; k < 8 && i+1 < n; k++) in[num++] = a[i] + (a[i+1]-a[i])*k/8;
+	}
+	return num;
+}
+
+#define AXIS_INPUTS(n)	((n)*10+2 > 256 ? (n)*10+2 : 256)
+
+/*
+ * Run one group map of the catalog through the rom's own axis and group lookup routines for a grid
+ * of inputs and count the results map_lookup_raw() gets wrong
+ *
+ * returns 0 if it was checked, -1 with *why set if it couldn't be
+ */
+static int check_group(ImageHandle *fh, EMU *e, MAP_CATALOG *cat, CATALOG_MAP *cm, const char **why)
+{
+	CATALOG_MAP *ax = &cat->maps[cm->x_axis], *ay = &cat->maps[cm->y_axis];
+	unsigned short args[EMU_MAX_ARGS], xargs[EMU_MAX_ARGS], yargs[EMU_MAX_ARGS], *px, *py;
+	unsigned int vars[EMU_MAX_ARGS], xvars[EMU_MAX_ARGS], yvars[EMU_MAX_ARGS];
+	int32_t *xin, *yin, got, want;
+	int i, j, w, xw, yw, sgn, xs, ys, gx, gy, ix, iy, nx, ny, x0, x1, res = EMU_OK;
+	long bad_pos = 0, bad = 0, first[6] = { 0 };
+	MAP_LOOKUP lk;
+	int32_t *mem;
+
+	*why = 0;
+	sgn = lookup_reads(fh, cm->lookup, &w);
+	xs  = lookup_reads(fh, ax->lookup, &xw);
+	ys  = lookup_reads(fh, ay->lookup, &yw);
+	if(w == 0)                                                     *why = "lookup routine doesn't read cells through r12";
+	else if(site_args(fh, cat->set.sites[cm - cat->maps].code, args, vars) != 0
+		|| site_args(fh, cat->set.sites[cm->x_axis].code, xargs, xvars) != 0
+		|| site_args(fh, cat->set.sites[cm->y_axis].code, yargs, yvars) != 0) *why = "call site not decoded";
+	else if((gx = site_input(vars, cm->in_x)) < 0 || (gy = site_input(vars, cm->in_y)) < 0
+		|| (ix = site_input(xvars, ax->in_x)) < 0 || (iy = site_input(yvars, ay->in_x)) < 0) *why = "inputs not found at the call sites";
+	else if(ax->x_axis_adr + (unsigned long)ax->x_num*ax->x_width > fh->len || ay->x_axis_adr + (unsigned long)ay->x_num*ay->x_width > fh->len
+		|| cm->cell_adr + (unsigned long)ax->x_num*ay->x_num*w > fh->len) *why = "table outside the image";
+	if(*why) return -1;
+
+	// the model of the table, x is the slow axis (r14) and y the row the cells run along (r15)
+	memset(&lk, 0, sizeof(lk));
+	lk.x_num      = ax->x_num;
+	lk.y_num      = ay->x_num;
+	lk.frac8      = 1;
+	lk.cell_width = w;
+	nx  = AXIS_INPUTS(lk.x_num);
+	ny  = AXIS_INPUTS(lk.y_num);
+	mem = (int32_t *)malloc((lk.x_num + lk.y_num + lk.x_num*lk.y_num + nx + ny)*sizeof(int32_t) + (nx + ny)*sizeof(unsigned short));
+	if(mem == 0) {
+		*why = "out of memory";
+		return -1;
+	}
+	lk.x_axis = mem;
+	lk.y_axis = lk.x_axis + lk.x_num;
+	lk.cells  = lk.y_axis + lk.y_num;
+	xin       = lk.cells + lk.x_num*lk.y_num;
+	yin       = xin + nx;
+	px        = (unsigned short *)(yin + ny);
+	py        = px + nx;
+	for(i=0;i<lk.x_num;i++) lk.x_axis[i] = sext(get_nwidth(fh->d.u8 + ax->x_axis_adr + i*ax->x_width, ax->x_width), ax->x_width, xs);
+	for(i=0;i<lk.y_num;i++) lk.y_axis[i] = sext(get_nwidth(fh->d.u8 + ay->x_axis_adr + i*ay->x_width, ay->x_width), ay->x_width, ys);
+	for(i=0;i<lk.x_num;i++) {
+		for(j=0;j<lk.y_num;j++) {
+			lk.cells[j*lk.x_num + i] = sext(get_nwidth(fh->d.u8 + cm->cell_adr + (i*lk.y_num + j)*w, w), w, sgn);
+		}
+	}
+	nx = axis_inputs(lk.x_axis, lk.x_num, ax->x_width, xs, xin);
+	ny = axis_inputs(lk.y_axis, lk.y_num, ay->x_width, ys, yin);
+
+	// positions from the rom's axis lookups, a signed input is passed as the raw byte/word
+	for(i=0; i < nx && res == EMU_OK; i++) {
+		xargs[ix] = xin[i] & (ax->x_width == UWORD ? 0xffff : 0xff);
+		res   = emu_call(e, ax->lookup, xargs, EMU_MAX_ARGS);
+		px[i] = emu_reg(e, 4);
+		if(px[i] != axis_pos8(lk.x_axis, lk.x_num, xin[i], &lk.x_hint, &x0, &x1)) bad_pos++;
+	}
+	for(i=0; i < ny && res == EMU_OK; i++) {
+		yargs[iy] = yin[i] & (ay->x_width == UWORD ? 0xffff : 0xff);
+		res   = emu_call(e, ay->lookup, yargs, EMU_MAX_ARGS);
+		py[i] = emu_reg(e, 4);
+		if(py[i] != axis_pos8(lk.y_axis, lk.y_num, yin[i], &lk.y_hint, &x0, &x1)) bad_pos++;
+	}
+
+	// and the cells at every pair of them
+	for(i=0; i < nx && res == EMU_OK; i++) {
+		for(j=0; j < ny && res == EMU_OK; j++) {
+			args[gx] = px[i];
+			args[gy] = py[j];
+			res  = emu_call(e, cm->lookup, args, EMU_MAX_ARGS);
+			got  = emu_reg(e, 4);
+			want = lookup_one(&lk, xin[i], yin[j]) & 0xffff;
+			if(got != want && bad++ == 0) {
+				first[0] = xin[i]; first[1] = yin[j]; first[2] = px[i]; first[3] = py[j]; first[4] = got; first[5] = want;
+			}
+		}
+	}
+
+	con_printf("  group phy:0x%lx %dx%-3d %s %s cells lookup:0x%lx axes:0x%lx%s,0x%lx%s  %d positions %ld wrong, %d values %ld wrong  %s\n",
+		cm->adr, lk.x_num, lk.y_num, sgn ? "signed" : "unsigned", w == UWORD ? "word" : "byte", cm->lookup,
+		ax->lookup, xs ? "(signed)" : "", ay->lookup, ys ? "(signed)" : "",
+		nx + ny, bad_pos, nx*ny, bad, cm->known ? cm->known : "");
+	if(res != EMU_OK) {
+		con_printf("    emulation stopped: %s at 0x%lx\n", emu_result_name(res), e->stop);
+	}
+	if(bad) {
+		con_printf("    first: x=%ld y=%ld r14=0x%04lx r15=0x%04lx rom 0x%04lx model 0x%04lx\n",
+			first[0], first[1], first[2], first[3], first[4], first[5]);
+	}
+	free(mem);
+	return (res != EMU_OK || bad || bad_pos) ? 1 : 0;
+}
+
+/*
+ * -lookupcheck: compare the lookup model (see maplookup.h) with the rom's own axis and group
+ * lookup routines, run in the emulator, for every group map of the map catalog
+ */
+int check_lookup(ImageHandle *fh, int show)
+{
+	MAP_CATALOG cat;
+	CATALOG_MAP *cm;
+	const char *why;
+	int i, r, checked = 0, differ = 0, skipped = 0;
+	EMU *e;
+
+	if(show == 0) return 0;
+
+	con_printf("\n-[ Lookup Check ]------------------------------------------------------------------------------------------\n\n");
+	con_printf(">>> Running the group maps through the rom's lookup routines [emulated] \n\n");
+
+	if(catalog_build(&cat, fh) < 0 || (e = emu_create(fh)) == 0) {
+		con_printf("failed to allocate map catalog or emulator\n");
+		catalog_free(&cat);
+		return -1;
+	}
+	catalog_match_known(&cat);
+
+	for(i=0;i<cat.set.num_sites;i++) {
+		cm = &cat.maps[i];
+		if(cm->kind != CAT_GROUP || cm->rejected) continue;
+		r = check_group(fh, e, &cat, cm, &why);
+		if(r < 0) {
+			con_printf("  group phy:0x%lx lookup:0x%lx skipped, %s\n", cm->adr, cm->lookup, why);
+			skipped++;
+			continue;
+		}
+		checked++;
+		if(r > 0) differ++;
+	}
+	con_printf("\n%d group maps checked, %d of them differ from the rom, %d skipped\n", checked, differ, skipped);
+
+	emu_free(e);
+	catalog_free(&cat);
+	return differ ? -1 : 0;
+}
@@ -0,0 +1,97 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _MAPLOOKUP_SUPPORT_H
+#define _MAPLOOKUP_SUPPORT_H
+#include "utils.h"
+#include "show_tables.h"
+
+// Evaluation of decoded maps at arbitrary operating points (-eval).
+//
+// Lookups use the integer arithmetic of the ECU's own map lookup: the input is
+// quantised to the axis' raw units, inputs outside the axis are clamped to the
+// first/last breakpoint, and each interpolation step is c0 + (c1-c0)*(x-x0)/(x1-x0)
+// with the division truncating toward zero (C167 DIV). A 2-axis map interpolates
+// its two neighbouring rows along x first, then between those along y.
+//
+// Tables with shared axes (MAP_LAYOUT_SPLIT, e.g. KFZW) are read by the ECU's group
+// lookup instead: each axis is first turned into an 8.8 position, index in the high
+// byte and frac = ((x-x0)<<8)/(x1-x0) truncated in the low byte, then the cells are
+// interpolated along y (the neighbouring cells in rom) first, then along x:
+//   byte cells  c0 + ((c1-c0)*frac >> 8)          rounded down (signed MUL, MDH)
+//   word cells  c0 +/- ((|c1-c0|*frac) >> 8)      rounded toward c0 (MULU, MDH)
+// check_lookup() (-lookupcheck) compares this with the rom's own routines.
+
+#define MAX_EVAL_MAPS			32
+#define MAX_REGISTERED_MAPS		128
+#define MAX_REGISTERED_VALUES	32
+#define LOOKUP_CHUNK			1024
+
+typedef struct MAP_LOOKUP {
+	MAP_DATA *m;
+	int       x_num, y_num;		// y_num is 0 for a 1-axis map
+	int32_t  *x_axis;			// raw breakpoints
+	int32_t  *y_axis;
+	int32_t  *cells;			// raw cells, row by row
+	int32_t   x_max, y_max;		// largest raw input the axis width can hold
+	int       x_hint, y_hint;	// segment of the previous lookup, datalogs rarely jump far
+	int       frac8;			// group lookup arithmetic (see above), set for MAP_LAYOUT_SPLIT
+	int       cell_width;		// byte width of the cells, the group lookups round words differently
+} MAP_LOOKUP;
+
+// one map requested with -evalmap NAME=xcol[:ycol]
+typedef struct EVAL_MAP {
+	char name[32];				// table name, "NAME#2" picks the 2nd table of that name (by address)
+	char x_col[64];
+	char y_col[64];
+} EVAL_MAP;
+
+int    map_lookup_init(MAP_LOOKUP *lk, MAP_DATA *m);
+void   map_lookup_free(MAP_LOOKUP *lk);
+long   map_lookup_raw(MAP_LOOKUP *lk, long x, long y);
+double map_lookup(MAP_LOOKUP *lk, double x, double y);
+void   map_lookup_batch_raw(MAP_LOOKUP *lk, const int32_t *x, const int32_t *y, int32_t *out, int num);
+void   map_lookup_batch(MAP_LOOKUP *lk, const double *x, const double *y, double *out, int num);
+
+// tables (and single values) found by the checks, kept once enabled instead of being freed
+typedef struct MAP_REGISTRY {
+	MAP_DATA *maps[MAX_REGISTERED_MAPS];
+	int       num;
+	char     *value_names[MAX_REGISTERED_VALUES];
+	double    values[MAX_REGISTERED_VALUES];
+	int       num_values;
+} MAP_REGISTRY;
+
+void   map_registry_enable(void);
+int    map_registry_add(MAP_DATA *m);
+int    map_registry_add_curve(TABLE_DEF *td, const unsigned char *data, int num, int nwidth, int x_step, unsigned long adr);
+int    map_registry_add_value(const char *name, double value);
+void   map_registry_take(MAP_REGISTRY *r);
+MAP_DATA *map_registry_find(MAP_REGISTRY *r, const char *name);
+int    map_registry_value(MAP_REGISTRY *r, const char *name, double *value);
+void   map_registry_free(MAP_REGISTRY *r);
+
+int    map_eval_parse(const char *spec, EVAL_MAP *maps, int max);
+int    map_eval_datalog(const char *logfile, EVAL_MAP *maps, int num, const char *outfile);
+
+int    check_lookup(ImageHandle *fh, int show);
+
+#endif
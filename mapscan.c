@@ -0,0 +1,398 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include <time.h>
+#include "mapscan.h"
+
+//-[ Map Area Scanner ] ----------------------------------------------------------------------------------------------------
+
+/*
+ * Not every map is looked up straight from the code, some are only reached through pointer tables and no
+ * needle will ever find them. Their headers still look the same though, so this slides over the map area
+ * and tries every offset as the start of a table:
+ *
+ *   x_num, x-axis, cells                     (1D, byte or word header)
+ *   x_num, y_num, x-axis, y-axis, cells      (2D, byte header with byte/word axes, or word header)
+ *   x_num, x-axis, y_num, y-axis, cells      (2D, word header)
+ *
+ * An axis must be strictly increasing (read as unsigned or as signed). Rather than walking each axis, the
+ * area is compared with itself shifted by one value first; those loops only look at neighbouring pairs so the
+ * compiler vectorises them (-O3, no intrinsics so the ARM/Android builds get the same). The run lengths of
+ * rising steps then answer "is this axis monotonic" for any start and length with one lookup.
+ *
+ * Overlapping candidates are settled by confidence, the map catalog's tables serve as anchors: a candidate
+ * ending exactly where a catalogued table starts is packed like the real ones are.
+ */
+
+typedef struct SCAN_AREA {
+	const unsigned char *a;					// the map area
+	unsigned long  base;					// its rom file offset
+	int            len;
+	unsigned char *run8, *srun8;			// rising byte steps starting at each offset (unsigned, signed)
+	unsigned char *run16, *srun16;			// rising word steps starting at each even offset (index offset/2)
+	int           *cat_at;					// catalog entry+1 whose table starts at each offset, 0 if none
+	MAP_CATALOG   *cat;
+	void          *mem;
+} SCAN_AREA;
+
+static void free_scan_area(SCAN_AREA *sa)
+{
+	free(sa->mem);
+	memset(sa, 0, sizeof(SCAN_AREA));
+}
+
+// run lengths back to front, capped so they fit a byte
+static void rising_runs(const unsigned char *up, unsigned char *run, int num)
+{
+	int i;
+
+	if(num <= 0) return;
+	run[num-1] = 0;
+	for(i=num-2;i>=0;i--) {
+		run[i] = up[i] ? (run[i+1] < 254 ? run[i+1]+1 : 255) : 0;
+	}
+}
+
+static int init_scan_area(SCAN_AREA *sa, ImageHandle *fh, MAP_CATALOG *cat)
+{
+	unsigned char *up, *sup;
+	uint16_t *w;
+	int i, nw, len;
+	unsigned long off;
+
+	memset(sa, 0, sizeof(SCAN_AREA));
+	if(fh->len <= MAP_AREA_START) return -1;
+	len = (fh->len - MAP_AREA_START < MAP_AREA_SIZE) ? (int)(fh->len - MAP_AREA_START) : MAP_AREA_SIZE;
+	nw  = len/2;
+
+	// one allocation: 4 run arrays + 2 step arrays, the words and the catalog starts
+	sa->mem = calloc(1, (size_t)len*6 + (size_t)nw*sizeof(uint16_t) + (size_t)len*sizeof(int));
+	if(sa->mem == 0) return -1;
+	sa->a      = fh->d.u8 + MAP_AREA_START;
+	sa->base   = MAP_AREA_START;
+	sa->len    = len;
+	sa->run8   = (unsigned char *)sa->mem;
+	sa->srun8  = sa->run8  + len;
+	sa->run16  = sa->srun8 + len;
+	sa->srun16 = sa->run16 + nw;
+	up         = sa->srun16 + nw;
+	sup        = up + len;
+	w          = (uint16_t *)(sup + len);
+	sa->cat_at = (int *)(w + nw);
+	sa->cat    = cat;
+
+	// each step only compares a value with its neighbour, these loops vectorise
+	for(i=0;i<len-1;i++) {
+		up[i]  = sa->a[i+1] > sa->a[i];
+		sup[i] = (signed char)sa->a[i+1] > (signed char)sa->a[i];
+	}
+	rising_runs(up,  sa->run8,  len);
+	rising_runs(sup, sa->srun8, len);
+
+	for(i=0;i<nw;i++) {
+		w[i] = (uint16_t)(sa->a[2*i] | (sa->a[2*i+1] << 8));
+	}
+	for(i=0;i<nw-1;i++) {
+		up[i]  = w[i+1] > w[i];
+		sup[i] = (int16_t)w[i+1] > (int16_t)w[i];
+	}
+	rising_runs(up,  sa->run16,  nw);
+	rising_runs(sup, sa->srun16, nw);
+
+	// tables the catalog found through their lookup calls
+	for(i=0;i<cat->set.num_sites;i++) {
+		off = cat->maps[i].x_num_adr;
+		if(CAT_CELLS_APART(&cat->maps[i])) off = cat->maps[i].cell_adr;
+		if(off != CAT_NO_ADR && off >= sa->base && off - sa->base < (unsigned long)len && sa->cat_at[off - sa->base] == 0) {
+			sa->cat_at[off - sa->base] = i+1;
+		}
+	}
+	return 0;
+}
+
+// n values of nwidth bytes from area offset off are strictly increasing
+static int axis_rising(SCAN_AREA *sa, int off, int n, int nwidth)
+{
+	if(n < 1 || off + n*nwidth > sa->len) return 0;
+	if(nwidth == 1) {
+		return sa->run8[off] >= n-1 || sa->srun8[off] >= n-1;
+	}
+	if(off & 1) return 0;									// words are never stored at odd addresses
+	return sa->run16[off/2] >= n-1 || sa->srun16[off/2] >= n-1;
+}
+
+// an axis counting up in steps of one is more likely an index or id list than a map axis
+static int axis_counting(SCAN_AREA *sa, int off, int n, int nwidth)
+{
+	unsigned int first, last;
+
+	if(nwidth == 1) {
+		first = sa->a[off];
+		last  = sa->a[off+n-1];
+	} else {
+		first = get16((unsigned char *)sa->a + off);
+		last  = get16((unsigned char *)sa->a + off + 2*(n-1));
+	}
+	return (last - first) == (unsigned int)(n-1);
+}
+
+static int get_count(SCAN_AREA *sa, int off, int nwidth)
+{
+	if(off + nwidth > sa->len) return 0;
+	if(nwidth == 1) return sa->a[off];
+	if(off & 1) return 0;
+	return get16((unsigned char *)sa->a + off);
+}
+
+static int catalog_start(SCAN_AREA *sa, unsigned long off)
+{
+	if(off < sa->base || off - sa->base >= (unsigned long)sa->len) return 0;
+	return sa->cat_at[off - sa->base];
+}
+
+/*
+ * Cell width and confidence of a candidate whose header and axes have been checked
+ */
+static void score_candidate(SCAN_AREA *sa, MAPSCAN_CANDIDATE *c, int counting)
+{
+	unsigned long cells = (unsigned long)c->x_num * (c->y_num ? c->y_num : 1);
+	int points = c->x_num + c->y_num, score, axis = 0;
+
+	// a catalogued axis distribution has no cells, it only agrees with a 1D candidate
+	c->catalog = catalog_start(sa, c->x_num_adr) - 1;
+	if(c->catalog >= 0 && sa->cat->maps[c->catalog].kind == CAT_AXIS) {
+		if(c->kind != CAT_CURVE) c->catalog = -1;
+		else axis = 1;
+	}
+
+	if(axis) {
+		c->kind       = CAT_AXIS;
+		c->cell_width = 0;
+		cells         = 0;
+	} else if(catalog_start(sa, c->cell_adr + cells)) {
+		// the cell width isn't in the header, an exact fit up to a catalogued table decides it
+		c->cell_width = 1;
+	} else if(catalog_start(sa, c->cell_adr + 2*cells)) {
+		c->cell_width = 2;
+	}
+	c->end = c->cell_adr + cells*c->cell_width;
+
+	if(c->kind == CAT_MAP) score = 50 + (2*points < 24 ? 2*points : 24);
+	else                   score = 30 + (3*points < 24 ? 3*points : 24);
+	if(counting) score -= 20;
+	if(catalog_start(sa, c->end) || ((c->end & 1) && catalog_start(sa, c->end+1))) score += 20;
+	if(c->catalog >= 0) score += 20;
+	c->score = score < 0 ? 0 : (score > 100 ? 100 : score);
+}
+
+static int add_candidate(SCAN_AREA *sa, MAPSCAN_CANDIDATE *cands, int num, MAPSCAN_CANDIDATE *c, int counting)
+{
+	if(num >= MAX_MAPSCAN_CANDIDATES) return num;
+	score_candidate(sa, c, counting);
+	if(c->end > sa->base + sa->len) return num;
+	cands[num] = *c;
+	return num+1;
+}
+
+/*
+ * Try every offset of the map area as a table header, returns the number of candidates
+ */
+static int find_candidates(SCAN_AREA *sa, MAPSCAN_CANDIDATE *cands)
+{
+	MAPSCAN_CANDIDATE c;
+	int off, xn, yn, xw, yw, x, y, num = 0;
+
+	for(off=0; off+2 < sa->len; off++) {
+		memset(&c, 0, sizeof(c));
+		c.x_num_adr = sa->base + off;
+		c.catalog   = -1;
+
+		// byte header: 1D curve
+		xn = sa->a[off];
+		if(xn >= MAPSCAN_MIN_POINTS && xn <= MAPSCAN_MAX_POINTS && axis_rising(sa, off+1, xn, 1)) {
+			c.kind = CAT_CURVE;  c.layout = MAP_LAYOUT_HEADER;
+			c.x_num = xn;  c.y_num = 0;
+			c.num_width = c.x_width = c.cell_width = 1;
+			c.y_width = 0;
+			c.cell_adr = c.x_num_adr + 1 + xn;
+			num = add_candidate(sa, cands, num, &c, axis_counting(sa, off+1, xn, 1));
+		}
+
+		// byte header: 2D map with byte or word axes
+		yn = sa->a[off+1];
+		if(xn >= 2 && xn <= MAPSCAN_MAX_POINTS && yn >= 2 && yn <= MAPSCAN_MAX_POINTS) {
+			for(xw=1;xw<=2;xw++) {
+				for(yw=1;yw<=2;yw++) {
+					x = off+2;
+					y = x + xn*xw;
+					if(!axis_rising(sa, x, xn, xw) || !axis_rising(sa, y, yn, yw)) continue;
+					c.kind = CAT_MAP;  c.layout = MAP_LAYOUT_HEADER;
+					c.x_num = xn;  c.y_num = yn;
+					c.num_width = 1;  c.x_width = xw;  c.y_width = yw;
+					c.cell_width = (xw == 2 || yw == 2) ? 2 : 1;
+					c.cell_adr = sa->base + y + yn*yw;
+					num = add_candidate(sa, cands, num, &c, axis_counting(sa, x, xn, xw) && axis_counting(sa, y, yn, yw));
+				}
+			}
+		}
+
+		if(off & 1) continue;
+
+		// word header: 1D curve
+		xn = get_count(sa, off, 2);
+		if(xn >= MAPSCAN_MIN_POINTS && xn <= MAPSCAN_MAX_POINTS && axis_rising(sa, off+2, xn, 2)) {
+			c.kind = CAT_CURVE;  c.layout = MAP_LAYOUT_HEADER;
+			c.x_num = xn;  c.y_num = 0;
+			c.num_width = c.x_width = c.cell_width = 2;
+			c.y_width = 0;
+			c.cell_adr = c.x_num_adr + 2 + 2*xn;
+			num = add_candidate(sa, cands, num, &c, axis_counting(sa, off+2, xn, 2));
+		}
+		if(xn < 2 || xn > MAPSCAN_MAX_POINTS) continue;
+
+		// word header: x_num, y_num, x-axis, y-axis
+		yn = get_count(sa, off+2, 2);
+		if(yn >= 2 && yn <= MAPSCAN_MAX_POINTS && axis_rising(sa, off+4, xn, 2) && axis_rising(sa, off+4+2*xn, yn, 2)) {
+			c.kind = CAT_MAP;  c.layout = MAP_LAYOUT_HEADER;
+			c.x_num = xn;  c.y_num = yn;
+			c.num_width = c.x_width = c.y_width = c.cell_width = 2;
+			c.cell_adr = c.x_num_adr + 4 + 2*xn + 2*yn;
+			num = add_candidate(sa, cands, num, &c, axis_counting(sa, off+4, xn, 2) && axis_counting(sa, off+4+2*xn, yn, 2));
+		}
+
+		// word header: x_num, x-axis, y_num, y-axis
+		yn = get_count(sa, off+2+2*xn, 2);
+		if(yn >= 2 && yn <= MAPSCAN_MAX_POINTS && axis_rising(sa, off+2, xn, 2) && axis_rising(sa, off+4+2*xn, yn, 2)) {
+			c.kind = CAT_MAP;  c.layout = MAP_LAYOUT_INTERLEAVED;
+			c.x_num = xn;  c.y_num = yn;
+			c.num_width = c.x_width = c.y_width = c.cell_width = 2;
+			c.cell_adr = c.x_num_adr + 4 + 2*xn + 2*yn;
+			num = add_candidate(sa, cands, num, &c, axis_counting(sa, off+2, xn, 2) && axis_counting(sa, off+4+2*xn, yn, 2));
+		}
+	}
+	return num;
+}
+
+static int cmp_score(const void *a, const void *b)
+{
+	const MAPSCAN_CANDIDATE *x = *(const MAPSCAN_CANDIDATE * const *)a, *y = *(const MAPSCAN_CANDIDATE * const *)b;
+
+	if(x->score != y->score) return y->score - x->score;
+	if(x->kind != y->kind) return y->kind - x->kind;			// 2D before 1D
+	return (x->x_num_adr > y->x_num_adr) - (x->x_num_adr < y->x_num_adr);
+}
+
+static int cmp_address(const void *a, const void *b)
+{
+	const MAPSCAN_CANDIDATE *x = *(const MAPSCAN_CANDIDATE * const *)a, *y = *(const MAPSCAN_CANDIDATE * const *)b;
+
+	return (x->x_num_adr > y->x_num_adr) - (x->x_num_adr < y->x_num_adr);
+}
+
+/*
+ * Keep the most confident candidates that don't overlap each other, returns how many are kept in 'keep'
+ */
+static int select_candidates(SCAN_AREA *sa, MAPSCAN_CANDIDATE *cands, int num, MAPSCAN_CANDIDATE **keep)
+{
+	unsigned char *used = calloc(1, sa->len);
+	unsigned long i, start, end;
+	int k, n = 0, taken = 0;
+
+	if(used == 0) return 0;
+	for(k=0;k<num;k++) {
+		if(cands[k].score >= MAPSCAN_MIN_SCORE) keep[n++] = &cands[k];
+	}
+	qsort(keep, n, sizeof(MAPSCAN_CANDIDATE *), cmp_score);
+
+	for(k=0;k<n;k++) {
+		start = keep[k]->x_num_adr - sa->base;
+		end   = keep[k]->end - sa->base;
+		for(i=start;i<end && used[i]==0;i++);
+		if(i < end) continue;
+		memset(used+start, 1, end-start);
+		keep[taken++] = keep[k];
+	}
+	free(used);
+	qsort(keep, taken, sizeof(MAPSCAN_CANDIDATE *), cmp_address);
+	return taken;
+}
+
+static const char *width_str(int nwidth)
+{
+	return nwidth == 1 ? "byte" : (nwidth == 2 ? "word" : "-");
+}
+
+int check_mapscan(ImageHandle *fh, int skip)
+{
+	MAPSCAN_CANDIDATE *cands, **keep, *c;
+	MAP_CATALOG cat;
+	SCAN_AREA sa;
+	clock_t start;
+	int i, num, taken, unreached = 0;
+	char dims[16];
+
+	if(skip == 0) return 0;
+
+	con_printf("\n-[ Map Area Scanner ]--------------------------------------------------------------------------------------\n\n");
+	con_printf(">>> Scanning 0x%x-0x%x for map headers [structure heuristic] \n", MAP_AREA_START, MAP_AREA_START+MAP_AREA_SIZE-1);
+
+	start = clock();
+	memset(&cat, 0, sizeof(cat));
+	cands = malloc(MAX_MAPSCAN_CANDIDATES*(sizeof(MAPSCAN_CANDIDATE) + sizeof(MAPSCAN_CANDIDATE *)));
+	if(cands == 0 || catalog_build(&cat, fh) < 0 || init_scan_area(&sa, fh, &cat) != 0) {
+		con_printf("failed to set up the map area scan\n");
+		free(cands);
+		catalog_free(&cat);
+		return 0;
+	}
+	keep = (MAPSCAN_CANDIDATE **)(cands + MAX_MAPSCAN_CANDIDATES);
+	catalog_match_known(&cat);
+
+	num   = find_candidates(&sa, cands);
+	taken = select_candidates(&sa, cands, num, keep);
+	for(i=0;i<taken;i++) {
+		if(keep[i]->catalog < 0) unreached++;
+	}
+
+	con_printf("\n%d candidate headers, %d plausible tables (confidence >= %d%%), %d not reached by any lookup call site (%.2f ms)\n\n",
+		num, taken, MAPSCAN_MIN_SCORE, unreached, 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC);
+
+	for(i=0;i<taken;i++) {
+		c = keep[i];
+		if(c->y_num) snprintf(dims, sizeof(dims), "%dx%d", c->x_num, c->y_num);
+		else         snprintf(dims, sizeof(dims), "%d", c->x_num);
+
+		con_printf("  phy:0x%x file-offset=0x%-5x %-5s %-5s x:%-4s y:%-4s cells:%-4s %5d bytes confidence %3d%%",
+			(int)(c->x_num_adr + CAT_ROM_BASE), (int)c->x_num_adr, catalog_kind_name(c->kind), dims,
+			width_str(c->x_width), width_str(c->y_width), width_str(c->cell_width), (int)(c->end - c->x_num_adr), c->score);
+		if(c->catalog >= 0) {
+			CATALOG_MAP *cm = &cat.maps[c->catalog];
+			con_printf("  catalog %s", catalog_kind_name(cm->kind));
+			if(cm->known) con_printf(" (%s)", cm->known);
+		}
+		con_printf("\n");
+	}
+
+	free_scan_area(&sa);
+	catalog_free(&cat);
+	free(cands);
+	return 0;
+}
@@ -0,0 +1,50 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _MAPSCAN_SUPPORT_H
+#define _MAPSCAN_SUPPORT_H
+#include "utils.h"
+#include "mapcatalog.h"
+
+// Structural scan of the 64KByte map area (MAP_AREA_START..+MAP_AREA_SIZE) for map headers,
+// finds the tables that are only reached through pointer tables so no lookup needle matches.
+// A header is a small x_num (and y_num) followed by strictly increasing axes of that length.
+
+#define MAPSCAN_MIN_POINTS       3			// shortest 1D axis taken, shorter runs are everywhere
+#define MAPSCAN_MAX_POINTS       32
+#define MAPSCAN_MIN_SCORE        50			// confidence (0..100) a candidate needs to be listed
+#define MAX_MAPSCAN_CANDIDATES   8192
+
+typedef struct MAPSCAN_CANDIDATE {
+	int            kind;					// CAT_CURVE or CAT_MAP
+	int            layout;					// MAP_LAYOUT_HEADER or MAP_LAYOUT_INTERLEAVED
+	unsigned long  x_num_adr;				// rom file offset of the header
+	unsigned long  cell_adr;
+	unsigned long  end;						// first byte after the table
+	int            x_num, y_num;
+	int            num_width, x_width, y_width, cell_width;
+	int            score;					// confidence 0..100
+	int            catalog;					// map catalog entry with the same header, -1 if none
+} MAPSCAN_CANDIDATE;
+
+int check_mapscan(ImageHandle *fh, int skip);
+
+#endif
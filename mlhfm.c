@@ -21,6 +21,10 @@
 */
 #include "mlhfm.h"
 #include "table_spec.h"
+#include "export.h"
+#include "maplookup.h"
+#include "dpptrack.h"
+#include "mapcatalog.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -42,8 +46,8 @@ int check_mlhfm(ImageHandle *fh, int skip)
 
 	if(skip == 0) return found;		
 
-	printf("-[ AirFlow Meter MLHFM ]----------------------------------------------------------------\n\n");
-	printf(">>> Scanning for a partial MLHFM Linearization Table Lookup code sequence... \n");
+	con_printf("-[ AirFlow Meter MLHFM ]----------------------------------------------------------------\n\n");
+	con_printf(">>> Scanning for a partial MLHFM Linearization Table Lookup code sequence... \n");
 
 	while(1)
 	{
@@ -61,22 +65,25 @@ int check_mlhfm(ImageHandle *fh, int skip)
 			{ 
 				false_positive++;				// we only found a partial match, so its not going to be the mlhfm table we really want, likely referencing some other table!!!
 			}  else { 
-				printf("Fuzzy match found!\n"); 
+				con_printf("Fuzzy match found!\n"); 
 
-				translate_seg(&_mlhfm, "MLHFM", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+4) /*val*/);
+				translate_seg(&_mlhfm, "MLHFM", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+4) /*seg*/, get16((unsigned char *)addr+4) /*val*/);
 				show_seg(&_mlhfm);
 
 				crc_hfm = crc32(0, _mlhfm.ram, entries*2);
 				if(crc_hfm == 0x4200bc1)			// crc32 checksum of MLHFM 1024byte table
 				{
-					printf("\nMLHFM Table Identified: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
+					con_printf("\nMLHFM Table Identified: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
 				} else if(crc_hfm == 0x87b3489a)	// crc32 checksum of MLHFM 1024byte table
 				{
-					printf("\nMLHFM Table Identified: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
+					con_printf("\nMLHFM Table Identified: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
 				}
 
-				printf("\nunsigned short MLHFM_%X[%d] = {\n", crc_hfm, entries);
+				con_printf("\nunsigned short MLHFM_%X[%d] = {\n", crc_hfm, entries);
 				hexdump_le_table(_mlhfm.ram, entries, "};\n");			
+				export_array("MLHFM", "Linearization of airflow voltages from air flow meter", (unsigned long)_mlhfm.rom, _mlhfm.ram, entries, 2);
+				map_registry_add_curve(&MLHFM_table, _mlhfm.ram, entries, 2, 2, (unsigned long)(_mlhfm.off));
+				catalog_note_table("MLHFM", CAT_NO_ADR, CAT_NO_ADR, (unsigned long)(_mlhfm.off));
 				found=1;
 				break;
 			}
@@ -85,44 +92,47 @@ int check_mlhfm(ImageHandle *fh, int skip)
 		// next loop around...
 	}
 
-	printf("\nFalse positives detected (and eliminated): %d\n", false_positive);
-	printf("Found status: %d",found);
+	con_printf("\nFalse positives detected (and eliminated): %d\n", false_positive);
+	con_printf("Found status: %d",found);
 	
 	if(found == 0) {
 
-		printf("\n>>> Scanning for full MLHFM Linearization Table Lookup code sequence - Variant #2... ");
+		con_printf("\n>>> Scanning for full MLHFM Linearization Table Lookup code sequence - Variant #2... ");
 
 		new_offset = 0;	
 		while(1)
 		{
-			printf("\nsearch...\n");
+			con_printf("\nsearch...\n");
 			current_offset = search_offset(rom_load_addr+new_offset, (fh->len)-new_offset, (unsigned char *)&needle_mlhfm, (unsigned char *)&mask_mlhfm, needle_mlhfm_len);
 			if(current_offset == 0) break;
 			if(current_offset != NULL) 
 			{
-				printf("\nMatch found at: offset=0x%x \n",(int)(current_offset+new_offset) );		
+				con_printf("\nMatch found at: offset=0x%x \n",(int)(current_offset+new_offset) );		
 				addr = rom_load_addr+current_offset+new_offset;
 				// disassemble needle found in rom
 				if(show_diss) { c167x_diss(addr-rom_load_addr, addr, 64); }
-				translate_seg(&_mlhfm, "MLHFM", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+10) /*val*/);
+				translate_seg(&_mlhfm, "MLHFM", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+10) /*seg*/, get16((unsigned char *)addr+10) /*val*/);
 				show_seg(&_mlhfm);
 
 				crc_hfm = crc32(0, _mlhfm.ram, entries*2);
 				if(crc_hfm == 0x4200bc1)			// crc32 checksum of MLHFM 1024byte table
 				{
-					printf("\nMLHFM Table Identified: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
+					con_printf("\nMLHFM Table Identified: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
 				} else if(crc_hfm == 0x87b3489a)	// crc32 checksum of MLHFM 1024byte table
 				{
-					printf("\nMLHFM Table Identified: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
+					con_printf("\nMLHFM Table Identified: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
 				}
-				printf("\nunsigned short MLHFM_%X[%d] = {\n", crc_hfm, entries);
+				con_printf("\nunsigned short MLHFM_%X[%d] = {\n", crc_hfm, entries);
 				hexdump_le_table(_mlhfm.ram, entries, "};\n");			
+				export_array("MLHFM", "Linearization of airflow voltages from air flow meter", (unsigned long)_mlhfm.rom, _mlhfm.ram, entries, 2);
+				map_registry_add_curve(&MLHFM_table, _mlhfm.ram, entries, 2, 2, (unsigned long)(_mlhfm.off));
+				catalog_note_table("MLHFM", CAT_NO_ADR, CAT_NO_ADR, (unsigned long)(_mlhfm.off));
 				found=1;
 				break;
 			}
 			new_offset += current_offset+needle_1_len;
 		}
-		printf("\nFound status: %d",found);
+		con_printf("\nFound status: %d",found);
 		
 	}
 
@@ -148,8 +158,8 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 			 */
 	if (find_mlhfm != 0)
 	{
-			printf("\n-[ AirFlow Meter MLHFM ]----------------------------------------------------------------\n\n");
-			printf(">>> Scanning for full MLHFM Linearization Table Lookup code sequence... \n");
+			con_printf("\n-[ AirFlow Meter MLHFM ]----------------------------------------------------------------\n\n");
+			con_printf(">>> Scanning for full MLHFM Linearization Table Lookup code sequence... \n");
 
 			addr = search( fh, (unsigned char *)&needle_1q, (unsigned char *)&mask_1q, needle_1q_len, 0 );
 			if(addr != NULL) {
@@ -163,12 +173,12 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 //-				if(entries > MAX_DHFM_ENTRIES) { printf("unusual entries size, defaulting to 512"); entries=DEFAULT_DHFM_ENTRIES; };
 			}
 			else {
-				printf("\nSequence not found\n\n");
+				con_printf("\nSequence not found\n\n");
 				seq_found = 0;
-				printf(">>> Scanning for full MLHFM Linearization Table Lookup code sequence - Variant #2... \n");
+				con_printf(">>> Scanning for full MLHFM Linearization Table Lookup code sequence - Variant #2... \n");
 				addr = search( fh, (unsigned char *)&needle_mlhfm, (unsigned char *)&mask_mlhfm, needle_mlhfm_len, 0 );
 				if(addr != NULL) {
-					printf("\nSequence Found @ %#x\n", addr);
+					con_printf("\nSequence Found @ %#x\n", addr);
 					entries=DEFAULT_DHFM_ENTRIES;
 					if(show_diss) {
 						c167x_diss(addr-rom_load_addr, addr, 64);
@@ -176,7 +186,7 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 					seq_found=1;
 					opskip=10;
 				} else {
-					printf("\nSequence not found\n\n");				
+					con_printf("\nSequence not found\n\n");				
 					seq_found = 0;
 				}
 
@@ -199,18 +209,18 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 					/* lets show the sequence we looked for and found
 					 * in hex (this is the machine code sequence for the GGHFM_DHFM_Lookup() function in the firmware image
 					 */
-					printf("\n\nFound GGHFM_DHFM_Lookup() instruction sequence at file offset: 0x%x, len=%d\n", addr-(fh->d.u8), needle_1_len );			
+					con_printf("\n\nFound GGHFM_DHFM_Lookup() instruction sequence at file offset: 0x%x, len=%d\n", addr-(fh->d.u8), needle_1_len );			
 
-					printf("\nExtracted MLHFM map table offset from mov instruction = 0x%x (endian compliant)\n",offset);
-					printf("Extracted %d table entries from code.\n",entries);
+					con_printf("\nExtracted MLHFM map table offset from mov instruction = 0x%x (endian compliant)\n",offset);
+					con_printf("Extracted %d table entries from code.\n",entries);
 					
-					printf("\nFile offset to MLHFM table 0x%x (%d) [%d bytes]\n",(MAP_FILE_OFFSET + offset),(MAP_FILE_OFFSET + offset), entries*2 );
+					con_printf("\nFile offset to MLHFM table 0x%x (%d) [%d bytes]\n",(MAP_FILE_OFFSET + offset),(MAP_FILE_OFFSET + offset), entries*2 );
 					
 					uint32_t crc_hfm;
 					crc_hfm = crc32(0, fh->d.p + MAP_FILE_OFFSET + offset, entries*2);
 
 						// get offset
-						printf("unsigned short MLHFM_%x[%d] = {\n", crc_hfm, entries);
+						con_printf("unsigned short MLHFM_%x[%d] = {\n", crc_hfm, entries);
 						hexdump_le_table(fh->d.p + MAP_FILE_OFFSET + offset, entries, "};\n");					
 
 					if(find_mlhfm == HFM_WRITING)
@@ -221,32 +231,32 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 						{
 							if(fh_hfm->len != 1024) {
 								ifree_file(fh_hfm);
-								printf("MLHFM table is the wrong size, cannot continue. Exiting. Are you sure its a MLHFM table?");
+								con_printf("MLHFM table is the wrong size, cannot continue. Exiting. Are you sure its a MLHFM table?");
 								return 0;
 							}
-							printf("Correctly loaded in an MLHFM file '%s'\n", filename_hfm);
+							con_printf("Correctly loaded in an MLHFM file '%s'\n", filename_hfm);
 							
 							uint32_t crc_hfm_file;
 							crc_hfm_file = crc32(0, fh_hfm->d.p, 1024);
 							
 							if(crc_hfm_file == 0x4200bc1)			/* crc32 checksum of MLHFM 1024byte table */
 							{
-								printf("MLHFM Table Identified in loaded file: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
+								con_printf("MLHFM Table Identified in loaded file: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
 							} else if(crc_hfm_file == 0x87b3489a)	/* crc32 checksum of MLHFM 1024byte table */
 							{
-								printf("MLHFM Table Identified in loaded file: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
+								con_printf("MLHFM Table Identified in loaded file: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
 							} else {
-								printf("MLHFM Table Not Identified in loaded file: Custom or not an MLHFM file!\n");
+								con_printf("MLHFM Table Not Identified in loaded file: Custom or not an MLHFM file!\n");
 							}
 							
 							/* check if firmware ALREADY matches the loaded in MLHFM table */
 							if(crc_hfm == crc_hfm_file) {
-								printf("\nMLHFM Table already IDENTICAL in the rom specified. Nothing to do here...\n");
+								con_printf("\nMLHFM Table already IDENTICAL in the rom specified. Nothing to do here...\n");
 								return 0;
 							}
 
 							/* copying hfm table from file into rom image in memory */
-							printf("\nMerging MLHFM table into rom...\n");
+							con_printf("\nMerging MLHFM table into rom...\n");
 							memcpy(fh->d.p + MAP_FILE_OFFSET + offset, fh_hfm->d.p, fh_hfm->len);
 
 							// now that we've merged MLHFM, force a checksum re-correction (note: his will automatically re-save!)
@@ -254,7 +264,7 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 							// do checksum correction and autosave it.
 							fix_checksums(fh, addr, filename_rom, dynamic_ROM_FILESIZE, rom_load_addr);
  
-							printf("\nAll done.\n");
+							con_printf("\nAll done.\n");
 						}
 						return 0;
 					}
@@ -262,7 +272,7 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 					if(filename_hfm != 0)
 					{
 						snprintf(ml_filename, MAX_FILENAME, "%s_%x.bin", filename_hfm, crc_hfm);
-						printf("Saving MLHFM filename as '%s'\n", ml_filename);
+						con_printf("Saving MLHFM filename as '%s'\n", ml_filename);
 					}
 					else 
 					{
@@ -271,11 +281,11 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 						 */
 						if(crc_hfm == 0x4200bc1)			// crc32 checksum of MLHFM 1024byte table
 						{
-							printf("MLHFM Table Identified: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
+							con_printf("MLHFM Table Identified: Ferrari 360 Modena/Spider/Challenge (Stock) Air Flow Meters\n");						
 							snprintf(ml_filename, MAX_FILENAME, "MLHFM_Modena_%x.bin", crc_hfm);
 						} else if(crc_hfm == 0x87b3489a)	// crc32 checksum of MLHFM 1024byte table
 						{
-							printf("MLHFM Table Identified: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
+							con_printf("MLHFM Table Identified: Ferrari 360 Challenge Stradale (Stock) Air Flow Meters\n");
 							snprintf(ml_filename, MAX_FILENAME, "MLHFM_Stradale_%x.bin", crc_hfm);
 						}
 					}
@@ -285,10 +295,10 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 					 */
 					if(find_mlhfm == HFM_READING)
 					{
-						printf("Saving raw MLHFM table (dumped with no endian conversion) to file: '%s'\n\n", ml_filename);
+						con_printf("Saving raw MLHFM table (dumped with no endian conversion) to file: '%s'\n\n", ml_filename);
 						save_result = save_file(ml_filename, fh->d.p + MAP_FILE_OFFSET + offset, entries*2 );
 						if(save_result) {
-							printf("\nFailed to save, result = %d\n", save_result);
+							con_printf("\nFailed to save, result = %d\n", save_result);
 						}
 
 //						// get offset
@@ -298,7 +308,7 @@ int check_mlhfm2(ImageHandle *fh, unsigned char *addr, char *filename_rom, char
 
 					}
 				} else {
-					printf("MLHFM not found. Probaby a matching byte sequence but not in a firmware image");
+					con_printf("MLHFM not found. Probaby a matching byte sequence but not in a firmware image");
 				}
 			}
 		}
@@ -22,6 +22,8 @@
 #include "multimap.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "funcindex.h"
+#include "export.h"
 
 //-[ Map Table Finder :) ] -----------------------------------------------------------------------------------------------------------------------------------------------------------------------------			
 
@@ -34,174 +36,198 @@
  *  The approach of masking all segment and relocation information out of the signatures means it works on any ME7x rom file 
  *  compiled for C167x cpu and works right across a huge number of rom variants.
  *
- *  This is just showing X-Axis tables (entire set of rom tables will come shortly and then we can easily match them too!)... 
- *  But ofcourse its quite simple to make this work for ALL the ROM resident tables. 
+ *  All of the lookup routine call patterns are matched in a single pass and every table is classified (see mapcatalog.c),
+ *  the tables the named checks show are then taken off the list so what is left are the maps nobody has named yet.
  * 
  *  This is a far better way than 'guessing' the maps knowing they reside (as some even commercial tools do) within a certain range 
- *  in the rom. This guarentee's your actually looking at real tables. The next step is to push the table start addresses into a hash 
- *  table to make it easy to de-duplicate them so you don't find calls to the lookups to the same tables (happens occasionally since 
- *  we are walking through the rom code and literaly picking up ALL of the accesses to the tables.
+ *  in the rom. This guarentee's your actually looking at real tables. Since we are walking through the rom code and literaly picking 
+ *  up ALL of the accesses to the tables the same table is usually found from several call sites, so the table addresses go into a 
+ *  hash set first (see MAP_SET) and each table is then shown once together with every call site that references it.
  * 
  *  Have fun ;)
  */
  
-extern unsigned dpp1_value;
-extern 
+static void show_map_refs(MAP_SET *ms, MAP_SITE *site)
+{
+	int r;
+
+	con_printf("Referenced from %d call site%s:\n", site->num_refs, site->num_refs > 1 ? "s" : "");
+	for(r = site->first_ref; r >= 0; r = ms->refs[r].next) {
+		if(ms->refs[r].func != FUNC_NONE) {
+			con_printf("\tlookup at offset=0x%x (estimated function start: 0x%x)\n", (int)ms->refs[r].offset, (int)ms->refs[r].func);
+		} else {
+			con_printf("\tlookup at offset=0x%x\n", (int)ms->refs[r].offset);
+		}
+	}
+}
+
+static const char *width_name(int nwidth)
+{
+	switch(nwidth) {
+		case 1:  return "byte";
+		case 2:  return "word";
+		default: return "-";
+	}
+}
+
+// one line summary of a catalog entry
+static void show_catalog_line(MAP_CATALOG *cat, CATALOG_MAP *cm)
+{
+	unsigned long off = CAT_CELLS_APART(cm) ? cm->cell_adr : cm->x_num_adr;
+	char dims[16];
+
+	if(cm->y_num) snprintf(dims, sizeof(dims), "%dx%d", cm->x_num, cm->y_num);
+	else          snprintf(dims, sizeof(dims), "%d", cm->x_num);
+
+	con_printf("%-5s phy:0x%x file-offset=0x%-5x %-5s x:%-4s y:%-4s cells:%-4s %5d bytes",
+		catalog_kind_name(cm->kind), (int)cm->adr, (int)off, dims,
+		width_name(cm->x_width), width_name(cm->y_width), width_name(cm->cell_width), (int)cm->size);
+	if(cm->lookup) con_printf(" lookup:0x%x", (int)cm->lookup);
+	else           con_printf(" indexed");
+	if(cm->known) {
+		con_printf(cm->kind == CAT_AXIS ? "  (axis of %s)" : "  %s", cm->known);
+	}
+	if(cm->rejected) {
+		con_printf("  rejected: %s", cm->rejected);
+	}
+	con_printf("\n");
+}
 
-int check_multimap(ImageHandle *fh, int skip)
+// values of one part of a table as stored in rom
+static void show_part(ImageHandle *fh, const char *name, unsigned long off, int num, int nwidth)
 {
-	int found = 0;
+	unsigned char *rom = fh->d.u8;
 	int i;
-	unsigned char *addr;
-	unsigned char *rom_load_addr = fh->d.p;
-
-	if(skip == 0) return found;		
-	
-	printf("-[ Generic X-Axis MAP Table Scanner! ]---------------------------------------------------------------------\n\n");
-	printf(">>> Scanning for Map Tables #1 Checking sub-routine [map finder!] \n");
-				
-	int disabled_maps_1=1;
-	if(disabled_maps_1==1)
-	{
-		int current_offset=0;
-		int x,y1, j=0;
-					
-		i=0;
-		while(j++ < MAX_TABLE_SEARCHES)
-		{
-					// search for signature for X-Axis (1 row) table..
-						addr = search( fh, (unsigned char *)&mapfinder_needle, (unsigned char *)&mapfinder_mask, mapfinder_needle_len, current_offset);
-
-						// exit the searching loop when we reach end of rom region
-						if(addr-rom_load_addr > dynamic_ROM_FILESIZE-mapfinder_needle_len) { break; }
-
-						// if we find a match lets dump it!
-						if(addr != NULL) {
-							printf("\n[Map #%d] 1D X-Axis  : Map function found at: offset=0x%x ",(i++)+1, (int)(addr-rom_load_addr) );
-//							// disassemble needle found in rom
-//							if(show_diss) { printf("\n"); c167x_diss(addr-rom_load_addr, addr, mapfinder_needle_len); }
-
-							unsigned long val          = get16((unsigned char *)addr + 2);	// from rom routine extract value (offset in rom to table)
-							unsigned long seg          = get16((unsigned char *)addr + 6);	// and segment (required to regenerate physical address from segment)
-							unsigned long map_adr      = (unsigned long)(seg*SEGMENT_SIZE)+(long int)val;	// derive phyiscal address from offset and segment
-							map_adr                   &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
-
-							unsigned char *table_start = rom_load_addr+map_adr+1;			// 2 bytes to skip x and y bytes
-							unsigned char x_axis       = get16(rom_load_addr+map_adr+0);		// get number of rows
-	//						unsigned char x_axis       = *(rom_load_addr+map_adr+1);		// get number of colums
-							
-	//						printf("(seg:0x%x phy:0x%x val:0x%x), offset=0x%x x-axis=%d",seg, seg*SEGMENT_SIZE+val, val, (unsigned long)table_start-(int)rom_load_addr, x_axis);
-							printf("phy:0x%x, file-offset=0x%x x-axis=%d",seg*SEGMENT_SIZE+val, (unsigned long)table_start-(int)rom_load_addr, x_axis);
-
-							printf("\n\t");
-							for(x=0;x<x_axis;x++) 
-							{
-								printf("%-2.2x ", (int)(*(table_start+x)) );	// show values directly out of the table
-							}
-						}
-//						printf("\n");
-						
-						// continue search from next location after this match...
-						current_offset = (addr-rom_load_addr)+mapfinder_needle_len;
-  
-						//printf("\nCurrent Offset : %x\n",current_offset);
+
+	if(off + (unsigned long)num*nwidth > fh->len) return;
+	con_printf("\t%-6s:", name);
+	for(i=0;i<num;i++) {
+		if(i && (i % 16) == 0) con_printf("\n\t       ");
+		if(nwidth == 1) con_printf(" %-2.2x", (int)rom[off+i]);
+		else            con_printf(" %-4.4x", (int)get16(rom+off+2*i));
+	}
+	con_printf("\n");
+}
+
+/*
+ * Decode an unknown table with a table definition made up from its catalogued widths,
+ * it's then shown (and exported) like the tables of the named checks
+ */
+static int show_catalog_table(ImageHandle *fh, CATALOG_MAP *cm)
+{
+	TABLE_DEF td = XXXX_table;
+	MAP_DATA m;
+	RENDER_CTX rc;
+	char name[32];
+
+	snprintf(name, sizeof(name), "%s_%X", catalog_kind_name(cm->kind), (unsigned int)cm->adr);
+	td.table_name     = name;
+	td.table_desc     = "Found by the map catalog, not yet defined.";
+	td.x_num_nwidth   = cm->num_width;
+	td.y_num_nwidth   = cm->y_num_adr != CAT_NO_ADR ? cm->num_width : 0;
+	td.x_axis_nwidth  = cm->x_width;
+	td.y_axis_nwidth  = cm->y_width;
+	td.cell_nwidth    = cm->cell_width;
+	td.x_axis.nwidth  = cm->x_width;
+	td.y_axis.nwidth  = cm->y_width;
+	td.cell.nwidth    = cm->cell_width;
+	td.decode         = 0;
+
+	if(decode_map(&m, fh->d.u8, fh->len, &td, cm->layout, cm->x_num_adr, 0, cm->cell_adr) != 0) {
+		con_printf("\n%s table lies outside the rom image.\n\n", name);
+		return -1;
+	}
+	m.rom_adr = cm->adr;
+	export_map(&m);
+	render_ctx_init(&rc);
+	show_map(&m, &rc);
+	free_map(&m);
+	return 0;
+}
+
+/*
+ * Show the map catalog, the unknown tables are listed one line each unless render is set
+ */
+int check_multimap(ImageHandle *fh, int skip, int render)
+{
+	static const int kind_order[CAT_KINDS] = { CAT_MAP, CAT_GROUP, CAT_CURVE, CAT_SPLIT, CAT_ARRAY, CAT_AXIS };
+	MAP_CATALOG cat;
+	CATALOG_MAP *cm;
+	int i, k, n = 0;
+
+	if(skip == 0) return 0;
+
+	con_printf("\n-[ Map Catalog ]-------------------------------------------------------------------------------------------\n\n");
+	con_printf(">>> Classifying every lookup routine call site [map finder!] \n");
+
+	if(catalog_build(&cat, fh) < 0) {
+		con_printf("failed to allocate map catalog\n");
+		catalog_free(&cat);
+		return 0;
+	}
+	catalog_match_known(&cat);
+
+	con_printf("\n%d unique map tables from %d lookup call sites: %d maps, %d group maps, %d curves, %d split curves, %d arrays, %d shared axes, %d rejected\n",
+		cat.set.num_sites, cat.set.num_refs, cat.num_kind[CAT_MAP], cat.num_kind[CAT_GROUP], cat.num_kind[CAT_CURVE],
+		cat.num_kind[CAT_SPLIT], cat.num_kind[CAT_ARRAY], cat.num_kind[CAT_AXIS], cat.num_rejected);
+	con_printf("%d of them shown by the named checks, %d unknown\n", cat.num_known, cat.set.num_sites - cat.num_known - cat.num_rejected);
+
+	if(cat.num_known) {
+		con_printf("\nKnown map tables:\n");
+		for(k=0;k<CAT_KINDS;k++) {
+			for(i=0;i<cat.set.num_sites;i++) {
+				cm = &cat.maps[i];
+				if(cm->kind != kind_order[k] || cm->known == 0) continue;
+				con_printf("  ");
+				show_catalog_line(&cat, cm);
+			}
 		}
-		printf("\n\n");
-					
 	}
 
-	//
-	// Multi-dimensional Type #1
-	//
-	int disabled_maps_2=1;
-	if(disabled_maps_2==1)
-	{ 
-		int current_offset = 0;
-		int new_offset=0;
-		unsigned char *tmp_ptr;
-		unsigned char *map_table_start;
-		unsigned int map_table_adr;
-		unsigned int map_table_x_axis_adr;
-		unsigned int map_table_y_axis_adr;
-		unsigned int map_table_x_num_adr;
-		unsigned int x_num, y_num;
-		unsigned int map_table_y_num_adr;
-		unsigned long val, seg;
-
-		while(1)
-		{
-						// search for signature for X/Y-Axis (multirow/column) table..
-						current_offset = search_offset(rom_load_addr+new_offset, (fh->len)-new_offset, (unsigned char *)&mapfinder_xy2_needle, (unsigned char *)&mapfinder_xy2_mask, mapfinder_xy2_needle_len);
-						if(current_offset == 0) break;
-
-						// if we find a match lets dump it!
-						if(current_offset != NULL) {
-							printf("\n------------------------------------------------------------------\n[Map #%d] Multi Axis Map Type #1 function found at: offset=0x%x \n",(i++)+1, (int)(current_offset+new_offset) );
-							addr = rom_load_addr+current_offset+new_offset;
-							dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 30), get16((unsigned char *)addr + 26), &XXXX_table, 0);
-							new_offset += current_offset+mapfinder_xy2_needle_len;
-						}
-						printf("\n");
+	/*
+	 * now show each unknown table once, grouped by kind in the order they were first found,
+	 * call sites whose header didn't hold up aren't tables and are only listed with -maptables
+	 */
+	con_printf("\n\nUnknown map tables:\n");
+	for(k=0;k<CAT_KINDS;k++) {
+		for(i=0;i<cat.set.num_sites;i++) {
+			cm = &cat.maps[i];
+			if(cm->kind != kind_order[k] || cm->known != 0 || cm->rejected) continue;
+
+			if(render == 0) {
+				con_printf("  [Map #%d] ", ++n);
+				show_catalog_line(&cat, cm);
+				continue;
+			}
+			con_printf("\n------------------------------------------------------------------\n[Map #%d] ", ++n);
+			show_catalog_line(&cat, cm);
+			show_map_refs(&cat.set, &cat.set.sites[i]);
+			if(cm->kind == CAT_GROUP && cm->x_axis >= 0 && cm->y_axis >= 0) {
+				con_printf("\tx-axis : shared, phy:0x%x\n", (int)cat.maps[cm->x_axis].adr);
+				con_printf("\ty-axis : shared, phy:0x%x\n", (int)cat.maps[cm->y_axis].adr);
+			}
+			if(cm->layout >= 0 && cm->x_num > 0) {
+				con_printf("\n");
+				show_catalog_table(fh, cm);
+				continue;
+			}
+			if(cm->x_axis_adr != CAT_NO_ADR) show_part(fh, "x-axis", cm->x_axis_adr, cm->x_num, cm->x_width);
+			if(cm->y_axis_adr != CAT_NO_ADR) show_part(fh, "y-axis", cm->y_axis_adr, cm->y_num, cm->y_width);
+			if(cm->cell_adr   != CAT_NO_ADR) show_part(fh, "cells",  cm->cell_adr, cm->x_num*(cm->y_num ? cm->y_num : 1), cm->cell_width);
+			if(cm->x_num == 0) con_printf("\ttable layout not recognised\n");
 		}
-		printf("\n\n");
 	}
 
-	//
-	// Single-dimensional Type #1 
-	//
-	int disabled_maps_3=1;
-	if(disabled_maps_3==1)
-	{
-		int current_offset = 0;
-		int new_offset=0;
-		unsigned long map_table_adr;
-		unsigned long map_axis_adr;
-		unsigned long val, seg;
-		unsigned int j = 0;
-					
-		while(j++ < MAX_TABLE_SEARCHES)
-		{
-						// search for signature for X/Y-Axis (multirow/column) table..
-						current_offset = search_offset(rom_load_addr+new_offset, (fh->len)-new_offset, (unsigned char *)&mapfinder_xy3_needle, (unsigned char *)&mapfinder_xy3_mask, mapfinder_xy3_needle_len);
-						if(current_offset == 0) break;
-
-						// if we find a match lets dump it!
-						if(current_offset != NULL) {
-							printf("\n\n------------------------------------------------------------------\n[Map #%d] Multi Map Type #2 lookup function found @ offset: 0x%x \n",(i++)+1, (int)(current_offset+new_offset) );
-
-							addr = rom_load_addr+current_offset+new_offset;
-							unsigned char *pos=addr;
-							unsigned char val;
-							int i=0;
-
-							// lets try to determine (experimental!!! ) start of main subroutine this belongs too
-							while(j++ < MAX_SEARCH_BACK_BYTES)
-							{
-								i++;
-								if(*(pos+0) == 0xDB)				// machine code for 'rets in C167 is 0xDB00 
-								{
-										if(*(pos+1) == 0x00) {
-											i++;
-											printf("\nFound estimated function start address: 0x%-8x", pos-rom_load_addr);
-											break;
-										}
-								}
-								if(pos <= rom_load_addr) { printf("not found\n"); break; } 
-								pos--;
-							}
-							printf("\nBacktrack offset: 0x%x (%d bytes)\n\n",(int)(current_offset+new_offset+4)-i,i);
-							
-							val                   = get16((unsigned char *)addr + 14 - 10) ;	// from rom routine extract value (offset in rom to table)
-							seg                   = get16((unsigned char *)addr + 18 - 10);	// and segment (required to regenerate physical address from segment)
-							map_table_adr         = (unsigned long)(seg*SEGMENT_SIZE)+(long int)val;	// derive phyiscal address from offset and segment
-							dump_table(addr, rom_load_addr, get16((unsigned char *)addr + 22 - 10), get16((unsigned char *)addr + 26 - 10), &XXXXB_table, map_table_adr);
-
-							new_offset += current_offset+mapfinder_xy2_needle_len;
-						}
-					//	printf("\n");
+	con_printf("\n%d unknown map tables\n", n);
+
+	if(render && cat.num_rejected) {
+		con_printf("\nRejected call sites:\n");
+		for(i=0;i<cat.set.num_sites;i++) {
+			if(cat.maps[i].rejected == 0) continue;
+			con_printf("  ");
+			show_catalog_line(&cat, &cat.maps[i]);
 		}
-	//	printf("\n\n");
 	}
-				
+	catalog_free(&cat);
 	return 0;
-} 
+}
@@ -23,12 +23,10 @@
 #define _MULTIMAP_SUPPORT_H
 #include "utils.h"
 #include "needles.h"
+#include "mapcatalog.h"
 
-int check_multimap(ImageHandle *fh, int skip);
+int check_multimap(ImageHandle *fh, int skip, int render);
 
 extern unsigned long dynamic_ROM_FILESIZE;
 
-#define MAX_TABLE_SEARCHES    	 4000
-#define MAX_SEARCH_BACK_BYTES    3500
-
 #endif
@@ -0,0 +1,386 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "needlegen.h"
+#include "inst_c16x.h"
+#include "outbuf.h"
+#include <time.h>
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
+#define NG_RAM_BITS		0x80		// bitoffs below this address words of 0xFD00-0xFDFE
+
+typedef struct NG_FIELD {
+	int         offset;				// byte offset into the needle
+	int         len;
+	const char *what;
+} NG_FIELD;
+
+typedef struct NG_ROM {
+	const char    *filename;
+	int            hits;			// -1 if the rom couldn't be loaded
+	unsigned long  at[NEEDLEGEN_SHOW_HITS];
+} NG_ROM;
+
+typedef struct NG_SEARCH {
+	const unsigned char *needle;
+	const unsigned char *mask;
+	int                  len;
+	NG_ROM              *roms;
+	int                  num;
+	int                  next;		// next rom to search
+#ifndef NO_THREADS
+	pthread_mutex_t      lock;
+#endif
+} NG_SEARCH;
+
+// mask len bytes of the instruction at needle offset 'at', fields may be 0 when nobody wants them
+static int mask_field(unsigned char *mask, NG_FIELD *fields, int nf, int at, int len, const char *what)
+{
+	int i;
+
+	for(i=0;i<len;i++) mask[at+i] = XXXX;
+	if(fields == 0) return nf;
+	fields[nf].offset = at;
+	fields[nf].len    = len;
+	fields[nf].what   = what;
+	return nf + 1;
+}
+
+/*
+ * Mask the relocatable operands of one instruction starting at needle offset 'at'
+ *
+ * returns the new number of fields
+ */
+static int mask_inst(const DIS_INST *di, unsigned char *mask, NG_FIELD *fields, int nf, int at)
+{
+	int i, wide = 0;
+
+	// extp/extpr #pag / exts/extsr #seg
+	if(di->raw[0] == 0xd7 && di->len == 4) {
+		return mask_field(mask, fields, nf, at+2, 2, (di->sub & 1) ? "page" : "segment");
+	}
+	for(i=0;i<di->nops;i++) {
+		const DIS_OP *op = &di->op[i];
+
+		switch(op->type) {
+			case MEM:
+				if(!wide++) nf = mask_field(mask, fields, nf, at+2, 2, "mem");
+				break;
+			case DATA16:
+				if(!wide++) nf = mask_field(mask, fields, nf, at+2, 2, "data16");
+				break;
+			case RW_IND_1_DATA16_2:
+				if(!wide++) nf = mask_field(mask, fields, nf, at+2, 2, "[rn+data16]");
+				break;
+			case ADR:
+				if(!wide++) nf = mask_field(mask, fields, nf, at+2, 2, "caddr");
+				break;
+			case SEG:
+				if(op->pos >= 1 && op->pos < di->len) nf = mask_field(mask, fields, nf, at+op->pos, 1, "seg");
+				break;
+			case BITADR:
+				// the bit number halves (pos 3/4) share the bitoff byte of pos 1/2
+				if(di->len == 4 && op->pos >= 3) break;
+				if(op->val < NG_RAM_BITS) nf = mask_field(mask, fields, nf, at+op->pos, 1, "ram bit");
+				break;
+			case BITADR_W2:
+				if(op->val < NG_RAM_BITS) nf = mask_field(mask, fields, nf, at+1, 1, "ram bit");
+				break;
+			case BITADR_W:
+				if(op->val < NG_RAM_BITS) nf = mask_field(mask, fields, nf, at+2, 1, "ram bit");
+				break;
+		}
+	}
+	return nf;
+}
+
+/*
+ * Mask for one instruction (di->len bytes), undefined opcodes are kept whole
+ */
+void needlegen_mask(const DIS_INST *di, unsigned char *mask)
+{
+	memset(mask, MASK, di->len);
+	if((di->flags & DIS_INVALID) == 0) mask_inst(di, mask, 0, 0, 0);
+}
+
+/*
+ * Needle and mask for whole instructions of code (at rom offset adr) until at least min_len
+ * bytes are covered, returns the needle length (0 if nothing decodes)
+ */
+int needlegen_make(const uint8_t *code, unsigned long avail, unsigned long adr, int min_len, unsigned char *needle, unsigned char *mask)
+{
+	DIS_INST di;
+	int len = 0, skip;
+
+	if(min_len > NEEDLEGEN_MAX_BYTES) min_len = NEEDLEGEN_MAX_BYTES;
+	while(len < min_len && (skip = c167x_decode(code + len, avail - len, adr + len, &di)) != 0) {
+		if(len + skip > NEEDLEGEN_MAX_BYTES) break;
+		memcpy(needle + len, di.raw, skip);
+		needlegen_mask(&di, mask + len);
+		len += skip;
+	}
+	return len;
+}
+
+// count the word aligned matches in one rom
+static void search_rom_file(NG_SEARCH *s, NG_ROM *r)
+{
+	ImageHandle ih;
+	int at = 0;
+
+	memset(&ih, 0, sizeof(ih));
+	r->hits = -1;
+	ih.d.p = load_file_ex(r->filename, &ih.len, 0);
+	if(ih.d.p == 0) return;
+
+	r->hits = 0;
+	while((at = search_image(&ih, at, s->needle, s->mask, s->len, 2)) >= 0) {
+		if(r->hits < NEEDLEGEN_SHOW_HITS) r->at[r->hits] = at;
+		r->hits++;
+		at += 2;
+	}
+	free(ih.d.p);
+}
+
+#ifndef NO_THREADS
+static void *search_thread(void *arg)
+{
+	NG_SEARCH *s = (NG_SEARCH *)arg;
+	int i;
+
+	while(1) {
+		pthread_mutex_lock(&s->lock);
+		i = s->next++;
+		pthread_mutex_unlock(&s->lock);
+		if(i >= s->num) break;
+		search_rom_file(s, &s->roms[i]);
+	}
+	return 0;
+}
+#endif
+
+// search every rom, up to NEEDLEGEN_THREADS at once
+static void search_corpus(NG_SEARCH *s)
+{
+#ifndef NO_THREADS
+	pthread_t tid[NEEDLEGEN_THREADS];
+	int i, n = s->num < NEEDLEGEN_THREADS ? s->num : NEEDLEGEN_THREADS, started = 0;
+
+	pthread_mutex_init(&s->lock, 0);
+	for(i=0;i<n;i++) {
+		if(pthread_create(&tid[i], 0, search_thread, s) == 0) started++;
+		else break;
+	}
+	if(started == 0) search_thread(s);		// no threads, search them all here
+	for(i=0;i<started;i++) pthread_join(tid[i], 0);
+	pthread_mutex_destroy(&s->lock);
+#else
+	int i;
+
+	for(i=0;i<s->num;i++) search_rom_file(s, &s->roms[i]);
+#endif
+}
+
+// one needles.c line: bytes (or MASK/XXXX) padded to the comment column, then the disassembly
+static void print_line(OUTBUF *ob, const unsigned char *bytes, const unsigned char *mask, int len, int as_mask, const char *text)
+{
+	size_t line = ob->len;
+	int i;
+
+	ob_putc(ob, '\t');
+	for(i=0;i<len;i++) {
+		if(as_mask)          ob_puts(ob, mask[i] ? "MASK, " : "XXXX, ");
+		else if(mask[i] == 0) ob_puts(ob, "XXXX, ");
+		else                 ob_printf(ob, "0x%02X, ", bytes[i]);
+	}
+	ob->len--;		// no space after the last comma
+	for(i=ob->len - line;i<NEEDLEGEN_COMMENT_COL+1;i++) ob_putc(ob, ' ');
+	ob_printf(ob, "// %s\n", text);
+}
+
+// the pair as it would go into needles.c, one line per instruction
+static void print_pair(OUTBUF *ob, const char *name, const DIS_INST *di, int n, const unsigned char *needle, const unsigned char *mask)
+{
+	OUTBUF text;
+	char **texts;
+	int i, j;
+
+	texts = (char **)calloc(n ? n : 1, sizeof(char *));
+	if(texts == 0) return;
+
+	// disassembly for the comments
+	memset(&text, 0, sizeof(text));
+	text.capture = 1;
+	for(i=0;i<n;i++) {
+		text.len = 0;
+		c167x_format(&text, &di[i]);
+		ob_putc(&text, 0);
+		texts[i] = strdup(text.data + 1);
+	}
+	ob_free(&text);
+
+	ob_printf(ob, "unsigned char needle_%s[] = {\n", name);
+	for(i=0, j=0;i<n;j+=di[i].len, i++) print_line(ob, needle + j, mask + j, di[i].len, 0, texts[i] ? texts[i] : "");
+	ob_printf(ob, "};\n\nunsigned char mask_%s[] = {\n", name);
+	for(i=0, j=0;i<n;j+=di[i].len, i++) print_line(ob, needle + j, mask + j, di[i].len, 1, texts[i] ? texts[i] : "");
+	ob_printf(ob, "};\nunsigned int needle_%s_len = sizeof(needle_%s);\n\n", name, name);
+	for(i=0;i<n;i++) free(texts[i]);
+	free(texts);
+}
+
+/*
+ * Print the needles.c pair for the code at rom offset adr, whole instructions covering at least
+ * min_len bytes (as needlegen_make)
+ */
+void needlegen_print(OUTBUF *ob, const char *name, const uint8_t *code, unsigned long avail, unsigned long adr, int min_len)
+{
+	DIS_INST di[NEEDLEGEN_MAX_BYTES/2];
+	unsigned char needle[NEEDLEGEN_MAX_BYTES], mask[NEEDLEGEN_MAX_BYTES];
+	int n = 0, len = 0, skip;
+
+	if(min_len > NEEDLEGEN_MAX_BYTES) min_len = NEEDLEGEN_MAX_BYTES;
+	while(len < min_len && (skip = c167x_decode(code + len, avail - len, adr + len, &di[n])) != 0) {
+		if(len + skip > NEEDLEGEN_MAX_BYTES) break;
+		memcpy(needle + len, di[n].raw, skip);
+		needlegen_mask(&di[n], mask + len);
+		len += skip;
+		n++;
+	}
+	print_pair(ob, name, di, n, needle, mask);
+}
+
+/*
+ * -mkneedle start-end[:name] : needle for the code at rom offsets start..end (inclusive) of the
+ * first romfile, checked for uniqueness against all of them
+ */
+int check_needlegen(char *spec, char **romfiles, int num)
+{
+	ImageHandle ih;
+	OUTBUF *ob = ob_get();
+	DIS_INST di[NEEDLEGEN_MAX_BYTES/2];
+	NG_FIELD fields[NEEDLEGEN_MAX_BYTES];
+	unsigned char needle[NEEDLEGEN_MAX_BYTES+4], mask[NEEDLEGEN_MAX_BYTES+4];
+	const char *name = "NEW";
+	NG_SEARCH s;
+	unsigned long a, b;
+	char *p = spec, *end;
+	int i, j, n, len = 0, nf = 0, masked = 0, invalid = 0, unique = 0, missing = 0, failed = 0;
+	clock_t start;
+
+	if(spec == 0 || num <= 0) return 0;
+
+	a = strtoul(p, &end, 0) & ~(ROM_1MB_MASK);
+	b = a;
+	if(end != p && *end == '-') {
+		p = end + 1;
+		b = strtoul(p, &end, 0) & ~(ROM_1MB_MASK);
+	}
+	if(end == p || b < a || (*end != 0 && *end != ':')) {
+		con_printf("-mkneedle expects start-end[:name], e.g. 0x6bb2e-0x6bb7f:ZWGRU\n");
+		return 0;
+	}
+	if(*end == ':' && end[1]) name = end + 1;
+	if(b - a + 1 > NEEDLEGEN_MAX_BYTES) {
+		con_printf("-mkneedle range is longer than %d bytes\n", NEEDLEGEN_MAX_BYTES);
+		return 0;
+	}
+
+	con_printf("\n-[ Needle Synthesis ]---------------------------------------------------------------\n\n");
+
+	memset(&ih, 0, sizeof(ih));
+	ih.d.p = load_file_ex(romfiles[0], &ih.len, 0);
+	if(ih.d.p == 0 || a >= ih.len) {
+		con_printf("0x%lx is outside '%s'\n", a, romfiles[0]);
+		free(ih.d.p);
+		return 0;
+	}
+	a &= ~1UL;
+	if(b >= ih.len) b = ih.len - 1;
+
+	// decode whole instructions, the last one may end past 'end'
+	n = c167x_decode_buf(ih.d.u8 + a, ih.len - a, a, di, sizeof(di)/sizeof(DIS_INST));
+	for(i=0;i<n && di[i].adr <= b && len + di[i].len <= NEEDLEGEN_MAX_BYTES;i++) len += di[i].len;
+	n = i;
+
+	for(i=0, j=0;i<n;i++) {
+		memcpy(needle + j, di[i].raw, di[i].len);
+		memset(mask + j, MASK, di[i].len);
+		if(di[i].flags & DIS_INVALID) invalid++;
+		else nf = mask_inst(&di[i], mask, fields, nf, j);
+		j += di[i].len;
+	}
+	for(i=0;i<len;i++) if(mask[i] == XXXX) masked++;
+
+	con_printf(">>> 0x%lx-0x%lx of '%s', %d instructions, %d bytes, %d masked in %d operands\n\n",
+		a, a + len - 1, romfiles[0], n, len, masked, nf);
+	if(invalid) con_printf("warning: %d undefined opcodes in the range, is it code?\n\n", invalid);
+
+	print_pair(ob, name, di, n, needle, mask);
+
+	// where the values the check reads sit relative to the needle
+	ob_puts(ob, "operand offsets:\n");
+	for(i=0;i<nf;i++) {
+		if(fields[i].len == 2) ob_printf(ob, "  +%-4d %-12s 0x%04x\n", fields[i].offset, fields[i].what, get16(needle + fields[i].offset));
+		else                   ob_printf(ob, "  +%-4d %-12s 0x%02x\n", fields[i].offset, fields[i].what, needle[fields[i].offset]);
+	}
+	ob_flush(ob);
+	free(ih.d.p);
+
+	// uniqueness over the corpus
+	memset(&s, 0, sizeof(s));
+	s.needle = needle;
+	s.mask   = mask;
+	s.len    = len;
+	s.num    = num;
+	s.roms   = (NG_ROM *)calloc(num, sizeof(NG_ROM));
+	if(s.roms == 0) return 0;
+	for(i=0;i<num;i++) s.roms[i].filename = romfiles[i];
+
+	start = clock();
+	search_corpus(&s);
+
+	con_printf("\n>>> Searching %d roms\n\n", num);
+	con_printf("  hits  offsets                               rom\n");
+	for(i=0;i<num;i++) {
+		NG_ROM *r = &s.roms[i];
+		size_t line = ob->len;
+
+		if(r->hits < 0) {
+			ob_printf(ob, "  %4s  %-36s  %s\n", "-", "failed to load", r->filename);
+			failed++;
+			continue;
+		}
+		ob_printf(ob, "  %4d  ", r->hits);
+		for(j=0;j<r->hits && j<NEEDLEGEN_SHOW_HITS;j++) ob_printf(ob, "%s0x%lx", j ? "," : "", r->at[j]);
+		if(r->hits > NEEDLEGEN_SHOW_HITS) ob_puts(ob, ",..");
+		for(j=ob->len - line;j<46;j++) ob_putc(ob, ' ');
+		ob_printf(ob, "%s\n", r->filename);
+		if(r->hits == 1) unique++;
+		if(r->hits == 0) missing++;
+	}
+	ob_flush(ob);
+	con_printf("\nunique in %d of %d roms, not found in %d, more than one hit in %d (%.2f ms)\n",
+		unique, num - failed, missing, num - failed - unique - missing, 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC);
+	free(s.roms);
+	return unique;
+}
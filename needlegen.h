@@ -0,0 +1,48 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+#ifndef _NEEDLEGEN_SUPPORT_H
+#define _NEEDLEGEN_SUPPORT_H
+#include "utils.h"
+#include "inst_c16x.h"
+
+// Needle synthesis: turn a range of code in a reference rom into a needle/mask pair in the
+// style of needles.c, with every relocatable operand masked out:
+//
+//   mem operands, #data16 immediates and [Rn+#data16] offsets (addresses and pages),
+//   the segment and caddr of calls/jmps/calla/jmpa, the #page/#seg of extp/exts,
+//   bit addresses in the bit addressable ram (0xFD00-0xFDFF, variables move between builds).
+//
+// Relative jumps, register operands, short constants and SFR bits are kept. The needle is then
+// searched for in every rom of the corpus (one thread per rom) to show whether it is unique.
+
+#define NEEDLEGEN_MAX_BYTES		512		// longest range turned into a needle
+#define NEEDLEGEN_THREADS		8
+#define NEEDLEGEN_SHOW_HITS		4		// offsets listed per rom
+#define NEEDLEGEN_COMMENT_COL	46		// column of the disassembly comment, as in needles.c
+
+void needlegen_mask(const DIS_INST *di, unsigned char *mask);
+int  needlegen_make(const uint8_t *code, unsigned long avail, unsigned long adr, int min_len, unsigned char *needle, unsigned char *mask);
+void needlegen_print(OUTBUF *ob, const char *name, const uint8_t *code, unsigned long avail, unsigned long adr, int min_len);
+int  check_needlegen(char *spec, char **romfiles, int num);
+
+#endif
@@ -0,0 +1,591 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "needlemine.h"
+#include "needlegen.h"
+#include "needles.h"
+#include "inst_c16x.h"
+#include "outbuf.h"
+#include <time.h>
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
+
+#define MINE_MAX_FAMILIES	64			// one bit each in MINE_ROM.missing
+#define MINE_SEED_ROMS		16			// roms per variant the seeds are taken from
+#define MINE_PRIME			16777619U	// FNV-1a
+#define MINE_BASIS			2166136261U
+
+const MINE_NEEDLE mine_needles[] = {
+	{ "main rom regions",     "needle_2",            needle_2,           mask_2,           &needle_2_len           },
+	{ "main rom region count","needle_2b",           needle_2b,          mask_2b,          &needle_2b_len          },
+	{ "main rom checksum",    "needle_3",            needle_3,           mask_3,           &needle_3_len           },
+	{ "main rom checksum",    "needle_3b",           needle_3b,          mask_3b,          &needle_3b_len          },
+	{ "multipoint table",     "needle_4",            needle_4,           mask_4,           &needle_4_len           },
+	{ "multipoint table",     "needle_4aa",          needle_4aa,         mask_4aa,         &needle_4aa_len         },
+	{ "multipoint entries",   "needle_4b",           needle_4b,          mask_4b,          &needle_4b_len          },
+	{ "multipoint entries",   "needle_4c",           needle_4c,          mask_4c,          &needle_4c_len          },
+	{ "seedkey",              "needle_5",            needle_5,           mask_5,           &needle_5_len           },
+	{ "seedkey",              "needle_6",            needle_6,           mask_6,           &needle_6_len           },
+	{ "mlhfm",                "needle_1",            needle_1,           mask_1,           &needle_1_len           },
+	{ "mlhfm",                "needle_1q",           needle_1q,          mask_1q,          &needle_1q_len          },
+	{ "mlhfm",                "needle_mlhfm",        needle_mlhfm,       mask_mlhfm,       &needle_mlhfm_len       },
+	{ "dpp",                  "needle_dpp",          needle_dpp,         mask_dpp,         &needle_dpp_len         },
+	{ "KFAGK",                "KFAGK_needle",        KFAGK_needle,       KFAGK_mask,       &KFAGK_needle_len       },
+	{ "KFAGK",                "KFAGK_needle2",       KFAGK_needle2,      KFAGK_mask2,      &KFAGK_needle2_len      },
+	{ "KFPED",                "KFPED_needle",        KFPED_needle,       KFPED_mask,       &KFPED_needle_len       },
+	{ "SSTB",                 "needle_SSTB",         needle_SSTB,        mask_SSTB,        &needle_SSTB_len        },
+	{ "SSTB2",                "needle_SSTB2",        needle_SSTB2,       mask_SSTB2,       &needle_SSTB2_len       },
+	{ "ZWGRU",                "needle_ZWGRU",        needle_ZWGRU,       mask_ZWGRU,       &needle_ZWGRU_len       },
+	{ "LAMFA",                "needle_LAMFA",        needle_LAMFA,       mask_LAMFA,       &needle_LAMFA_len       },
+	{ "KFKHFM",               "needle_KFKHFM",       needle_KFKHFM,      mask_KFKHFM,      &needle_KFKHFM_len      },
+	{ "KRKTE",                "needle_KRKTE",        needle_KRKTE,       mask_KRKTE,       &needle_KRKTE_len       },
+	{ "CWKONFZ1",             "needle_CWKONFZ1",     needle_CWKONFZ1,    mask_CWKONFZ1,    &needle_CWKONFZ1_len    },
+	{ "CWKONABG",             "needle_CWKONABG",     needle_CWKONABG,    mask_CWKONABG,    &needle_CWKONABG_len    },
+	{ "ESKONF",               "needle_ESKONF",       needle_ESKONF,      mask_ESKONF,      &needle_ESKONF_len      },
+	{ "TVKUP",                "needle_TVKUP",        needle_TVKUP,       mask_TVKUP,       &needle_TVKUP_len       },
+	{ "LRSTPZA",              "needle_LRSTPZA",      needle_LRSTPZA,     mask_LRSTPZA,     &needle_LRSTPZA_len     },
+	{ "BBSAWE",               "needle_BBSAWE",       needle_BBSAWE,      mask_BBSAWE,      &needle_BBSAWE_len      },
+	{ "RKTI",                 "needle_RKTI",         needle_RKTI,        mask_RKTI,        &needle_RKTI_len        },
+	{ "DFFTCNV",              "needle_DFFTCNV",      needle_DFFTCNV,     mask_DFFTCNV,     &needle_DFFTCNV_len     },
+	{ "PROKON",               "needle_PROKON",       needle_PROKON,      mask_PROKON,      &needle_PROKON_len      },
+	{ "DEKON2",               "needle_DEKON2",       needle_DEKON2,      mask_DEKON2,      &needle_DEKON2_len      },
+	{ "NWS",                  "needle_NWS",          needle_NWS,         mask_NWS,         &needle_NWS_len         },
+	{ "SU",                   "needle_SU",           needle_SU,          mask_SU,          &needle_SU_len          },
+	{ "BGMSZS",               "needle_BGMSZS",       needle_BGMSZS,      mask_BGMSZS,      &needle_BGMSZS_len      },
+	{ "FUEDK",                "needle_FUEDK",        needle_FUEDK,       mask_FUEDK,       &needle_FUEDK_len       },
+	{ "crc32",                "crc32_needle",        crc32_needle,       crc32_mask,       &crc32_needle_len       },
+	{ "rom info",             "meinfo_needle",       meinfo_needle,      meinfo_mask,      &meinfo_needle_len      },
+	{ "kwp2000 ecu",          "kwp2000_ecu_needle",  kwp2000_ecu_needle, kwp2000_ecu_mask, &kwp2000_ecu_needle_len },
+};
+#define MINE_NUM_NEEDLES	(int)(sizeof(mine_needles)/sizeof(MINE_NEEDLE))
+const int mine_num_needles = MINE_NUM_NEEDLES;
+
+typedef struct MINE_SEED {
+	uint32_t       hash;				// skeleton hash of MINE_NGRAM instructions
+	unsigned short fam;					// family + 1, 0 is a free slot
+	unsigned short rel;					// offset of the first instruction into the routine
+} MINE_SEED;
+
+typedef struct MINE_VARIANT {
+	uint32_t       hash;				// of the masked needle, equal skeletons are one variant
+	int            roms;
+	int            example;				// lowest rom index it was found in
+	unsigned long  at;
+	int            votes;
+} MINE_VARIANT;
+
+typedef struct MINE_FAMILY {
+	const char    *name;
+	int            variants;
+	int            len;					// of the first variant, the length new ones are cut to
+	int            ngrams;				// fewest seeds one hit produced, 0 if nothing was seeded
+	int            seeded[MINE_NUM_NEEDLES];	// roms seeds were taken from, per variant
+	int            hit, missed, mined, dropped;
+	int            nv;
+	MINE_VARIANT   v[MINE_MAX_VARIANTS];
+} MINE_FAMILY;
+
+typedef struct MINE_ROM {
+	char               *filename;
+	int                 failed;
+	unsigned long long  missing;		// families none of whose variants hit
+} MINE_ROM;
+
+typedef struct MINE {
+	MINE_ROM      *roms;
+	int            num, size;
+	int            next;				// next rom for a worker
+	int            pass;
+	int            fam_of[MINE_NUM_NEEDLES];
+	MINE_FAMILY    fam[MINE_MAX_FAMILIES];
+	int            nfam;
+	MINE_SEED      seeds[MINE_SEED_SLOTS];
+	int            nseeds, seeds_full;
+	uint32_t       bk;					// MINE_PRIME^(MINE_NGRAM-1), drops the oldest skeleton
+#ifndef NO_THREADS
+	pthread_mutex_t lock;
+#endif
+} MINE;
+
+// the last MINE_NGRAM skeletons of a sweep and their rolling hash
+typedef struct MINE_ROLL {
+	uint32_t       s[MINE_NGRAM];
+	unsigned long  at[MINE_NGRAM];
+	int            n;
+	uint32_t       h;
+} MINE_ROLL;
+
+typedef struct MINE_START {
+	unsigned long  at;
+	int            votes;
+} MINE_START;
+
+// starts voted for of one family, only those the sweep could still vote for are kept
+typedef struct MINE_VOTES {
+	MINE_START     s[MINE_MAX_STARTS];
+	int            n;
+	MINE_START     best;				// most votes of the retired ones
+} MINE_VOTES;
+
+static void mine_lock(MINE *m)
+{
+#ifndef NO_THREADS
+	pthread_mutex_lock(&m->lock);
+#endif
+}
+
+static void mine_unlock(MINE *m)
+{
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&m->lock);
+#endif
+}
+
+// opcode skeleton of one instruction: its bytes with the relocatable operands masked
+static uint32_t skeleton(const DIS_INST *di)
+{
+	unsigned char mask[4];
+	uint32_t h = MINE_BASIS ^ di->len;
+	int i;
+
+	needlegen_mask(di, mask);
+	for(i=0;i<di->len;i++) h = (h ^ (di->raw[i] & mask[i]) ^ (mask[i] ? 0 : 0x100)) * MINE_PRIME;
+	return h;
+}
+
+// add a skeleton, returns 1 once the window holds MINE_NGRAM of them (r->at[r->n % MINE_NGRAM] is its start)
+static int roll_push(MINE_ROLL *r, uint32_t s, unsigned long at, uint32_t bk)
+{
+	int i = r->n % MINE_NGRAM;
+
+	if(r->n >= MINE_NGRAM) r->h -= r->s[i] * bk;
+	r->h = r->h * MINE_PRIME + s;
+	r->s[i]  = s;
+	r->at[i] = at;
+	r->n++;
+	return r->n >= MINE_NGRAM;
+}
+
+// called with the lock held
+static void add_seed(MINE *m, uint32_t hash, int fam, int rel)
+{
+	int i, j;
+
+	for(i=0;i<MINE_SEED_SLOTS;i++) {
+		MINE_SEED *s = &m->seeds[(hash + i) & (MINE_SEED_SLOTS-1)];
+
+		if(s->fam == 0) {
+			// keep a quarter free so lookups stay short
+			if(m->nseeds >= MINE_SEED_SLOTS - MINE_SEED_SLOTS/4) {
+				m->seeds_full++;
+				return;
+			}
+			s->hash = hash;
+			s->fam  = fam + 1;
+			s->rel  = rel;
+			m->nseeds++;
+			return;
+		}
+		j = s->fam - 1;
+		if(s->hash == hash && j == fam && s->rel == rel) return;
+	}
+}
+
+/*
+ * Pass 1: which families the rom has, seeds from the code under the variants that hit
+ */
+static void seed_rom(MINE *m, MINE_ROM *r)
+{
+	ImageHandle ih;
+	DIS_INST di;
+	MINE_ROLL roll;
+	MINE_SEED seeds[NEEDLEGEN_MAX_BYTES/2];
+	unsigned long long hit = 0;
+	unsigned long adr;
+	int i, j, n, at, fam, len, skip;
+
+	memset(&ih, 0, sizeof(ih));
+	ih.d.p = load_file_ex(r->filename, &ih.len, 0);
+	if(ih.d.p == 0) {
+		r->failed = 1;
+		return;
+	}
+
+	for(i=0;i<MINE_NUM_NEEDLES;i++) {
+		fam = m->fam_of[i];
+		len = *mine_needles[i].len;
+		at  = search_image(&ih, 0, mine_needles[i].needle, mine_needles[i].mask, len, 2);
+		if(at < 0) continue;
+		hit |= 1ULL << fam;
+
+		// hash the runs of instructions inside the hit
+		memset(&roll, 0, sizeof(roll));
+		n = 0;
+		for(adr=at;adr<(unsigned long)at+len && n<(int)(sizeof(seeds)/sizeof(MINE_SEED));adr+=skip) {
+			skip = c167x_decode(ih.d.u8 + adr, ih.len - adr, adr, &di);
+			if(skip == 0 || adr + skip > (unsigned long)at + len) break;
+			if(roll_push(&roll, skeleton(&di), adr, m->bk)) {
+				seeds[n].hash = roll.h;
+				seeds[n].rel  = roll.at[roll.n % MINE_NGRAM] - at;
+				n++;
+			}
+		}
+
+		mine_lock(m);
+		if(m->fam[fam].seeded[i]++ < MINE_SEED_ROMS) {
+			for(j=0;j<n;j++) add_seed(m, seeds[j].hash, fam, seeds[j].rel);
+			if(n && (m->fam[fam].ngrams == 0 || n < m->fam[fam].ngrams)) m->fam[fam].ngrams = n;
+		}
+		mine_unlock(m);
+	}
+	r->missing = ((m->nfam < 64 ? (1ULL << m->nfam) : 0) - 1) & ~hit;
+	free(ih.d.p);
+}
+
+// keep the best of the starts more than len bytes behind the sweep at w, all of them if w is 0
+static void retire(MINE_VOTES *v, unsigned long w, int len)
+{
+	int i;
+
+	for(i=0;i<v->n;) {
+		if(w && v->s[i].at + len > w) {
+			i++;
+			continue;
+		}
+		if(v->s[i].votes > v->best.votes || (v->s[i].votes == v->best.votes && v->s[i].at < v->best.at)) v->best = v->s[i];
+		v->s[i] = v->s[--v->n];
+	}
+}
+
+// a vote for the routine starting at 'at', from the run at w
+static void vote(MINE_VOTES *v, unsigned long at, unsigned long w, int len)
+{
+	int i, low = 0;
+
+	retire(v, w, len);
+	for(i=0;i<v->n;i++) {
+		if(v->s[i].at == at) {
+			v->s[i].votes++;
+			return;
+		}
+		if(v->s[i].votes < v->s[low].votes) low = i;
+	}
+	if(v->n < MINE_MAX_STARTS) i = v->n++;
+	else if(v->s[low].votes <= 1) i = low;		// full, replace a single stray vote
+	else return;
+	v->s[i].at    = at;
+	v->s[i].votes = 1;
+}
+
+/*
+ * Pass 2: sweep a rom missing some families and look every run of skeletons up in the seeds
+ */
+static void mine_rom(MINE *m, MINE_ROM *r)
+{
+	ImageHandle ih;
+	DIS_INST di;
+	MINE_ROLL roll;
+	MINE_VOTES *votes;
+	unsigned char needle[NEEDLEGEN_MAX_BYTES], mask[NEEDLEGEN_MAX_BYTES];
+	unsigned long adr, w;
+	unsigned long long missing = 0;
+	uint32_t h;
+	int i, j, skip, len, need;
+
+	// only the families something was seeded for can be mined
+	for(i=0;i<m->nfam;i++) if(m->fam[i].ngrams) missing |= 1ULL << i;
+	missing &= r->missing;
+	if(missing == 0 || r->failed) return;
+
+	memset(&ih, 0, sizeof(ih));
+	ih.d.p = load_file_ex(r->filename, &ih.len, 0);
+	votes = (MINE_VOTES *)calloc(m->nfam, sizeof(MINE_VOTES));
+	if(ih.d.p == 0 || votes == 0) {
+		free(ih.d.p);
+		free(votes);
+		return;
+	}
+
+	memset(&roll, 0, sizeof(roll));
+	for(adr=0;adr+2<=ih.len;adr+=skip) {
+		skip = c167x_decode(ih.d.u8 + adr, ih.len - adr, adr, &di);
+		if(skip == 0) break;
+		if(!roll_push(&roll, skeleton(&di), adr, m->bk)) continue;
+
+		h = roll.h;
+		w = roll.at[roll.n % MINE_NGRAM];
+		for(i=0;i<MINE_SEED_SLOTS;i++) {
+			const MINE_SEED *s = &m->seeds[(h + i) & (MINE_SEED_SLOTS-1)];
+
+			if(s->fam == 0) break;
+			if(s->hash != h || (missing & (1ULL << (s->fam-1))) == 0 || w < s->rel) continue;
+			vote(&votes[s->fam-1], w - s->rel, w, m->fam[s->fam-1].len);
+		}
+	}
+
+	for(i=0;i<m->nfam;i++) {
+		MINE_FAMILY *f = &m->fam[i];
+		MINE_VARIANT *v = 0;
+		uint32_t hash = MINE_BASIS;
+
+		if((missing & (1ULL << i)) == 0) continue;
+		retire(&votes[i], 0, f->len);
+
+		// a third of the runs of the shortest hit must be there
+		need = (f->ngrams + 2) / 3;
+		if(need < 2) need = 2;
+		if(votes[i].best.votes < need) continue;
+
+		adr = votes[i].best.at;
+		len = needlegen_make(ih.d.u8 + adr, ih.len - adr, adr, f->len, needle, mask);
+		if(len == 0) continue;
+		for(j=0;j<len;j++) hash = (hash ^ (needle[j] & mask[j]) ^ (mask[j] ? 0 : 0x100)) * MINE_PRIME;
+
+		mine_lock(m);
+		f->mined++;
+		for(j=0;j<f->nv;j++) if(f->v[j].hash == hash) v = &f->v[j];
+		if(v == 0 && f->nv < MINE_MAX_VARIANTS) {
+			v = &f->v[f->nv++];
+			memset(v, 0, sizeof(MINE_VARIANT));
+			v->hash    = hash;
+			v->example = -1;
+		}
+		if(v == 0) {
+			f->dropped++;
+		} else {
+			v->roms++;
+			if(v->example < 0 || r - m->roms < v->example) {
+				v->example = r - m->roms;
+				v->at      = adr;
+				v->votes   = votes[i].best.votes;
+			}
+		}
+		mine_unlock(m);
+	}
+	free(votes);
+	free(ih.d.p);
+}
+
+static void mine_next(MINE *m)
+{
+	int i;
+
+	while(1) {
+		mine_lock(m);
+		i = m->next++;
+		mine_unlock(m);
+		if(i >= m->num) break;
+		if(m->pass == 1) seed_rom(m, &m->roms[i]);
+		else             mine_rom(m, &m->roms[i]);
+	}
+}
+
+#ifndef NO_THREADS
+static void *mine_thread(void *arg)
+{
+	mine_next((MINE *)arg);
+	return 0;
+}
+#endif
+
+// run one pass over every rom, up to MINE_THREADS at once
+static void mine_pass(MINE *m, int pass)
+{
+#ifndef NO_THREADS
+	pthread_t tid[MINE_THREADS];
+	int i, started = 0;
+#endif
+
+	m->pass = pass;
+	m->next = 0;
+#ifndef NO_THREADS
+	for(i=0;i<MINE_THREADS && i<m->num;i++) {
+		if(pthread_create(&tid[i], 0, mine_thread, m) == 0) started++;
+		else break;
+	}
+	if(started == 0) mine_next(m);		// no threads, do them all here
+	for(i=0;i<started;i++) pthread_join(tid[i], 0);
+#else
+	mine_next(m);
+#endif
+}
+
+// collect the files that could be roms, following sub directories
+static void add_dir(MINE *m, const char *dirname, int depth)
+{
+	DIR *dir;
+	struct dirent *de;
+	struct stat st;
+	char *path;
+	MINE_ROM *roms;
+
+	if(depth > MINE_MAX_DEPTH || (dir = opendir(dirname)) == 0) return;
+	while((de = readdir(dir)) != 0) {
+		if(de->d_name[0] == '.') continue;
+		path = (char *)malloc(strlen(dirname) + strlen(de->d_name) + 2);
+		if(path == 0) break;
+		sprintf(path, "%s/%s", dirname, de->d_name);
+		if(stat(path, &st) != 0) {
+			free(path);
+			continue;
+		}
+		if(S_ISDIR(st.st_mode)) {
+			add_dir(m, path, depth + 1);
+			free(path);
+			continue;
+		}
+		if(!S_ISREG(st.st_mode) || st.st_size < MINE_MIN_ROM || st.st_size > MINE_MAX_ROM) {
+			free(path);
+			continue;
+		}
+		if(m->num == m->size) {
+			roms = (MINE_ROM *)realloc(m->roms, (m->size ? m->size*2 : 64) * sizeof(MINE_ROM));
+			if(roms == 0) {
+				free(path);
+				break;
+			}
+			m->roms = roms;
+			m->size = m->size ? m->size*2 : 64;
+		}
+		memset(&m->roms[m->num], 0, sizeof(MINE_ROM));
+		m->roms[m->num++].filename = path;
+	}
+	closedir(dir);
+}
+
+static int cmp_rom(const void *a, const void *b)
+{
+	return strcmp(((const MINE_ROM *)a)->filename, ((const MINE_ROM *)b)->filename);
+}
+
+// ZWGRU_mined1, main_rom_regions_mined2, ..
+static void variant_name(char *name, int size, const char *family, int k)
+{
+	int i;
+
+	snprintf(name, size, "%s_mined%d", family, k);
+	for(i=0;name[i];i++) if(name[i] == ' ') name[i] = '_';
+}
+
+/*
+ * -mine <dir> : propose new variants of the built in needles from every rom under dir
+ */
+int check_needlemine(char *dirname)
+{
+	OUTBUF *ob = ob_get();
+	ImageHandle ih;
+	MINE *m;
+	char name[64];
+	int i, j, failed = 0, found = 0;
+	clock_t start;
+
+	if(dirname == 0) return 0;
+	m = (MINE *)calloc(1, sizeof(MINE));
+	if(m == 0) return 0;
+
+	con_printf("\n-[ Needle Variant Mining ]----------------------------------------------------------\n\n");
+
+	// families, in table order
+	for(i=0;i<MINE_NUM_NEEDLES;i++) {
+		for(j=0;j<m->nfam && strcmp(m->fam[j].name, mine_needles[i].family);j++);
+		if(j == m->nfam) {
+			if(m->nfam == MINE_MAX_FAMILIES) break;
+			m->fam[j].name = mine_needles[i].family;
+			m->fam[j].len  = *mine_needles[i].len;
+			m->nfam++;
+		}
+		m->fam_of[i] = j;
+		m->fam[j].variants++;
+	}
+	for(m->bk=1, i=1;i<MINE_NGRAM;i++) m->bk *= MINE_PRIME;
+
+	add_dir(m, dirname, 0);
+	if(m->num == 0) {
+		con_printf("no roms (%d-%dKb files) under '%s'\n", MINE_MIN_ROM/1024, MINE_MAX_ROM/1024, dirname);
+		free(m->roms);
+		free(m);
+		return 0;
+	}
+	qsort(m->roms, m->num, sizeof(MINE_ROM), cmp_rom);
+
+	start = clock();
+#ifndef NO_THREADS
+	pthread_mutex_init(&m->lock, 0);
+#endif
+	mine_pass(m, 1);
+	mine_pass(m, 2);
+#ifndef NO_THREADS
+	pthread_mutex_destroy(&m->lock);
+#endif
+
+	for(i=0;i<m->num;i++) {
+		if(m->roms[i].failed) {
+			failed++;
+			continue;
+		}
+		for(j=0;j<m->nfam;j++) {
+			if(m->roms[i].missing & (1ULL << j)) m->fam[j].missed++;
+			else                                 m->fam[j].hit++;
+		}
+	}
+
+	con_printf(">>> %d roms under '%s' (%d failed to load), %d needles in %d families, %d seeds of %d instructions%s (%.2f ms)\n\n",
+		m->num, dirname, failed, MINE_NUM_NEEDLES, m->nfam, m->nseeds, MINE_NGRAM,
+		m->seeds_full ? ", seed table full" : "", 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC);
+
+	ob_printf(ob, "  %-24s %8s %6s %6s %6s %6s %4s\n", "family", "variants", "runs", "hit", "missed", "mined", "new");
+	ob_printf(ob, "  %-24s %8s %6s %6s %6s %6s %4s\n", "------", "--------", "----", "---", "------", "-----", "---");
+	for(i=0;i<m->nfam;i++) {
+		MINE_FAMILY *f = &m->fam[i];
+
+		ob_printf(ob, "  %-24s %8d %6d %6d %6d %6d %4d%s\n", f->name, f->variants, f->ngrams, f->hit, f->missed, f->mined, f->nv,
+			f->dropped ? " (more not kept)" : "");
+		found += f->nv;
+	}
+	ob_flush(ob);
+
+	// each new variant as a needles.c pair, cut from the first rom it was found in
+	for(i=0;i<m->nfam;i++) {
+		MINE_FAMILY *f = &m->fam[i];
+
+		for(j=0;j<f->nv;j++) {
+			MINE_VARIANT *v = &f->v[j];
+
+			memset(&ih, 0, sizeof(ih));
+			ih.d.p = load_file_ex(m->roms[v->example].filename, &ih.len, 0);
+			if(ih.d.p == 0) continue;
+
+			variant_name(name, sizeof(name), f->name, j+1);
+			ob_printf(ob, "\n>>> %s: new variant in %d rom%s, e.g. 0x%lx of '%s' (%d of %d runs matched)\n\n",
+				f->name, v->roms, v->roms == 1 ? "" : "s", v->at, m->roms[v->example].filename, v->votes, f->ngrams);
+			needlegen_print(ob, name, ih.d.u8 + v->at, ih.len - v->at, v->at, f->len);
+			ob_flush(ob);
+			free(ih.d.p);
+		}
+	}
+	if(found == 0) con_printf("\nno new variants, every rom that has a family's routine is found by its needles\n");
+
+	for(i=0;i<m->num;i++) free(m->roms[i].filename);
+	free(m->roms);
+	free(m);
+	return found;
+}
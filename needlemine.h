@@ -0,0 +1,64 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+#ifndef _NEEDLEMINE_SUPPORT_H
+#define _NEEDLEMINE_SUPPORT_H
+#include "utils.h"
+
+// Needle variant mining: every built in needle belongs to a family of variants that find the same
+// routine (needle_3/needle_3b, needle_4b/needle_4c, needle_5/needle_6, KFAGK_needle/KFAGK_needle2..).
+// Over a directory of roms:
+//
+//   pass 1  search each variant, from the code under the first hit hash every run of MINE_NGRAM
+//           instructions with their relocatable operands masked (the opcode skeleton) into a seed
+//           table of (hash, family, offset into the routine), and note which families each rom misses
+//   pass 2  for the roms missing a family, a rolling hash over the skeletons of a linear sweep of
+//           the whole rom is looked up in the seed table, every match votes for where the routine
+//           would start. Enough votes make a candidate, candidates with the same skeleton are one
+//           cluster, and every cluster is a proposed new variant.
+//
+// Only MINE_THREADS roms are held in memory at once, the seed and cluster tables are fixed size,
+// so the corpus can be thousands of roms.
+
+#define MINE_THREADS		8
+#define MINE_NGRAM			4			// instructions per hashed run
+#define MINE_SEED_SLOTS		8192		// seed table size (power of 2)
+#define MINE_MAX_STARTS		64			// candidate starts one family can have in the sweep window
+#define MINE_MAX_VARIANTS	8			// new variants kept per family
+#define MINE_MAX_DEPTH		8			// sub directories followed
+#define MINE_MIN_ROM		(256*1024)	// files outside these sizes are not roms
+#define MINE_MAX_ROM		(1024*1024)
+
+typedef struct MINE_NEEDLE {
+	const char          *family;		// routine name, variants of one routine are listed together
+	const char          *name;
+	const unsigned char *needle;
+	const unsigned char *mask;
+	const unsigned int  *len;
+} MINE_NEEDLE;
+
+extern const MINE_NEEDLE mine_needles[];	// every built in needle that finds a routine
+extern const int         mine_num_needles;
+
+int  check_needlemine(char *dirname);
+
+#endif
@@ -2009,7 +2009,7 @@ unsigned int mapfinder_needle_len = sizeof(mapfinder_needle);
 const unsigned char mapfinder_mask[] = {
  MASK, MASK, XXXX, XXXX,  // mov     r12, #(MAP_X_NUM - ROM_MAP_REGION_818000)   <--- * This is the MAP XXX
  MASK, MASK, XXXX, XXXX,  // mov     r13, #XXXXh
- MASK, MASK, XXXX, XXXX,  // movbz   r14, XXXX		// x-axis
+ 0xCF, MASK, XXXX, XXXX,  // movbz   r14, XXXX		// x-axis, 0xC2 movbz (byte input) and 0xF2 mov (word input) both match
 // MASK, MASK, XXXX, XXXX,  // movbz   r15, XXXX		// y-axis
  MASK, XXXX, XXXX, XXXX,  // calls   XXXXh, Lookup_Table_Data ; References a lookup tableAE
 };
@@ -2082,14 +2082,14 @@ const unsigned char mapfinder_xy2_mask[] = {
  MASK, XXXX, XXXX, XXXX,  // calls   XXXXh, XXXX_Lookup_func	; do the lookup
 };
 
-
+// 2D map with its own page (r13) or group map (r13 = axis), usually followed by a mov word_XXXX, r4
+// but not always (e.g. the KFZW lookups in ZWGRU use the result straight away)
 const unsigned char mapfinder_xy_needle[] = {
  0xE6, 0xFC, XXXX, XXXX,  // mov     r12, #(MAP_X_NUM - ROM_MAP_REGION_818000)   <--- * This is the MAP XXX
  0xE6, 0xFD, XXXX, XXXX,  // mov     r13, #XXXXh
  0xF2, 0xFE, XXXX, XXXX,  // mov     r14, word_XXXX
  0xF2, 0xFF, XXXX, XXXX,  // mov     r14, word_XXXX
  0xDA, XXXX, XXXX, XXXX,  // calls   XXXXh, Lookup_Table_Data ; References a lookup tableAE
- 0xF6, 0xF4, XXXX, XXXX,  // mov     word_XXXX, r4
 };
 unsigned int mapfinder_xy_needle_len = sizeof(mapfinder_xy_needle);
 
@@ -2097,9 +2097,78 @@ unsigned int mapfinder_xy_needle_len = sizeof(mapfinder_xy_needle);
 const unsigned char mapfinder_xy_mask[] = {
  MASK, MASK, XXXX, XXXX,  // mov     r12, #(MAP_X_NUM - ROM_MAP_REGION_818000)   <--- * This is the MAP XXX
  MASK, MASK, XXXX, XXXX,  // mov     r13, #XXXXh
- MASK, MASK, XXXX, XXXX,  // mov     r14, word_XXXX		// x-axis
- MASK, MASK, XXXX, XXXX,  // mov     r15, word_XXXX		// x-axis
+ 0xCF, MASK, XXXX, XXXX,  // mov     r14, word_XXXX		// x-axis, 0xC2 movbz (byte input) and 0xF2 mov (word input) both match
+ 0xCF, MASK, XXXX, XXXX,  // mov     r15, word_XXXX		// y-axis
  MASK, XXXX, XXXX, XXXX,  // calls   XXXXh, Lookup_Table_Data ; References a lookup tableAE
+};
+
+// 2D map with its own header (x_num, y_num, x-axis, y-axis, cells) near the map segment,
+// the x input already in a register (e.g. KFWDKMSN)
+const unsigned char mapfinder_xy4_needle[] = {
+ 0xE6, 0xFC, XXXX, XXXX,  // mov     r12, #XXXX_X_NUM		; header                    [+2]
+ 0xF0, 0xD0,              // mov     r13, rX				; x input
+ 0xF2, 0xFE, XXXX, XXXX,  // mov     r14, word_XXXX			; y input                   [+6]
+ 0xDA, XXXX, XXXX, XXXX,  // calls   XXXXh, Lookup_Table_Data
+};
+unsigned int mapfinder_xy4_needle_len = sizeof(mapfinder_xy4_needle);
+
+const unsigned char mapfinder_xy4_mask[] = {
+ MASK, MASK, XXXX, XXXX,  // mov     r12, #XXXX_X_NUM
+ MASK, 0xF0,              // mov     r13, rX
+ 0xCF, MASK, XXXX, XXXX,  // mov     r14, word_XXXX			; 0xC2 movbz and 0xF2 mov both match
+ MASK, XXXX, XXXX, XXXX,  // calls   XXXXh, Lookup_Table_Data
+};
+
+// bounds checked index into a word array in the map segment (e.g. MLHFM), the register
+// compared is the one indexed
+const unsigned char mapfinder_index_needle[] = {
+ 0x46, 0xF0, XXXX, XXXX,  // cmp     rX, #XXXX				; number of values          [+2]
+ 0x9D, XXXX,              // jmpr    cc_NC, clamp
+ 0xF0, 0x40,              // mov     r4, rX
+ 0x5C, 0x14,              // shl     r4, #1
+ 0xD4, 0x04, XXXX, XXXX,  // mov     rY, [r4+#XXXX_ARRAY]	; values                    [+12]
+};
+unsigned int mapfinder_index_needle_len = sizeof(mapfinder_index_needle);
+
+const unsigned char mapfinder_index_mask[] = {
+ MASK, 0xF0, XXXX, XXXX,  // cmp     rX, #XXXX
+ MASK, XXXX,              // jmpr    cc_NC, clamp
+ MASK, 0xF0,              // mov     r4, rX
+ MASK, MASK,              // shl     r4, #1
+ MASK, 0x0F, XXXX, XXXX,  // mov     rY, [r4+#XXXX_ARRAY]
+};
+
+// shared axis distribution (e.g. SNM16ZUUB) in the map segment, the input is either
+// a byte (movbz r13) or a word (mov r13), the result is the index the group maps use
+const unsigned char mapfinder_axis_needle[] = {
+ 0xE6, 0xFC, XXXX, XXXX,  // mov     r12, #XXXX_AXIS		; axis (x_num, x-axis)      [+2]
+ 0xC2, 0xFD, XXXX, XXXX,  // movbz   r13, XXXX				; input (or mov r13, word)  [+6]
+ 0xF2, 0xFE, XXXX, XXXX,  // mov     r14, word_XXXX			; previous result           [+10]
+ 0xDA, XXXX, XXXX, XXXX,  // calls   XXXXh, Axis_Distribution_XXXX
+ 0xF6, 0xF4, XXXX, XXXX,  // mov     word_XXXX, r4			; result                    [+18]
+};
+unsigned int mapfinder_axis_needle_len = sizeof(mapfinder_axis_needle);
+
+const unsigned char mapfinder_axis_mask[] = {
+ MASK, MASK, XXXX, XXXX,  // mov     r12, #XXXX_AXIS
+ 0xCF, MASK, XXXX, XXXX,  // movbz   r13, XXXX				; 0xC2 movbz and 0xF2 mov both match
+ MASK, MASK, XXXX, XXXX,  // mov     r14, word_XXXX
+ MASK, XXXX, XXXX, XXXX,  // calls   XXXXh, Axis_Distribution_XXXX
+ MASK, MASK, XXXX, XXXX,  // mov     word_XXXX, r4
+};
+
+const unsigned char mapfinder_axis2_needle[] = {
+ 0xE6, 0xFC, XXXX, XXXX,  // mov     r12, #XXXX_AXIS		; axis (x_num, x-axis)      [+2]
+ 0xC2, 0xFD, XXXX, XXXX,  // movbz   r13, XXXX				; input (or mov r13, word)  [+6]
+ 0xDA, XXXX, XXXX, XXXX,  // calls   XXXXh, Axis_Distribution_XXXX
+ 0xF6, 0xF4, XXXX, XXXX,  // mov     word_XXXX, r4			; result                    [+14]
+};
+unsigned int mapfinder_axis2_needle_len = sizeof(mapfinder_axis2_needle);
+
+const unsigned char mapfinder_axis2_mask[] = {
+ MASK, MASK, XXXX, XXXX,  // mov     r12, #XXXX_AXIS
+ 0xCF, MASK, XXXX, XXXX,  // movbz   r13, XXXX				; 0xC2 movbz and 0xF2 mov both match
+ MASK, XXXX, XXXX, XXXX,  // calls   XXXXh, Axis_Distribution_XXXX
  MASK, MASK, XXXX, XXXX,  // mov     word_XXXX, r4
 };
 
@@ -204,6 +204,26 @@ const unsigned char mapfinder_xy3_needle[];
 const unsigned char mapfinder_xy3_mask[];
 extern unsigned int mapfinder_xy3_needle_len;
 
+extern const unsigned char mapfinder_xy_needle[];
+extern const unsigned char mapfinder_xy_mask[];
+extern unsigned int mapfinder_xy_needle_len;
+
+extern const unsigned char mapfinder_xy4_needle[];
+extern const unsigned char mapfinder_xy4_mask[];
+extern unsigned int mapfinder_xy4_needle_len;
+
+extern const unsigned char mapfinder_index_needle[];
+extern const unsigned char mapfinder_index_mask[];
+extern unsigned int mapfinder_index_needle_len;
+
+extern const unsigned char mapfinder_axis_needle[];
+extern const unsigned char mapfinder_axis_mask[];
+extern unsigned int mapfinder_axis_needle_len;
+
+extern const unsigned char mapfinder_axis2_needle[];
+extern const unsigned char mapfinder_axis2_mask[];
+extern unsigned int mapfinder_axis2_needle_len;
+
 extern const unsigned char crc32_needle[];
 extern const unsigned char crc32_mask[];
 extern unsigned int crc32_needle_len;
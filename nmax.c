@@ -22,6 +22,8 @@
 #include "nmax.h"
 #include "table_spec.h"
 #include "show_tables.h"
+#include "export.h"
+#include "dpptrack.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -35,23 +37,25 @@ int check_nmax(ImageHandle *fh, int skip)
 	unsigned int nmax;
 	if(skip == 0) return found;		
 
-	printf("\n-[ NMAX Rev limiter]-----------------\n\n");
-	printf(">>> Scanning for NMAX Lookup code sequence... \n");
+	con_printf("\n-[ NMAX Rev limiter]-----------------\n\n");
+	con_printf(">>> Scanning for NMAX Lookup code sequence... \n");
 	/* search: *** Find NMAX Value by searching for correct function code byte sequence */
 	byte_offset    = search_offset( rom_load_addr, fh->len, (unsigned char *)&needle_DFFTCNV, (unsigned char *)&mask_DFFTCNV, needle_DFFTCNV_len);
 	if(byte_offset != 0) 
 	{
 		addr = rom_load_addr + byte_offset;
-		printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
+		con_printf("\nfound needle at offset=%#x\n",(int)(byte_offset));
 
 		// disassemble needle found in rom
 		if(show_diss) { c167x_diss(byte_offset, rom_load_addr + byte_offset, needle_DFFTCNV_len+16); }
 
-		translate_seg(&_nmax, "NMAX", rom_load_addr, dpp1_value-1 /*seg*/, get16((unsigned char *)addr+30) /*val*/);
+		translate_seg(&_nmax, "NMAX", rom_load_addr, dpp_seg_at(fh, (unsigned char *)addr+30) /*seg*/, get16((unsigned char *)addr+30) /*val*/);
 		show_seg(&_nmax);
 		
-		printf("\nNMAX:  %-4.4d rpm (u/min) limit\n", (get16(_nmax.ram))/4);
-		printf("NMAXH:  %d rpm (u/min) hysteresis for hard speed limitation\n", (get16(_nmax.ram-2))/4);
+		con_printf("\nNMAX:  %-4.4d rpm (u/min) limit\n", (get16(_nmax.ram))/4);
+		con_printf("NMAXH:  %d rpm (u/min) hysteresis for hard speed limitation\n", (get16(_nmax.ram-2))/4);
+		export_scalar("NMAX",  "Rev limiter", (unsigned long)_nmax.rom, get16(_nmax.ram), (get16(_nmax.ram))/4, "rpm");
+		export_scalar("NMAXH", "Hysteresis for hard speed limitation", (unsigned long)_nmax.rom-2, get16(_nmax.ram-2), (get16(_nmax.ram-2))/4, "rpm");
 	}
 
 	return found;
@@ -0,0 +1,351 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include "outbuf.h"
+
+static OB_THREAD OUTBUF thread_ob;
+
+static const char hex_lc[] = "0123456789abcdef";
+static const char hex_uc[] = "0123456789ABCDEF";
+
+static const double pow10_d[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+static const unsigned long long pow10_u[10] = { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL };
+
+// a single printf conversion with literal text either side of it
+typedef struct FMT_SPEC {
+	const char *pre;
+	int  pre_len;
+	const char *post;
+	int  left, alt, zero, plus, space, is_long;
+	int  width, prec;
+	char conv;
+} FMT_SPEC;
+
+/*
+ * Return the calling thread's output buffer (flushes to stdout)
+ */
+OUTBUF *ob_get(void)
+{
+	if(thread_ob.fp == 0) thread_ob.fp = stdout;
+	return &thread_ob;
+}
+
+void ob_flush(OUTBUF *ob)
+{
+	if(ob->len && ob->capture == 0) {
+		fwrite(ob->data, 1, ob->len, ob->fp ? ob->fp : stdout);
+		ob->len = 0;
+	}
+}
+
+void ob_free(OUTBUF *ob)
+{
+	ob_flush(ob);
+	free(ob->data);
+	ob->data = 0;
+	ob->size = 0;
+}
+
+// make room for n more bytes, returns 0 if the buffer could not grow
+static int ob_reserve(OUTBUF *ob, size_t n)
+{
+	size_t size;
+	char *p;
+
+	if(ob->len + n <= ob->size) return 1;
+
+	size = ob->size ? ob->size : OUTBUF_INITIAL_SIZE;
+	while(size < ob->len + n) size *= 2;
+
+	p = realloc(ob->data, size);
+	if(p == 0) return 0;
+	ob->data = p;
+	ob->size = size;
+	return 1;
+}
+
+void ob_write(OUTBUF *ob, const char *s, size_t n)
+{
+	if(!ob_reserve(ob, n)) {
+		// out of memory, fall back to writing straight through
+		ob_flush(ob);
+		fwrite(s, 1, n, ob->fp ? ob->fp : stdout);
+		return;
+	}
+	memcpy(ob->data + ob->len, s, n);
+	ob->len += n;
+}
+
+void ob_puts(OUTBUF *ob, const char *s)
+{
+	ob_write(ob, s, strlen(s));
+}
+
+void ob_putc(OUTBUF *ob, char c)
+{
+	if(ob->len < ob->size) {
+		ob->data[ob->len++] = c;
+	} else {
+		ob_write(ob, &c, 1);
+	}
+}
+
+/*
+ * Write val as exactly 'digits' lower case hex digits (zero padded)
+ */
+void ob_hex(OUTBUF *ob, unsigned long val, int digits)
+{
+	char tmp[2*sizeof(unsigned long)];
+	int i;
+
+	if(digits > (int)sizeof(tmp)) digits = sizeof(tmp);
+	for(i=digits-1;i>=0;i--) {
+		tmp[i] = hex_lc[val & 0xf];
+		val >>= 4;
+	}
+	ob_write(ob, tmp, digits);
+}
+
+void ob_vprintf(OUTBUF *ob, const char *fmt, va_list ap)
+{
+	va_list ap2;
+	int n;
+
+	va_copy(ap2, ap);
+	ob_reserve(ob, 256);
+	n = vsnprintf(ob->data + ob->len, ob->size - ob->len, fmt, ap);
+	if(n >= 0 && (size_t)n >= ob->size - ob->len) {
+		if(ob_reserve(ob, n+1)) {
+			n = vsnprintf(ob->data + ob->len, ob->size - ob->len, fmt, ap2);
+		} else {
+			ob_flush(ob);
+			vfprintf(ob->fp ? ob->fp : stdout, fmt, ap2);
+			n = -1;
+		}
+	}
+	if(n > 0) ob->len += n;
+	va_end(ap2);
+}
+
+void ob_printf(OUTBUF *ob, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	ob_vprintf(ob, fmt, ap);
+	va_end(ap);
+}
+
+void con_printf(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	if(thread_ob.capture) {
+		ob_vprintf(&thread_ob, fmt, ap);
+	} else {
+		vprintf(fmt, ap);
+	}
+	va_end(ap);
+}
+
+// split fmt into prefix / conversion / suffix, returns -1 if this is not a simple single conversion
+static int parse_fmt(const char *fmt, FMT_SPEC *f)
+{
+	const char *p = strchr(fmt, '%');
+
+	if(p == 0) return -1;
+	memset(f, 0, sizeof(FMT_SPEC));
+	f->pre     = fmt;
+	f->pre_len = p - fmt;
+	f->prec    = -1;
+
+	for(p++;;p++) {
+		if(*p == '-')      f->left  = 1;
+		else if(*p == '#') f->alt   = 1;
+		else if(*p == '0') f->zero  = 1;
+		else if(*p == '+') f->plus  = 1;
+		else if(*p == ' ') f->space = 1;
+		else break;
+	}
+	while(*p >= '0' && *p <= '9') f->width = f->width*10 + (*p++ - '0');
+	if(*p == '.') {
+		f->prec = 0;
+		for(p++; *p >= '0' && *p <= '9'; p++) f->prec = f->prec*10 + (*p - '0');
+	}
+	if(*p == 'l') {
+		f->is_long = 1;
+		p++;
+	}
+	f->conv = *p++;
+	f->post = p;
+
+	if(f->conv == 0 || strchr(p, '%') != 0) return -1;
+	return 0;
+}
+
+// emit prefix + [sign/0x] + digits with printf style width padding + suffix
+static void ob_emit(OUTBUF *ob, FMT_SPEC *f, const char *sign, int sign_len, const char *digits, int dlen, int zero_pad)
+{
+	int pad = f->width - (sign_len + dlen);
+	char *d;
+
+	if(!ob_reserve(ob, f->pre_len + (pad > 0 ? pad : 0) + sign_len + dlen)) {
+		ob_flush(ob);
+		if(!ob_reserve(ob, f->pre_len + (pad > 0 ? pad : 0) + sign_len + dlen)) return;
+	}
+	d = ob->data + ob->len;
+
+	memcpy(d, f->pre, f->pre_len);
+	d += f->pre_len;
+	if(f->left == 0 && zero_pad == 0) for(;pad>0;pad--) *d++ = ' ';
+	memcpy(d, sign, sign_len);
+	d += sign_len;
+	if(f->left == 0 && zero_pad == 1) for(;pad>0;pad--) *d++ = '0';
+	memcpy(d, digits, dlen);
+	d += dlen;
+	for(;pad>0;pad--) *d++ = ' ';
+
+	ob->len = d - ob->data;
+	if(*f->post) ob_puts(ob, f->post);
+}
+
+/*
+ * Format an integer using a printf format containing one %d/%u/%x/%X conversion
+ */
+void ob_fmt_int(OUTBUF *ob, const char *fmt, long val)
+{
+	FMT_SPEC f;
+	char tmp[48], sign[2];
+	char *d = tmp + sizeof(tmp);
+	const char *digits = hex_lc;
+	unsigned long u;
+	int base, sign_len = 0, n = 0;
+
+	if(parse_fmt(fmt, &f) != 0 || f.prec >= (int)sizeof(tmp)-24) {
+		ob_printf(ob, fmt, val);
+		return;
+	}
+
+	switch(f.conv) {
+		case 'd':
+		case 'i':
+			base = 10;
+			if(f.is_long == 0) val = (int)val;
+			u = (val < 0) ? 0UL - (unsigned long)val : (unsigned long)val;
+			if(val < 0)       sign[sign_len++] = '-';
+			else if(f.plus)   sign[sign_len++] = '+';
+			else if(f.space)  sign[sign_len++] = ' ';
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+			base = (f.conv == 'u') ? 10 : 16;
+			u = f.is_long ? (unsigned long)val : (unsigned int)val;
+			if(f.conv == 'X') digits = hex_uc;
+			if(f.alt && base == 16 && u != 0) {
+				sign[sign_len++] = '0';
+				sign[sign_len++] = f.conv;
+			}
+			break;
+		default:
+			if(f.is_long) ob_printf(ob, fmt, val);
+			else ob_printf(ob, fmt, (int)val);
+			return;
+	}
+
+	// precision 0 and a zero value prints no digits at all
+	while(u != 0) {
+		*--d = digits[u % base];
+		u /= base;
+		n++;
+	}
+	if(f.prec < 0 && n == 0) {
+		*--d = '0';
+		n++;
+	}
+	while(n < f.prec) {
+		*--d = '0';
+		n++;
+	}
+	ob_emit(ob, &f, sign, sign_len, d, n, f.zero && f.prec < 0);
+}
+
+/*
+ * Format a double using a printf format containing one %f conversion.
+ * Values are rounded in fixed point, anything close enough to a rounding tie
+ * that binary representation matters goes through vsnprintf to stay identical.
+ */
+void ob_fmt_double(OUTBUF *ob, const char *fmt, double val)
+{
+	FMT_SPEC f;
+	char tmp[48], sign[1];
+	char *d = tmp + sizeof(tmp);
+	double a, scaled, r, frac;
+	unsigned long long n, ip, fp;
+	int i, sign_len = 0, len = 0;
+
+	if(parse_fmt(fmt, &f) != 0 || (f.conv != 'f' && f.conv != 'F')) {
+		ob_printf(ob, fmt, val);
+		return;
+	}
+	if(f.prec < 0) f.prec = 6;
+
+	a = fabs(val);
+	if(f.prec > 9 || !isfinite(val) || (scaled = a * pow10_d[f.prec]) >= 1e9) {
+		ob_printf(ob, fmt, val);
+		return;
+	}
+	r    = floor(scaled);
+	frac = scaled - r;
+	if(fabs(frac - 0.5) < 1e-6) {
+		ob_printf(ob, fmt, val);
+		return;
+	}
+	n  = (unsigned long long)r + (frac > 0.5 ? 1 : 0);
+	ip = n / pow10_u[f.prec];
+	fp = n % pow10_u[f.prec];
+
+	for(i=0;i<f.prec;i++) {
+		*--d = '0' + (fp % 10);
+		fp /= 10;
+		len++;
+	}
+	if(f.prec > 0 || f.alt) {
+		*--d = '.';
+		len++;
+	}
+	do {
+		*--d = '0' + (ip % 10);
+		ip /= 10;
+		len++;
+	} while(ip != 0);
+
+	if(signbit(val))   sign[sign_len++] = '-';
+	else if(f.plus)    sign[sign_len++] = '+';
+	else if(f.space)   sign[sign_len++] = ' ';
+
+	ob_emit(ob, &f, sign, sign_len, d, len, f.zero);
+}
@@ -0,0 +1,67 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _OUTBUF_SUPPORT_H
+#define _OUTBUF_SUPPORT_H
+#include <stdio.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+// Table and hexdump output is formatted into a growable buffer and handed to
+// stdio with a single fwrite() once a table (or dump) is complete. Each thread
+// owns its own buffer, see ob_get().
+
+#define OUTBUF_INITIAL_SIZE		(64*1024)
+
+#if defined(_MSC_VER)
+#define OB_THREAD __declspec(thread)
+#else
+#define OB_THREAD __thread
+#endif
+
+typedef struct OUTBUF {
+	char	*data;
+	size_t	len;
+	size_t	size;
+	FILE	*fp;			// flush target
+	int		capture;		// set while a worker thread collects a check's output, ob_flush() is deferred
+} OUTBUF;
+
+OUTBUF *ob_get(void);
+void ob_flush(OUTBUF *ob);
+void ob_free(OUTBUF *ob);
+
+void ob_write(OUTBUF *ob, const char *s, size_t n);
+void ob_puts(OUTBUF *ob, const char *s);
+void ob_putc(OUTBUF *ob, char c);
+void ob_hex(OUTBUF *ob, unsigned long val, int digits);
+void ob_printf(OUTBUF *ob, const char *fmt, ...);
+void ob_vprintf(OUTBUF *ob, const char *fmt, va_list ap);
+
+// console output of the check modules, captured into the thread's buffer while it runs as a job
+void con_printf(const char *fmt, ...);
+
+// fast paths for the single-conversion formats used by TABLE_DEF (eg. "%8.2f ", "%-#8.4x ")
+// anything they do not understand is passed on to vsnprintf() so output never changes
+void ob_fmt_int(OUTBUF *ob, const char *fmt, long val);
+void ob_fmt_double(OUTBUF *ob, const char *fmt, double val);
+
+#endif
@@ -32,22 +32,22 @@ int check_pukans(ImageHandle *fh, int skip)
 	/*
 	 * search: *** Find KFKHFM Table by searching for correct function code byte sequence ***
 	 */
-	printf("\n-[ PUKANS Air Pulsation correction Table ]-----------------------------------------------\n\n");
-	printf(">>> Scanning for PUKANS Table Lookup code sequence - Variant #1 - Access via seg... \n");
+	con_printf("\n-[ PUKANS Air Pulsation correction Table ]-----------------------------------------------\n\n");
+	con_printf(">>> Scanning for PUKANS Table Lookup code sequence - Variant #1 - Access via seg... \n");
 	val =  44;					// byte offset to extract 16-bit address value for PUKANS table from mov. instruction (see needle)
 	seg =  48;					// byte offset to extract 16-bit segment value for PUKANS table from mov. instruction (see needle)
 	found = find_dump_table_seg( fh->d.p, fh->len, &needle_KFKHFM, &mask_KFKHFM, needle_KFKHFM_len, val, seg, &PUKANS_table);
 //	printf( "seg_found=%d\n",found);
 	if(found == 0) {		
-		printf(">>> Scanning for PUKANS Table Lookup code sequence - Variant #1 - Access via dppx... \n");
+		con_printf(">>> Scanning for PUKANS Table Lookup code sequence - Variant #1 - Access via dppx... \n");
 		val =  44;				// byte offset to extract 16-bit address value for PUKANS table from mov. instruction (see needle)
-		seg =  dpp1_value-1;	// implied from dppx, not specified directly (perhaps in the IROM function call itself)
+		seg =  SEG_DPP_TRACKED;	// implied from the dppx at the match, not specified directly
 		found = find_dump_table_dppx(fh->d.p, fh->len, &needle_KFKHFM, &mask_KFKHFM, needle_KFKHFM_len, val, seg, &PUKANS_table);
 //		printf( "dppx_found=%d\n",found);
 	}
 
-	if(found == 0) { printf("Sequence not found\n"); }
-	if(found > 1)  { printf("**** Developer Warning****: False positive detected. >1 match found. Check needle is unique!\n"); }	
+	if(found == 0) { con_printf("Sequence not found\n"); }
+	if(found > 1)  { con_printf("**** Developer Warning****: False positive detected. >1 match found. Check needle is unique!\n"); }	
 	
 	return found;
 }
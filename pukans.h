@@ -19,8 +19,8 @@
    OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
    IN THE SOFTWARE.
 */
-#ifndef _KFKHFM_SUPPORT_H
-#define _KFKHFM_SUPPORT_H
+#ifndef _PUKANS_SUPPORT_H
+#define _PUKANS_SUPPORT_H
 #include "utils.h"
 #include "needles.h"
 
@@ -0,0 +1,243 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "replay.h"
+#include "datalog.h"
+#include "outbuf.h"
+
+// column order of REPLAY_COLUMNS
+#define COL_UHFM	0
+#define COL_NMOT	1
+#define COL_RL		2
+#define COL_TANS	3
+#define NUM_COLS	4
+
+static int bind_map(MAP_LOOKUP *lk, MAP_REGISTRY *r, const char *name)
+{
+	MAP_DATA *m = map_registry_find(r, name);
+
+	if(m == 0 || map_lookup_init(lk, m) != 0) return 0;
+	return 1;
+}
+
+/*
+ * Build the replay model of a rom from everything its checks have kept so far
+ * (see map_registry_take), call once the rom has been searched.
+ *
+ * returns 0 on success
+ */
+int replay_model_init(REPLAY_MODEL *rm, const char *romfile)
+{
+	memset(rm, 0, sizeof(REPLAY_MODEL));
+	rm->romfile = romfile;
+	map_registry_take(&rm->reg);
+
+	rm->have_mlhfm  = bind_map(&rm->mlhfm,  &rm->reg, "MLHFM");
+	rm->have_kfkhfm = bind_map(&rm->kfkhfm, &rm->reg, "KFKHFM");
+	rm->have_pukans = bind_map(&rm->pukans, &rm->reg, "PUKANS");
+	rm->have_lamfa  = bind_map(&rm->lamfa,  &rm->reg, "LAMFA");
+	rm->have_fkkvs  = bind_map(&rm->fkkvs,  &rm->reg, "FKKVS");
+	rm->have_kfzw   = bind_map(&rm->kfzw,   &rm->reg, "KFZW") || bind_map(&rm->kfzw, &rm->reg, "KFZW2");
+	rm->have_krkte  = map_registry_value(&rm->reg, "KRKTE", &rm->krkte);
+
+	printf("Replay model '%s':%s%s%s%s%s%s%s\n", romfile,
+		rm->have_mlhfm  ? " MLHFM"  : "", rm->have_kfkhfm ? " KFKHFM" : "", rm->have_pukans ? " PUKANS" : "",
+		rm->have_lamfa  ? " LAMFA"  : "", rm->have_krkte  ? " KRKTE"  : "", rm->have_fkkvs  ? " FKKVS"  : "",
+		rm->have_kfzw   ? " KFZW"   : "");
+	return 0;
+}
+
+void replay_model_free(REPLAY_MODEL *rm)
+{
+	if(rm->have_mlhfm)  map_lookup_free(&rm->mlhfm);
+	if(rm->have_kfkhfm) map_lookup_free(&rm->kfkhfm);
+	if(rm->have_pukans) map_lookup_free(&rm->pukans);
+	if(rm->have_lamfa)  map_lookup_free(&rm->lamfa);
+	if(rm->have_fkkvs)  map_lookup_free(&rm->fkkvs);
+	if(rm->have_kfzw)   map_lookup_free(&rm->kfzw);
+	map_registry_free(&rm->reg);
+	memset(rm, 0, sizeof(REPLAY_MODEL));
+}
+
+static void fill_nan(double *d, int num)
+{
+	int i;
+
+	for(i=0;i<num;i++) d[i] = NAN;
+}
+
+/*
+ * Run one block of rows through the model, a stage at a time over the whole block.
+ * tmp is scratch space of 'rows' doubles.
+ */
+static void replay_block(REPLAY_MODEL *rm, double **in, int rows, double *tmp, double *ml, double *te, double *zw)
+{
+	int i;
+
+	// air mass flow
+	if(rm->have_mlhfm && in[COL_UHFM] != 0) {
+		map_lookup_batch(&rm->mlhfm, in[COL_UHFM], 0, ml, rows);
+		if(rm->have_kfkhfm) {
+			map_lookup_batch(&rm->kfkhfm, in[COL_NMOT], in[COL_RL], tmp, rows);
+			for(i=0;i<rows;i++) ml[i] *= tmp[i] / KFKHFM_ONE;
+		}
+		if(rm->have_pukans && in[COL_TANS] != 0) {
+			map_lookup_batch(&rm->pukans, in[COL_TANS], 0, tmp, rows);
+			for(i=0;i<rows;i++) ml[i] *= tmp[i];
+		}
+	} else {
+		fill_nan(ml, rows);
+	}
+
+	// injection time
+	if(rm->have_krkte) {
+		if(rm->have_lamfa) {
+			map_lookup_batch(&rm->lamfa, in[COL_NMOT], in[COL_RL], tmp, rows);
+		} else {
+			for(i=0;i<rows;i++) tmp[i] = 1.0;
+		}
+		for(i=0;i<rows;i++) te[i] = (tmp[i] > 0) ? in[COL_RL][i] / tmp[i] * rm->krkte : NAN;
+		if(rm->have_fkkvs) {
+			map_lookup_batch(&rm->fkkvs, in[COL_NMOT], te, tmp, rows);
+			for(i=0;i<rows;i++) te[i] *= tmp[i];
+		}
+	} else {
+		fill_nan(te, rows);
+	}
+
+	// ignition
+	if(rm->have_kfzw) {
+		map_lookup_batch(&rm->kfzw, in[COL_NMOT], in[COL_RL], zw, rows);
+	} else {
+		fill_nan(zw, rows);
+	}
+}
+
+static void put_val(OUTBUF *ob, const char *fmt, double v)
+{
+	ob_putc(ob, ',');
+	if(!isnan(v)) ob_fmt_double(ob, fmt, v);
+}
+
+/*
+ * Stream a datalog through one rom's model (or two side by side) and write predicted air
+ * mass flow, injection time and ignition angle per row. 'columns' names the log's hfm
+ * voltage, engine speed, load and intake air temperature columns (REPLAY_COLUMNS if 0).
+ * Memory use is a few DATALOG_BLOCK_ROWS sized arrays whatever the length of the log.
+ *
+ * returns 0 on success, -1 on error
+ */
+int replay_datalog(const char *logfile, const char *columns, REPLAY_MODEL *a, REPLAY_MODEL *b, const char *outfile)
+{
+	static const char *col_desc[NUM_COLS] = { "hfm voltage", "engine speed", "load", "intake air temperature" };
+	char names[NUM_COLS][64];
+	int  cols[NUM_COLS];
+	double *in[NUM_COLS], *cin[NUM_COLS], *mem, *tmp;
+	double *ml[2], *te[2], *zw[2];		// per rom
+	const char *s;
+	DATALOG *dl;
+	OUTBUF ob;
+	clock_t start = clock();
+	int i, k, rows, roms = b ? 2 : 1;
+
+	if(columns == 0) columns = REPLAY_COLUMNS;
+	for(i=0, s=columns; i<NUM_COLS; i++) {
+		for(k=0; *s && *s != ','; s++) {
+			if(k < (int)sizeof(names[i])-1) names[i][k++] = *s;
+		}
+		names[i][k] = 0;
+		if(*s == ',') s++;
+	}
+
+	dl = datalog_open(logfile);
+	if(dl == 0) return -1;
+	for(i=0;i<NUM_COLS;i++) {
+		cols[i] = datalog_column(dl, names[i]);
+		if(cols[i] < 0) printf("Datalog has no %s column '%s'\n", col_desc[i], names[i]);
+	}
+	if(cols[COL_NMOT] < 0 || cols[COL_RL] < 0) {
+		datalog_close(dl);
+		return -1;
+	}
+
+	// inputs, scratch and 3 results per rom, each DATALOG_BLOCK_ROWS long
+	mem = (double *)malloc((size_t)(NUM_COLS + 1 + 3*roms) * DATALOG_BLOCK_ROWS * sizeof(double));
+	if(mem == 0) {
+		datalog_close(dl);
+		return -1;
+	}
+	for(i=0;i<NUM_COLS;i++) {
+		in[i]  = mem + (size_t)i*DATALOG_BLOCK_ROWS;
+		cin[i] = (cols[i] < 0) ? 0 : in[i];		// a column the log doesn't have drops its stage out
+	}
+	tmp = mem + (size_t)NUM_COLS*DATALOG_BLOCK_ROWS;
+	for(i=0;i<roms;i++) {
+		ml[i] = tmp + (size_t)(1 + 3*i)*DATALOG_BLOCK_ROWS;
+		te[i] = ml[i] + DATALOG_BLOCK_ROWS;
+		zw[i] = te[i] + DATALOG_BLOCK_ROWS;
+	}
+
+	memset(&ob, 0, sizeof(ob));
+	ob.fp = stdout;
+	if(strcmp(outfile, "-") != 0) {
+		ob.fp = fopen(outfile, "wb");
+		if(ob.fp == 0) {
+			printf("Failed to create '%s'\n", outfile);
+			free(mem);
+			datalog_close(dl);
+			return -1;
+		}
+	}
+	ob_puts(&ob, b ? "row,mshfm,te,zw,mshfm_2,te_2,zw_2,te_diff,zw_diff\n" : "row,mshfm,te,zw\n");
+
+	while((rows = datalog_read(dl, cols, NUM_COLS, in, DATALOG_BLOCK_ROWS)) > 0) {
+		replay_block(a, cin, rows, tmp, ml[0], te[0], zw[0]);
+		if(b) replay_block(b, cin, rows, tmp, ml[1], te[1], zw[1]);
+
+		for(k=0;k<rows;k++) {
+			ob_fmt_int(&ob, "%ld", (long)(dl->rows - rows + k + 1));
+			for(i=0;i<roms;i++) {
+				put_val(&ob, "%.2f", ml[i][k]);
+				put_val(&ob, "%.4f", te[i][k]);
+				put_val(&ob, "%.3f", zw[i][k]);
+			}
+			if(b) {
+				put_val(&ob, "%.4f", te[1][k] - te[0][k]);
+				put_val(&ob, "%.3f", zw[1][k] - zw[0][k]);
+			}
+			ob_putc(&ob, '\n');
+		}
+		ob_flush(&ob);
+	}
+	ob_flush(&ob);
+	free(ob.data);
+	if(ob.fp != stdout) fclose(ob.fp);
+	free(mem);
+
+	printf("Replayed %lu datalog rows through %d rom(s) in %.3f seconds, output '%s'\n",
+		dl->rows, b ? 2 : 1, (double)(clock() - start)/CLOCKS_PER_SEC, outfile);
+	datalog_close(dl);
+	return 0;
+}
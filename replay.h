@@ -0,0 +1,54 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _REPLAY_SUPPORT_H
+#define _REPLAY_SUPPORT_H
+#include "maplookup.h"
+
+// Replay of a datalog through the air, fuel and ignition path of the rom (-replay).
+//
+// Per row, with the logged hfm voltage, engine speed, load and intake air temperature:
+//
+//   mshfm = MLHFM(uhfm) * KFKHFM(nmot,rl)/128 * PUKANS(tans)     corrected air mass flow [kg/h]
+//   rk    = rl / LAMFA(nmot,rl)                                  relative fuel mass [%]
+//   te    = rk * KRKTE,  te *= FKKVS(nmot,te)                    effective injection time [ms]
+//   zw    = KFZW(nmot,rl)  (KFZW2 if KFZW isn't found)           ignition angle [grad KW]
+//
+// A table that wasn't found in the rom drops out of the chain (factor 1, lambda 1), the
+// outputs that need MLHFM, KRKTE or KFZW are left empty without them.
+
+#define REPLAY_COLUMNS		"uhfm,nmot,rl,tans"
+#define KFKHFM_ONE			128.0		// KFKHFM raw value of a correction factor of 1.0
+
+typedef struct REPLAY_MODEL {
+	const char   *romfile;
+	MAP_REGISTRY  reg;					// everything the checks found in this rom
+	MAP_LOOKUP    mlhfm, kfkhfm, pukans, lamfa, fkkvs, kfzw;
+	int           have_mlhfm, have_kfkhfm, have_pukans, have_lamfa, have_fkkvs, have_kfzw;
+	int           have_krkte;
+	double        krkte;
+} REPLAY_MODEL;
+
+int  replay_model_init(REPLAY_MODEL *rm, const char *romfile);
+void replay_model_free(REPLAY_MODEL *rm);
+int  replay_datalog(const char *logfile, const char *columns, REPLAY_MODEL *a, REPLAY_MODEL *b, const char *outfile);
+
+#endif
@@ -21,6 +21,9 @@
 */
 #include "rominfo.h"
 #include "utils.h"
+#include "export.h"
+#include "labels.h"
+#include "dpptrack.h"
 
 static char vmecuhn_str[] = { "VMECUHN [Vehicle Manufacturer ECU Hardware Number SKU]" };
 static char ssecuhn_str[] = { "SSECUHN [Bosch Hardware Number]" };
@@ -71,6 +74,8 @@ int get_rominfo(ImageHandle *fh, unsigned char *addr, unsigned int offset, unsig
 			struct_adr                &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
 //			printf("adr=%p\n",struct_adr); fflush(0);
 			printf("\nfound table at offset=%p.\n\n",(void *)struct_adr ); fflush(0);
+			label_symbol(addr-offset_addr, SYM_CODE, "rom info lookup");
+			label_symbol(struct_adr, SYM_DATA, "rom info table");
 
 			p = (unsigned char *)offset_addr + struct_adr;
 
@@ -142,6 +147,12 @@ int get_rominfo(ImageHandle *fh, unsigned char *addr, unsigned int offset, unsig
 											} else {
 												printf("\n");
 											}
+											if(export_active()) {
+												char id_name[16];
+												snprintf(id_name, sizeof(id_name), "ID%d", idx);
+												export_string(id_name, idx_str, (unsigned long)(segm*SEGMENT_SIZE)+(long int)valu, strbuf);
+											}
+											label_add(str_adr-(unsigned long)offset_addr, str_adr-(unsigned long)offset_addr+len, LBL_STRING, idx_str ? idx_str : "rom info", idx, 0, 0);
 											
 											matches++;
 											}
@@ -158,7 +169,7 @@ int get_rominfo(ImageHandle *fh, unsigned char *addr, unsigned int offset, unsig
 						{
 							printf("\nfound needle at offset=0x%x.\n",(int)(addr-offset_addr) );
 									unsigned long val          = get16((unsigned char *)addr + 28);// and segment (required to regenerate physical address from segment)
-									int seg = dpp1_value-1;
+									int seg = dpp_seg_at(fh, (unsigned char *)addr + 28);
 									unsigned long map_adr      = (unsigned long)(seg*SEGMENT_SIZE)+(long int)val;	// derive phyiscal address from offset and segment
 									map_adr                   &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
 							printf("EPK: @ %#x { ",map_adr);
@@ -167,6 +178,8 @@ int get_rominfo(ImageHandle *fh, unsigned char *addr, unsigned int offset, unsig
 							i=0;
 							unsigned char len=0;
 							unsigned char ch;
+							char epk[72];
+							int epk_len=0;
 							len =(unsigned char *)*(adrs+i);
 							i += 2;
 							while(1)
@@ -176,6 +189,7 @@ int get_rominfo(ImageHandle *fh, unsigned char *addr, unsigned int offset, unsig
 								if(isprint(ch))
 								{
 									printf("%c", ch);
+									epk[epk_len++] = ch;
 								} else {
 									break;
 								}
@@ -184,6 +198,11 @@ int get_rominfo(ImageHandle *fh, unsigned char *addr, unsigned int offset, unsig
 							   if(i>=len) break;
 							}
 							printf(" }\n");
+							epk[epk_len] = 0;
+							export_string("EPK", "EPK information", (unsigned long)(seg*SEGMENT_SIZE)+(long int)val, epk);
+							label_add(map_adr, map_adr+i, LBL_STRING, "EPK", -1, 0, 0);
+							label_symbol(addr-offset_addr, SYM_CODE, "EPK lookup");
+							label_symbol(map_adr, SYM_DATA, "EPK");
 						}
 	return 0;
 }
\ No newline at end of file
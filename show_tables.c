@@ -21,6 +21,15 @@
 */
 #include "show_tables.h"
 #include "utils.h"
+#include "outbuf.h"
+#include "export.h"
+#include "maplookup.h"
+#include "mapcatalog.h"
+#include "labels.h"
+#include "dpptrack.h"
+#ifndef NO_THREADS
+#include <pthread.h>
+#endif
 
 // defined in main.c (TODO: this needs cleaning up!)
 extern int full_debug;
@@ -28,6 +37,7 @@ extern int show_hex;
 extern int show_adr;
 extern int show_phy;
 extern int show_diss;
+extern unsigned long dynamic_ROM_FILESIZE;
 
 //get_nwidth
 unsigned long get_nwidth(unsigned char *s, int nwidth)
@@ -56,686 +66,438 @@ unsigned long get_nwidth(unsigned char *s, int nwidth)
 
 void show_entry_def(ENTRY_DEF *entry, int nwidth)
 {
-	char *conv_formula[32];
+	OUTBUF *ob = ob_get();
+	char conv_formula[32];
 
 	if(nwidth == 0) return;
 	
-	printf("\n    %s:\n",entry->field_name);  
-	printf("      Unit:                    %s\n",entry->desc);
-	printf("      Conversion name:         %s\n",entry->conv_name);
-	snprintf(conv_formula, 32, "f(phys) = 0.0 + %3.6f * phys", strtod(entry->conv,NULL) );
-	printf("      Conversion formula:      %s\n",conv_formula);
-	printf("      Data type:               ");
+	ob_printf(ob, "\n    %s:\n",entry->field_name);  
+	ob_printf(ob, "      Unit:                    %s\n",entry->desc);
+	ob_printf(ob, "      Conversion name:         %s\n",entry->conv_name);
+	snprintf(conv_formula, 32, "f(phys) = 0.0 + %3.6f * phys", entry->fconv );
+	ob_printf(ob, "      Conversion formula:      %s\n",conv_formula);
+	ob_puts(ob, "      Data type:               ");
 	switch(nwidth)
 	{
-		case 1:	  printf("UBYTE"); break;
-		case 2:	  printf("UWORD"); break;
-		case 4:	  printf("ULONG"); break;
-		default:  printf("%d BYTES", nwidth);
+		case 1:	  ob_puts(ob, "UBYTE"); break;
+		case 2:	  ob_puts(ob, "UWORD"); break;
+		case 4:	  ob_puts(ob, "ULONG"); break;
+		default:  ob_printf(ob, "%d BYTES", nwidth);
 	}
 }
 
-static unsigned char *X_AXIS_START=0;
-static unsigned char *Y_AXIS_START=0;
-static unsigned char *CELL_START=0;
-static TABLE_DEF *TBL_DEF=0;
-
-int set_table_overrides(char *x_axis, char* y_axis, char *cells, TABLE_DEF *td)
+// take what show_map() prints from the -phy/-hex/-adr/-dbg options, the options themselves are left untouched
+void render_ctx_init(RENDER_CTX *rc)
 {
-	X_AXIS_START = x_axis;
-	Y_AXIS_START = y_axis;
-	CELL_START   = cells;
-	TBL_DEF      = td;
+	rc->show_phy = show_phy;
+	rc->show_hex = show_hex;
+	rc->show_adr = show_adr;
+
+	// if we turn on full debug support, turn on flags to show everything		
+	if(full_debug == 1) {
+		rc->show_phy = 1;
+		rc->show_adr = 1;
+		rc->show_hex = 1;
+	}
 }
 
-int dump_table(unsigned char *adr, unsigned char *offset_addr, unsigned long val, unsigned long seg, TABLE_DEF *td, unsigned long cell_table_override_adr)
-{
-	int x,y;
-	int seg_start             = 0x800000;
-	unsigned long rom_adr      = (unsigned long)(seg*SEGMENT_SIZE)+(long int)val;	// derive phyiscal address from offset and segment
-	unsigned long map_table_adr= rom_adr;
-	map_table_adr             &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
+//
+// Map model: tables are decoded once into a MAP_DATA and every renderer/consumer works from that.
+//
 
-	unsigned char *table_start =   offset_addr+map_table_adr;			// 2 bytes to skip x and y bytes
-	unsigned long  table_start2 =  cell_table_override_adr;			// 2 bytes to skip x and y bytes
-	table_start2               &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
-	table_start2              += offset_addr;
-	
-	double double_x_axis_value, double_cell_value, conv_value, conv2_value;
-	int    i,x_pos,y_pos;
-	int    entry;
-	int    integer_cell_value;
-	int    table_data_offset;
-	double y_axis_hdr_value_raw;
-	double y_axis_hdr_value_fmt;
-	unsigned char  *x_num_data_start;
-	unsigned char  *y_num_data_start;
-	unsigned char  *x_axis_header_data_start;
-	unsigned char  *y_axis_header_data_start;
-	unsigned char  *cell_data_start;
-	unsigned int x_num, y_num, line=0;
-//	unsigned int bytes_per_x_row;
-//	unsigned int bytes_per_y_row;
-//	char *conv_formula[32];
-	unsigned char *cell_adr;
-
-	// get the cell data
-		if(cell_table_override_adr == 0)
-		{
-			table_data_offset  = 0;
-			x_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->x_num_nwidth);				// x num
-			x_num 					  = get_nwidth(x_num_data_start, td->x_num_nwidth);		// get number of colums   **FIXED**
-
-			y_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->y_num_nwidth);				// y num
-			y_num                     = get_nwidth(y_num_data_start, td->y_num_nwidth);		// get number of rows	  **FIXED**
-
-			x_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (x_num*td->x_axis_nwidth);		//x axis header data
-
-			y_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (y_num*td->y_axis_nwidth);		// y axis header data
-
-			cell_data_start           = table_start + table_data_offset;
-//			printf("Defaulting to implide cell_data start address at %p\n", cell_data_start);
-
-		} else {
-			table_data_offset  = 0;
-			x_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->x_num_nwidth);				// x num
-			printf("X_NUM  start address: %p\n", x_num_data_start - offset_addr);
-			x_num 					  = get_nwidth(x_num_data_start, td->x_num_nwidth);		// get number of colums   **FIXED**
-
-			x_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (x_num*td->x_axis_nwidth);		//x axis header data
-			printf("X_AXIS start address: %p\n", x_axis_header_data_start - offset_addr);
-
-			y_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->y_num_nwidth);				// y num
-			printf("Y_NUM  start address: %p\n", y_num_data_start - offset_addr);
-			y_num                     = get_nwidth(y_num_data_start, td->y_num_nwidth);		// get number of rows	  **FIXED**
-
-			y_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (y_num*td->y_axis_nwidth);		// y axis header data
-			printf("Y_AXIS start address: %p\n", y_axis_header_data_start - offset_addr);
-
-			cell_data_start           = table_start2 ;
-			printf("Overriding cell_data start address to %p\n", cell_data_start);
-			
+// fill in the numeric conversion values of an entry defined without CONV()/CONV2(), done once per entry
+void compile_entry_def(ENTRY_DEF *entry)
+{
+	if(entry->fconv == 0.0 && entry->conv != NULL) {
+		entry->fconv = strtod(entry->conv, NULL);
+		if(entry->conv2 != NULL) {
+			entry->fconv2 = strtod(entry->conv2, NULL);
 		}
+	}
+}
 
-//		bytes_per_x_row           = (x_num*td->cell_nwidth);
-//		bytes_per_y_row           = (y_num*td->cell_nwidth);
+// convert a raw axis or cell value to its physical value using the entry's conversion
+double conv_entry_value(ENTRY_DEF *entry, double raw)
+{
+	switch(entry->otype) {
+		case 'd':	return raw / entry->fconv - entry->fconv2;
+		case 'x':	return raw * entry->fconv - entry->fconv2;
+		case '*':	return raw * entry->fconv;
+		case '/':
+		default: 	return raw / entry->fconv;
+	}
+}
 
-		// if we turn on full debug support, turn on flags to show everything		
-		if(full_debug == 1) {
-			show_phy = 1;
-			show_adr = 1;
-			show_hex = 1;
-		}
-//					printf("    xnum=%d (nwidth=%d), ynum=%d (nwidth=%d)\n", x_num, td->x_num_nwidth, y_num, td->y_num_nwidth);  
-
-					printf("\n%s\n",td->table_name);
-					printf("    Long identifier:           %s\n", td->table_desc);
-					printf("    Display identifier:        %s\n", " ");  
-
-//					unsigned long tmp = (unsigned long)cell_data_start;
-//					tmp = tmp - (unsigned long)offset_addr;
-//					printf("    Cell Address:              0x%x\n", (char *)tmp );	
-
-					printf("    Address:                   0x%x\n", (char *)rom_adr  );	
-					printf("    Value:\n\n");  
-
-					printf(" No.           | ");
-					for(i=0;i<x_num;i++) {
-						printf("    %4d ", i);
-					}
-
-					if(show_phy == 1)
-					{
-						printf("\n            PHY| ");
-						for(i=0;i<x_num;i++) {
-							entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-//							printf(td->x_axis.fmt_PHY, entry/strtod(td->x_axis.conv,NULL) );		// convert stored table value to correct viewing format
-
-								double_x_axis_value = (double)entry;
-								conv_value          = (double)strtod(td->x_axis.conv,NULL);
-								if(td->x_axis.conv2 != NULL) {
-									conv2_value       = (double)strtod(td->x_axis.conv2,NULL);									
-								}
-								
-								switch(td->x_axis.otype) {
-									case 'x':	double_x_axis_value = (double)double_x_axis_value * (double)conv_value - (double)conv2_value; 
-									break;
-									case '*':	double_x_axis_value = (double)double_x_axis_value * (double)conv_value; break;
-									case '/':
-									default: 	double_x_axis_value = (double)double_x_axis_value / (double)conv_value; break;
-								}
-								printf(td->x_axis.fmt_PHY,   (double)double_x_axis_value );	// show values directly out of the table
-
-
-						}
-						line++;
-					}
-
-					if(show_hex == 1)
-					{
-						printf("\n            HEX| ");
-						for(i=0;i<x_num;i++) {
-							entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-							printf(td->cell.fmt_HEX, entry );						// show raw hex
-						}
-						line++;
-					}
-
-					if(show_adr == 1)
-					{
-						printf("\n            ADR| ");
-						for(i=0;i<x_num;i++) {
-							printf("0x%X ", (x_axis_header_data_start+(i*td->x_axis_nwidth ) - offset_addr + seg_start ));
-						}
-						line++;
-					}
-					
-					printf("\n");
-					printf(" --------------+");
-					for(i=0;i<x_num;i++) {
-						printf("---------");
-					}
-
-					if(y_num == 0) 		// this means there this is a 1-axis table, we therefore only need to show 1 row
-					{
-#if 1
-						if(show_phy==1)
-						{
-							printf("\n            PHY| ");
-							for(i=x_num;i<x_num*2;i++) {
-								entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-								double_cell_value = (double)entry;
-								conv_value        = (double)strtod(td->cell.conv,NULL);
-								if(td->cell.conv2 != NULL) {
-									conv2_value       = (double)strtod(td->cell.conv2,NULL);									
-								}
-								
-								switch(td->cell.otype) {
-									case 'x':	double_cell_value = (double)double_cell_value * (double)conv_value - (double)conv2_value; break;
-									case '*':	double_cell_value = (double)double_cell_value * (double)conv_value; break;
-									case '/':
-									default: 	double_cell_value = (double)double_cell_value / (double)conv_value; break;
-								}
-								printf(td->cell.fmt_PHY,   (double)double_cell_value );	// show values directly out of the table
-							}
-						}					
-
-						if(show_hex==1)
-						{
-							printf("\n            HEX| ");
-							for(i=x_num;i<x_num*2;i++) {
-								entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-								printf(td->cell.fmt_HEX, entry );						// show raw hex
-							}
-						}
-						if(show_adr==1)
-						{
-							printf("\n            ADR| ");
-							for(i=x_num;i<x_num*2;i++) {
-								cell_adr = x_axis_header_data_start+(i*td->x_axis_nwidth);
-								entry = get_nwidth(adr, td->x_axis_nwidth);	//**FIXED**
-								printf(td->cell.fmt_ADR, cell_adr - offset_addr + seg_start );						// show raw hex
-							}
-						}
-#endif
+// convert a whole block of raw values, the operation is picked once so each loop vectorises
+static void conv_entry_block(ENTRY_DEF *entry, int otype, const uint16_t *raw, double *phy, int num)
+{
+	int i;
+	double conv_value  = entry->fconv;
+	double conv2_value = entry->fconv2;
+
+	switch(otype) {
+		case 'd':	for(i=0; i < num; i++) { phy[i] = (double)raw[i] / conv_value - conv2_value; }	break;
+		case 'x':	for(i=0; i < num; i++) { phy[i] = (double)raw[i] * conv_value - conv2_value; }	break;
+		case '*':	for(i=0; i < num; i++) { phy[i] = (double)raw[i] * conv_value; }				break;
+		case '/':
+		default:	for(i=0; i < num; i++) { phy[i] = (double)raw[i] / conv_value; }				break;
+	}
+}
 
-					}
-					else 
-					{
-						for(y_pos=0;y_pos <y_num;y_pos++) 
-						{
-#if 1
-							// get y_axis header data
-							unsigned char *adr = y_axis_header_data_start + (y_pos*td->y_axis_nwidth);
-							y_axis_hdr_value_raw = get_nwidth( adr, td->y_axis_nwidth );		//**FIXED**
-							y_axis_hdr_value_fmt = y_axis_hdr_value_raw/(strtod(td->y_axis.conv,NULL));	
-
-							if(show_phy==1)
-							{
-								printf("\n ");
-								printf(td->y_axis.fmt_PHY, (double)y_axis_hdr_value_fmt );
-								printf("    PHY| ");
-								for(x_pos=0;x_pos<x_num;x_pos++) 
-								{
-									// get cell data
-									entry = get_nwidth( (cell_data_start + (x_pos)*(y_num*td->cell_nwidth) + y_pos*td->cell_nwidth ), td->cell_nwidth ); 	//**FIXED**
-									double_cell_value = (double)entry;
-									conv_value        = (double)strtod(td->cell.conv,NULL);
-									if(td->cell.conv2 != NULL) {
-										conv2_value       = (double)strtod(td->cell.conv2,NULL);									
-									}
-									
-									switch(td->cell.otype) {
-										case 'x':	double_cell_value = (double)double_cell_value * (double)conv_value - (double)conv2_value; break;
-										case '*':	double_cell_value = (double)double_cell_value * (double)conv_value; break;
-										case '/':
-										default: 	double_cell_value = (double)double_cell_value / (double)conv_value; break;
-									}
-									printf(td->cell.fmt_PHY,   (double)double_cell_value );	// show values directly out of the table
-
-
-									// show floating point formatted value
-//									double_cell_value = (double)entry;
-//									double_cell_value = (double)double_cell_value / (strtod(td->cell.conv,NULL));
-//									printf(td->cell.fmt_PHY,   (double)double_cell_value );	// show values directly out of the table
-								}
-							}
-
-							if(show_hex==1)
-							{
-								// get y_axis formatting and display it
-								y_axis_hdr_value_fmt = y_axis_hdr_value_raw/(strtod(td->y_axis.conv,NULL));	
-								printf("\n  ");
-								printf("%-#8.4x ", get_nwidth( (int)adr, td->y_axis_nwidth ) );						//**FIXED**
-								printf(" HEX| ");
-								for(x_pos=0;x_pos<x_num;x_pos++) 
-								{
-									cell_adr = (cell_data_start + (x_pos)*(y_num*td->cell_nwidth) + y_pos*td->cell_nwidth );	// get cell address
-									entry    = get_nwidth( cell_adr, td->cell_nwidth );										//**FIXED**// get cell data
-									printf(td->cell.fmt_HEX,(int)entry);						// show values directly out of the table
-								}
-							}
-
-							if(show_adr==1)
-							{
-								// get y_axis formatting and display it
-								y_axis_hdr_value_fmt = y_axis_hdr_value_raw/(strtod(td->y_axis.conv,NULL));	
-								printf("\n  ");
-								printf("%-#9.5x", (int)(adr - (unsigned char *)(offset_addr))+seg_start );
-								printf(" ADR| ");
-								for(x_pos=0;x_pos<x_num;x_pos++) 
-								{	
-									cell_adr = (cell_data_start + (x_pos)*(y_num*td->cell_nwidth) + y_pos*td->cell_nwidth );	// get cell address
-									entry    = get_nwidth( cell_adr, td->cell_nwidth );									//**FIXED**	// get cell data
-									printf("0x%x ", cell_adr - offset_addr + seg_start );			// show address
-								}
-							} 
-							
-							if(line > 1)
-								printf("\n");					
-#endif						
-						}					
-					}
-
-		printf("\n\n");
-		show_entry_def(&td->cell,   td->cell_nwidth);
-		show_entry_def(&td->x_axis, td->x_axis_nwidth);
-		show_entry_def(&td->y_axis, td->y_axis_nwidth);
-		printf("\n\n");
-		return 0;
+/*
+ * Table decoders specialised on the axis and cell byte widths (UBYTE/UWORD), so every load is a
+ * fixed width load. decode_map() binds the matching one to each TABLE_DEF the first time it's used.
+ */
+#define LOAD_UBYTE(s)	((uint16_t)(s)[0])
+#define LOAD_UWORD(s)	((uint16_t)((s)[0] | ((s)[1] << 8)))
+
+#define DEFINE_MAP_DECODER(XW, YW, CW)																	\
+static void decode_map_##XW##_##YW##_##CW(MAP_DATA *m, unsigned char *rom)								\
+{																										\
+	TABLE_DEF *td = m->td;																				\
+	unsigned char *s;																					\
+	int i, x, y;																						\
+																										\
+	for(i=0, s=rom+m->x_axis_adr; i < m->x_num; i++, s += XW) { m->x_raw[i] = LOAD_##XW(s); }			\
+	for(i=0, s=rom+m->y_axis_adr; i < m->y_num; i++, s += YW) { m->y_raw[i] = LOAD_##YW(s); }			\
+																										\
+	if(m->y_num == 0) {																					\
+		/* 1-axis tables keep their values straight after the x-axis, with the x-axis width */			\
+		for(i=0, s=rom+m->cell_adr; i < m->cell_num; i++, s += XW) { m->cell_raw[i] = LOAD_##XW(s); }	\
+	} else {																							\
+		/* rom stores cells column by column, keep them row by row (see MAP_CELL_RAW) */				\
+		for(x=0, s=rom+m->cell_adr; x < m->x_num; x++) {												\
+			for(y=0; y < m->y_num; y++, s += CW) { m->cell_raw[y*m->x_num+x] = LOAD_##CW(s); }			\
+		}																								\
+	}																									\
+																										\
+	conv_entry_block(&td->x_axis, td->x_axis.otype, m->x_raw,    m->x_phy,    m->x_num);					\
+	conv_entry_block(&td->y_axis, '/',              m->y_raw,    m->y_phy,    m->y_num);	/* y-axis has always been shown as raw/conv */	\
+	conv_entry_block(&td->cell,   td->cell.otype,   m->cell_raw, m->cell_phy, m->cell_num);				\
 }
 
-//
-// table formatting right is a big mess (!) and needs a major cleanup (TO DO!!!)
-//
+DEFINE_MAP_DECODER(UBYTE, UBYTE, UBYTE)
+DEFINE_MAP_DECODER(UBYTE, UBYTE, UWORD)
+DEFINE_MAP_DECODER(UBYTE, UWORD, UBYTE)
+DEFINE_MAP_DECODER(UBYTE, UWORD, UWORD)
+DEFINE_MAP_DECODER(UWORD, UBYTE, UBYTE)
+DEFINE_MAP_DECODER(UWORD, UBYTE, UWORD)
+DEFINE_MAP_DECODER(UWORD, UWORD, UBYTE)
+DEFINE_MAP_DECODER(UWORD, UWORD, UWORD)
+
+static map_decoder map_decoders[2][2][2] = {
+	{ { decode_map_UBYTE_UBYTE_UBYTE, decode_map_UBYTE_UBYTE_UWORD }, { decode_map_UBYTE_UWORD_UBYTE, decode_map_UBYTE_UWORD_UWORD } },
+	{ { decode_map_UWORD_UBYTE_UBYTE, decode_map_UWORD_UBYTE_UWORD }, { decode_map_UWORD_UWORD_UBYTE, decode_map_UWORD_UWORD_UWORD } },
+};
+
+#ifndef NO_THREADS
+static pthread_mutex_t compile_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
-int dump_table2(unsigned char *offset_addr, unsigned long cell_table_override_adr)
+// bind the specialised decoder and numeric conversions to a table definition, returns -1 for unsupported widths
+static int compile_table_def(TABLE_DEF *td)
 {
-	dump_raw_table(0, offset_addr, cell_table_override_adr);
+	// a width of 0 means the part isn't present (e.g. no y-axis), nothing is loaded for it
+	int xw = td->x_axis_nwidth ? td->x_axis_nwidth : UBYTE;
+	int yw = td->y_axis_nwidth ? td->y_axis_nwidth : UBYTE;
+	int cw = td->cell_nwidth   ? td->cell_nwidth   : UBYTE;
+
+	if(xw > UWORD || yw > UWORD || cw > UWORD) return -1;
+
+	// checks run as parallel jobs can share a table definition, bind it once. td->decode is
+	// only read under the lock, the lock is cheap next to decoding the table
+#ifndef NO_THREADS
+	pthread_mutex_lock(&compile_lock);
+#endif
+	if(td->decode == 0) {
+		compile_entry_def(&td->x_axis);
+		compile_entry_def(&td->y_axis);
+		compile_entry_def(&td->cell);
+		td->decode = map_decoders[xw-1][yw-1][cw-1];
+	}
+#ifndef NO_THREADS
+	pthread_mutex_unlock(&compile_lock);
+#endif
+	return 0;
 }
 
-int dump_raw_table(unsigned char *table_start, unsigned char *offset_addr, unsigned long cell_table_override_adr)
+/*
+ * Decode a table into 'm'. All offsets are rom file offsets, which ones are used depends on layout;
+ *
+ *  MAP_LAYOUT_HEADER       x_off : x_num, y_num, x-axis, y-axis, cells
+ *  MAP_LAYOUT_INTERLEAVED  x_off : x_num, x-axis, y_num, y-axis  cell_off : cells
+ *  MAP_LAYOUT_SPLIT        x_off : x_num, x-axis  y_off : y_num, y-axis  cell_off : cells
+ *
+ * A table with y_num of 0 is a 1-axis table, its x_num cells follow the x-axis (stored with the x-axis width).
+ * The values are read and converted by the table's specialised decoder (see DEFINE_MAP_DECODER).
+ * returns 0 on success, -1 if the table doesn't fit in the image or memory couldn't be allocated.
+ */
+int decode_map(MAP_DATA *m, unsigned char *rom, unsigned long rom_len, TABLE_DEF *td, int layout, unsigned long x_off, unsigned long y_off, unsigned long cell_off)
 {
-	int x,y;
-	int seg_start             = 0x800000;
-    TABLE_DEF *td=0;
-	
-//	unsigned long rom_adr      = (unsigned long)(seg*SEGMENT_SIZE)+(long int)val;	// derive phyiscal address from offset and segment
-//	unsigned long map_table_adr= rom_adr;
-//	map_table_adr             &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
+	unsigned long end;
+	int cell_nwidth;
+	size_t total;
 
-	unsigned long  table_start2 =  cell_table_override_adr;			// 2 bytes to skip x and y bytes
-	table_start2               &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
-	table_start2              += offset_addr;
-	
-	double double_cell_value, double_x_axis_value, conv_value, conv2_value;
-	int    i,x_pos,y_pos;
-	int    entry;
-	int    integer_cell_value;
-	int    table_data_offset;
-	double y_axis_hdr_value_raw;
-	double y_axis_hdr_value_fmt;
-	unsigned char  *x_num_data_start;
-	unsigned char  *y_num_data_start;
-	unsigned char  *x_axis_header_data_start;
-	unsigned char  *y_axis_header_data_start;
-	unsigned char  *cell_data_start;
-	unsigned int x_num, y_num, line=0;
-//	unsigned int bytes_per_x_row;
-//	unsigned int bytes_per_y_row;
-//	char *conv_formula[32];
-	unsigned char *cell_adr;
-
-	// get the cell data
-		if(cell_table_override_adr == 0)
-		{
-			table_data_offset  = 0;
-			x_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->x_num_nwidth);				// x num
-			printf("X_NUM  start address: %p\n", x_num_data_start);// - offset_addr);
-			x_num 					  = get_nwidth(x_num_data_start, td->x_num_nwidth);		// get number of colums   **FIXED**
+	memset(m, 0, sizeof(*m));
+	if(compile_table_def(td) != 0) return -1;
+	m->td     = td;
+	m->layout = layout;
 
-			y_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->y_num_nwidth);				// y num
-			y_num                     = get_nwidth(y_num_data_start, td->y_num_nwidth);		// get number of rows	  **FIXED**
-			printf("Y_NUM  start address: %p\n", y_num_data_start);// - offset_addr);
+	m->x_num_adr = x_off;
+	if(m->x_num_adr + td->x_num_nwidth > rom_len) return -1;
+	m->x_num     = get_nwidth(rom + m->x_num_adr, td->x_num_nwidth);
 
-			x_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (x_num*td->x_axis_nwidth);		//x axis header data
-			printf("X_AXIS start address: %p\n", x_axis_header_data_start); // - offset_addr);
+	switch(layout)
+	{
+		case MAP_LAYOUT_HEADER:
+			m->y_num_adr  = m->x_num_adr + td->x_num_nwidth;
+			if(m->y_num_adr + td->y_num_nwidth > rom_len) return -1;
+			m->y_num      = get_nwidth(rom + m->y_num_adr, td->y_num_nwidth);
+			m->x_axis_adr = m->y_num_adr  + td->y_num_nwidth;
+			m->y_axis_adr = m->x_axis_adr + m->x_num*td->x_axis_nwidth;
+			m->cell_adr   = m->y_axis_adr + m->y_num*td->y_axis_nwidth;
+			break;
+		case MAP_LAYOUT_INTERLEAVED:
+			m->x_axis_adr = m->x_num_adr  + td->x_num_nwidth;
+			m->y_num_adr  = m->x_axis_adr + m->x_num*td->x_axis_nwidth;
+			if(m->y_num_adr + td->y_num_nwidth > rom_len) return -1;
+			m->y_num      = get_nwidth(rom + m->y_num_adr, td->y_num_nwidth);
+			m->y_axis_adr = m->y_num_adr  + td->y_num_nwidth;
+			m->cell_adr   = cell_off;
+			break;
+		case MAP_LAYOUT_SPLIT:
+			m->x_axis_adr = m->x_num_adr  + td->x_num_nwidth;
+			m->y_num_adr  = y_off;
+			if(m->y_num_adr + td->y_num_nwidth > rom_len) return -1;
+			m->y_num      = get_nwidth(rom + m->y_num_adr, td->y_num_nwidth);
+			m->y_axis_adr = m->y_num_adr  + td->y_num_nwidth;
+			m->cell_adr   = cell_off;
+			break;
+		default:
+			return -1;
+	}
 
+	// 1-axis tables keep their values straight after the x-axis
+	if(m->y_num == 0) {
+		m->cell_adr  = m->x_axis_adr + m->x_num*td->x_axis_nwidth;
+		m->cell_num  = m->x_num;
+		cell_nwidth  = td->x_axis_nwidth;
+	} else {
+		m->cell_num  = m->x_num*m->y_num;
+		cell_nwidth  = td->cell_nwidth;
+	}
+
+	// everything must lie within the image
+	if(m->x_axis_adr + m->x_num*td->x_axis_nwidth > rom_len) return -1;
+	if(m->y_axis_adr + m->y_num*td->y_axis_nwidth > rom_len) return -1;
+	end = m->cell_adr + (unsigned long)m->cell_num*cell_nwidth;
+	if(end > rom_len) return -1;
+
+	// one allocation holds every raw and physical array
+	total    = (size_t)(m->x_num + m->y_num + m->cell_num);
+	m->x_phy = (double *)malloc(total*(sizeof(double)+sizeof(uint16_t)));
+	if(m->x_phy == 0) return -1;
+	m->y_phy    = m->x_phy + m->x_num;
+	m->cell_phy = m->y_phy + m->y_num;
+	m->x_raw    = (uint16_t *)(m->cell_phy + m->cell_num);
+	m->y_raw    = m->x_raw + m->x_num;
+	m->cell_raw = m->y_raw + m->y_num;
+
+	td->decode(m, rom);
+	return 0;
+}
 
-			y_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (y_num*td->y_axis_nwidth);		// y axis header data
-			printf("Y_AXIS start address: %p\n", y_axis_header_data_start); // - offset_addr);
+void free_map(MAP_DATA *m)
+{
+	if(m->x_phy != 0) free(m->x_phy);
+	memset(m, 0, sizeof(*m));
+}
 
-			cell_data_start           = table_start + table_data_offset;
-			printf("Defaulting to implide cell_data start address at %p\n", cell_data_start);
+// rom file offset of cell (x,y) as stored in the image
+unsigned long map_cell_adr(MAP_DATA *m, int x, int y)
+{
+	if(m->y_num == 0) {
+		return m->cell_adr + x*m->td->x_axis_nwidth;
+	}
+	return m->cell_adr + (x*m->y_num + y)*m->td->cell_nwidth;
+}
 
+/*
+ * Render a decoded map in the classic text layout, 'rc' selects the PHY/HEX/ADR rows
+ */
+int show_map(MAP_DATA *m, RENDER_CTX *rc)
+{
+	TABLE_DEF *td = m->td;
+	OUTBUF *ob = ob_get();
+	int seg_start = 0x800000;
+	int i, x_pos, y_pos;
+	unsigned int line=0;
+
+	if(m->layout == MAP_LAYOUT_INTERLEAVED) {
+		ob_printf(ob, "X_NUM  start address: %p\n", (void *)m->x_num_adr);
+		ob_printf(ob, "X_AXIS start address: %p\n", (void *)m->x_axis_adr);
+		ob_printf(ob, "Y_NUM  start address: %p\n", (void *)m->y_num_adr);
+		ob_printf(ob, "Y_AXIS start address: %p\n", (void *)m->y_axis_adr);
+		ob_printf(ob, "Overriding cell_data start address to %p\n", (void *)m->cell_adr);
+	}
+
+	ob_printf(ob, "\n%s\n",td->table_name);
+	ob_printf(ob, "    Long identifier:           %s\n", td->table_desc);
+	ob_puts(ob, "    Display identifier:         \n");  
+	if(m->layout != MAP_LAYOUT_SPLIT) {
+		ob_fmt_int(ob, "    Address:                   0x%x\n", (unsigned int)m->rom_adr );	
+	}
+	ob_puts(ob, "    Value:\n\n");  
+
+	ob_puts(ob, " No.           | ");
+	for(i=0;i<m->x_num;i++) {
+		ob_fmt_int(ob, "    %4d ", i);
+	}
+
+	// x-axis
+	if(rc->show_phy == 1) {
+		ob_puts(ob, "\n            PHY| ");
+		for(i=0;i<m->x_num;i++) {
+			ob_fmt_double(ob, td->x_axis.fmt_PHY, m->x_phy[i] );
 		}
-		else if(cell_table_override_adr == FULL_OVERRIDE) 
-		{
-//			printf("FULL OVERRIDE MODE\n");
-			td                        = TBL_DEF;
-		
-			table_data_offset         = 0;
-			x_num_data_start          = X_AXIS_START;
-			table_data_offset        += (td->x_num_nwidth);				// x num
-//			printf("X_NUM  start address: %p\n", x_num_data_start);
-			x_num 					  = get_nwidth(x_num_data_start, td->x_num_nwidth);		// get number of colums   **FIXED**
-//			printf("x_num=%d\n", x_num);
-
-			x_axis_header_data_start  = x_num_data_start + table_data_offset;
-			table_data_offset        += (x_num*td->x_axis_nwidth);		//x axis header data
-//			printf("X_AXIS start address: %p\n", x_axis_header_data_start);
-
-			table_data_offset         = 0;
-			y_num_data_start          = Y_AXIS_START;
-			table_data_offset        += (td->y_num_nwidth);				// y num
-//			printf("Y_NUM  start address: %p\n", y_num_data_start);
-			y_num                     = get_nwidth(y_num_data_start, td->y_num_nwidth);		// get number of rows	  **FIXED**
-//			printf("y_num=%d\n", y_num);
-
-			y_axis_header_data_start  = y_num_data_start + table_data_offset;
-			table_data_offset        += (y_num*td->y_axis_nwidth);		// y axis header data
-//			printf("Y_AXIS start address: %p\n", y_axis_header_data_start);
-
-			cell_data_start           = CELL_START;
-//			printf("Overriding cell_data start address to %p\n", cell_data_start);
-
-		} 
-		else 
-		{
-			table_data_offset  = 0;
-			x_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->x_num_nwidth);				// x num
-			printf("X_NUM  start address: %p\n", x_num_data_start - offset_addr);
-			x_num 					  = get_nwidth(x_num_data_start, td->x_num_nwidth);		// get number of colums   **FIXED**
-
-			x_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (x_num*td->x_axis_nwidth);		//x axis header data
-			printf("X_AXIS start address: %p\n", x_axis_header_data_start - offset_addr);
-
-			y_num_data_start          = table_start + table_data_offset;
-			table_data_offset        += (td->y_num_nwidth);				// y num
-			printf("Y_NUM  start address: %p\n", y_num_data_start - offset_addr);
-			y_num                     = get_nwidth(y_num_data_start, td->y_num_nwidth);		// get number of rows	  **FIXED**
-
-			y_axis_header_data_start  = table_start + table_data_offset;
-			table_data_offset        += (y_num*td->y_axis_nwidth);		// y axis header data
-			printf("Y_AXIS start address: %p\n", y_axis_header_data_start - offset_addr);
-
-			cell_data_start           = table_start2 ;
-			printf("Overriding cell_data start address to %p\n", cell_data_start);
-			
+		line++;
+	}
+	if(rc->show_hex == 1) {
+		ob_puts(ob, "\n            HEX| ");
+		for(i=0;i<m->x_num;i++) {
+			ob_fmt_int(ob, td->cell.fmt_HEX, (int)m->x_raw[i] );
 		}
+		line++;
+	}
+	if(rc->show_adr == 1) {
+		ob_puts(ob, "\n            ADR| ");
+		for(i=0;i<m->x_num;i++) {
+			ob_fmt_int(ob, "0x%X ", (unsigned int)(m->x_axis_adr + i*td->x_axis_nwidth + seg_start) );
+		}
+		line++;
+	}
+	
+	ob_puts(ob, "\n");
+	ob_puts(ob, " --------------+");
+	for(i=0;i<m->x_num;i++) {
+		ob_puts(ob, "---------");
+	}
 
-//		bytes_per_x_row           = (x_num*td->cell_nwidth);
-//		bytes_per_y_row           = (y_num*td->cell_nwidth);
-
-		// if we turn on full debug support, turn on flags to show everything		
-		if(full_debug == 1) {
-			show_phy = 1;
-			show_adr = 1;
-			show_hex = 1;
+	if(m->y_num == 0) 		// this means there this is a 1-axis table, we therefore only need to show 1 row
+	{
+		if(m->layout != MAP_LAYOUT_SPLIT)
+		{
+			if(rc->show_phy==1) {
+				ob_puts(ob, "\n            PHY| ");
+				for(i=0;i<m->cell_num;i++) {
+					ob_fmt_double(ob, td->cell.fmt_PHY, m->cell_phy[i] );
+				}
+			}
+			if(rc->show_hex==1) {
+				ob_puts(ob, "\n            HEX| ");
+				for(i=0;i<m->cell_num;i++) {
+					ob_fmt_int(ob, td->cell.fmt_HEX, (int)m->cell_raw[i] );
+				}
+			}
+			if(rc->show_adr==1) {
+				ob_puts(ob, "\n            ADR| ");
+				for(i=0;i<m->cell_num;i++) {
+					ob_fmt_int(ob, td->cell.fmt_ADR, (unsigned int)(map_cell_adr(m, i, 0) + seg_start) );
+				}
+			}
 		}
-//					printf("    xnum=%d (nwidth=%d), ynum=%d (nwidth=%d)\n", x_num, td->x_num_nwidth, y_num, td->y_num_nwidth);  
-
-					printf("\n%s\n",td->table_name);
-					printf("    Long identifier:           %s\n", td->table_desc);
-					printf("    Display identifier:        %s\n", " ");  
-
-//					unsigned long tmp = (unsigned long)cell_data_start;
-//					tmp = tmp - (unsigned long)offset_addr;
-//					printf("    Cell Address:              0x%x\n", (char *)tmp );	
-
-//					printf("    Address:                   0x%x\n", (char *)table_start);	//rom_adr  );	
-					printf("    Value:\n\n");  
-
-					printf(" No.           | ");
-					for(i=0;i<x_num;i++) {
-						printf("    %4d ", i);
-					}
-
-
-					if(show_phy == 1)
-					{
-						//
-						// X-AXIS
-						//
-						printf("\n            PHY| ");
-						for(i=0;i<x_num;i++) {
-							entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-//							printf(td->x_axis.fmt_PHY, entry/strtod(td->x_axis.conv,NULL) );		// convert stored table value to correct viewing format
-								double_x_axis_value = (double)entry;
-								conv_value          = (double)strtod(td->x_axis.conv,NULL);
-								if(td->x_axis.conv2 != NULL) {
-									conv2_value       = (double)strtod(td->x_axis.conv2,NULL);		
-								}
-								
-								switch(td->x_axis.otype) {
-									case 'd':	double_x_axis_value = (double)double_x_axis_value / (double)conv_value - (double)conv2_value; 		break;
-									case 'x':	double_x_axis_value = (double)double_x_axis_value * (double)conv_value - (double)conv2_value; 		break;
-									case '*':	double_x_axis_value = (double)double_x_axis_value * (double)conv_value; break;
-									case '/':
-									default: 	double_x_axis_value = (double)double_x_axis_value / (double)conv_value; break;
-								}
-								printf(td->x_axis.fmt_PHY,   (double)double_x_axis_value );	// show values directly out of the table
-						}
-						line++;
-					}
-#if 0
-					if(show_phy == 1)
-					{
-						//
-						// X-AXIS
-						//
-						printf("\n            PHY| ");
-						for(i=0;i<x_num;i++) {
-							entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-							printf(td->x_axis.fmt_PHY, entry/strtod(td->x_axis.conv,NULL) );		// convert stored table value to correct viewing format
-						}
-						line++;
-					}
-#endif
+	}
+	else 
+	{
+		for(y_pos=0;y_pos <m->y_num;y_pos++) 
+		{
+			if(rc->show_phy==1) {
+				ob_puts(ob, "\n ");
+				ob_fmt_double(ob, td->y_axis.fmt_PHY, m->y_phy[y_pos] );
+				ob_puts(ob, "    PHY| ");
+				for(x_pos=0;x_pos<m->x_num;x_pos++) {
+					ob_fmt_double(ob, td->cell.fmt_PHY, MAP_CELL_PHY(m, x_pos, y_pos) );
+				}
+			}
+			if(rc->show_hex==1) {
+				ob_puts(ob, "\n  ");
+				ob_fmt_int(ob, "%-#8.4x ", (unsigned int)m->y_raw[y_pos] );
+				ob_puts(ob, " HEX| ");
+				for(x_pos=0;x_pos<m->x_num;x_pos++) {
+					ob_fmt_int(ob, td->cell.fmt_HEX, (int)MAP_CELL_RAW(m, x_pos, y_pos) );
+				}
+			}
+			if(rc->show_adr==1) {
+				ob_puts(ob, "\n  ");
+				ob_fmt_int(ob, "%-#9.5x", (unsigned int)(m->y_axis_adr + y_pos*td->y_axis_nwidth + seg_start) );
+				ob_puts(ob, " ADR| ");
+				for(x_pos=0;x_pos<m->x_num;x_pos++) {
+					ob_fmt_int(ob, (m->layout == MAP_LAYOUT_SPLIT) ? "0x%X " : "0x%x ", (unsigned int)(map_cell_adr(m, x_pos, y_pos) + seg_start) );
+				}
+			} 
+			if(line > 1)
+				ob_puts(ob, "\n");					
+		}					
+	}
 
-					if(show_hex == 1)
-					{
-						//
-						// X-AXIS
-						//
-						printf("\n            HEX| ");
-						for(i=0;i<x_num;i++) {
-							entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-							printf(td->cell.fmt_HEX, entry );						// show raw hex
-						}
-						line++;
-					}
-
-					if(show_adr == 1)
-					{
-						//
-						// X-AXIS
-						//
-						printf("\n            ADR| ");
-						for(i=0;i<x_num;i++) {
-							printf("0x%X ", (x_axis_header_data_start+(i*td->x_axis_nwidth ) - offset_addr + seg_start ));
-						}
-						line++;
-					}
-					
-					printf("\n");
-					printf(" --------------+");
-					for(i=0;i<x_num;i++) {
-						printf("---------");
-					}
-
-					if(y_num == 0) 		// this means there this is a 1-axis table, we therefore only need to show 1 row
-					{
-#if 1
-
-#if 0
-						if(show_phy==1)
-						{
-							//
-							// X-AXIS
-							//
-							printf("\n            PHY| ");
-							for(i=x_num;i<x_num*2;i++) {
-								entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-								double_cell_value = (double)entry;
-								conv_value        = (double)strtod(td->cell.conv,NULL);
-								
-								switch(td->cell.otype) {
-									case '*':	double_cell_value = (double)double_cell_value * (double)conv_value; break;
-									case '/':
-									default: 	double_cell_value = (double)double_cell_value / (double)conv_value; break;
-								}
-								printf(td->cell.fmt_PHY,   (double)double_cell_value );	// show values directly out of the table
-							}
-						}					
-
-						if(show_hex==1)
-						{
-							printf("\n            HEX| ");
-							for(i=x_num;i<x_num*2;i++) {
-								entry = get_nwidth(x_axis_header_data_start+(i*td->x_axis_nwidth), td->x_axis_nwidth);	//**FIXED**
-								printf(td->cell.fmt_HEX, entry );						// show raw hex
-							}
-						}
-						if(show_adr==1)
-						{
-							printf("\n            ADR| ");
-							for(i=x_num;i<x_num*2;i++) {
-								cell_adr = x_axis_header_data_start+(i*td->x_axis_nwidth);
-////FIXME:TLM
-//								entry = get_nwidth(adr, td->x_axis_nwidth);	//**FIXED**
-//								printf(td->cell.fmt_ADR, cell_adr - offset_addr + seg_start );						// show raw hex
-							}
-						}
+	ob_puts(ob, "\n\n");
+	show_entry_def(&td->cell,   td->cell_nwidth);
+	show_entry_def(&td->x_axis, td->x_axis_nwidth);
+	show_entry_def(&td->y_axis, td->y_axis_nwidth);
+	ob_puts(ob, "\n\n");
 
-#endif
+	// hand the whole table to stdio in one go
+	ob_flush(ob);
+	return 0;
+}
 
-#endif
+int dump_table(unsigned char *adr, unsigned char *offset_addr, unsigned long val, unsigned long seg, TABLE_DEF *td, unsigned long cell_table_override_adr)
+{
+	MAP_DATA m;
+	RENDER_CTX rc;
+	unsigned long rom_adr      = (unsigned long)(seg*SEGMENT_SIZE)+(long int)val;	// derive phyiscal address from offset and segment
+	unsigned long map_table_adr= rom_adr & ~(ROM_1MB_MASK);						// convert physical address to a rom file offset we can easily work with.
+	int result;
 
-					}
-					else 
-					{
-						for(y_pos=0;y_pos <y_num;y_pos++) 
-						{
-#if 1
-							// get y_axis header data
-							unsigned char *adr = y_axis_header_data_start + (y_pos*td->y_axis_nwidth);
-							y_axis_hdr_value_raw = get_nwidth( adr, td->y_axis_nwidth );		//**FIXED**
-							y_axis_hdr_value_fmt = y_axis_hdr_value_raw/(strtod(td->y_axis.conv,NULL));	
-
-							if(show_phy==1)
-							{
-								// cells
-#if 1
-								printf("\n ");
-								printf(td->y_axis.fmt_PHY, (double)y_axis_hdr_value_fmt );
-								printf("    PHY| ");
-								for(x_pos=0;x_pos<x_num;x_pos++) 
-								{
-									// get cell data
-									entry = get_nwidth( (cell_data_start + (x_pos)*(y_num*td->cell_nwidth) + y_pos*td->cell_nwidth ), td->cell_nwidth ); 	//**FIXED**
-
-									double_cell_value = (double)entry;
-									conv_value        = (double)strtod(td->cell.conv,NULL);
-//									if(td->cell.conv2 != NULL) {
-//										conv2_value       = (double)strtod(td->cell.conv2,NULL);									
-//									}
-									
-									switch(td->cell.otype) {
-//										case 'x':	double_cell_value = (double)double_cell_value * (double)conv_value - (double)conv2_value; break;
-										case '*':	double_cell_value = (double)double_cell_value * (double)conv_value; break;
-										case '/':
-										default: 	double_cell_value = (double)double_cell_value / (double)conv_value; break;
-									}
-									printf(td->cell.fmt_PHY,   (double)double_cell_value );	// show values directly out of the table
-
-
-									// show floating point formatted value
-//									double_cell_value = (double)entry;
-//									double_cell_value = (double)double_cell_value / (strtod(td->cell.conv,NULL));
-//									printf(td->cell.fmt_PHY,   (double)double_cell_value );	// show values directly out of the table
-								}
-#endif
-							}
-
-							if(show_hex==1)
-							{
-								// get y_axis formatting and display it
-								y_axis_hdr_value_fmt = y_axis_hdr_value_raw/(strtod(td->y_axis.conv,NULL));	
-								printf("\n  ");
-								printf("%-#8.4x ", get_nwidth( (int)adr, td->y_axis_nwidth ) );						//**FIXED**
-								printf(" HEX| ");
-								for(x_pos=0;x_pos<x_num;x_pos++) 
-								{
-									cell_adr = (cell_data_start + (x_pos)*(y_num*td->cell_nwidth) + y_pos*td->cell_nwidth );	// get cell address
-									entry    = get_nwidth( cell_adr, td->cell_nwidth );										//**FIXED**// get cell data
-									printf(td->cell.fmt_HEX,(int)entry);						// show values directly out of the table
-								}
-							}
-
-							if(show_adr==1)
-							{
-								// get y_axis formatting and display it
-								y_axis_hdr_value_fmt = y_axis_hdr_value_raw/(strtod(td->y_axis.conv,NULL));	
-								printf("\n  ");
-								printf("%-#9.5x", (int)(adr - (unsigned char *)(offset_addr))+seg_start );
-								printf(" ADR| ");
-								for(x_pos=0;x_pos<x_num;x_pos++) 
-								{	
-									cell_adr = (cell_data_start + (x_pos)*(y_num*td->cell_nwidth) + y_pos*td->cell_nwidth );	// get cell address
-									entry    = get_nwidth( cell_adr, td->cell_nwidth );									//**FIXED**	// get cell data
-									printf("0x%X ", cell_adr - offset_addr + seg_start );			// show address
-								}
-							} 
-							
-							if(line > 1)
-								printf("\n");					
-#endif						
-						}					
-					}
-
-		printf("\n\n");
-		show_entry_def(&td->cell,   td->cell_nwidth);
-		show_entry_def(&td->x_axis, td->x_axis_nwidth);
-		show_entry_def(&td->y_axis, td->y_axis_nwidth);
-		printf("\n\n");
-		return 0;
+	if(cell_table_override_adr == 0) {
+		result = decode_map(&m, offset_addr, dynamic_ROM_FILESIZE, td, MAP_LAYOUT_HEADER, map_table_adr, 0, 0);
+	} else {
+		result = decode_map(&m, offset_addr, dynamic_ROM_FILESIZE, td, MAP_LAYOUT_INTERLEAVED, map_table_adr, 0, cell_table_override_adr & ~(ROM_1MB_MASK));
+	}
+	if(result != 0) {
+		con_printf("\n%s table at 0x%x lies outside the rom image.\n\n", td->table_name, (unsigned int)rom_adr);
+		return -1;
+	}
+	m.rom_adr = rom_adr;
+	export_map(&m);
+	render_ctx_init(&rc);
+	show_map(&m, &rc);
+	catalog_note_map(&m);
+	label_add_map(&m);
+	if(map_registry_add(&m) == 0) free_map(&m);
+	return 0;
 }
 
+/*
+ * Dump a table whose x-axis (with x_num), y-axis (with y_num) and cells each live at their own address, e.g. KFZW
+ */
+int dump_split_table(unsigned char *offset_addr, unsigned char *x_axis, unsigned char *y_axis, unsigned char *cells, TABLE_DEF *td)
+{
+	MAP_DATA m;
+	RENDER_CTX rc;
+
+	if(decode_map(&m, offset_addr, dynamic_ROM_FILESIZE, td, MAP_LAYOUT_SPLIT, x_axis-offset_addr, y_axis-offset_addr, cells-offset_addr) != 0) {
+		con_printf("\n%s table lies outside the rom image.\n\n", td->table_name);
+		return -1;
+	}
+	export_map(&m);
+	render_ctx_init(&rc);
+	show_map(&m, &rc);
+	catalog_note_map(&m);
+	label_add_map(&m);
+	if(map_registry_add(&m) == 0) free_map(&m);
+	return 0;
+}
 
 int find_dump_table_dppx(unsigned char *rom_load_addr, int rom_len, unsigned char *needle, unsigned char *needle_mask, unsigned int needle_len, int table_offset, int segment, TABLE_DEF *table_fmt)
 {
@@ -756,7 +518,8 @@ int find_dump_table_dppx(unsigned char *rom_load_addr, int rom_len, unsigned cha
 			// calculate its physical address in memory
 			addr = rom_load_addr+current_offset+new_offset;
 			// show its physical address in rom 
-			printf("Function byte-sequence found @ %#x\n\n",addr-rom_load_addr);
+			con_printf("Function byte-sequence found @ %#x\n\n",addr-rom_load_addr);
+			label_symbol(addr-rom_load_addr, SYM_CODE, table_fmt->table_name);
 			// disassemble needle found in rom
 			if(show_diss) {
 				c167x_diss(addr-rom_load_addr, addr, needle_len+44);
@@ -765,13 +528,13 @@ int find_dump_table_dppx(unsigned char *rom_load_addr, int rom_len, unsigned cha
 			// now lets extract offset from needle to where table is located
 			table_adr = get16((unsigned char *)addr + table_offset);
 			// now lets show the table formatted correctly
-			dump_table(addr, rom_load_addr, table_adr, segment, table_fmt, 0);
+			dump_table(addr, rom_load_addr, table_adr, (segment == SEG_DPP_TRACKED) ? dpp_seg(addr + table_offset - rom_load_addr, table_adr) : segment, table_fmt, 0);
 
 			// search for next match...
 			new_offset += current_offset+needle_len;
 		}
 	}
-	printf("\n");
+	con_printf("\n");
 	return found;
 }
 
@@ -798,12 +561,13 @@ int find_dump_table_seg(unsigned char *rom_load_addr, int rom_len, unsigned char
 			// calculate its physical address in memory
 			addr = rom_load_addr+current_offset+new_offset;
 			// show its physical address in rom 
-			printf("Function byte-sequence found @ %#x, needle offset is +%d bytes, seg offset is +%d bytes\n\n",addr-rom_load_addr, table_offset, segment_offset);			
+			con_printf("Function byte-sequence found @ %#x, needle offset is +%d bytes, seg offset is +%d bytes\n\n",addr-rom_load_addr, table_offset, segment_offset);			
+			label_symbol(addr-rom_load_addr, SYM_CODE, table_fmt->table_name);
 			table_adr = get16((unsigned char *)addr + table_offset);
 			segm_adr  = get16((unsigned char *)addr + segment_offset);			
 
-			printf("valu_adr  : %#4.4x for offset +%d\n",table_adr,table_offset);
-			printf("segm_adr  : %#4.4x for offset +%d\n\n",segm_adr,segment_offset);
+			con_printf("valu_adr  : %#4.4x for offset +%d\n",table_adr,table_offset);
+			con_printf("segm_adr  : %#4.4x for offset +%d\n\n",segm_adr,segment_offset);
 			
 			opcode    = *(unsigned char *)((addr + segment_offset) - 2);
 			found_op  = 0xE6;
@@ -821,12 +585,12 @@ int find_dump_table_seg(unsigned char *rom_load_addr, int rom_len, unsigned char
 				}
 
 				if(segm_adr  > 0x240) { 
-					printf("rom_start : %p\n",rom_load_addr);
-					printf("rom_end   : %p\n",rom_load_addr+rom_len);
-					printf("table_adr : %p\n",table_adr);
-					printf("opcode    : 0x%2X (%s) != 0x%2X\n",opcode, inst_set[opcode].name, found_op );
-					printf("segm_adr  : %p for offset +%d\n",segm_adr,segment_offset);
-					printf("Invalid segment!! Likely a false positive detection at %p!",addr-rom_load_addr);
+					con_printf("rom_start : %p\n",rom_load_addr);
+					con_printf("rom_end   : %p\n",rom_load_addr+rom_len);
+					con_printf("table_adr : %p\n",table_adr);
+					con_printf("opcode    : 0x%2X (%s) != 0x%2X\n",opcode, inst_set[opcode].name, found_op );
+					con_printf("segm_adr  : %p for offset +%d\n",segm_adr,segment_offset);
+					con_printf("Invalid segment!! Likely a false positive detection at %p!",addr-rom_load_addr);
 					found = 0;
 					return found;
 				} else {
@@ -44,8 +44,17 @@ typedef struct ENTRY_DEF {
 		char *fmt_HEX;       // HEX: data formatting for raw hex values
 		char *fmt_ADR;       // ADR: data formatting for physical addresses
 		char *conv_name;     // conversion name
+		double fconv;        // conv as a number (set by CONV() or compile_entry_def())
+		double fconv2;       // conv2 as a number (set by CONV2() or compile_entry_def())
 } ENTRY_DEF;
 
+// conversion values are written once as numbers, the string form is kept for display
+#define CONV(v)		.conv  = #v, .fconv  = (v)
+#define CONV2(v)	.conv2 = #v, .fconv2 = (v)
+
+struct MAP_DATA;
+typedef void (*map_decoder)(struct MAP_DATA *m, unsigned char *rom);
+
 typedef struct TABLE_DEF {
 		char *table_name;           // name of the table 
 		char *table_desc;           // description of the table 
@@ -56,19 +65,71 @@ typedef struct TABLE_DEF {
 		int   x_axis_nwidth;        // width in bytes of the field
 		int   y_axis_nwidth;        // width in bytes of the field 
 		int   cell_nwidth;          // width in bytes of the field
+		int   cell_signed;          // the ecu's lookup sign extends the cells (movbs), e.g. KFZW
 
 		ENTRY_DEF x_axis;			// x-axis format entry
 		ENTRY_DEF y_axis;			// y-axis format entry
 		ENTRY_DEF cell;				// cell format entry
+
+		map_decoder decode;			// decoder specialised for the widths above (bound on first use)
 } TABLE_DEF;
 
-#define FULL_OVERRIDE	1
+// how a table's header, axes and cells are laid out in rom (see decode_map)
+#define MAP_LAYOUT_HEADER		0	// x_num, y_num, x-axis, y-axis, cells
+#define MAP_LAYOUT_INTERLEAVED	1	// x_num, x-axis, y_num, y-axis, cells elsewhere
+#define MAP_LAYOUT_SPLIT		2	// x_num/x-axis, y_num/y-axis and cells each at their own address
+
+// a table decoded from rom, cells are kept row by row
+typedef struct MAP_DATA {
+		TABLE_DEF     *td;			// table format used to decode it
+		int            layout;		// MAP_LAYOUT_xxx
+		unsigned long  rom_adr;		// physical address (seg*SEGMENT_SIZE+val) if known, else 0
+
+		unsigned long  x_num_adr;	// rom file offsets of each part
+		unsigned long  y_num_adr;
+		unsigned long  x_axis_adr;
+		unsigned long  y_axis_adr;
+		unsigned long  cell_adr;
+
+		int            x_num;		// number of columns
+		int            y_num;		// number of rows, 0 for a 1-axis table
+		int            cell_num;	// x_num*y_num, or x_num for a 1-axis table
+
+		uint16_t      *x_raw;		// raw values as stored in rom
+		uint16_t      *y_raw;
+		uint16_t      *cell_raw;
+		double        *x_phy;		// converted physical values
+		double        *y_phy;
+		double        *cell_phy;
+} MAP_DATA;
+
+// what show_map() prints, filled from the -phy/-hex/-adr/-dbg options by render_ctx_init()
+typedef struct RENDER_CTX {
+		int show_phy;
+		int show_hex;
+		int show_adr;
+} RENDER_CTX;
+
+#define MAP_CELL_RAW(m,x,y)	((m)->cell_raw[(y)*(m)->x_num+(x)])
+#define MAP_CELL_PHY(m,x,y)	((m)->cell_phy[(y)*(m)->x_num+(x)])
 
 #define UBYTE 1
 #define UWORD 2
 
 extern TABLE_DEF XXXX_table;
+unsigned long get_nwidth(unsigned char *s, int nwidth);
+void compile_entry_def(ENTRY_DEF *entry);
+double conv_entry_value(ENTRY_DEF *entry, double raw);
+int decode_map(MAP_DATA *m, unsigned char *rom, unsigned long rom_len, TABLE_DEF *td, int layout, unsigned long x_off, unsigned long y_off, unsigned long cell_off);
+void free_map(MAP_DATA *m);
+unsigned long map_cell_adr(MAP_DATA *m, int x, int y);
+void render_ctx_init(RENDER_CTX *rc);
+int show_map(MAP_DATA *m, RENDER_CTX *rc);
 extern int dump_table(unsigned char *adr, unsigned char *offset_addr, unsigned long val, unsigned long seg, TABLE_DEF *td, unsigned long cell_table_override_adr);
+extern int dump_split_table(unsigned char *offset_addr, unsigned char *x_axis, unsigned char *y_axis, unsigned char *cells, TABLE_DEF *td);
+
+// segment for find_dump_table_dppx(), the page is whatever the DPPs hold at each match (see dpptrack.h)
+#define SEG_DPP_TRACKED		(-1)
 
 extern int find_dump_table_dppx(unsigned char *rom_load_addr, int rom_len, unsigned char *needle, unsigned char *needle_mask, unsigned int needle_len, int table_offset, int segment, TABLE_DEF *table_fmt);
 extern int find_dump_table_seg( unsigned char *rom_load_addr, int rom_len, unsigned char *needle, unsigned char *needle_mask, unsigned int needle_len, int table_offset, int segment_offset, TABLE_DEF *table_fmt);
@@ -0,0 +1,404 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "sigdb.h"
+#include "funcindex.h"
+#include "labels.h"
+#include "needlegen.h"
+#include "needlemine.h"
+#include "needles.h"
+#include "inst_c16x.h"
+#include "mapcatalog.h"
+#include "outbuf.h"
+#include <time.h>
+
+#define SIG_PRIME		16777619U	// FNV-1a
+#define SIG_BASIS		2166136261U
+
+typedef struct SIG {
+	unsigned long  len;					// function length in bytes
+	uint32_t       lead;				// hash of the first SIG_LEAD bytes, operands masked
+	uint32_t       body;				// hash of the whole function, operands masked
+	int            roms;				// reference roms it was named in
+	char          *name;
+} SIG;
+
+typedef struct SIG_DB {
+	SIG           *sigs;
+	int            num, size;
+	int           *slots;				// sigs index + 1 by (len, lead), 0 is free
+	int            nslots;
+	int            collisions;			// same signature given another name, the first is kept
+	char          *filename;			// the loaded database
+} SIG_DB;
+
+// a function of a reference rom and its name(s)
+typedef struct SIG_NAMED {
+	unsigned long  start;
+	char           name[SIG_MAX_NAME];
+} SIG_NAMED;
+
+// loaded once for -sigs, the names stay referenced by the symbol index
+static SIG_DB sig_db;
+
+static uint32_t sig_key(unsigned long len, uint32_t lead)
+{
+	return ((uint32_t)len * SIG_PRIME) ^ lead;
+}
+
+/*
+ * Signature of the function at rom offsets [start,end), -1 if it is too short or too long
+ */
+static int sig_make(const uint8_t *rom, unsigned long romlen, unsigned long start, unsigned long end, SIG *s)
+{
+	DIS_INST di;
+	unsigned char mask[4];
+	unsigned long adr;
+	uint32_t h = SIG_BASIS;
+	int i, m, skip, whole;
+
+	if(end > romlen) end = romlen;
+	if(end <= start || end - start < SIG_MIN_LEN || end - start > SIG_MAX_LEN) return -1;
+
+	s->len  = end - start;
+	s->lead = 0;
+	for(adr=start;adr<end;adr+=skip) {
+		skip  = c167x_decode(rom + adr, end - adr, adr, &di);
+		whole = (skip == 0);
+		if(whole) skip = end - adr;		// an instruction cut by the next function, kept whole
+		else      needlegen_mask(&di, mask);
+		for(i=0;i<skip;i++) {
+			m = whole ? MASK : mask[i];
+			if(adr + i - start == SIG_LEAD) s->lead = h;
+			h = (h ^ (rom[adr+i] & m) ^ (m ? 0 : 0x100)) * SIG_PRIME;
+		}
+	}
+	if(s->len <= SIG_LEAD) s->lead = h;
+	s->body = h;
+	return 0;
+}
+
+static int sig_find(SIG_DB *db, const SIG *s)
+{
+	uint32_t i, k;
+	int j;
+
+	if(db->nslots == 0) return -1;
+	for(i=0, k=sig_key(s->len, s->lead);i<(uint32_t)db->nslots;i++, k++) {
+		j = db->slots[k & (db->nslots-1)] - 1;
+		if(j < 0) break;
+		if(db->sigs[j].len == s->len && db->sigs[j].lead == s->lead && db->sigs[j].body == s->body) return j;
+	}
+	return -1;
+}
+
+static int sig_rehash(SIG_DB *db, int nslots)
+{
+	uint32_t k;
+	int i;
+
+	free(db->slots);
+	db->slots = (int *)calloc(nslots, sizeof(int));
+	if(db->slots == 0) {
+		db->nslots = 0;
+		return -1;
+	}
+	db->nslots = nslots;
+	for(i=0;i<db->num;i++) {
+		for(k=sig_key(db->sigs[i].len, db->sigs[i].lead);db->slots[k & (nslots-1)];k++);
+		db->slots[k & (nslots-1)] = i + 1;
+	}
+	return 0;
+}
+
+/*
+ * Add a named signature, returns 1 if it is new, 0 if it was known, -1 on a name collision or no memory
+ */
+static int sig_add(SIG_DB *db, const SIG *s, const char *name, int roms)
+{
+	SIG *p;
+	uint32_t k;
+	int i;
+
+	i = sig_find(db, s);
+	if(i >= 0) {
+		if(strcmp(db->sigs[i].name, name) != 0) {
+			db->collisions++;
+			return -1;
+		}
+		db->sigs[i].roms += roms;
+		return 0;
+	}
+
+	if(db->num == db->size) {
+		p = (SIG *)realloc(db->sigs, (db->size ? db->size*2 : 256) * sizeof(SIG));
+		if(p == 0) return -1;
+		db->sigs = p;
+		db->size = db->size ? db->size*2 : 256;
+	}
+	p = &db->sigs[db->num];
+	*p = *s;
+	p->roms = roms;
+	p->name = strdup(name);
+	if(p->name == 0) return -1;
+	db->num++;
+
+	// slots at most half full
+	if(db->num*2 > db->nslots) return sig_rehash(db, db->nslots ? db->nslots*2 : 1024) == 0 ? 1 : -1;
+	for(k=sig_key(p->len, p->lead);db->slots[k & (db->nslots-1)];k++);
+	db->slots[k & (db->nslots-1)] = db->num;
+	return 1;
+}
+
+static void sig_free(SIG_DB *db)
+{
+	int i;
+
+	for(i=0;i<db->num;i++) free(db->sigs[i].name);
+	free(db->sigs);
+	free(db->slots);
+	free(db->filename);
+	memset(db, 0, sizeof(SIG_DB));
+}
+
+// "0x0052 1a2b3c4d 5e6f7a8b 3 ZWGRU" lines, returns the signatures read, -1 if the file can't be opened
+static int sig_load(SIG_DB *db, const char *filename)
+{
+	FILE *fp;
+	char line[SIG_MAX_LINE], *name, *end;
+	SIG s;
+	unsigned int lead, body;
+	int roms, n = 0, pos;
+
+	fp = fopen(filename, "r");
+	if(fp == 0) return -1;
+	while(fgets(line, sizeof(line), fp) != 0) {
+		if(line[0] == '#' || sscanf(line, "%lx %x %x %d %n", &s.len, &lead, &body, &roms, &pos) != 4) continue;
+		name = line + pos;
+		for(end=name+strlen(name);end>name && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ');end--);
+		*end = 0;
+		if(*name == 0) continue;
+		s.lead = lead;
+		s.body = body;
+		sig_add(db, &s, name, roms);
+		n++;
+	}
+	fclose(fp);
+	return n;
+}
+
+static int cmp_sig(const void *a, const void *b)
+{
+	const SIG *x = (const SIG *)a, *y = (const SIG *)b;
+	int c = strcmp(x->name, y->name);
+
+	if(c) return c;
+	return (x->len > y->len) - (x->len < y->len);
+}
+
+static int sig_save(SIG_DB *db, const char *filename)
+{
+	FILE *fp;
+	int i;
+
+	fp = fopen(filename, "w");
+	if(fp == 0) return -1;
+
+	// sorted by name so databases diff well, the slots no longer match
+	qsort(db->sigs, db->num, sizeof(SIG), cmp_sig);
+	sig_rehash(db, db->nslots ? db->nslots : 1024);
+
+	fprintf(fp, "# me7romtool function signatures (-mksig), %d functions\n", db->num);
+	fprintf(fp, "# length lead(first %d bytes) body roms name, operands masked before hashing\n", SIG_LEAD);
+	for(i=0;i<db->num;i++) {
+		fprintf(fp, "0x%04lx %08x %08x %d %s\n", db->sigs[i].len, db->sigs[i].lead, db->sigs[i].body, db->sigs[i].roms, db->sigs[i].name);
+	}
+	return fclose(fp) == 0 ? 0 : -1;
+}
+
+// name the function containing offset, a function named twice gets both names
+static int add_named(SIG_NAMED *named, int num, unsigned long offset, const char *name)
+{
+	unsigned long start = func_start(offset);
+	size_t len;
+	int i;
+
+	if(start == FUNC_NONE) return num;
+	for(i=0;i<num;i++) {
+		if(named[i].start != start) continue;
+		if(strstr(named[i].name, name) == 0) {
+			len = strlen(named[i].name);
+			snprintf(named[i].name + len, SIG_MAX_NAME - len, "/%s", name);
+		}
+		return num;
+	}
+	named[num].start = start;
+	snprintf(named[num].name, SIG_MAX_NAME, "%s", name);
+	return num + 1;
+}
+
+// "offset name" lines of <romfile>.sym, returns the number of names read
+static int read_sym(const char *romfile, SIG_NAMED *named, int *num, int max)
+{
+	FILE *fp;
+	char filename[MAX_FILENAME+8], line[SIG_MAX_LINE], name[SIG_MAX_NAME];
+	unsigned long offset;
+	int n = 0;
+
+	snprintf(filename, sizeof(filename), "%s.sym", romfile);
+	fp = fopen(filename, "r");
+	if(fp == 0) return 0;
+	while(*num < max && fgets(line, sizeof(line), fp) != 0) {
+		if(line[0] == '#' || line[0] == ';' || sscanf(line, "%lx %63s", &offset, name) != 2) continue;
+		*num = add_named(named, *num, offset & ~(ROM_1MB_MASK), name);
+		n++;
+	}
+	fclose(fp);
+	return n;
+}
+
+/*
+ * -mksig db -romfile ref.bin .. : add the named functions of every reference rom to the database
+ */
+int check_sigbuild(char *dbname, char **romfiles, int num)
+{
+	SIG_DB db;
+	SIG s;
+	SIG_NAMED *named;
+	ImageHandle ih;
+	int i, j, n, max, at, res, by_needle, by_sym, added = 0, known = 0, unsigned_funcs = 0, collisions;
+	int total_new = 0, total_known = 0;
+	clock_t start;
+
+	if(dbname == 0 || num <= 0) return 0;
+	memset(&db, 0, sizeof(db));
+
+	con_printf("\n-[ Function Signature Database ]----------------------------------------------------\n\n");
+
+	start = clock();
+	n = sig_load(&db, dbname);
+	if(n > 0) con_printf(">>> %d signatures already in '%s'\n\n", db.num, dbname);
+
+	max = mine_num_needles + 4096;
+	named = (SIG_NAMED *)malloc(max * sizeof(SIG_NAMED));
+	if(named == 0) {
+		sig_free(&db);
+		return 0;
+	}
+
+	con_printf("  functions  named  needles  .sym    new  known  not signed  rom\n");
+	for(i=0;i<num;i++) {
+		memset(&ih, 0, sizeof(ih));
+		ih.d.p = load_file_ex(romfiles[i], &ih.len, 0);
+		if(ih.d.p == 0 || func_index_build(&ih) != 0) {
+			con_printf("  %9s  %5s  %7s  %4s  %5s  %5s  %10s  %s (failed to load)\n", "-", "-", "-", "-", "-", "-", "-", romfiles[i]);
+			free(ih.d.p);
+			continue;
+		}
+
+		// the routines the needles find, then the user's names
+		n = by_needle = 0;
+		for(j=0;j<mine_num_needles;j++) {
+			at = search_image(&ih, 0, mine_needles[j].needle, mine_needles[j].mask, *mine_needles[j].len, 2);
+			if(at < 0) continue;
+			n = add_named(named, n, at, mine_needles[j].family);
+			by_needle++;
+		}
+		by_sym = read_sym(romfiles[i], named, &n, max);
+
+		added = known = unsigned_funcs = 0;
+		collisions = db.collisions;
+		for(j=0;j<n;j++) {
+			if(sig_make(ih.d.u8, ih.len, named[j].start, func_end(named[j].start), &s) != 0) {
+				unsigned_funcs++;
+				continue;
+			}
+			res = sig_add(&db, &s, named[j].name, 1);
+			if(res == 1) added++;
+			if(res == 0) known++;
+		}
+		con_printf("  %9d  %5d  %7d  %4d  %5d  %5d  %10d  %s%s\n", func_index_num(), n, by_needle, by_sym, added, known, unsigned_funcs,
+			romfiles[i], db.collisions > collisions ? " (name collisions)" : "");
+		total_new   += added;
+		total_known += known;
+
+		func_index_free();
+		free(ih.d.p);
+	}
+	free(named);
+
+	if(sig_save(&db, dbname) != 0) {
+		con_printf("\ncan't write signature database '%s'\n", dbname);
+	} else {
+		con_printf("\n%d signatures written to '%s', %d new, %d seen again, %d name collisions kept the first name (%.2f ms)\n",
+			db.num, dbname, total_new, total_known, db.collisions, 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC);
+	}
+	n = db.num;
+	sig_free(&db);
+	return n;
+}
+
+/*
+ * -sigs db : name every function of the rom that has a signature in the database
+ */
+int check_sigs(ImageHandle *fh, char *dbname)
+{
+	OUTBUF *ob = ob_get();
+	SIG s;
+	unsigned long a, b;
+	int i, j, num, found = 0, signed_funcs = 0;
+	clock_t start;
+
+	if(dbname == 0) return 0;
+
+	con_printf("\n-[ Function Signatures ]------------------------------------------------------------\n\n");
+
+	// loaded for the first rom, kept for the rest of the run
+	if(sig_db.filename == 0 || strcmp(sig_db.filename, dbname) != 0) {
+		sig_free(&sig_db);
+		if(sig_load(&sig_db, dbname) < 0) {
+			con_printf("can't read signature database '%s'\n", dbname);
+			return 0;
+		}
+		sig_db.filename = strdup(dbname);
+	}
+
+	start = clock();
+	num = func_index_num();
+	for(i=0;i<num;i++) {
+		a = func_at(i);
+		b = func_end(a);
+		if(sig_make(fh->d.u8, fh->len, a, b, &s) != 0) continue;
+		signed_funcs++;
+		if((j = sig_find(&sig_db, &s)) < 0) continue;
+
+		if(found++ == 0) {
+			ob_printf(ob, "  %-8s  %-8s  %6s  %4s  %s\n", "offset", "address", "length", "roms", "name");
+		}
+		ob_printf(ob, "  0x%06lx  0x%06lx  %6lu  %4d  %s\n", a, a + CAT_ROM_BASE, s.len, sig_db.sigs[j].roms, sig_db.sigs[j].name);
+		label_symbol(a, SYM_CODE, sig_db.sigs[j].name);
+	}
+	ob_flush(ob);
+
+	con_printf("%s%d of %d functions named (%d long enough to sign) from %d signatures in '%s' (%.2f ms)\n",
+		found ? "\n" : "", found, num, signed_funcs, sig_db.num, dbname, 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC);
+	return found;
+}
@@ -0,0 +1,47 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+#ifndef _SIGDB_SUPPORT_H
+#define _SIGDB_SUPPORT_H
+#include "utils.h"
+
+// Function signatures, in the spirit of IDA's FLIRT: each function of the function index is
+// reduced to its length, a hash of its first SIG_LEAD bytes and a hash of its whole body, both
+// with the relocatable operands masked the way -mkneedle masks them. The database is keyed by
+// (length, lead hash), so naming every function of a rom is one hash lookup per function
+// boundary, the body hash then confirms the match.
+//
+// The database is a text file with one signature per line, built by -mksig from reference roms.
+// Their functions are named by the built in needles (the function each needle hits in) and by an
+// optional <romfile>.sym of "offset name" lines (rom offsets or 0x8xxxxx addresses). Databases
+// can be concatenated, the first name given to a signature is kept.
+
+#define SIG_LEAD			32			// bytes in the lead hash
+#define SIG_MIN_LEN			12			// shorter functions (stubs, lone returns) are everywhere
+#define SIG_MAX_LEN			(16*1024)
+#define SIG_MAX_NAME		64
+#define SIG_MAX_LINE		256
+
+int  check_sigbuild(char *dbname, char **romfiles, int num);
+int  check_sigs(ImageHandle *fh, char *dbname);
+
+#endif
@@ -0,0 +1,755 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include <stdint.h>
+#include "table_ini.h"
+#include "table_spec.h"
+#include "needles.h"
+#include "inifile/inifile.h"
+
+extern unsigned long dpp0_value, dpp1_value, dpp2_value, dpp3_value;
+
+/*
+ * Cache file layout, all little endian and written with the structs below:
+ *
+ *   CACHE_HEADER
+ *   CACHE_DEF    [num_defs]
+ *   CACHE_BIND   [num_binds]
+ *   char strings [strings_len]		NUL terminated strings, offset 0 is the NULL pointer
+ *
+ * Parsing the .ini produces exactly this image in memory, so a fresh parse and a cache
+ * hit both end up in instantiate().
+ */
+
+typedef struct CACHE_HEADER {
+	char     magic[8];
+	uint32_t version;
+	uint32_t stamp;				// hash of the built-in tables and cache structs, see build_stamp()
+	uint32_t src_size;			// .ini size and content hash the cache was built from
+	uint32_t src_hash;
+	uint32_t num_defs;
+	uint32_t num_binds;
+	uint32_t strings_len;
+	uint32_t data_hash;			// hash of everything after the header
+} CACHE_HEADER;
+
+typedef struct CACHE_ENTRY {
+	uint32_t field_name, conv, conv2, desc, fmt_PHY, fmt_HEX, fmt_ADR, conv_name;
+	int32_t  nwidth;
+	int32_t  otype;
+	double   fconv;
+	double   fconv2;
+} CACHE_ENTRY;
+
+typedef struct CACHE_DEF {
+	uint32_t    hash;			// fnv1a(table_name)
+	uint32_t    table_name, table_desc;
+	int32_t     x_num_nwidth, y_num_nwidth;
+	int32_t     x_axis_nwidth, y_axis_nwidth, cell_nwidth, cell_signed;
+	CACHE_ENTRY x_axis, y_axis, cell;
+} CACHE_DEF;
+
+typedef struct CACHE_BIND {
+	uint32_t def;				// index into the CACHE_DEF array
+	int32_t  method, table_offset, segment_offset, dpp, segment, needle_len;
+	uint8_t  needle[MAX_INI_NEEDLE];
+	uint8_t  mask[MAX_INI_NEEDLE];
+} CACHE_BIND;
+
+typedef struct CACHE_IMAGE {
+	CACHE_HEADER hdr;
+	CACHE_DEF    *defs;
+	CACHE_BIND   *binds;
+	char         *strings;
+	size_t        strings_size;
+} CACHE_IMAGE;
+
+// loaded definitions, these live for the rest of the run
+static char          *ini_strings;
+static TABLE_DEF     *ini_tables;
+static int            ini_tables_num;
+static TABLE_BINDING *ini_binds;
+static int            ini_binds_num;
+
+static TABLE_DEF     *table_hash[TABLE_HASH_SIZE];
+static int            table_hash_built;
+
+// new tables start from the formats most of table_spec.c uses
+static const TABLE_DEF default_table = {
+	.x_num_nwidth  = UBYTE, .y_num_nwidth  = UBYTE,
+	.x_axis_nwidth = UBYTE, .y_axis_nwidth = UBYTE,
+	.cell_nwidth   = UBYTE,
+	.x_axis = { .field_name = "X-axis", .nwidth = UBYTE, CONV(1), .desc = " ", .fmt_PHY = "%8.2f ", .fmt_HEX = "0x%X ",    .fmt_ADR = "  %#6x ",  .conv_name = " " },
+	.y_axis = { .field_name = "Y-axis", .nwidth = UBYTE, CONV(1), .desc = " ", .fmt_PHY = " %-6.2f", .fmt_HEX = "%-#8.4x ", .fmt_ADR = "%-#9.5x ", .conv_name = " " },
+	.cell   = { .field_name = "Cells",  .nwidth = UBYTE, CONV(1), .desc = " ", .fmt_PHY = "%8.2f ", .fmt_HEX = "  %#6x ",  .fmt_ADR = "%#6x ",    .conv_name = " " },
+};
+
+static uint32_t fnv1a(const char *s, uint32_t h)
+{
+	if(s == 0) return h;
+	for(;*s;s++) {
+		h ^= (unsigned char)*s;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static uint32_t fnv1a_mem(const void *p, size_t len, uint32_t h)
+{
+	const unsigned char *s = p;
+	while(len--) {
+		h ^= *s++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+#define FNV_INIT	2166136261u
+
+/*
+ * Name lookup over the built-in and loaded tables
+ */
+static void table_hash_insert(TABLE_DEF *td)
+{
+	uint32_t i = fnv1a(td->table_name, FNV_INIT) & (TABLE_HASH_SIZE-1);
+
+	while(table_hash[i] != 0) {
+		if(strcmp(table_hash[i]->table_name, td->table_name) == 0) break;
+		i = (i+1) & (TABLE_HASH_SIZE-1);
+	}
+	table_hash[i] = td;
+}
+
+static void table_hash_build(void)
+{
+	int i;
+
+	memset(table_hash, 0, sizeof(table_hash));
+	for(i=0;i<builtin_tables_num;i++) table_hash_insert(builtin_tables[i]);
+	for(i=0;i<ini_tables_num;i++)     table_hash_insert(&ini_tables[i]);
+	table_hash_built = 1;
+}
+
+TABLE_DEF *table_def_find(const char *name)
+{
+	uint32_t i;
+
+	if(name == 0) return 0;
+	if(!table_hash_built) table_hash_build();
+
+	i = fnv1a(name, FNV_INIT) & (TABLE_HASH_SIZE-1);
+	while(table_hash[i] != 0) {
+		if(strcmp(table_hash[i]->table_name, name) == 0) return table_hash[i];
+		i = (i+1) & (TABLE_HASH_SIZE-1);
+	}
+	return 0;
+}
+
+/*
+ * A cache is only valid for the built-in tables it was resolved against (overrides start
+ * from them) and for this cache layout, so both go into the stamp.
+ */
+static void stamp_entry(uint32_t *h, ENTRY_DEF *e)
+{
+	*h = fnv1a(e->field_name, *h);
+	*h = fnv1a(e->conv, *h);
+	*h = fnv1a(e->conv2, *h);
+	*h = fnv1a(e->desc, *h);
+	*h = fnv1a(e->fmt_PHY, *h);
+	*h = fnv1a(e->fmt_HEX, *h);
+	*h = fnv1a(e->fmt_ADR, *h);
+	*h = fnv1a(e->conv_name, *h);
+	*h = fnv1a_mem(&e->nwidth, sizeof(e->nwidth), *h);
+	*h = fnv1a_mem(&e->otype, sizeof(e->otype), *h);
+}
+
+static uint32_t build_stamp(void)
+{
+	uint32_t h = FNV_INIT;
+	uint32_t sizes[4] = { sizeof(CACHE_HEADER), sizeof(CACHE_DEF), sizeof(CACHE_BIND), MAX_INI_NEEDLE };
+	TABLE_DEF *td;
+	int i;
+
+	h = fnv1a_mem(sizes, sizeof(sizes), h);
+	for(i=0;i<builtin_tables_num;i++) {
+		td = builtin_tables[i];
+		h = fnv1a(td->table_name, h);
+		h = fnv1a(td->table_desc, h);
+		h = fnv1a_mem(&td->x_num_nwidth,  sizeof(int), h);
+		h = fnv1a_mem(&td->y_num_nwidth,  sizeof(int), h);
+		h = fnv1a_mem(&td->x_axis_nwidth, sizeof(int), h);
+		h = fnv1a_mem(&td->y_axis_nwidth, sizeof(int), h);
+		h = fnv1a_mem(&td->cell_nwidth,   sizeof(int), h);
+		h = fnv1a_mem(&td->cell_signed,   sizeof(int), h);
+		stamp_entry(&h, &td->x_axis);
+		stamp_entry(&h, &td->y_axis);
+		stamp_entry(&h, &td->cell);
+	}
+	return h;
+}
+
+/*
+ * String pool of the cache image
+ */
+static uint32_t pool_add(CACHE_IMAGE *ci, const char *s)
+{
+	size_t len, size;
+	uint32_t off;
+	char *p;
+
+	if(s == 0) return 0;
+	len = strlen(s) + 1;
+
+	if(ci->hdr.strings_len + len > ci->strings_size) {
+		size = ci->strings_size ? ci->strings_size : 4096;
+		while(size < ci->hdr.strings_len + len) size *= 2;
+		p = realloc(ci->strings, size);
+		if(p == 0) return 0;
+		ci->strings      = p;
+		ci->strings_size = size;
+	}
+	if(ci->hdr.strings_len == 0) ci->strings[ci->hdr.strings_len++] = 0;	// offset 0 is NULL
+
+	off = ci->hdr.strings_len;
+	memcpy(ci->strings + off, s, len);
+	ci->hdr.strings_len += len;
+	return off;
+}
+
+static void store_entry(CACHE_IMAGE *ci, CACHE_ENTRY *ce, ENTRY_DEF *e)
+{
+	ce->field_name = pool_add(ci, e->field_name);
+	ce->conv       = pool_add(ci, e->conv);
+	ce->conv2      = pool_add(ci, e->conv2);
+	ce->desc       = pool_add(ci, e->desc);
+	ce->fmt_PHY    = pool_add(ci, e->fmt_PHY);
+	ce->fmt_HEX    = pool_add(ci, e->fmt_HEX);
+	ce->fmt_ADR    = pool_add(ci, e->fmt_ADR);
+	ce->conv_name  = pool_add(ci, e->conv_name);
+	ce->nwidth     = e->nwidth;
+	ce->otype      = e->otype;
+	ce->fconv      = e->fconv;
+	ce->fconv2     = e->fconv2;
+}
+
+static void store_def(CACHE_IMAGE *ci, CACHE_DEF *cd, TABLE_DEF *td)
+{
+	memset(cd, 0, sizeof(CACHE_DEF));
+	cd->hash          = fnv1a(td->table_name, FNV_INIT);
+	cd->table_name    = pool_add(ci, td->table_name);
+	cd->table_desc    = pool_add(ci, td->table_desc);
+	cd->x_num_nwidth  = td->x_num_nwidth;
+	cd->y_num_nwidth  = td->y_num_nwidth;
+	cd->x_axis_nwidth = td->x_axis_nwidth;
+	cd->y_axis_nwidth = td->y_axis_nwidth;
+	cd->cell_nwidth   = td->cell_nwidth;
+	cd->cell_signed   = td->cell_signed;
+	store_entry(ci, &cd->x_axis, &td->x_axis);
+	store_entry(ci, &cd->y_axis, &td->y_axis);
+	store_entry(ci, &cd->cell,   &td->cell);
+}
+
+static char *pool_str(CACHE_IMAGE *ci, uint32_t off)
+{
+	return off ? ci->strings + off : 0;
+}
+
+static void load_entry(CACHE_IMAGE *ci, ENTRY_DEF *e, CACHE_ENTRY *ce)
+{
+	e->field_name = pool_str(ci, ce->field_name);
+	e->conv       = pool_str(ci, ce->conv);
+	e->conv2      = pool_str(ci, ce->conv2);
+	e->desc       = pool_str(ci, ce->desc);
+	e->fmt_PHY    = pool_str(ci, ce->fmt_PHY);
+	e->fmt_HEX    = pool_str(ci, ce->fmt_HEX);
+	e->fmt_ADR    = pool_str(ci, ce->fmt_ADR);
+	e->conv_name  = pool_str(ci, ce->conv_name);
+	e->nwidth     = ce->nwidth;
+	e->otype      = ce->otype;
+	e->fconv      = ce->fconv;
+	e->fconv2     = ce->fconv2;
+}
+
+static TABLE_DEF *builtin_find(const char *name)
+{
+	int i;
+
+	for(i=0;i<builtin_tables_num;i++) {
+		if(strcmp(builtin_tables[i]->table_name, name) == 0) return builtin_tables[i];
+	}
+	return 0;
+}
+
+/*
+ * Turn a cache image (parsed or read back) into live TABLE_DEFs and bindings.
+ * Definitions named like a built-in table are copied over it, so the existing
+ * check_xxx() functions pick up the change.
+ */
+static int instantiate(CACHE_IMAGE *ci)
+{
+	TABLE_DEF td, *dst;
+	CACHE_DEF *cd;
+	CACHE_BIND *cb;
+	TABLE_DEF **defs;
+	int i, num_new = 0;
+
+	defs = calloc(ci->hdr.num_defs + 1, sizeof(TABLE_DEF *));
+	ini_tables = calloc(ci->hdr.num_defs + 1, sizeof(TABLE_DEF));
+	ini_binds  = calloc(ci->hdr.num_binds + 1, sizeof(TABLE_BINDING));
+	if(defs == 0 || ini_tables == 0 || ini_binds == 0) {
+		printf("Failed to allocate table definitions\n");
+		free(defs);
+		return -1;
+	}
+
+	for(i=0;i<(int)ci->hdr.num_defs;i++) {
+		cd = &ci->defs[i];
+		memset(&td, 0, sizeof(TABLE_DEF));
+		td.table_name    = pool_str(ci, cd->table_name);
+		td.table_desc    = pool_str(ci, cd->table_desc);
+		td.x_num_nwidth  = cd->x_num_nwidth;
+		td.y_num_nwidth  = cd->y_num_nwidth;
+		td.x_axis_nwidth = cd->x_axis_nwidth;
+		td.y_axis_nwidth = cd->y_axis_nwidth;
+		td.cell_nwidth   = cd->cell_nwidth;
+		td.cell_signed   = cd->cell_signed;
+		load_entry(ci, &td.x_axis, &cd->x_axis);
+		load_entry(ci, &td.y_axis, &cd->y_axis);
+		load_entry(ci, &td.cell,   &cd->cell);
+
+		dst = builtin_find(td.table_name);
+		if(dst == 0) dst = &ini_tables[num_new++];
+		*dst = td;
+		defs[i] = dst;
+	}
+	ini_tables_num = num_new;
+
+	for(i=0;i<(int)ci->hdr.num_binds;i++) {
+		cb = &ci->binds[i];
+		ini_binds[i].td             = defs[cb->def];
+		ini_binds[i].method         = cb->method;
+		ini_binds[i].table_offset   = cb->table_offset;
+		ini_binds[i].segment_offset = cb->segment_offset;
+		ini_binds[i].dpp            = cb->dpp;
+		ini_binds[i].segment        = cb->segment;
+		ini_binds[i].needle_len     = cb->needle_len;
+		memcpy(ini_binds[i].needle, cb->needle, MAX_INI_NEEDLE);
+		memcpy(ini_binds[i].mask,   cb->mask,   MAX_INI_NEEDLE);
+	}
+	ini_binds_num = ci->hdr.num_binds;
+
+	ini_strings = ci->strings;
+	free(defs);
+	table_hash_build();
+	return 0;
+}
+
+/*
+ * .ini parsing
+ */
+static int parse_width(const char *s, int *w)
+{
+	if(strcasecmp(s, "byte") == 0 || strcasecmp(s, "ubyte") == 0) { *w = UBYTE; return 0; }
+	if(strcasecmp(s, "word") == 0 || strcasecmp(s, "uword") == 0) { *w = UWORD; return 0; }
+	if((s[0] == '0' || s[0] == '1' || s[0] == '2') && s[1] == 0)  { *w = s[0] - '0'; return 0; }
+	return -1;
+}
+
+static int parse_int(const char *s, int *v)
+{
+	char *end;
+	long l = strtol(s, &end, 0);
+
+	if(end == s || *end != 0) return -1;
+	*v = (int)l;
+	return 0;
+}
+
+// "88 90 F2 F4 XX XX C2 F5", XX or ?? is a wildcard byte
+static int parse_needle(const char *s, CACHE_BIND *cb)
+{
+	char *end;
+	unsigned long b;
+
+	cb->needle_len = 0;
+	while(*s) {
+		if(*s == ' ' || *s == '\t' || *s == ',') {
+			s++;
+			continue;
+		}
+		if(cb->needle_len >= MAX_INI_NEEDLE) return -1;
+		if((s[0] == 'X' || s[0] == 'x' || s[0] == '?') && s[1] == s[0]) {
+			cb->needle[cb->needle_len] = 0;
+			cb->mask[cb->needle_len++] = XXXX;
+			s += 2;
+			continue;
+		}
+		b = strtoul(s, &end, 16);
+		if(end == s || b > 0xff) return -1;
+		cb->needle[cb->needle_len] = b;
+		cb->mask[cb->needle_len++] = MASK;
+		s = end;
+	}
+	return cb->needle_len ? 0 : -1;
+}
+
+// "dpp1-1", "dpp1+2", "dpp3" or a plain segment number
+static int parse_segment(const char *s, CACHE_BIND *cb)
+{
+	if(strncasecmp(s, "dpp", 3) == 0 && s[3] >= '0' && s[3] <= '3') {
+		cb->dpp = s[3] - '0';
+		cb->segment = 0;
+		return s[4] ? parse_int(s+4, &cb->segment) : 0;
+	}
+	cb->dpp = -1;
+	return parse_int(s, &cb->segment);
+}
+
+static int parse_entry_key(ENTRY_DEF *e, const char *key, char *val)
+{
+	if(strcmp(key, "name") == 0)           e->field_name = val;
+	else if(strcmp(key, "conv") == 0)      { e->conv  = val; e->fconv  = strtod(val, NULL); }
+	else if(strcmp(key, "conv2") == 0)     { e->conv2 = val; e->fconv2 = strtod(val, NULL); }
+	else if(strcmp(key, "unit") == 0)      e->desc      = val;
+	else if(strcmp(key, "fmt") == 0)       e->fmt_PHY   = val;
+	else if(strcmp(key, "hex") == 0)       e->fmt_HEX   = val;
+	else if(strcmp(key, "adr") == 0)       e->fmt_ADR   = val;
+	else if(strcmp(key, "conv_name") == 0) e->conv_name = val;
+	else if(strcmp(key, "op") == 0) {
+		if(strlen(val) != 1 || strchr("/*dx", val[0]) == 0) return -1;
+		e->otype = (val[0] == '/') ? 0 : val[0];
+	}
+	else return -1;
+	return 0;
+}
+
+static int parse_section(struct section *sect, TABLE_DEF *td, CACHE_BIND *cb)
+{
+	struct property *prop;
+	TABLE_DEF *builtin = builtin_find(sect->name);
+	char *val, *key;
+	int ret;
+
+	*td = builtin ? *builtin : default_table;
+	td->table_name = sect->name;
+	td->decode     = 0;
+	if(builtin == 0) td->table_desc = sect->name;
+
+	memset(cb, 0, sizeof(CACHE_BIND));
+	cb->dpp = -1;
+
+	for(prop = sect->properties; prop != 0; prop = prop->next) {
+		key = prop->name;
+		val = prop->value ? prop->value : "";
+
+		ret = 0;
+		if(strcmp(key, "desc") == 0)                td->table_desc = val;
+		else if(strcmp(key, "x_num") == 0)          ret = parse_width(val, &td->x_num_nwidth);
+		else if(strcmp(key, "y_num") == 0)          ret = parse_width(val, &td->y_num_nwidth);
+		else if(strcmp(key, "x_axis") == 0)         ret = parse_width(val, &td->x_axis.nwidth);
+		else if(strcmp(key, "y_axis") == 0)         ret = parse_width(val, &td->y_axis.nwidth);
+		else if(strcmp(key, "cells") == 0)          ret = parse_width(val, &td->cell.nwidth);
+		else if(strcmp(key, "signed") == 0)         ret = parse_int(val, &td->cell_signed);
+		else if(strncmp(key, "x.", 2) == 0)         ret = parse_entry_key(&td->x_axis, key+2, val);
+		else if(strncmp(key, "y.", 2) == 0)         ret = parse_entry_key(&td->y_axis, key+2, val);
+		else if(strncmp(key, "cell.", 5) == 0)      ret = parse_entry_key(&td->cell,   key+5, val);
+		else if(strcmp(key, "needle") == 0)         ret = parse_needle(val, cb);
+		else if(strcmp(key, "table_offset") == 0)   ret = parse_int(val, &cb->table_offset);
+		else if(strcmp(key, "segment_offset") == 0) ret = parse_int(val, &cb->segment_offset);
+		else if(strcmp(key, "segment") == 0)        ret = parse_segment(val, cb);
+		else if(strcmp(key, "find") == 0) {
+			if(strcasecmp(val, "seg") == 0)       cb->method = BIND_SEG;
+			else if(strcasecmp(val, "dppx") == 0) cb->method = BIND_DPPX;
+			else                                  cb->method = -1;
+			if(cb->method < 0) ret = -1;
+		}
+		else {
+			printf("[%s] unknown key '%s'\n", sect->name, key);
+			return -1;
+		}
+
+		if(ret != 0) {
+			printf("[%s] bad value for '%s': '%s'\n", sect->name, key, val);
+			return -1;
+		}
+	}
+
+	// the entries carry the same width as the table part they describe
+	if(find_property(sect, "x_axis")) td->x_axis_nwidth = td->x_axis.nwidth;
+	if(find_property(sect, "y_axis")) td->y_axis_nwidth = td->y_axis.nwidth;
+	if(find_property(sect, "cells"))  td->cell_nwidth   = td->cell.nwidth;
+
+	if(td->x_axis_nwidth > UWORD || td->y_axis_nwidth > UWORD || td->cell_nwidth > UWORD || td->x_num_nwidth == 0) {
+		printf("[%s] unsupported field widths\n", sect->name);
+		return -1;
+	}
+	if(cb->needle_len != 0 && cb->method == BIND_NONE) cb->method = BIND_SEG;
+	if(cb->method != BIND_NONE && cb->needle_len == 0) {
+		printf("[%s] find= needs a needle\n", sect->name);
+		return -1;
+	}
+	// like the built-in dppx checks (see pukans.c), a table without a segment is at dpp1-1
+	if(cb->method == BIND_DPPX && cb->dpp < 0 && cb->segment == 0) { cb->dpp = 1; cb->segment = -1; }
+	return 0;
+}
+
+static int parse_ini(const char *filename, char *text, CACHE_IMAGE *ci)
+{
+	struct section *sections, *sect;
+	TABLE_DEF td;
+	CACHE_BIND cb;
+	int num = 0, ret = 0;
+
+	sections = parse_properties(text);
+	if(sections == 0) return -1;
+
+	for(sect = sections; sect != 0; sect = sect->next) num++;
+	if(num > MAX_INI_TABLES) {
+		printf("%s: too many tables (%d, max %d)\n", filename, num, MAX_INI_TABLES);
+		free_properties(sections);
+		return -1;
+	}
+
+	ci->defs  = calloc(num + 1, sizeof(CACHE_DEF));
+	ci->binds = calloc(num + 1, sizeof(CACHE_BIND));
+	if(ci->defs == 0 || ci->binds == 0) {
+		free_properties(sections);
+		return -1;
+	}
+
+	for(sect = sections; sect != 0; sect = sect->next) {
+		if(parse_section(sect, &td, &cb) != 0) {
+			ret = -1;
+			break;
+		}
+		store_def(ci, &ci->defs[ci->hdr.num_defs], &td);
+		if(cb.method != BIND_NONE) {
+			cb.def = ci->hdr.num_defs;
+			ci->binds[ci->hdr.num_binds++] = cb;
+		}
+		ci->hdr.num_defs++;
+	}
+	free_properties(sections);
+
+	if(ret == 0 && ci->strings == 0) pool_add(ci, "");		// keep an empty file's pool valid
+	return ret;
+}
+
+/*
+ * Cache file
+ */
+static void cache_name(char *dst, const char *filename)
+{
+	snprintf(dst, MAX_FILENAME, "%s%s", filename, TABLE_CACHE_EXT);
+}
+
+static uint32_t image_hash(CACHE_IMAGE *ci)
+{
+	uint32_t h = FNV_INIT;
+
+	h = fnv1a_mem(ci->defs,    ci->hdr.num_defs  * sizeof(CACHE_DEF),  h);
+	h = fnv1a_mem(ci->binds,   ci->hdr.num_binds * sizeof(CACHE_BIND), h);
+	h = fnv1a_mem(ci->strings, ci->hdr.strings_len, h);
+	return h;
+}
+
+static int read_cache(const char *filename, uint32_t src_size, uint32_t src_hash, CACHE_IMAGE *ci)
+{
+	char name[MAX_FILENAME];
+	CACHE_HEADER *h = &ci->hdr;
+	size_t defs_len, binds_len;
+	FILE *fp;
+	int ok = 0;
+
+	cache_name(name, filename);
+	fp = fopen(name, "rb");
+	if(fp == 0) return -1;
+
+	if(fread(h, sizeof(CACHE_HEADER), 1, fp) == 1
+		&& memcmp(h->magic, TABLE_CACHE_MAGIC, sizeof(h->magic)) == 0
+		&& h->version   == TABLE_CACHE_VERSION
+		&& h->stamp     == build_stamp()
+		&& h->src_size  == src_size
+		&& h->src_hash  == src_hash
+		&& h->num_defs  <= MAX_INI_TABLES
+		&& h->num_binds <= h->num_defs
+		&& h->strings_len > 0) {
+
+		defs_len  = h->num_defs  * sizeof(CACHE_DEF);
+		binds_len = h->num_binds * sizeof(CACHE_BIND);
+		ci->defs    = malloc(defs_len + 1);
+		ci->binds   = malloc(binds_len + 1);
+		ci->strings = malloc(h->strings_len);
+
+		if(ci->defs && ci->binds && ci->strings
+			&& fread(ci->defs,    1, defs_len,       fp) == defs_len
+			&& fread(ci->binds,   1, binds_len,      fp) == binds_len
+			&& fread(ci->strings, 1, h->strings_len, fp) == h->strings_len
+			&& fgetc(fp) == EOF
+			&& ci->strings[h->strings_len-1] == 0
+			&& image_hash(ci) == h->data_hash) {
+			ok = 1;
+		}
+	}
+	fclose(fp);
+	if(!ok) return -1;
+
+	// never trust offsets from disk
+	{
+		uint32_t i, n, *off;
+		CACHE_ENTRY *ce[3];
+		int j;
+
+		for(i=0;i<h->num_defs;i++) {
+			if(ci->defs[i].table_name == 0 || ci->defs[i].table_name >= h->strings_len || ci->defs[i].table_desc >= h->strings_len) return -1;
+			if(ci->defs[i].hash != fnv1a(ci->strings + ci->defs[i].table_name, FNV_INIT)) return -1;
+			ce[0] = &ci->defs[i].x_axis;
+			ce[1] = &ci->defs[i].y_axis;
+			ce[2] = &ci->defs[i].cell;
+			for(j=0;j<3;j++) {
+				off = &ce[j]->field_name;
+				for(n=0;n<8;n++) if(off[n] >= h->strings_len) return -1;
+			}
+		}
+		for(i=0;i<h->num_binds;i++) {
+			if(ci->binds[i].def >= h->num_defs || ci->binds[i].needle_len > MAX_INI_NEEDLE) return -1;
+		}
+	}
+	return 0;
+}
+
+static void write_cache(const char *filename, uint32_t src_size, uint32_t src_hash, CACHE_IMAGE *ci)
+{
+	char name[MAX_FILENAME];
+	FILE *fp;
+	int ok;
+
+	memcpy(ci->hdr.magic, TABLE_CACHE_MAGIC, sizeof(ci->hdr.magic));
+	ci->hdr.version   = TABLE_CACHE_VERSION;
+	ci->hdr.stamp     = build_stamp();
+	ci->hdr.src_size  = src_size;
+	ci->hdr.src_hash  = src_hash;
+	ci->hdr.data_hash = image_hash(ci);
+
+	// a read only location just means parsing again next time
+	cache_name(name, filename);
+	fp = fopen(name, "wb");
+	if(fp == 0) return;
+
+	ok = fwrite(&ci->hdr, sizeof(CACHE_HEADER), 1, fp) == 1
+		&& fwrite(ci->defs,    sizeof(CACHE_DEF),  ci->hdr.num_defs,  fp) == ci->hdr.num_defs
+		&& fwrite(ci->binds,   sizeof(CACHE_BIND), ci->hdr.num_binds, fp) == ci->hdr.num_binds
+		&& fwrite(ci->strings, 1, ci->hdr.strings_len, fp) == ci->hdr.strings_len;
+	if(fclose(fp) != 0 || !ok) remove(name);
+}
+
+static void free_image(CACHE_IMAGE *ci)
+{
+	free(ci->defs);
+	free(ci->binds);
+	free(ci->strings);
+	memset(ci, 0, sizeof(CACHE_IMAGE));
+}
+
+/*
+ * Load table definitions from an .ini file (or its up to date cache)
+ */
+int table_ini_load(const char *filename)
+{
+	CACHE_IMAGE ci;
+	uint8_t *text, *p;
+	size_t len;
+	uint32_t hash;
+	int cached = 1;
+
+	if(ini_strings != 0) {
+		printf("Table definitions are already loaded\n");
+		return -1;
+	}
+
+	// hashing the text is cheap next to parsing it, and unlike a timestamp it can't be fooled
+	text = load_file_ex(filename, &len, 0);
+	if(text == 0 || (p = realloc(text, len+1)) == 0) {
+		printf("Failed to open table definitions %s\n", filename);
+		free(text);
+		return -1;
+	}
+	text = p;
+	text[len] = 0;
+	hash = fnv1a_mem(text, len, FNV_INIT);
+
+	memset(&ci, 0, sizeof(CACHE_IMAGE));
+	if(read_cache(filename, len, hash, &ci) != 0) {
+		free_image(&ci);
+		cached = 0;
+		if(parse_ini(filename, (char *)text, &ci) != 0) {
+			printf("Failed to load table definitions from %s\n", filename);
+			free_image(&ci);
+			free(text);
+			return -1;
+		}
+		write_cache(filename, len, hash, &ci);
+	}
+	free(text);
+
+	if(instantiate(&ci) != 0) {
+		free_image(&ci);
+		return -1;
+	}
+	printf("Loaded %d table definitions (%d new, %d with needles) from %s%s\n",
+		ci.hdr.num_defs, ini_tables_num, ini_binds_num, filename, cached ? " (cached)" : "");
+
+	// the string pool now belongs to the tables
+	free(ci.defs);
+	free(ci.binds);
+	return 0;
+}
+
+/*
+ * Search for and show every table with a needle in the loaded .ini
+ */
+int check_ini_tables(ImageHandle *fh, int skip)
+{
+	TABLE_BINDING *b;
+	unsigned long dpp[4] = { dpp0_value, dpp1_value, dpp2_value, dpp3_value };
+	int i, found, total = 0;
+
+	if(skip == 0) return 0;
+
+	for(i=0;i<ini_binds_num;i++) {
+		b = &ini_binds[i];
+
+		con_printf("\n-[ %s %s ]-----------------------------------------------------------\n\n", b->td->table_name, b->td->table_desc);
+		con_printf(">>> Scanning for %s Table Lookup code sequence... \n", b->td->table_name);
+
+		if(b->method == BIND_DPPX) {
+			found = find_dump_table_dppx(fh->d.p, fh->len, b->needle, b->mask, b->needle_len, b->table_offset,
+				(b->dpp >= 0 ? (int)dpp[b->dpp] : 0) + b->segment, b->td);
+		} else {
+			found = find_dump_table_seg(fh->d.p, fh->len, b->needle, b->mask, b->needle_len, b->table_offset, b->segment_offset, b->td);
+		}
+
+		if(found == 0) { con_printf("Sequence not found\n"); }
+		if(found > 1)  { con_printf("**** Developer Warning****: False positive detected. >1 match found. Check needle is unique!\n"); }
+		total += found;
+	}
+	return total;
+}
@@ -0,0 +1,80 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _TABLE_INI_SUPPORT_H
+#define _TABLE_INI_SUPPORT_H
+#include "utils.h"
+#include "show_tables.h"
+
+// Table definitions and needles loaded at runtime (-tables file.ini), so a map can be
+// added or a built-in one corrected without recompiling. Each [section] is a table;
+// a section named like a built-in table (e.g. [KFZW]) only changes the keys it sets.
+//
+//   [KFXYZ]
+//   desc       = Some new map
+//   x_num      = 1              ; byte widths (1, 2 or 0) of x_num, y_num, the axes and cells
+//   y_num      = 1
+//   x_axis     = 1
+//   y_axis     = 2
+//   cells      = 1
+//   signed     = 1              ; the ecu sign extends the cells in its lookup (as KFZW), for -eval
+//   x.conv     = 0.025          ; x./y./cell. + name conv conv2 op unit fmt hex adr conv_name
+//   x.unit     = Upm
+//   cell.op    = *              ; '/' (default) '*' 'd' or 'x', see conv_entry_value()
+//   cell.fmt   = %8.4f^20       ; the inifile parser trims values, ^xx is a hex escaped char
+//   find       = seg            ; seg: segment word at +segment_offset of the needle
+//   needle     = 88 90 F2 F4 XX XX C2 F5 ?? ??   (dppx: segment = dpp1-1 or a number)
+//   table_offset   = 46
+//   segment_offset = 42
+//
+// The parsed result (conversion factors as numbers, name hashes, needles and masks) is
+// written next to the .ini as <file>.cache and used instead of parsing while the .ini
+// is unchanged.
+
+#define MAX_INI_TABLES			1024
+#define MAX_INI_NEEDLE			128
+#define TABLE_HASH_SIZE			4096		// power of two, well above built-in + .ini tables
+
+#define TABLE_CACHE_EXT			".cache"
+#define TABLE_CACHE_MAGIC		"ME7TDEFS"
+#define TABLE_CACHE_VERSION		3
+
+#define BIND_NONE				0
+#define BIND_SEG				1			// find_dump_table_seg()
+#define BIND_DPPX				2			// find_dump_table_dppx()
+
+typedef struct TABLE_BINDING {
+	TABLE_DEF     *td;
+	int            method;					// BIND_xxx
+	int            table_offset;			// needle offset of the table address word
+	int            segment_offset;			// BIND_SEG: needle offset of the segment word
+	int            dpp;						// BIND_DPPX: segment is dppN_value+segment, or just segment if dpp is -1
+	int            segment;
+	int            needle_len;
+	unsigned char  needle[MAX_INI_NEEDLE];
+	unsigned char  mask[MAX_INI_NEEDLE];
+} TABLE_BINDING;
+
+int  table_ini_load(const char *filename);
+TABLE_DEF *table_def_find(const char *name);
+int  check_ini_tables(ImageHandle *fh, int skip);
+
+#endif
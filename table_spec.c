@@ -60,7 +60,7 @@ TABLE_DEF KFAGK_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",  		    // conversion value for huamn readable
+		CONV(0.025),           		    // conversion value for huamn readable
 		.desc      = "Upm",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -72,7 +72,7 @@ TABLE_DEF KFAGK_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.333333", 		// conversion value
+		CONV(1.333333),          		// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = " %-5.0f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -84,7 +84,7 @@ TABLE_DEF KFAGK_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.1f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -105,7 +105,7 @@ TABLE_DEF KPED_table = {
 	// x-axis
 	.x_axis = {
 		.field_name = "X-axis",				// field name
-		.conv       = "655.35",    			// conversion value for huamn readable
+		CONV(655.35),              			// conversion value for huamn readable
 		.desc       = "% PED",  			// conversion description
 		.fmt_PHY    = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX    = "0x%X ",				// HEX: x axis data formatting for raw hex values
@@ -116,7 +116,7 @@ TABLE_DEF KPED_table = {
 	// y-axis
 	.y_axis = {
 		.field_name = "Y-axis",				// field name
-		.conv        = "4.0",  				// conversion value
+		CONV(4.0),             				// conversion value
 		.desc        = "U/min", 			// conversion description
 		.fmt_PHY     = " %-5.0f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX     = "%-#8.4x ",			// HEX: x axis data formatting for raw hex values
@@ -127,7 +127,7 @@ TABLE_DEF KPED_table = {
 	// cells
 	.cell = {
 		.field_name = "Cells",				// field name
-		.conv       = "327.68", 			// conversion value
+		CONV(327.68),           			// conversion value
 		.desc       = "%", 					// conversion description
 		.fmt_PHY    = "%8.1f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX    = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -152,7 +152,7 @@ TABLE_DEF KPEDR_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "655.35",     		// conversion value for huamn readable
+		CONV(655.35),              		// conversion value for huamn readable
 		.desc      = "% PED",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -164,7 +164,7 @@ TABLE_DEF KPEDR_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "4.0",   			// conversion value
+		CONV(4.0),            			// conversion value
 		.desc      = "U/min", 			// conversion description
 		.fmt_PHY   = " %-5.0f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -176,7 +176,7 @@ TABLE_DEF KPEDR_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "327.68", 			// conversion value
+		CONV(327.68),          			// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = "%8.1f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -201,7 +201,7 @@ TABLE_DEF XXXX_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0",     		// conversion value for huamn readable
+		CONV(1.0),              		// conversion value for huamn readable
 		.desc      = " ",  				// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -213,7 +213,7 @@ TABLE_DEF XXXX_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "1.0",   			// conversion value
+		CONV(1.0),            			// conversion value
 		.desc      = " ", 			// conversion description
 		.fmt_PHY   = " %-5.0f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -225,7 +225,7 @@ TABLE_DEF XXXX_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.0f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -251,7 +251,7 @@ TABLE_DEF XXXXB_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0",     		// conversion value for huamn readable
+		CONV(1.0),              		// conversion value for huamn readable
 		.desc      = " ",  				// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -263,7 +263,7 @@ TABLE_DEF XXXXB_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = 0,				// field type
-		.conv      = "1.0",   			// conversion value
+		CONV(1.0),            			// conversion value
 		.desc      = " ", 			// conversion description
 		.fmt_PHY   = " %-5.0f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -275,7 +275,7 @@ TABLE_DEF XXXXB_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.0f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -302,7 +302,7 @@ TABLE_DEF KFKHFM_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",     		// conversion value for huamn readable
+		CONV(0.025),              		// conversion value for huamn readable
 		.desc      = "Upm",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -314,7 +314,7 @@ TABLE_DEF KFKHFM_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.333333",		// conversion value
+		CONV(1.333333),         		// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = " %-6.2f",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -326,7 +326,7 @@ TABLE_DEF KFKHFM_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.0f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -352,7 +352,7 @@ TABLE_DEF PUKANS_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0", 	  		// conversion value for huamn readable
+		CONV(1.0),          	  		// conversion value for huamn readable
 		.desc      = "Grad C",			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -364,7 +364,7 @@ TABLE_DEF PUKANS_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0",   			// conversion value
+		CONV(1.0),            			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = " %-5.0f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -376,7 +376,7 @@ TABLE_DEF PUKANS_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.0078125", 		// conversion value
+		CONV(0.0078125),          		// conversion value
 		.otype     = 0x2a,				// conversion type (override default / to use *)
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.4f ", 			// PHY: cell data formatting for conversion to human readable
@@ -402,7 +402,7 @@ TABLE_DEF LAMFA_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",    		// conversion value for huamn readable
+		CONV(0.025),             		// conversion value for huamn readable
 		.desc      = "Upm",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -414,7 +414,7 @@ TABLE_DEF LAMFA_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "327.68", 			// conversion value
+		CONV(327.68),          			// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = " %-6.2f",       	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -426,7 +426,7 @@ TABLE_DEF LAMFA_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.0078125", 		// conversion value
+		CONV(0.0078125),          		// conversion value
 		.otype     = 0x2a,				// conversion type (override default / to use *)
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.4f ", 			// PHY: cell data formatting for conversion to human readable
@@ -449,7 +449,7 @@ TABLE_DEF KFNW_table = { //
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",  		    // conversion value for huamn readable
+		CONV(0.025),           		    // conversion value for huamn readable
 		.desc      = "Upm",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -461,7 +461,7 @@ TABLE_DEF KFNW_table = { //
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.333333", 		// conversion value
+		CONV(1.333333),          		// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = " %-5.2f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -473,7 +473,7 @@ TABLE_DEF KFNW_table = { //
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.1f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -495,7 +495,7 @@ TABLE_DEF KFNWWL_table = { //
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",  		    // conversion value for huamn readable
+		CONV(0.025),           		    // conversion value for huamn readable
 		.desc      = "Upm",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -507,7 +507,7 @@ TABLE_DEF KFNWWL_table = { //
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.333333", 		// conversion value
+		CONV(1.333333),          		// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = " %-5.2f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -519,7 +519,7 @@ TABLE_DEF KFNWWL_table = { //
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.1f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -537,12 +537,13 @@ TABLE_DEF KFZW_table = { //
 	.x_num_nwidth  = UBYTE, .y_num_nwidth  = UBYTE,		// number of x/y item fields width
     .x_axis_nwidth = UBYTE, .y_axis_nwidth = UBYTE,		// x/y axis widths
 	.cell_nwidth   = UBYTE,								// cell width
+	.cell_signed   = 1,									// signed cells, the ecu sign extends them (movbs) in its group lookup
 
 	// x-axis
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",  		    // conversion value for huamn readable
+		CONV(0.025),           		    // conversion value for huamn readable
 		.desc      = "Upm",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -554,7 +555,7 @@ TABLE_DEF KFZW_table = { //
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.333333", 		// conversion value
+		CONV(1.333333),          		// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = " %-5.2f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -567,7 +568,7 @@ TABLE_DEF KFZW_table = { //
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = '/',				// conversion type (override default / to use *)
-		.conv      = "1.3333", 			// conversion value
+		CONV(1.3333),          			// conversion value
 		.desc      = "grad KW", 		// conversion description
 		.fmt_PHY   = "%8.3f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -584,12 +585,13 @@ TABLE_DEF KFZW2_table = { //
 	.x_num_nwidth  = UBYTE, .y_num_nwidth  = UBYTE,		// number of x/y item fields width
     .x_axis_nwidth = UBYTE, .y_axis_nwidth = UBYTE,		// x/y axis widths
 	.cell_nwidth   = UBYTE,								// cell width
+	.cell_signed   = 1,									// signed cells, the ecu sign extends them (movbs) in its group lookup
 
 	// x-axis
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",  		    // conversion value for huamn readable
+		CONV(0.025),           		    // conversion value for huamn readable
 		.desc      = "Upm",  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -601,7 +603,7 @@ TABLE_DEF KFZW2_table = { //
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "1.333333", 		// conversion value
+		CONV(1.333333),          		// conversion value
 		.desc      = "%", 				// conversion description
 		.fmt_PHY   = " %-5.2f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -614,7 +616,7 @@ TABLE_DEF KFZW2_table = { //
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = '/',				// conversion type (override default / to use *)
-		.conv      = "1.3333", 			// conversion value
+		CONV(1.3333),          			// conversion value
 		.desc      = "grad KW", 		// conversion description
 		.fmt_PHY   = "%8.3f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -637,8 +639,8 @@ TABLE_DEF KFTVSA_table = { //
 		.field_name = "X-axis (stm05saub)",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = 'd',	 			// conversion value
-		.conv      = "1.333333", 	    // conversion value for huamn readable
-		.conv2     = "48",				// additional field
+		CONV(1.333333),          	    // conversion value for huamn readable
+		CONV2(48),        				// additional field
 		.desc      = "Grad C",  		// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -650,7 +652,7 @@ TABLE_DEF KFTVSA_table = { //
 	.y_axis = {
 		.field_name = "Y-axis (snm08__ub)",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025", 		    // conversion value for huamn readable
+		CONV(0.025),          		    // conversion value for huamn readable
 		.desc      = "Upm", 			// conversion description
 		.fmt_PHY   = " %-6.0f",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -663,7 +665,7 @@ TABLE_DEF KFTVSA_table = { //
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = '/',				// conversion type (override default / to use *)
-		.conv      = "100", 			// conversion value
+		CONV(100),          			// conversion value
 		.desc      = "secs", 			// conversion description
 		.fmt_PHY   = " %7.2f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -686,8 +688,8 @@ TABLE_DEF KFTVSA0_table = { //
 		.field_name = "X-axis (stm05saub)",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = 'd',	 			// conversion value
-		.conv      = "1.333333", 	    // conversion value for huamn readable
-		.conv2     = "48",				// additional field
+		CONV(1.333333),          	    // conversion value for huamn readable
+		CONV2(48),        				// additional field
 		.desc      = "Grad C",  		// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -699,7 +701,7 @@ TABLE_DEF KFTVSA0_table = { //
 	.y_axis = {
 		.field_name = "Y-axis (snm08__ub)",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025", 		    // conversion value for huamn readable
+		CONV(0.025),          		    // conversion value for huamn readable
 		.desc      = "Upm", 			// conversion description
 		.fmt_PHY   = " %-6.0f",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -712,7 +714,7 @@ TABLE_DEF KFTVSA0_table = { //
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = '/',				// conversion type (override default / to use *)
-		.conv      = "100", 			// conversion value
+		CONV(100),          			// conversion value
 		.desc      = "secs", 			// conversion description
 		.fmt_PHY   = " %7.2f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -737,7 +739,7 @@ TABLE_DEF FKKVS_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025",     		// conversion value for huamn readable
+		CONV(0.025),              		// conversion value for huamn readable
 		.desc      = "rpm",  				// conversion description
 		.fmt_PHY   = "%8.1f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -749,7 +751,7 @@ TABLE_DEF FKKVS_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "312.5",  			// conversion value
+		CONV(312.5),           			// conversion value
 		.desc      = "ms injection", 	// conversion description
 		.fmt_PHY   = " %-5.1f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -761,7 +763,7 @@ TABLE_DEF FKKVS_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "32768.0", 			// conversion value
+		CONV(32768.0),          			// conversion value
 		.desc      = " ", 				// conversion description
 		.fmt_PHY   = "%8.4f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -786,7 +788,7 @@ TABLE_DEF KFWDKMSN_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "655.35",     		// conversion value for huamn readable
+		CONV(655.35),              		// conversion value for huamn readable
 		.desc      = "%",	  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -798,7 +800,7 @@ TABLE_DEF KFWDKMSN_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "4.0",   			// conversion value
+		CONV(4.0),            			// conversion value
 		.desc      = "U/min", 			// conversion description
 		.fmt_PHY   = " %-5.0f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -810,7 +812,7 @@ TABLE_DEF KFWDKMSN_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "10.0", 			// conversion value
+		CONV(10.0),          			// conversion value
 		.desc      = "kg/h", 			// conversion description
 		.fmt_PHY   = "%8.1f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -834,7 +836,7 @@ TABLE_DEF KFMSNWDK_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "655.35",     		// conversion value for huamn readable
+		CONV(655.35),              		// conversion value for huamn readable
 		.desc      = "%",	  			// conversion description
 		.fmt_PHY   = "%8.2f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -846,7 +848,7 @@ TABLE_DEF KFMSNWDK_table = {
 	.y_axis = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "4.0",   			// conversion value
+		CONV(4.0),            			// conversion value
 		.desc      = "U/min", 			// conversion description
 		.fmt_PHY   = " %-5.0f ",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -858,7 +860,7 @@ TABLE_DEF KFMSNWDK_table = {
 	.cell = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UWORD,				// field type
-		.conv      = "10.0", 			// conversion value
+		CONV(10.0),          			// conversion value
 		.desc      = "kg/h", 			// conversion description
 		.fmt_PHY   = "%8.1f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -880,7 +882,7 @@ TABLE_DEF KFSU_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025", 		    // conversion value for huamn readable
+		CONV(0.025),          		    // conversion value for huamn readable
 		.desc      = "Upm", 			// conversion description
 		.fmt_PHY   = "%8.1f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -893,8 +895,8 @@ TABLE_DEF KFSU_table = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = 'd',	 			// conversion value
-		.conv      = "1.333333", 	    // conversion value for huamn readable
-		.conv2     = "48",				// additional field
+		CONV(1.333333),          	    // conversion value for huamn readable
+		CONV2(48),        				// additional field
 		.desc      = "%",		  		// conversion description
 		.fmt_PHY   = " %-6.0f",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -907,7 +909,7 @@ TABLE_DEF KFSU_table = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = '/',				// conversion type (override default / to use *)
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = "---", 			// conversion description
 		.fmt_PHY   = " %7.2f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -929,7 +931,7 @@ TABLE_DEF KFSU2_table = {
 	.x_axis = {
 		.field_name = "X-axis",			// field name
 		.nwidth    = UBYTE,				// field type
-		.conv      = "0.025", 		    // conversion value for huamn readable
+		CONV(0.025),          		    // conversion value for huamn readable
 		.desc      = "Upm", 			// conversion description
 		.fmt_PHY   = "%8.1f ",     		// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
@@ -942,8 +944,8 @@ TABLE_DEF KFSU2_table = {
 		.field_name = "Y-axis",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = 'd',	 			// conversion value
-		.conv      = "1.333333", 	    // conversion value for huamn readable
-		.conv2     = "48",				// additional field
+		CONV(1.333333),          	    // conversion value for huamn readable
+		CONV2(48),        				// additional field
 		.desc      = "%",		  		// conversion description
 		.fmt_PHY   = " %-6.0f",     	// PHY: x axis data formatting for conversion to human readable
 		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
@@ -956,7 +958,7 @@ TABLE_DEF KFSU2_table = {
 		.field_name = "Cells",			// field name
 		.nwidth    = UBYTE,				// field type
 		.otype     = '/',				// conversion type (override default / to use *)
-		.conv      = "1.0", 			// conversion value
+		CONV(1.0),          			// conversion value
 		.desc      = "---", 			// conversion description
 		.fmt_PHY   = " %7.2f ", 			// PHY: cell data formatting for conversion to human readable
 		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
@@ -964,3 +966,60 @@ TABLE_DEF KFSU2_table = {
 		.conv_name = "rel_uw_b200",		// conversion name
 	}
 };
+
+// MLHFM is stored as a bare array of 512 words, its axis is the hfm voltage (10-bit adc, 2 counts per entry),
+// only used to look it up (see map_registry_add_curve), the tool still prints MLHFM as a hex table.
+TABLE_DEF MLHFM_table = {
+	// basic table information
+	.table_name = "MLHFM",  .table_desc = "Linearization of airflow voltages from air flow meter", 
+
+	// table data byte widths
+	.x_num_nwidth  = 0,     .y_num_nwidth  = 0,		// number of x/y item fields width
+    .x_axis_nwidth = UWORD, .y_axis_nwidth = 0,		// x/y axis widths
+	.cell_nwidth   = UWORD,							// cell width
+
+	// x-axis
+	.x_axis = {
+		.field_name = "X-axis",			// field name
+		.nwidth    = UWORD,				// field type
+		CONV(204.8),          		    // conversion value for huamn readable
+		.desc      = "V", 				// conversion description
+		.fmt_PHY   = "%8.3f ",     		// PHY: x axis data formatting for conversion to human readable
+		.fmt_HEX   = "0x%X ",			// HEX: x axis data formatting for raw hex values
+		.fmt_ADR   = "  %#6x ",			// ADR: x axis data formatting for physical addresses
+		.conv_name = "uhfm_w",  		// conversion name
+	},
+	
+	// y-axis
+	.y_axis = {
+		.field_name = "Y-axis",			// field name
+		.nwidth    = 0,					// field type
+		CONV(1.0),          	 	    // conversion value for huamn readable
+		.desc      = " ",		  		// conversion description
+		.fmt_PHY   = " %-6.0f",     	// PHY: x axis data formatting for conversion to human readable
+		.fmt_HEX   = "%-#8.4x ",		// HEX: x axis data formatting for raw hex values
+		.fmt_ADR   = "%-#9.5x ",		// ADR: x axis data formatting for physical addresses
+		.conv_name = " ",				// conversion name
+	},
+	
+	// cells
+	.cell = {
+		.field_name = "Cells",			// field name
+		.nwidth    = UWORD,				// field type
+		CONV(10.0),          			// conversion value
+		.desc      = "kg/h", 			// conversion description
+		.fmt_PHY   = " %7.1f ", 		// PHY: cell data formatting for conversion to human readable
+		.fmt_HEX   = "  %#6x ",			// HEX: cell data formatting for raw hex values
+		.fmt_ADR   = "%-#9.5x",         // ADR: cell data formatting for physical addresses
+		.conv_name = "mshfm_w",			// conversion name
+	}
+};
+
+// every built-in table, -tables .ini definitions of the same name override these (see table_ini.c)
+TABLE_DEF *builtin_tables[] = {
+	&KFAGK_table,  &KPED_table,     &KPEDR_table,    &XXXX_table,     &XXXXB_table,
+	&KFKHFM_table, &PUKANS_table,   &LAMFA_table,    &KFNW_table,     &KFNWWL_table,
+	&KFZW_table,   &KFZW2_table,    &KFTVSA_table,   &KFTVSA0_table,  &FKKVS_table,
+	&KFWDKMSN_table, &KFMSNWDK_table, &KFSU_table,   &KFSU2_table,    &MLHFM_table,
+};
+int builtin_tables_num = sizeof(builtin_tables)/sizeof(TABLE_DEF *);
@@ -40,8 +40,12 @@ extern TABLE_DEF KFWDKMSN_table;
 extern TABLE_DEF FKKVS_table;
 extern TABLE_DEF KFSU_table;
 extern TABLE_DEF KFSU2_table;
+extern TABLE_DEF MLHFM_table;
 
 extern TABLE_DEF XXXX_table;
 extern TABLE_DEF XXXXB_table;
 
+extern TABLE_DEF *builtin_tables[];
+extern int builtin_tables_num;
+
 #endif
\ No newline at end of file
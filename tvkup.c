@@ -20,6 +20,7 @@
    IN THE SOFTWARE.
 */
 #include "tvkup.h"
+#include "export.h"
 
 extern int show_diss;
 extern unsigned dpp1_value;
@@ -34,32 +35,34 @@ int check_tvkup(ImageHandle *fh, int skip)
 
 	if(skip == 0) return found;		
 				
-	printf("\n>>> Scanning for TVKUP [Delay time for clutch pedal (b_kupplv) ]\n");
+	con_printf("\n>>> Scanning for TVKUP [Delay time for clutch pedal (b_kupplv) ]\n");
 	addr = search( fh, (unsigned char *)&needle_TVKUP, (unsigned char *)&mask_TVKUP, needle_TVKUP_len, 0 );
 	if(addr != NULL) {
-		printf("found GGEGAS() function at offset=0x%x. ",(int)(addr-rom_load_addr) );
+		con_printf("found GGEGAS() function at offset=0x%x. ",(int)(addr-rom_load_addr) );
 		seg = get16((unsigned char *)addr+20);
 		seg -= 2;
 		val = get16((unsigned char *)addr+32);
 //		printf("seg=%-4.4x, val=%-4.4x ",seg,val);
 		unsigned long str_adr = (unsigned long)(seg*SEGMENT_SIZE)+(long int)val;	// derive phyiscal address from offset and segment
-		printf("TVKUP   @ ADR:%#8x ", str_adr);
+		unsigned long tvkup_adr = str_adr;
+		con_printf("TVKUP   @ ADR:%#8x ", str_adr);
 		str_adr              &= ~(ROM_1MB_MASK);					// convert physical address to a rom file offset we can easily work with.
-		printf("(%#8x )\n", str_adr);
+		con_printf("(%#8x )\n", str_adr);
 		str_adr              += rom_load_addr;
 		tmp_adr               = (unsigned char *)str_adr;				
 		val                   = *tmp_adr;
 					
 		// disassemble needle found in rom
 		if(show_diss) { 
-			printf("\nDumping ...\n");
+			con_printf("\nDumping ...\n");
 			c167x_diss(addr-rom_load_addr, addr, needle_TVKUP_len+20); 
 		}
 
-		printf("\nTVKUP: 0x%-2.2x (0.%d s delay)\n",val,val*50);
+		con_printf("\nTVKUP: 0x%-2.2x (0.%d s delay)\n",val,val*50);
+		export_scalar("TVKUP", "Delay time for clutch pedal (b_kupplv)", tvkup_adr, val, val*0.05, "s");
 
 	} else {
-		printf("not found\n");
+		con_printf("not found\n");
 	}
 	
 	return 0;
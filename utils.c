@@ -24,6 +24,8 @@
 #include <stdlib.h>
 
 #include "utils.h"
+#include "outbuf.h"
+#include "labels.h"
 
 int iload_file(struct ImageHandle *ih, const char *fname, int rw)
 {
@@ -36,35 +38,40 @@ int iload_file(struct ImageHandle *ih, const char *fname, int rw)
 
 int ifree_file(struct ImageHandle *ih)
 {
-	if((ih->d.p) != 0) { /*printf("Freeing %d bytes at %p.\n", (int)ih->len, ih->d.p);*/ free(ih->d.p); } else { printf("Nothing to free\n"); }
+	if((ih->d.p) != 0) { /*printf("Freeing %d bytes at %p.\n", (int)ih->len, ih->d.p);*/ free(ih->d.p); } else { con_printf("Nothing to free\n"); }
 	memset(ih, 0, sizeof(*ih));
 	return 0;
 }
 
 /* load a file into memory and return buffer */
 uint8_t *load_file(const char *filename, size_t *filelen)
+{
+	return load_file_ex(filename, filelen, 1);
+}
+
+uint8_t *load_file_ex(const char *filename, size_t *filelen, int verbose)
 {
 	FILE *fp;
 	uint8_t *data;
 	size_t size,bytesRead;
 
 	/* open file */
-	printf("þ Opening '%s' file\n",filename);
-	if ((fp = (FILE *)fopen(filename, "rb")) == NULL){ printf("\nCan't open file \"%s\".", filename); return(0); }
+	if(verbose) con_printf("þ Opening '%s' file\n",filename);
+	if ((fp = (FILE *)fopen(filename, "rb")) == NULL){ if(verbose) con_printf("\nCan't open file \"%s\".", filename); return(0); }
 
 	/* get file length */
 //	printf("þ Getting length of '%s' file\n",filename);
 	fseek(fp, 0, SEEK_END);
 	size = ftell(fp);
 	fseek(fp, 0, SEEK_SET);
-	if(size <= 0) { printf("Error: Problem with seeking filesize\n"); fclose(fp); return(0); }
+	if(size <= 0) { if(verbose) con_printf("Error: Problem with seeking filesize\n"); fclose(fp); return(0); }
 
 	*filelen = size;		/* return size of file to caller */
 
 	/* alloc buffer for file */
 //	printf("þ Allocating buffer of %d bytes (%p)\n",(int)size,(void *)size);
 	data = (uint8_t *)malloc(size);
-	if(data == 0) { printf("\nfailed to allocate memory to load module\n"); fclose(fp); return 0; }
+	if(data == 0) { if(verbose) con_printf("\nfailed to allocate memory to load module\n"); fclose(fp); return 0; }
 
 	/* load file into buffer */
 //	printf("þ Reading file to buffer\n");
@@ -72,7 +79,7 @@ uint8_t *load_file(const char *filename, size_t *filelen)
 
 	/* validate it all loaded correctly */
 //	printf("þ Validating size correct %d=%d\n",(int)bytesRead,(int)size);
-	if(bytesRead != size) { printf("\nfailed to load module into buffer\n"); free(data); fclose(fp); return 0; }
+	if(bytesRead != size) { if(verbose) con_printf("\nfailed to load module into buffer\n"); free(data); fclose(fp); return 0; }
 
 	/* close the file */
 //	printf("þ Closing file\n\n");
@@ -88,7 +95,7 @@ int save_file(const char *filename, const uint8_t *filebuf, size_t filelen)
 
 	/* open file */
 //	printf("þ Opening '%s' file for writing\n",filename);
-	if ((fp = (FILE *)fopen(filename, "wb")) == NULL){ printf("\nCan't open file \"%s\".", filename); return(-1); }
+	if ((fp = (FILE *)fopen(filename, "wb")) == NULL){ con_printf("\nCan't open file \"%s\".", filename); return(-1); }
 
 	/* load file into buffer */
 //	printf("þ Writing to file\n");
@@ -96,7 +103,7 @@ int save_file(const char *filename, const uint8_t *filebuf, size_t filelen)
 
 	/* validate it all loaded correctly */
 //	printf("þ Validating size correct %d=%d\n",(int)bytesWritten,(int)filelen);
-	if(bytesWritten != filelen) { printf("\nfailed to write buffer\n"); fclose(fp); return(-2); }
+	if(bytesWritten != filelen) { con_printf("\nfailed to write buffer\n"); fclose(fp); return(-2); }
 
 	/* close the file */
 //	printf("þ All OK, closing file\n\n");
@@ -257,7 +264,7 @@ int search_replace(ImageHandle *fh, unsigned char *pNeedle, unsigned char *pMask
 //				hexdump( start_adr, start_len, " }\n");
 
 			}
-			printf("\n");
+			con_printf("\n");
 			found++;
 		}
 					
@@ -288,14 +295,21 @@ int search_image(const struct ImageHandle *ih, int start, const void *needle, co
 #if 1
 void hexdump(uint8_t *buf, int len, const char *end)
 {
-    while(len--) printf("%02x%s", *buf++, len?" ":"");
-    printf("%s", end);
+	OUTBUF *ob = ob_get();
+
+    while(len--) {
+		ob_hex(ob, *buf++, 2);
+		if(len) ob_putc(ob, ' ');
+	}
+    ob_puts(ob, end);
+	ob_flush(ob);
 }
 
 #endif
 
 void hexdump_le_table(uint8_t *buf, int len, const char *end)
 {
+	OUTBUF *ob = ob_get();
 	int i,j=0,k=0;
 	int val;
 
@@ -307,14 +321,15 @@ void hexdump_le_table(uint8_t *buf, int len, const char *end)
 		buf++;
 		buf++;
 		
-		printf("0x%-4.4x",val);
+		ob_puts(ob, "0x");
+		ob_hex(ob, val, 4);
 		k++;
 
 		if(k==1)
 		{
 			if(i < len-1)
 			{
-				printf(",");
+				ob_putc(ob, ',');
 			}
 			
 			k=0;
@@ -322,7 +337,7 @@ void hexdump_le_table(uint8_t *buf, int len, const char *end)
 
 		if(j==15)
 		{
-			printf("\n");
+			ob_putc(ob, '\n');
 			j=0;
 		}
 		else
@@ -331,15 +346,17 @@ void hexdump_le_table(uint8_t *buf, int len, const char *end)
 		}
 
 	}
-    printf("%s", end);
+    ob_puts(ob, end);
+	ob_flush(ob);
 }
 
 void hexdump_le32_table(uint8_t *buf, int len, const char *end)
 {
+	OUTBUF *ob = ob_get();
 	int i,j=0,k=0;
 	int val;
 
-	printf(" ");
+	ob_putc(ob, ' ');
 	for(i=0;i<len;i += 4)
 	{
 //		val = *(buf++);
@@ -350,14 +367,15 @@ void hexdump_le32_table(uint8_t *buf, int len, const char *end)
 		buf++;
 		buf++;
 		
-		printf("0x%-8.8x",val);
+		ob_puts(ob, "0x");
+		ob_hex(ob, (unsigned int)val, 8);
 		k++;
 
 		if(k==1)
 		{
 			if(i < len-4)
 			{
-				printf(", ");
+				ob_puts(ob, ", ");
 			}
 			
 			k=0;
@@ -365,7 +383,7 @@ void hexdump_le32_table(uint8_t *buf, int len, const char *end)
 
 		if(j==7)
 		{
-			printf("\n ");
+			ob_puts(ob, "\n ");
 			j=0;
 		}
 		else
@@ -374,7 +392,8 @@ void hexdump_le32_table(uint8_t *buf, int len, const char *end)
 		}
 
 	}
-    printf("%s", end);
+    ob_puts(ob, end);
+	ob_flush(ob);
 }
 
 
@@ -503,11 +522,12 @@ void translate_seg(MPTR *mp, char *name, unsigned char *rom_load_addr, int seg,
 	val_adr       &= ~(ROM_1MB_MASK);				// convert physical address to a rom file offset we can easily work with.
 	mp->ram        = (unsigned char *)rom_load_addr + val_adr;
 	mp->off        = val_adr;
+	label_symbol(val_adr, SYM_DATA, name);		// for -listing and its symbol scripts
 }
 
 void show_seg(MPTR *mp)
 {
-	printf("%-8.8s @ ROM:%#x RAM:%#x File-Offset:%#x (seg=0x%-4.4X val=0x%-4.4X)\n", mp->name, mp->rom, mp->ram, mp->off, mp->seg, mp->val );
+	con_printf("%-8.8s @ ROM:%#x RAM:%#x File-Offset:%#x (seg=0x%-4.4X val=0x%-4.4X)\n", mp->name, mp->rom, mp->ram, mp->off, mp->seg, mp->val );
 }
 
 
@@ -527,12 +547,12 @@ void put16(unsigned short val, unsigned char *adr, int offset)
 	if(adr != 0)
 	{
 		adr += offset;
-		printf("adr = %p, val: %-2x\n", adr, *s);
+		con_printf("adr = %p, val: %-2x\n", adr, *s);
 		*adr++ = *s++;
-		printf("adr = %p, val: %-2x\n", adr, *s);
+		con_printf("adr = %p, val: %-2x\n", adr, *s);
 		*adr++ = *s++;
 	}
-	printf("\n");
+	con_printf("\n");
 }
 
 void put32le(unsigned long val, unsigned char *adr) 
@@ -545,7 +565,7 @@ void put32le(unsigned long val, unsigned char *adr)
 		{
 			v = val;
 //			v  = (unsigned long)( ((s[3] << 24)) | ((s[2] <<  16)) |((s[1] <<  8)) |  ((s[0])) );
-			printf("addr = %p, val: %-8.8x\n", adr, (unsigned long)v);
+			con_printf("addr = %p, val: %-8.8x\n", adr, (unsigned long)v);
 			*adr = v;
 		}
 	}
@@ -555,50 +575,52 @@ void put32le(unsigned long val, unsigned char *adr)
 
 void show_hex_dump(const void *adrs, unsigned long nbytes, void *offset)
 {
+    OUTBUF *ob = ob_get();
     unsigned long t, end;
     int   i;
     end = (nbytes + 15) & -16;
     //if(offset == 0) 
-	printf("Hex Dump: 0 1  2 3  4 5  6 7  8 9  A B  C D  E F  0123456789abcdef \n");    
+	ob_puts(ob, "Hex Dump: 0 1  2 3  4 5  6 7  8 9  A B  C D  E F  0123456789abcdef \n");    
     for(t=0; t<end; t++)
     {
-	       if((t&15) == 0) printf("%08lx:", (long)offset+t);
-	       if((t& 1) == 0) printf(" ");
+	       if((t&15) == 0) ob_fmt_int(ob, "%08lx:", (long)offset+t);
+	       if((t& 1) == 0) ob_putc(ob, ' ');
 	       if(t < nbytes) {
-            printf("%02x", ((unsigned char *)adrs)[t]);
+            ob_hex(ob, ((unsigned char *)adrs)[t], 2);
 	       } else {
-	          printf("  ");
+	          ob_puts(ob, "  ");
          }
          if((t&15) == 15) {
-	           printf(" ");
+	           ob_putc(ob, ' ');
 	           for(i=15; i>=0; i--)
 	           {
 		            if(isprint(((unsigned char *)adrs)[t-i])) {
-                  printf("%c", ((unsigned char *)adrs)[t-i]);
+                  ob_putc(ob, ((unsigned char *)adrs)[t-i]);
 		            } else {
-		              printf(".");
+		              ob_putc(ob, '.');
 		            }
              }
-             printf("\n");
+             ob_putc(ob, '\n');
           }
     }
-    printf("\n");
+    ob_putc(ob, '\n');
+    ob_flush(ob);
 }
 
 void dump_bitfmt_table(BITFMT_TABLE *p, unsigned char value, char *s_bin)
 {
-	printf("                   7 6 5 4 3 2 1 0  bits\n");
-	printf("                   ---------------\n");
-	printf("%-12.12s %#-2.2X  %s\n", p->name, (unsigned char)value, s_bin );
-	printf("                   | | | | | | | |\n");
-	printf("                   | | | | | | | +--- %-9.9s   : %s\n", p->b7, p->b7_desc);
-	printf("                   | | | | | | +----- %-9.9s   : %s\n", p->b6, p->b6_desc);
-	printf("                   | | | | | +------- %-9.9s   : %s\n", p->b5, p->b5_desc);
-	printf("                   | | | | +--------- %-9.9s   : %s\n", p->b4, p->b4_desc);
-	printf("                   | | | +----------- %-9.9s   : %s\n", p->b3, p->b3_desc);
-	printf("                   | | +------------- %-9.9s   : %s\n", p->b2, p->b2_desc);
-	printf("                   | +--------------- %-9.9s   : %s\n", p->b1, p->b1_desc);
-	printf("                   +----------------- %-9.9s   : %s\n\n", p->b0, p->b0_desc);
+	con_printf("                   7 6 5 4 3 2 1 0  bits\n");
+	con_printf("                   ---------------\n");
+	con_printf("%-12.12s %#-2.2X  %s\n", p->name, (unsigned char)value, s_bin );
+	con_printf("                   | | | | | | | |\n");
+	con_printf("                   | | | | | | | +--- %-9.9s   : %s\n", p->b7, p->b7_desc);
+	con_printf("                   | | | | | | +----- %-9.9s   : %s\n", p->b6, p->b6_desc);
+	con_printf("                   | | | | | +------- %-9.9s   : %s\n", p->b5, p->b5_desc);
+	con_printf("                   | | | | +--------- %-9.9s   : %s\n", p->b4, p->b4_desc);
+	con_printf("                   | | | +----------- %-9.9s   : %s\n", p->b3, p->b3_desc);
+	con_printf("                   | | +------------- %-9.9s   : %s\n", p->b2, p->b2_desc);
+	con_printf("                   | +--------------- %-9.9s   : %s\n", p->b1, p->b1_desc);
+	con_printf("                   +----------------- %-9.9s   : %s\n\n", p->b0, p->b0_desc);
 }
 
 const char *bitconv[16] = {
@@ -610,7 +632,7 @@ const char *bitconv[16] = {
 
 void dump_byte(unsigned char byte)
 {
-    printf("%s%s", bitconv[byte >> 4], bitconv[byte & 0b00001111]);
+    con_printf("%s%s", bitconv[byte >> 4], bitconv[byte & 0b00001111]);
 }
 
 void dump_bin(char *dst, int val, int numbits)
@@ -636,7 +658,7 @@ void show_cli_usage(int argc, char *argv[], OPTS_ENTRY table[], int entrysize)
 	int j;
 	/* walk through options list and process them */
 	for (j = 0; j < entrysize; j++) {
-		printf(" %-10s: %s", table[j].option_name, table[j].desc);
+		con_printf(" %-10s: %s", table[j].option_name, table[j].desc);
 	}	
 }
 
@@ -659,7 +681,7 @@ int parse_cli_options(int argc, char *argv[],int i, OPTS_ENTRY table[], int entr
 					if(argv[i+1] != 0) {
 						*current_name = argv[++i]; 
 						if(opt == MANDATORY && *current_name == 0) {
-							printf("Mandatory option not provided for agument '%s'\n",table[j].option_name);
+							con_printf("Mandatory option not provided for agument '%s'\n",table[j].option_name);
 							return(1);
 						}
 					}
@@ -755,13 +777,13 @@ unsigned long get_addr_from_rom(unsigned char *rom_start_addr, unsigned dynamic_
 
 	if(hi_addr ==0)
 	{
-		printf("\n\tlo:0x%x.L (seg: 0x%x phy:0x%x) : ",(unsigned int)var_lo_offset+table_index,(int)segment_offset, (int)(var_lo_addr+table_index) );
+		con_printf("\n\tlo:0x%x.L (seg: 0x%x phy:0x%x) : ",(unsigned int)var_lo_offset+table_index,(int)segment_offset, (int)(var_lo_addr+table_index) );
 	} else {
 		if(lo_addr ==0) 
 		{
-			printf("\n\thi:0x%x (seg: 0x%x phy:0x%x) : ",(unsigned int)var_hi_offset+table_index,(int)segment_offset, (int)(var_hi_addr+table_index) );
+			con_printf("\n\thi:0x%x (seg: 0x%x phy:0x%x) : ",(unsigned int)var_hi_offset+table_index,(int)segment_offset, (int)(var_hi_addr+table_index) );
 		} else {
-		printf("\n\tlo:0x%x.W hi:0x%x.W (seg: 0x%x phy:0x%x) : ",(unsigned int)var_lo_offset+table_index,(unsigned int)var_hi_offset+table_index,(int)segment_offset, (int)(var_lo_addr+table_index) );
+		con_printf("\n\tlo:0x%x.W hi:0x%x.W (seg: 0x%x phy:0x%x) : ",(unsigned int)var_lo_offset+table_index,(unsigned int)var_hi_offset+table_index,(int)segment_offset, (int)(var_lo_addr+table_index) );
 		// re-create 32-bit unsigned long from hi and low words
 		var_final_address = (unsigned long )(((var_hi_value <<  16)) | var_lo_value );
 		}
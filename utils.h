@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include "outbuf.h"
 
 #define OPTION_CLR   0
 #define OPTION_SET   1
@@ -166,12 +167,14 @@ int iload_file(struct ImageHandle *ih, const char *fname, int rw);
 int ifree_file(struct ImageHandle *ih);
 int save_file(const char *filename, const uint8_t *filebuf, size_t filelen);
 uint8_t *load_file(const char *filename, size_t *filelen);
+uint8_t *load_file_ex(const char *filename, size_t *filelen, int verbose);
 
 void show_cli_usage(int argc, char *argv[], OPTS_ENTRY table[], int entrysize);
 int parse_cli_options(int argc, char *argv[],int i, OPTS_ENTRY table[], int entrysize);
 
 unsigned char *search(ImageHandle *fh, unsigned char *pNeedle, unsigned char *pMask, int needle_len, int offset);
 int search_image(const struct ImageHandle *ih, int start, const void *needle, const void *mask, int len, int align);
+int memcmp_mask(const void *ptr1, const void *ptr2, const void *mask, size_t len);
 unsigned char *search_offset(unsigned char *buf, int buflen, unsigned char *pNeedle, unsigned char *pMask, int needle_len);
 unsigned long get_addr_from_rom(unsigned char *rom_start_addr, unsigned dynamic_romsize, unsigned char *lo_addr, int lo_bits, unsigned char *hi_addr, int hi_bits, unsigned char *segment, int table_index);
 unsigned long get_addr16_of_from_rom(unsigned char *rom_start_addr, unsigned dynamic_romsize, unsigned char *addr, unsigned char *segment, int table_index);
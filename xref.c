@@ -0,0 +1,502 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#include "xref.h"
+#include "labels.h"
+#include "funcindex.h"
+#include "mapcatalog.h"
+#include "crc32.h"
+#include "dpptrack.h"
+#include <time.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+extern unsigned long dpp0_value, dpp1_value, dpp2_value, dpp3_value;
+
+#define XREF_PAGE_BASE		(CAT_ROM_BASE / SEGMENT_SIZE)	// extp/dpp page of the first byte of the image
+#define XREF_SEG_BASE		(CAT_ROM_BASE >> 16)			// exts segment of the first byte of the image
+#define XREF_SHOW_MAX		64
+
+static const XREF     *xrefs;
+static const uint32_t *by_data;
+static int             num_xrefs;
+static void           *image;			// header + records + index, mapped or malloc'd
+static size_t          image_len;
+static int             image_mapped;
+static int             from_file;
+
+static const char *kind_names[XR_KINDS] = { "mem", "extp", "exts", "pair", "ptr" };
+
+const char *xref_kind_name(int kind)
+{
+	return (kind >= 0 && kind < XR_KINDS) ? kind_names[kind] : "?";
+}
+
+//-[ Build ]----------------------------------------------------------------------------------------------------------------
+
+typedef struct XREF_LIST {
+	XREF *x;
+	int   num, max;
+} XREF_LIST;
+
+// last immediate loaded into each general purpose register of the current block
+typedef struct REG_IMM {
+	uint32_t       adr;
+	unsigned short val;
+	unsigned char  valid;
+	unsigned char  data16;		// loaded with a #data16 (a #data4 is never an address)
+	unsigned char  paired;		// used as part of an offset/page pair
+} REG_IMM;
+
+static int add_xref(XREF_LIST *l, unsigned long code, unsigned long data, int kind, int reg, int width)
+{
+	XREF *p;
+
+	if(l->num == l->max) {
+		int max = l->max ? l->max*2 : 4096;
+		if((p = realloc(l->x, max * sizeof(XREF))) == 0) return -1;
+		l->x   = p;
+		l->max = max;
+	}
+	p = &l->x[l->num++];
+	p->code  = code;
+	p->data  = data;
+	p->kind  = kind;
+	p->reg   = reg;
+	p->width = width;
+	return 0;
+}
+
+// physical address to a file offset of the image, FLOW_NONE if it isn't in the rom
+static unsigned long rom_offset(unsigned long phys, unsigned long len)
+{
+	if(phys < CAT_ROM_BASE || phys - CAT_ROM_BASE >= len) return FLOW_NONE;
+	return phys - CAT_ROM_BASE;
+}
+
+// offset in lo with a page (or segment) number in hi, FLOW_NONE if hi isn't a rom page
+static unsigned long pair_offset(unsigned short lo, unsigned short hi, unsigned long len)
+{
+	if(hi >= XREF_PAGE_BASE && hi < XREF_PAGE_BASE + len/SEGMENT_SIZE && lo < SEGMENT_SIZE) return (unsigned long)(hi - XREF_PAGE_BASE)*SEGMENT_SIZE + lo;
+	if(hi >= XREF_SEG_BASE  && hi < XREF_SEG_BASE + (len >> 16)) return ((unsigned long)(hi - XREF_SEG_BASE) << 16) | lo;
+	return FLOW_NONE;
+}
+
+// byte or word access of a mem operand
+static int mem_width(const DIS_INST *di, int op)
+{
+	const char *name = c167x_name(di);
+	int n;
+
+	if(name == 0) return 0;
+	n = strcspn(name, " ");
+	if(n == 5 && strncmp(name, "movb", 4) == 0) return (op == 1) ? 1 : 2;	// movbz/movbs read a byte, store a word
+	return (n > 0 && name[n-1] == 'b') ? 1 : 2;
+}
+
+// general purpose register an operand writes, -1 if none
+static int dest_reg(const DIS_INST *di, const DIS_OP *op)
+{
+	switch(op->type) {
+		case RW:
+		case RW_L:		return op->reg & 0xf;
+		case RB:		return (op->reg & 0xf) >> 1;
+		case REGW:		return (di->raw[1] >= 0xf0) ? (di->raw[1] & 0xf) : -1;
+		case REGB:		return (di->raw[1] >= 0xf0) ? (di->raw[1] & 0xf) >> 1 : -1;
+	}
+	return -1;
+}
+
+// mem operands are paged by the dpps or an extp/exts prefix, see dpptrack.h
+static int scan_block(const FLOW_GRAPH *g, const FLOW_BLOCK *b, XREF_LIST *l)
+{
+	static const int ext_kinds[3] = { XR_MEM, XR_EXTP, XR_EXTS };
+	REG_IMM regs[16];
+	const DIS_INST *di;
+	unsigned long a, phys, off;
+	int i, r, ext;
+
+	memset(regs, 0, sizeof(regs));
+	for(a=b->start;a<b->end;a+=di->len) {
+		di = &g->insts[a/2];
+		if(di->flags & DIS_INVALID) break;
+		// extp/exts only read their operands, dpp_mem() knows what they cover
+		if(di->raw[0] == 0xd7 || di->raw[0] == 0xdc) continue;
+
+		for(i=0;i<di->nops;i++) {
+			if(di->op[i].type != MEM) continue;
+			if((phys = dpp_mem(a, di->op[i].val, &ext)) == DPP_UNKNOWN) continue;
+			if((off = rom_offset(phys, g->len)) != FLOW_NONE) {
+				if(add_xref(l, a, off, ext_kinds[ext], i, mem_width(di, i)) != 0) return -1;
+			}
+		}
+
+		// mov Rn,#data16 (E6 Fn) and mov Rn,#data4 (E0) keep their value, any other write to Rn forgets it
+		r = -1;
+		if(di->raw[0] == 0xe6 && di->raw[1] >= 0xf0)  r = di->raw[1] & 0xf;
+		else if(di->raw[0] == 0xe0)                   r = di->op[0].reg & 0xf;
+		if(r >= 0) {
+			regs[r].adr    = a;
+			regs[r].val    = (di->raw[0] == 0xe6) ? di->op[1].val : di->op[1].reg;
+			regs[r].valid  = 1;
+			regs[r].data16 = (di->raw[0] == 0xe6);
+			regs[r].paired = 0;
+			// offset and page are in consecutive registers, r4/r5 or r13/r14
+			for(i=r-1;i<=r;i++) {
+				REG_IMM *lo = &regs[i & 0xf], *hi = &regs[(i+1) & 0xf];
+				if(i < 0 || i > 14 || !lo->valid || !hi->valid) continue;
+				if((off = pair_offset(lo->val, hi->val, g->len)) != FLOW_NONE) {
+					if(add_xref(l, lo->adr, off, XR_PAIR, i, 0) != 0) return -1;
+					lo->paired = hi->paired = 1;
+					break;
+				}
+			}
+		} else if(di->flags & DIS_CALL) {
+			for(r=XREF_ARG_FIRST;r<16;r++) {
+				if(!regs[r].valid || !regs[r].data16 || regs[r].paired) continue;
+				if((off = rom_offset(dpp_near(regs[r].adr, regs[r].val), g->len)) != FLOW_NONE) {
+					if(add_xref(l, regs[r].adr, off, XR_PTR, r, 0) != 0) return -1;
+				}
+			}
+			memset(regs, 0, sizeof(regs));
+		} else if(di->nops && (r = dest_reg(di, &di->op[0])) >= 0) {
+			regs[r].valid = 0;
+		}
+	}
+	return 0;
+}
+
+static int cmp_code(const void *a, const void *b)
+{
+	const XREF *x = a, *y = b;
+
+	if(x->code != y->code) return (x->code > y->code) - (x->code < y->code);
+	if(x->data != y->data) return (x->data > y->data) - (x->data < y->data);
+	return (int)x->kind - (int)y->kind;
+}
+
+static const XREF *sort_base;
+
+static int cmp_data(const void *a, const void *b)
+{
+	const XREF *x = &sort_base[*(const uint32_t *)a], *y = &sort_base[*(const uint32_t *)b];
+
+	if(x->data != y->data) return (x->data > y->data) - (x->data < y->data);
+	return (x->code > y->code) - (x->code < y->code);
+}
+
+// header, records and index in one block, laid out exactly as the sidecar file
+static int build(ImageHandle *fh, XREF_HEADER *hdr)
+{
+	const FLOW_GRAPH *g;
+	XREF_LIST l = { 0, 0, 0 };
+	uint32_t *idx;
+	char *p;
+	int i, j;
+
+	if((g = flow_graph()) == 0 && (flow_build(fh) != 0 || (g = flow_graph()) == 0)) return -1;
+	for(i=0;i<g->num_blocks;i++) {
+		if(scan_block(g, &g->blocks[i], &l) != 0) {
+			free(l.x);
+			return -1;
+		}
+	}
+	qsort(l.x, l.num, sizeof(XREF), cmp_code);
+	// a register pair reloaded with the same values is the same reference
+	for(i=0,j=0;i<l.num;i++) {
+		if(j == 0 || cmp_code(&l.x[j-1], &l.x[i]) != 0) l.x[j++] = l.x[i];
+	}
+	l.num = j;
+
+	image_len = sizeof(XREF_HEADER) + l.num*(sizeof(XREF) + sizeof(uint32_t));
+	if((p = malloc(image_len)) == 0) {
+		free(l.x);
+		return -1;
+	}
+	if(l.num) memcpy(p + sizeof(XREF_HEADER), l.x, l.num*sizeof(XREF));
+	free(l.x);
+
+	sort_base = (const XREF *)(p + sizeof(XREF_HEADER));
+	idx = (uint32_t *)(p + sizeof(XREF_HEADER) + l.num*sizeof(XREF));
+	for(i=0;i<l.num;i++) idx[i] = i;
+	qsort(idx, l.num, sizeof(uint32_t), cmp_data);
+
+	hdr->num      = l.num;
+	hdr->data_crc = crc32(0, p + sizeof(XREF_HEADER), image_len - sizeof(XREF_HEADER));
+	memcpy(p, hdr, sizeof(XREF_HEADER));
+	image        = p;
+	image_mapped = 0;
+	return 0;
+}
+
+//-[ Sidecar File ]---------------------------------------------------------------------------------------------------------
+
+static void sidecar_name(char *name, const char *romfile)
+{
+	snprintf(name, MAX_FILENAME, "%s.xref", romfile);
+}
+
+// map the sidecar in if it was built from this image, the records are used in place
+static int load(const char *name, const XREF_HEADER *want)
+{
+	const XREF_HEADER *h;
+	uint32_t i;
+	size_t len;
+	void *p = 0;
+#if !defined(_WIN32)
+	struct stat st;
+	int fd;
+
+	if((fd = open(name, O_RDONLY)) < 0) return -1;
+	if(fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(XREF_HEADER)) {
+		len = st.st_size;
+		p   = mmap(0, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(p == MAP_FAILED) p = 0;
+	}
+	close(fd);
+	if(p == 0) return -1;
+	image_mapped = 1;
+#else
+	if((p = load_file_ex(name, &len, 0)) == 0) return -1;
+	image_mapped = 0;
+#endif
+	image     = p;
+	image_len = len;
+
+	h = (const XREF_HEADER *)p;
+	if(memcmp(h->magic, want->magic, sizeof(h->magic)) != 0
+		|| h->version  != want->version
+		|| h->rom_size != want->rom_size
+		|| h->rom_crc  != want->rom_crc
+		|| memcmp(h->dpp, want->dpp, sizeof(h->dpp)) != 0
+		|| h->num > (len - sizeof(XREF_HEADER)) / (sizeof(XREF) + sizeof(uint32_t))
+		|| len != sizeof(XREF_HEADER) + h->num*(sizeof(XREF) + sizeof(uint32_t))
+		|| crc32(0, (const char *)p + sizeof(XREF_HEADER), len - sizeof(XREF_HEADER)) != h->data_crc) {
+		xref_close();
+		return -1;
+	}
+	// never trust indexes from disk
+	by_data = (const uint32_t *)((const char *)p + sizeof(XREF_HEADER) + h->num*sizeof(XREF));
+	for(i=0;i<h->num;i++) {
+		if(by_data[i] >= h->num) {
+			xref_close();
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int save(const char *name)
+{
+	FILE *fp = fopen(name, "wb");
+	int ok;
+
+	if(fp == 0) return -1;
+	ok = (fwrite(image, 1, image_len, fp) == image_len);
+	if(fclose(fp) != 0) ok = 0;
+	if(!ok) remove(name);
+	return ok ? 0 : -1;
+}
+
+/*
+ * Load the cross references of the image from <romfile>.xref, or build them (and the flow
+ * graph if there is none yet) and write the sidecar.
+ *
+ * returns 1 if they came from the sidecar, 0 if they were built, -1 on failure
+ */
+int xref_open(ImageHandle *fh, const char *romfile)
+{
+	XREF_HEADER hdr;
+	char name[MAX_FILENAME];
+
+	xref_close();
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, XREF_MAGIC, sizeof(XREF_MAGIC));
+	hdr.version  = XREF_VERSION;
+	hdr.rom_size = fh->len;
+	hdr.rom_crc  = crc32(0, fh->d.p, fh->len);
+	hdr.dpp[0]   = dpp0_value;
+	hdr.dpp[1]   = dpp1_value;
+	hdr.dpp[2]   = dpp2_value;
+	hdr.dpp[3]   = dpp3_value;
+
+	if(romfile) sidecar_name(name, romfile);
+	if(romfile && load(name, &hdr) == 0) {
+		from_file = 1;
+	} else {
+		if(build(fh, &hdr) != 0) return -1;
+		if(romfile) save(name);
+		from_file = 0;
+	}
+	num_xrefs = ((const XREF_HEADER *)image)->num;
+	xrefs     = (const XREF *)((const char *)image + sizeof(XREF_HEADER));
+	by_data   = (const uint32_t *)(xrefs + num_xrefs);
+	return from_file;
+}
+
+void xref_close(void)
+{
+#if !defined(_WIN32)
+	if(image_mapped) munmap(image, image_len);
+	else
+#endif
+	free(image);
+	image        = 0;
+	image_len    = 0;
+	image_mapped = 0;
+	xrefs        = 0;
+	by_data      = 0;
+	num_xrefs    = 0;
+	from_file    = 0;
+}
+
+int xref_num(void)
+{
+	return num_xrefs;
+}
+
+int xref_loaded(void)
+{
+	return from_file;
+}
+
+//-[ Queries ]--------------------------------------------------------------------------------------------------------------
+
+/*
+ * References made by the code in [start,end), up to max of them into out, returns how many there are
+ */
+int xref_by_code(unsigned long start, unsigned long end, const XREF **out, int max)
+{
+	int lo = 0, hi = num_xrefs, mid, n = 0;
+
+	while(lo < hi) {
+		mid = (lo + hi) / 2;
+		if(xrefs[mid].code < start) lo = mid + 1;
+		else hi = mid;
+	}
+	for(;lo<num_xrefs && xrefs[lo].code < end;lo++,n++) {
+		if(n < max) out[n] = &xrefs[lo];
+	}
+	return n;
+}
+
+/*
+ * References to the data in [start,end), up to max of them into out, returns how many there are
+ */
+int xref_by_data(unsigned long start, unsigned long end, const XREF **out, int max)
+{
+	int lo = 0, hi = num_xrefs, mid, n = 0;
+
+	while(lo < hi) {
+		mid = (lo + hi) / 2;
+		if(xrefs[by_data[mid]].data < start) lo = mid + 1;
+		else hi = mid;
+	}
+	for(;lo<num_xrefs && xrefs[by_data[lo]].data < end;lo++,n++) {
+		if(n < max) out[n] = &xrefs[by_data[lo]];
+	}
+	return n;
+}
+
+//-[ Report ]---------------------------------------------------------------------------------------------------------------
+
+static void show_xref(const XREF *x, unsigned long adr)
+{
+	char desc[96];
+
+	if(label_format(adr, desc, sizeof(desc)) == 0) snprintf(desc, sizeof(desc), "-");
+	con_printf("    0x%-6.6x %-4s %-5s 0x%-6.6lx %s\n", (int)x->code, xref_kind_name(x->kind),
+		x->width == 1 ? "byte" : x->width == 2 ? "word" : "", (unsigned long)x->data, desc);
+}
+
+static void show_list(const XREF **found, int n, int by_code)
+{
+	int i;
+
+	for(i=0;i<n && i<XREF_SHOW_MAX;i++) show_xref(found[i], by_code ? found[i]->data : found[i]->code);
+	if(n > XREF_SHOW_MAX) con_printf("    ... %d more\n", n - XREF_SHOW_MAX);
+}
+
+/*
+ * For each comma separated rom offset or range in list show the code reading it, and if it
+ * is code what the enclosing function references (physical 0x8xxxxx addresses are accepted)
+ */
+int check_xref(ImageHandle *fh, const char *romfile, char *list)
+{
+	const XREF *found[XREF_SHOW_MAX];
+	char *p = list, *end;
+	unsigned long a, b, fs, fe;
+	clock_t start;
+	double ms;
+	int n, res, in_func;
+
+	if(list == 0) return 0;
+
+	con_printf("\n-[ Cross References ]---------------------------------------------------------------\n\n");
+	start = clock();
+	res = xref_open(fh, romfile);
+	ms  = 1000.0*(double)(clock() - start)/CLOCKS_PER_SEC;
+	if(res < 0) {
+		con_printf("failed to build the cross references\n");
+		return 0;
+	}
+	con_printf("%d code->data references %s %s.xref (%.2f ms)\n\n", num_xrefs, res ? "loaded from" : "built, saved to", romfile ? romfile : "", ms);
+
+	while(*p) {
+		a = strtoul(p, &end, 0) & ~(ROM_1MB_MASK);
+		if(end == p) break;
+		b = a;
+		p = end;
+		if(*p == '-') {
+			b = strtoul(p+1, &end, 0) & ~(ROM_1MB_MASK);
+			if(end == p+1) break;
+			p = end;
+		}
+
+		if(a >= fh->len) {
+			con_printf("0x%-6.6lx : outside the rom image\n", a);
+		} else {
+			n = xref_by_data(a, b+1, found, XREF_SHOW_MAX);
+			if(b > a) con_printf("0x%-6.6lx-0x%-6.6lx : referenced by %d instructions\n", a, b, n);
+			else      con_printf("0x%-6.6lx : referenced by %d instructions\n", a, n);
+			show_list(found, n, 0);
+
+			// code, what its function (or the range) touches
+			fs = a;
+			fe = b+1;
+			in_func = (b == a && flow_func_at(a) >= 0);
+			if(in_func) {
+				fs = func_start(a);
+				fe = func_end(a);
+			}
+			if(fs != FUNC_NONE && fe != FUNC_NONE && (n = xref_by_code(fs, fe, found, XREF_SHOW_MAX)) > 0) {
+				if(in_func) con_printf("  sub_%lX references %d rom addresses\n", fs, n);
+				else        con_printf("  code 0x%-6.6lx-0x%-6.6lx references %d rom addresses\n", fs, fe-1, n);
+				show_list(found, n, 1);
+			}
+		}
+		while(*p == ',' || *p == ' ') p++;
+	}
+	con_printf("\n");
+	return 0;
+}
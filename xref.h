@@ -0,0 +1,82 @@
+/*
+   Permission is hereby granted, free of charge, to any person obtaining
+   a copy of this software and associated documentation files (the
+   "Software"), to deal in the Software without restriction, including
+   without limitation the rights to use, copy, modify, merge, publish,
+   distribute, sublicense, and/or sell copies of the Software, and to
+   permit persons to whom the Software is furnished to do so, subject to
+   the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+   OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+   NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+   BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+   AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+   OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+#ifndef _XREF_SUPPORT_H
+#define _XREF_SUPPORT_H
+#include "utils.h"
+#include "flowgraph.h"
+
+// Code -> rom data cross references of every reached instruction (see flowgraph.h), e.g.
+// "who reads the table at 0x81852d" or "what does sub_52B4E touch" without a needle.
+//
+// A reference is a mem operand (paged by dpp0-dpp3, or by a preceding extp/exts #page/#seg
+// for the instructions it covers), an offset/page pair loaded as immediates into two
+// consecutive registers (mov r4,#offset / mov r5,#page), or a near pointer loaded into
+// one of the argument registers r12-r15 of a call (mov r12,#1FF8h / calls ..., how tables
+// are handed to the lookup routines). Only addresses inside the rom image are kept.
+//
+// Near pointers in dpp0 (page 0) are taken to be in the map data page just below dpp1,
+// as the table checks do (dpp1_value-1).
+//
+// The table is written next to the rom as <romfile>.xref and mapped straight back in on the
+// next run, records sorted by code address followed by an index of them sorted by data.
+
+#define XREF_MAGIC			"ME7XREF"
+#define XREF_VERSION		2
+#define XREF_ARG_FIRST		12		// r12-r15 carry call arguments
+
+#define XR_MEM				0		// mem operand paged by a dpp
+#define XR_EXTP				1		// mem operand under extp/extpr #page
+#define XR_EXTS				2		// mem operand under exts/extsr #seg
+#define XR_PAIR				3		// immediate offset + page (or segment) register pair
+#define XR_PTR				4		// near pointer passed to a call
+#define XR_KINDS			5
+
+typedef struct XREF {
+	uint32_t code;			// rom file offset of the instruction (the offset load of a pair)
+	uint32_t data;			// rom file offset referenced
+	uint8_t  kind;			// XR_xxx
+	uint8_t  reg;			// XR_PAIR/XR_PTR: register holding the offset, otherwise the operand index
+	uint16_t width;			// access width in bytes, 0 if only the address is taken
+} XREF;
+
+typedef struct XREF_HEADER {
+	char     magic[8];
+	uint32_t version;
+	uint32_t rom_size;		// image the table was built from
+	uint32_t rom_crc;
+	uint32_t dpp[4];
+	uint32_t num;			// XREF records, then num uint32_t indexes sorted by data
+	uint32_t data_crc;		// crc of everything after the header
+} XREF_HEADER;
+
+int  xref_open(ImageHandle *fh, const char *romfile);
+void xref_close(void);
+int  xref_num(void);
+int  xref_loaded(void);
+
+int  xref_by_code(unsigned long start, unsigned long end, const XREF **out, int max);
+int  xref_by_data(unsigned long start, unsigned long end, const XREF **out, int max);
+const char *xref_kind_name(int kind);
+
+int  check_xref(ImageHandle *fh, const char *romfile, char *list);
+
+#endif